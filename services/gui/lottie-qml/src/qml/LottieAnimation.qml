@@ -141,7 +141,10 @@ Item {
      */
     // Start the animation, restarts if already running
     function start() {
-        if (d.animationItem) {
+        if (d.nativeItem) {
+            d.nativeItem.start();
+            running = true;
+        } else if (d.animationItem) {
             d.animationItem.play();
             running = true;
         }
@@ -153,7 +156,10 @@ Item {
      * This is the same as setting running to false.
      */
     function pause() {
-        if (d.animationItem) {
+        if (d.nativeItem) {
+            d.nativeItem.pause();
+            running = false;
+        } else if (d.animationItem) {
             d.animationItem.pause();
             running = false;
         }
@@ -165,7 +171,10 @@ Item {
      * Stops playback and rewinds the animation to the beginning.
      */
     function stop() {
-        if (d.animationItem) {
+        if (d.nativeItem) {
+            d.nativeItem.stop();
+            running = false;
+        } else if (d.animationItem) {
             d.animationItem.stop();
             running = false;
         }
@@ -175,6 +184,11 @@ Item {
      * Clear the animation canvas
      */
     function clear() {
+        if (d.nativeItem) {
+            d.nativeItem.clear();
+            return;
+        }
+
         if (!canvas.available) {
             return;
         }
@@ -202,6 +216,31 @@ Item {
         // to provide a seamless experience
         property real pendingRawFrame: -1
 
+        // NativeLottieAnimation of the Mycroft plugin, when it was built with it:
+        // the animation is then rendered in C++ instead of JavaScript and the canvas stays unused
+        property Item nativeItem: null
+        property bool nativeChecked: false
+
+        function ensureNative() {
+            if (!nativeChecked) {
+                nativeChecked = true;
+                try {
+                    nativeItem = Qt.createQmlObject("import Mycroft 1.0 as Mycroft; Mycroft.NativeLottieAnimation { anchors.fill: parent }",
+                                                    lottieItem, "NativeLottieAnimation");
+                } catch (e) {
+                    nativeItem = null;
+                }
+            }
+            return nativeItem !== null;
+        }
+
+        function syncFromNative() {
+            lottieItem.errorString = nativeItem.errorString;
+            lottieItem.status = nativeItem.status;
+            lottieItem.implicitWidth = nativeItem.implicitWidth;
+            lottieItem.implicitHeight = nativeItem.implicitHeight;
+        }
+
         onAnimationDataChanged: {
             destroyAnimation();
 
@@ -236,7 +275,7 @@ Item {
         }
 
         // TODO clean that up a bit
-        readonly property bool shouldPlay: canvas.available && componentComplete
+        readonly property bool shouldPlay: !nativeItem && canvas.available && componentComplete
                                            && lottieItem.width > 0 && lottieItem.height > 0
 
         onShouldPlayChanged: {
@@ -332,6 +371,10 @@ Item {
         }
 
         function destroyAndRecreate() {
+            if (nativeItem) {
+                return;
+            }
+
             if (animationItem) {
                 d.pendingRawFrame = animationItem.currentRawFrame;
             }
@@ -356,6 +399,7 @@ Item {
         }
 
         Component.onCompleted: {
+            ensureNative();
             componentComplete = true;
         }
     }
@@ -389,6 +433,12 @@ Item {
     }
 
     onSourceChanged: {
+        if (d.ensureNative()) {
+            d.nativeItem.source = source;
+            d.syncFromNative();
+            return;
+        }
+
         // is already JS object, use verbatim
         if (typeof source === "object") { // TODO what about QUrl, I think it is treated as {} here
             d.animationData = source;
@@ -438,6 +488,22 @@ Item {
     // stored in a variable by Lottie, we would crash somewhere in Qt.
     onParentChanged: Qt.callLater(d.destroyAndRecreate);
 
+    Binding { target: d.nativeItem; property: "running"; value: lottieItem.running }
+    Binding { target: d.nativeItem; property: "loops"; value: lottieItem.loops }
+    Binding { target: d.nativeItem; property: "speed"; value: lottieItem.speed }
+    Binding { target: d.nativeItem; property: "reverse"; value: lottieItem.reverse }
+    Binding { target: d.nativeItem; property: "fillMode"; value: lottieItem.fillMode }
+
+    Connections {
+        target: d.nativeItem
+        onStatusChanged: d.syncFromNative()
+        onImplicitWidthChanged: d.syncFromNative()
+        onImplicitHeightChanged: d.syncFromNative()
+        onRunningChanged: lottieItem.running = d.nativeItem.running
+        onFinished: lottieItem.finished()
+        onLoopFinished: lottieItem.loopFinished(currentLoop)
+    }
+
     Item {
         id: container
         anchors.fill: parent
@@ -43,7 +43,11 @@ Rectangle {
 
 
     Connections {
+        id: listenerConnections
         target: Mycroft.MycroftController
+        Component.onCompleted: {
+            Mycroft.MycroftController.declareIntentTypes(["recognizer_loop:wakeword", "mycroft.mic.listen", "recognizer_loop:record_end", "mycroft.speech.recognition.unknown", "mycroft.mic.mute", "mycroft.mic.unmute"], listenerConnections);
+        }
         onIntentRecevied: {
             switch(type){
             case "recognizer_loop:wakeword":
@@ -56,8 +56,12 @@ Item {
     }
 
     Connections {
+        id: intentConnections
         target: Mycroft.MycroftController
 
+        Component.onCompleted: {
+            Mycroft.MycroftController.declareIntentTypes(["mycroft.display.screenshot.get", "mycroft.ready"], intentConnections);
+        }
         onIntentRecevied: {
             if (type == "mycroft.display.screenshot.get") {
                 var filepath = "/tmp/" + "screen-" +  Qt.formatDateTime(new Date(), "hhmmss-ddMMyy") + ".png"
@@ -171,6 +175,10 @@ Item {
             Kirigami.Theme.colorSet: Kirigami.Theme.Complementary
 
             bottomPadding: virtualKeyboard.state == "visible" ? virtualKeyboard.height : 0
+            // Keeps the listener animations running while heavy pages are created
+            incubationBudget: 4
+            // Shows the last screen right away at boot, before the core is up
+            snapshotInterval: 5000
 
             ListenerAnimation {
                 id: listenerAnimator
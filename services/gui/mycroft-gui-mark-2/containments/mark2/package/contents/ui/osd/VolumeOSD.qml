@@ -41,8 +41,12 @@ SliderControl {
     }
 
     Connections {
+        id: volumeConnections
         target: Mycroft.MycroftController
 
+        Component.onCompleted: {
+            Mycroft.MycroftController.declareIntentTypes(["hardware.volume"], volumeConnections);
+        }
         onIntentRecevied:{
             if ((type == "hardware.volume") && !data.no_osd) {
                 root.parent.color = Qt.rgba(0, 0, 0, 0.5)
@@ -36,12 +36,16 @@ SliderBase {
     }
 
     Connections {
+        id: volumeConnections
         target: Mycroft.MycroftController
         onSocketStatusChanged: {
             if (Mycroft.MycroftController.status == Mycroft.MycroftController.Open) {
                 Mycroft.MycroftController.sendRequest("mycroft.volume.get", {});
             }
         }
+        Component.onCompleted: {
+            Mycroft.MycroftController.declareIntentTypes(["mycroft.volume.get.response", "hardware.volume"], volumeConnections);
+        }
         onIntentRecevied: {
             if (type == "mycroft.volume.get.response") {
                 slider.value = data.percent;
@@ -38,26 +38,45 @@ Kirigami.Page {
         var defaultFold = '/opt/mycroft/skills'
         var fileToFind = "README.md"
         var getList = Mycroft.FileReader.checkForMeta(defaultFold, fileToFind)
+        var pending = getList.length
+        if (pending === 0) {
+            modelCreatedObject = hintList
+            filteredModel = modelCreatedObject
+            return
+        }
         for(var i=0; i < getList.length; i++){
             var fileName = getList[i] + "/" + fileToFind;
-            var fileParse = Mycroft.FileReader.read(fileName);
-            console.log("Loading hints from", fileName);
-            var matchedRegex = getDataFromRegex(fileName, fileParse, /<img[^>]*src='([^']*)'.*\/>\s(.*)/g)
-            var matchedExamples = getDataFromRegex(fileName, fileParse, /## Examples.*\n.*"(.*)"\n\*\s"(.*)"/g)
-            var matchedCategory = getDataFromRegex(fileName, fileParse, /## Category.*\n\*\*(.*)\*\*/g)
-            if(matchedRegex !== null && matchedRegex.length > 0 && matchedExamples !== null && matchedExamples.length > 0 && matchedCategory !== null && matchedCategory.length > 0) {
-                console.log("All good. \n");
-                var metaFileObject = {
-                    imgSrc: matchedRegex[1],
-                    title: matchedRegex[2],
-                    category: matchedCategory[1],
-                    examples: matchedExamples
+            // read off the GUI thread, hints keep the order of the skills
+            Mycroft.FileReader.readAsync(fileName, parseHintFile.bind(null, hintList, i, fileName, function() {
+                if (--pending === 0) {
+                    modelCreatedObject = hintList.filter(function(hint) { return hint !== undefined; })
+                    filteredModel = filterModel(filterHints.text.toLowerCase())
                 }
-                hintList.push(metaFileObject);
+            }));
+        }
+    }
+
+    function parseHintFile(hintList, index, fileName, done, fileParse, error){
+        if (error !== null) {
+            console.log("Cannot read", fileName, error);
+            done();
+            return;
+        }
+        console.log("Loading hints from", fileName);
+        var matchedRegex = getDataFromRegex(fileName, fileParse, /<img[^>]*src='([^']*)'.*\/>\s(.*)/g)
+        var matchedExamples = getDataFromRegex(fileName, fileParse, /## Examples.*\n.*"(.*)"\n\*\s"(.*)"/g)
+        var matchedCategory = getDataFromRegex(fileName, fileParse, /## Category.*\n\*\*(.*)\*\*/g)
+        if(matchedRegex !== null && matchedRegex.length > 0 && matchedExamples !== null && matchedExamples.length > 0 && matchedCategory !== null && matchedCategory.length > 0) {
+            console.log("All good. \n");
+            var metaFileObject = {
+                imgSrc: matchedRegex[1],
+                title: matchedRegex[2],
+                category: matchedCategory[1],
+                examples: matchedExamples
             }
+            hintList[index] = metaFileObject;
         }
-        modelCreatedObject = hintList
-        filteredModel = modelCreatedObject
+        done();
     }
 
     function getDataFromRegex(fileName, fileText, matchRegex){
@@ -25,6 +25,8 @@
 #include <QCursor>
 #include <QtWebView/QtWebView>
 
+#include <chrono>
+
 #ifdef Q_OS_ANDROID
 #include <QGuiApplication>
 #include <QtAndroid>
@@ -40,8 +42,29 @@
 #include "appsettings.h"
 #include "version.h"
 
+// Phases done before the Mycroft plugin is loaded, its StartupTracer
+// reads them back from the application when MYCROFT_GUI_STARTUP_TRACE is set
+static void markStartupPhase(const QString &phase)
+{
+    static const bool enabled = qEnvironmentVariableIsSet("MYCROFT_GUI_STARTUP_TRACE");
+    static QVariantList phases;
+    if (!enabled) {
+        return;
+    }
+
+    using namespace std::chrono;
+    const qint64 now = duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    phases << QVariantMap({{QStringLiteral("name"), phase}, {QStringLiteral("ts"), now}});
+
+    if (QCoreApplication::instance()) {
+        QCoreApplication::instance()->setProperty("mycroftStartupPhases", phases);
+    }
+}
+
 int main(int argc, char *argv[])
 {
+    markStartupPhase(QStringLiteral("main"));
+
     QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 
     QStringList arguments;
@@ -76,6 +99,7 @@ int main(int argc, char *argv[])
     app.setApplicationName(QStringLiteral("mycroft.gui"));
     app.setOrganizationDomain(QStringLiteral("kde.org"));
     app.setWindowIcon(QIcon::fromTheme(QStringLiteral("mycroft")));
+    markStartupPhase(QStringLiteral("app_constructed"));
     
 #ifdef Q_OS_ANDROID
     KeyFilter *kf = new KeyFilter;
@@ -91,6 +115,7 @@ int main(int argc, char *argv[])
     }
 
     QtWebView::initialize();
+    markStartupPhase(QStringLiteral("webview_initialized"));
 
     QQuickView view;
     view.setResizeMode(QQuickView::SizeRootObjectToView);
@@ -138,6 +163,7 @@ int main(int argc, char *argv[])
     qmlRegisterType<SpeechIntent>("org.kde.private.mycroftgui", 1, 0, "SpeechIntent");
 
     engine.load(QUrl(QStringLiteral("qrc:/main.qml")));
+    markStartupPhase(QStringLiteral("engine_loaded"));
 
 #ifdef Q_OS_ANDROID
     QtAndroid::runOnAndroidThread([=]() {
@@ -300,7 +300,11 @@ Kirigami.ApplicationWindow {
                 }
 
                 Connections {
+                    id: utteranceConnections
                     target: Mycroft.MycroftController
+                    Component.onCompleted: {
+                        Mycroft.MycroftController.declareIntentTypes(["recognizer_loop:utterance"], utteranceConnections);
+                    }
                     onIntentRecevied: {
                         if(type == "recognizer_loop:utterance") {
                             inputQuery.text = data.utterances[0]
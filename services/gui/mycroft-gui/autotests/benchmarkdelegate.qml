@@ -0,0 +1,7 @@
+import QtQuick 2.4
+import Mycroft 1.0 as Mycroft
+
+Mycroft.AbstractDelegate {
+    width: 100
+    height: 100
+}
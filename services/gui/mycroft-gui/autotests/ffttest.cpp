@@ -0,0 +1,74 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <QtTest>
+#include "../import/thirdparty/fft.h"
+
+class FFTTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testRealForward_data();
+    void testRealForward();
+};
+
+void FFTTest::testRealForward_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("4") << 4;
+    QTest::newRow("8") << 8;
+    QTest::newRow("64") << 64;
+    QTest::newRow("512") << 512;
+}
+
+void FFTTest::testRealForward()
+{
+    QFETCH(int, size);
+
+    std::vector<double> input(size);
+    for (int i = 0; i < size; ++i) {
+        input[i] = std::sin(i * 0.37) + 0.25 * std::cos(i * 1.91) + (i % 3) * 0.1;
+    }
+
+    FFTEngine engine(size);
+    QCOMPARE(engine.size(), size_t(size));
+    std::vector<Complex> output(size / 2 + 1);
+    engine.realForward(input.data(), output.data());
+
+    CArray reference(size);
+    for (int i = 0; i < size; ++i) {
+        reference[i] = Complex(input[i], 0);
+    }
+    fft(reference);
+
+    for (int k = 0; k <= size / 2; ++k) {
+        // Plain DFT as the ground truth for both implementations
+        Complex expected(0, 0);
+        for (int n = 0; n < size; ++n) {
+            expected += input[n] * std::polar(1.0, -2 * PI * k * n / size);
+        }
+
+        QVERIFY2(std::abs(output[k] - expected) < 1e-9, qPrintable(QStringLiteral("engine bin %1").arg(k)));
+        QVERIFY2(std::abs(reference[k % size] - expected) < 1e-9, qPrintable(QStringLiteral("fft bin %1").arg(k)));
+    }
+}
+
+QTEST_MAIN(FFTTest);
+
+#include "ffttest.moc"
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <QtTest>
+#include <QQmlEngine>
+#include <QQmlContext>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "../import/abstractdelegate.h"
+#include "../import/activeskillsmodel.h"
+#include "../import/delegatesmodel.h"
+#include "../import/abstractskillview.h"
+#include "../import/sessiondatamap.h"
+#include "../import/sessiondatamodel.h"
+
+static const QString s_skill = QStringLiteral("benchmark.skill");
+
+/**
+ * Measures how many messages per second AbstractSkillView can process
+ * for every message type of the gui protocol, parsing included.
+ * No socket is involved: messages are fed straight to the view.
+ */
+class GuiMessageBenchmark : public QObject
+{
+    Q_OBJECT
+
+public Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+private Q_SLOTS:
+    void benchmarkMessages_data();
+    void benchmarkMessages();
+
+private:
+    void feed(const QJsonObject &message);
+
+    QQmlEngine *m_engine;
+    AbstractSkillView *m_view;
+};
+
+static QJsonObject listMessage(const QString &type, const QString &property, const QJsonObject &fields)
+{
+    QJsonObject message(fields);
+    message[QStringLiteral("type")] = type;
+    message[QStringLiteral("namespace")] = s_skill;
+    message[QStringLiteral("property")] = property;
+    return message;
+}
+
+static QJsonArray rows(int count)
+{
+    QJsonArray array;
+    for (int i = 0; i < count; ++i) {
+        array.append(QJsonObject({{QStringLiteral("title"), QStringLiteral("Item %1").arg(i)},
+                                  {QStringLiteral("value"), i}}));
+    }
+    return array;
+}
+
+static QJsonArray pages(int count)
+{
+    const QString url = QUrl::fromLocalFile(QFINDTESTDATA("benchmarkdelegate.qml")).toString();
+    QJsonArray array;
+    for (int i = 0; i < count; ++i) {
+        array.append(QJsonObject({{QStringLiteral("url"), url}}));
+    }
+    return array;
+}
+
+void GuiMessageBenchmark::feed(const QJsonObject &message)
+{
+    m_view->onGuiSocketMessageReceived(QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact)));
+}
+
+void GuiMessageBenchmark::initTestCase()
+{
+    qmlRegisterType<AbstractDelegate>("Mycroft", 1, 0, "AbstractDelegate");
+
+    m_engine = new QQmlEngine(this);
+    m_view = new AbstractSkillView;
+    QQmlEngine::setContextForObject(m_view, m_engine->rootContext());
+
+    feed(QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.list.insert")},
+                      {QStringLiteral("namespace"), QStringLiteral("mycroft.system.active_skills")},
+                      {QStringLiteral("position"), 0},
+                      {QStringLiteral("data"), QJsonArray({QJsonObject({{QStringLiteral("skill_id"), s_skill}})})}}));
+    QCOMPARE(m_view->activeSkills()->rowCount(), 1);
+}
+
+void GuiMessageBenchmark::cleanupTestCase()
+{
+    delete m_view;
+}
+
+void GuiMessageBenchmark::benchmarkMessages_data()
+{
+    QTest::addColumn<QJsonObject>("setup");
+    QTest::addColumn<QJsonObject>("message");
+    QTest::addColumn<int>("count");
+
+    const int count = 5000;
+    const int pageCount = 100;
+
+    QTest::newRow("mycroft.session.set")
+        << QJsonObject()
+        << QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.set")},
+                        {QStringLiteral("namespace"), s_skill},
+                        {QStringLiteral("data"), QJsonObject({{QStringLiteral("temperature"), 21},
+                                                              {QStringLiteral("condition"), QStringLiteral("sunny")}})}})
+        << count;
+
+    QTest::newRow("mycroft.session.set list")
+        << QJsonObject()
+        << QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.set")},
+                        {QStringLiteral("namespace"), s_skill},
+                        {QStringLiteral("data"), QJsonObject({{QStringLiteral("forecast"), rows(10)}})}})
+        << count;
+
+    QTest::newRow("mycroft.session.delete")
+        << QJsonObject()
+        << QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.delete")},
+                        {QStringLiteral("namespace"), s_skill},
+                        {QStringLiteral("property"), QStringLiteral("temperature")}})
+        << count;
+
+    QTest::newRow("mycroft.session.list.insert")
+        << QJsonObject()
+        << listMessage(QStringLiteral("mycroft.session.list.insert"), QStringLiteral("insertList"),
+                       QJsonObject({{QStringLiteral("position"), 0}, {QStringLiteral("data"), rows(1)}}))
+        << count;
+
+    QTest::newRow("mycroft.session.list.update")
+        << listMessage(QStringLiteral("mycroft.session.list.insert"), QStringLiteral("updateList"),
+                       QJsonObject({{QStringLiteral("position"), 0}, {QStringLiteral("data"), rows(10)}}))
+        << listMessage(QStringLiteral("mycroft.session.list.update"), QStringLiteral("updateList"),
+                       QJsonObject({{QStringLiteral("position"), 2}, {QStringLiteral("data"), rows(1)}}))
+        << count;
+
+    QTest::newRow("mycroft.session.list.move")
+        << listMessage(QStringLiteral("mycroft.session.list.insert"), QStringLiteral("moveList"),
+                       QJsonObject({{QStringLiteral("position"), 0}, {QStringLiteral("data"), rows(10)}}))
+        << listMessage(QStringLiteral("mycroft.session.list.move"), QStringLiteral("moveList"),
+                       QJsonObject({{QStringLiteral("from"), 0}, {QStringLiteral("to"), 5}, {QStringLiteral("items_number"), 1}}))
+        << count;
+
+    QTest::newRow("mycroft.session.list.remove")
+        << listMessage(QStringLiteral("mycroft.session.list.insert"), QStringLiteral("removeList"),
+                       QJsonObject({{QStringLiteral("position"), 0}, {QStringLiteral("data"), rows(count)}}))
+        << listMessage(QStringLiteral("mycroft.session.list.remove"), QStringLiteral("removeList"),
+                       QJsonObject({{QStringLiteral("position"), 0}, {QStringLiteral("items_number"), 1}}))
+        << count;
+
+    QTest::newRow("mycroft.gui.list.insert")
+        << QJsonObject()
+        << QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.gui.list.insert")},
+                        {QStringLiteral("namespace"), s_skill},
+                        {QStringLiteral("position"), 0},
+                        {QStringLiteral("data"), pages(1)}})
+        << pageCount;
+
+    QTest::newRow("mycroft.gui.list.move")
+        << QJsonObject()
+        << QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.gui.list.move")},
+                        {QStringLiteral("namespace"), s_skill},
+                        {QStringLiteral("from"), 0},
+                        {QStringLiteral("to"), 1},
+                        {QStringLiteral("items_number"), 1}})
+        << count;
+
+    QTest::newRow("mycroft.events.triggered")
+        << QJsonObject()
+        << QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.events.triggered")},
+                        {QStringLiteral("namespace"), s_skill},
+                        {QStringLiteral("event_name"), QStringLiteral("benchmark.event")},
+                        {QStringLiteral("data"), QJsonObject({{QStringLiteral("value"), 1}})}})
+        << count;
+
+    QTest::newRow("mycroft.gui.list.remove")
+        << QJsonObject()
+        << QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.gui.list.remove")},
+                        {QStringLiteral("namespace"), s_skill},
+                        {QStringLiteral("position"), 0},
+                        {QStringLiteral("items_number"), 1}})
+        << pageCount;
+}
+
+void GuiMessageBenchmark::benchmarkMessages()
+{
+    QFETCH(QJsonObject, setup);
+    QFETCH(QJsonObject, message);
+    QFETCH(int, count);
+
+    if (!setup.isEmpty()) {
+        feed(setup);
+    }
+
+    // Pre serialize, so only the view is measured
+    const QString text = QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact));
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i) {
+        m_view->onGuiSocketMessageReceived(text);
+    }
+    const qint64 elapsed = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    qInfo().noquote() << QStringLiteral("%1: %2 messages in %3 ms, %4 messages/sec")
+        .arg(QString::fromLatin1(QTest::currentDataTag()))
+        .arg(count)
+        .arg(elapsed / 1000000.0, 0, 'f', 2)
+        .arg(count * 1000000000.0 / elapsed, 0, 'f', 0);
+
+    // Let deleteLater() of removed items run between rows
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+QTEST_MAIN(GuiMessageBenchmark);
+
+#include "guimessagebenchmark.moc"
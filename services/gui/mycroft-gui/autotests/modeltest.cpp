@@ -21,16 +21,25 @@
 #include <QAbstractItemModel>
 #include <QQuickView>
 #include <QQmlEngine>
+#include <QQmlComponent>
 #include <QAbstractItemModelTester>
+#include <QJsonArray>
 #include "../import/mycroftcontroller.h"
 #include "../import/abstractdelegate.h"
 #include "../import/filereader.h"
 #include "../import/globalsettings.h"
 #include "../import/activeskillsmodel.h"
 #include "../import/delegatesmodel.h"
+#include "../import/guimetrics.h"
+#include "../import/imagecache.h"
+#include "../import/networkcache.h"
+#include "../import/prioritydispatcher.h"
 #include "../import/abstractskillview.h"
 #include "../import/sessiondatamap.h"
 #include "../import/sessiondatamodel.h"
+#include "../import/sessionsnapshot.h"
+#include "../import/skillmemory.h"
+#include "../import/voiceactivitydetector.h"
 
 class ModelTest : public QObject
 {
@@ -42,7 +51,23 @@ public Q_SLOTS:
 private Q_SLOTS:
     void testActiveSkillsModel();
     void testDelegatesModel();
+    void testDelegatesModelLoading();
+    void testDelegatesModelRecycling();
+    void testDelegatesModelPrefetch();
+    void testDelegateSuspended();
     void testSessionDataModel();
+    void testSessionDataModelReplace();
+    void testSessionDataModelBatching();
+    void testSessionDataNestedModel();
+    void testSessionSnapshot();
+    void testSkillMemory();
+    void testLatencyHistogram();
+    void testPriorityDispatcher();
+    void testVoiceActivityDetector();
+    void testImageCache();
+    void testNetworkCacheRevalidation();
+    void testFileReader();
+    void testGlobalSettings();
 
 private:
     AbstractSkillView *m_view;
@@ -54,6 +79,9 @@ private:
 
 void ModelTest::initTestCase()
 {
+    // Not the settings of the user: before anything reads them
+    QStandardPaths::setTestModeEnabled(true);
+
     m_view = new AbstractSkillView();
     m_skillsModel = new ActiveSkillsModel(this);
     m_delegatesModel = new DelegatesModel(this);
@@ -73,6 +101,19 @@ void ModelTest::testActiveSkillsModel()
     m_skillsModel->moveRows(QModelIndex(), 0, 2, QModelIndex(), 4);
     m_skillsModel->removeRows(1, 2);
     m_skillsModel->insertSkills(2, QStringList({QStringLiteral("newSkill")}));
+
+    // duplicates, even within the inserted list, are ignored
+    m_skillsModel->insertSkills(0, QStringList({QStringLiteral("newSkill"), QStringLiteral("skill4"), QStringLiteral("skill4")}));
+    QCOMPARE(m_skillsModel->rowCount(), 4);
+
+    // the index stays in sync with the rows
+    for (int row = 0; row < m_skillsModel->rowCount(); ++row) {
+        const QString skillId = m_skillsModel->data(m_skillsModel->index(row, 0)).toString();
+        QVERIFY(m_skillsModel->containsSkill(skillId));
+        QCOMPARE(m_skillsModel->skillIndex(skillId).row(), row);
+    }
+    QVERIFY(!m_skillsModel->containsSkill(QStringLiteral("skill1")));
+    QVERIFY(!m_skillsModel->skillIndex(QStringLiteral("skill1")).isValid());
 }
 
 void ModelTest::testDelegatesModel()
@@ -87,6 +128,137 @@ void ModelTest::testDelegatesModel()
     m_delegatesModel->insertDelegateLoaders(0, {new DelegateLoader(m_view)});
 }
 
+void ModelTest::testDelegatesModelLoading()
+{
+    qmlRegisterType<AbstractDelegate>("Mycroft", 1, 0, "AbstractDelegate");
+
+    QQmlEngine engine;
+    AbstractSkillView view;
+    QQmlEngine::setContextForObject(&view, engine.rootContext());
+    view.setIncubationBudget(4);
+
+    DelegatesModel model;
+    new QAbstractItemModelTester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest, this);
+    DelegateLoader *loader = new DelegateLoader(&view);
+    loader->init(QStringLiteral("skill0"), QUrl::fromLocalFile(QFINDTESTDATA("benchmarkdelegate.qml")));
+    model.insertDelegateLoaders(0, {loader});
+
+    // incubated asynchronously: nothing before the event loop runs
+    const QModelIndex index = model.index(0, 0);
+    QVERIFY(model.data(index, DelegatesModel::DelegateLoading).toBool());
+    QVERIFY(!model.data(index, DelegatesModel::DelegateUi).value<AbstractDelegate *>());
+
+    QSignalSpy dataChangedSpy(&model, &DelegatesModel::dataChanged);
+    QVERIFY(dataChangedSpy.wait());
+    QVERIFY(!model.data(index, DelegatesModel::DelegateLoading).toBool());
+    AbstractDelegate *delegate = model.data(index, DelegatesModel::DelegateUi).value<AbstractDelegate *>();
+    QVERIFY(delegate);
+    QCOMPARE(delegate->skillId(), QStringLiteral("skill0"));
+}
+
+void ModelTest::testDelegatesModelRecycling()
+{
+    qmlRegisterType<AbstractDelegate>("Mycroft", 1, 0, "AbstractDelegate");
+
+    QQmlEngine engine;
+    AbstractSkillView view;
+    QQmlEngine::setContextForObject(&view, engine.rootContext());
+    const QUrl url = QUrl::fromLocalFile(QFINDTESTDATA("benchmarkdelegate.qml"));
+
+    DelegatesModel model;
+    DelegateLoader *loader = new DelegateLoader(&view);
+    loader->init(QStringLiteral("skill0"), url);
+    QVERIFY(loader->delegate());
+    loader->delegate()->setProperty("recyclable", true);
+    model.insertDelegateLoaders(0, {loader});
+
+    QSignalSpy recycledSpy(loader->delegate(), &AbstractDelegate::recycled);
+    QSignalSpy reusedSpy(loader->delegate(), &AbstractDelegate::reused);
+    model.removeRows(0, 1);
+    QCOMPARE(recycledSpy.count(), 1);
+
+    QVERIFY(!view.reuseDelegateLoader(QStringLiteral("skill1"), url));
+    QCOMPARE(view.reuseDelegateLoader(QStringLiteral("skill0"), url), loader);
+    QCOMPARE(reusedSpy.count(), 1);
+    // taken out of the pool
+    QVERIFY(!view.reuseDelegateLoader(QStringLiteral("skill0"), url));
+}
+
+void ModelTest::testDelegatesModelPrefetch()
+{
+    qmlRegisterType<AbstractDelegate>("Mycroft", 1, 0, "AbstractDelegate");
+
+    QQmlEngine engine;
+    AbstractSkillView view;
+    QQmlEngine::setContextForObject(&view, engine.rootContext());
+    view.setPagePrefetch(1);
+    const QUrl url = QUrl::fromLocalFile(QFINDTESTDATA("benchmarkdelegate.qml"));
+
+    DelegatesModel model;
+    QList<DelegateLoader *> loaders;
+    for (int i = 0; i < 4; ++i) {
+        DelegateLoader *loader = new DelegateLoader(&view);
+        loader->init(QStringLiteral("skill0"), url, i > 0);
+        loaders << loader;
+    }
+    model.insertDelegateLoaders(0, loaders);
+
+    // only the first page right away, the others are loading meanwhile
+    QVERIFY(loaders[0]->delegate());
+    QVERIFY(loaders[1]->isDeferred());
+    QVERIFY(model.data(model.index(1, 0), DelegatesModel::DelegateLoading).toBool());
+
+    // its neighbour in the background, not farther
+    QTRY_VERIFY(loaders[1]->delegate());
+    PriorityDispatcher::instance()->flush();
+    QVERIFY(loaders[2]->isDeferred());
+    QVERIFY(loaders[3]->isDeferred());
+
+    // swiping further creates the page at once, then its neighbour
+    model.setCurrentIndex(2);
+    QVERIFY(loaders[2]->delegate());
+    QTRY_VERIFY(loaders[3]->delegate());
+
+    // out of range indices don't move the pager
+    model.setCurrentIndex(-1);
+    QCOMPARE(model.currentIndex(), 2);
+    model.setCurrentIndex(loaders.count());
+    QCOMPARE(model.currentIndex(), 2);
+}
+
+void ModelTest::testDelegateSuspended()
+{
+    qmlRegisterType<AbstractDelegate>("Mycroft", 1, 0, "AbstractDelegate");
+
+    QQmlEngine engine;
+    QQmlComponent component(&engine);
+    component.setData("import QtQuick 2.4\n"
+                      "import Mycroft 1.0 as Mycroft\n"
+                      "Mycroft.AbstractDelegate {\n"
+                      "    NumberAnimation on x { objectName: \"running\"; from: 0; to: 100; loops: Animation.Infinite }\n"
+                      "    NumberAnimation on y { objectName: \"stopped\"; running: false; from: 0; to: 100 }\n"
+                      "}", QUrl());
+    QScopedPointer<QObject> object(component.create());
+    AbstractDelegate *delegate = qobject_cast<AbstractDelegate *>(object.data());
+    QVERIFY(delegate);
+    QObject *running = delegate->findChild<QObject *>(QStringLiteral("running"));
+    QObject *stopped = delegate->findChild<QObject *>(QStringLiteral("stopped"));
+    QVERIFY(running && stopped);
+
+    QSignalSpy suspendedSpy(delegate, &AbstractDelegate::suspendedChanged);
+    delegate->setSuspended(true);
+    QVERIFY(delegate->isSuspended());
+    QCOMPARE(suspendedSpy.count(), 1);
+    QVERIFY(running->property("paused").toBool());
+    QVERIFY(!stopped->property("paused").toBool());
+
+    // only what was paused by suspending gets resumed
+    delegate->setSuspended(false);
+    QVERIFY(!running->property("paused").toBool());
+    QVERIFY(running->property("running").toBool());
+    QCOMPARE(suspendedSpy.count(), 2);
+}
+
 void ModelTest::testSessionDataModel()
 {
     m_sessionDataModel->insertData(0, QList<QVariantMap> ({{{QStringLiteral("prop"), QStringLiteral("value1")}}, {{QStringLiteral("prop"), QStringLiteral("value2")}},  {{QStringLiteral("prop"), QStringLiteral("value3")}}, {{QStringLiteral("prop"), QStringLiteral("value4")}}}));
@@ -97,6 +269,520 @@ void ModelTest::testSessionDataModel()
     m_sessionDataModel->removeRows(1, 2);
     m_sessionDataModel->insertData(2, QList<QVariantMap> ({{{QStringLiteral("prop"), QStringLiteral("newValue")}}}));
     QCOMPARE(m_sessionDataModel->data(m_sessionDataModel->index(2, 0), m_sessionDataModel->roleNames().key("prop")).toString(), QStringLiteral("newValue"));
+
+    // unknown keys are ignored, known ones updated in place
+    m_sessionDataModel->updateData(2, QList<QVariantMap> ({{{QStringLiteral("prop"), QStringLiteral("updated")}, {QStringLiteral("unknown"), 1}}}));
+    QCOMPARE(m_sessionDataModel->data(m_sessionDataModel->index(2, 0), m_sessionDataModel->roleNames().key("prop")).toString(), QStringLiteral("updated"));
+    QCOMPARE(m_sessionDataModel->roleNames().count(), 1);
+    QVERIFY(!m_sessionDataModel->data(m_sessionDataModel->index(2, 0), Qt::UserRole + 2).isValid());
+}
+
+void ModelTest::testSessionDataModelReplace()
+{
+    auto row = [](const QString &id, int value) {
+        return QVariantMap({{QStringLiteral("id"), id}, {QStringLiteral("value"), value}});
+    };
+
+    SessionDataModel model;
+    new QAbstractItemModelTester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest, this);
+    const int valueRole = Qt::UserRole + 2;
+    model.insertData(0, QList<QVariantMap>({row(QStringLiteral("a"), 1), row(QStringLiteral("b"), 2), row(QStringLiteral("c"), 3)}));
+
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy movedSpy(&model, &QAbstractItemModel::rowsMoved);
+
+    // Positional: only the second row changes, then one row gets appended
+    model.replaceData(QList<QVariantMap>({row(QStringLiteral("a"), 1), row(QStringLiteral("b"), 20), row(QStringLiteral("c"), 3), row(QStringLiteral("d"), 4)}));
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.first()[0].toModelIndex().row(), 1);
+    QCOMPARE(changedSpy.first()[2].value<QVector<int>>(), QVector<int>({valueRole}));
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(model.rowCount(), 4);
+
+    // Keyed: "a" removed, "d" moved on top, "e" new
+    changedSpy.clear();
+    insertedSpy.clear();
+    model.replaceData(QList<QVariantMap>({row(QStringLiteral("d"), 4), row(QStringLiteral("b"), 20), row(QStringLiteral("c"), 3), row(QStringLiteral("e"), 5)}), QStringLiteral("id"));
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(movedSpy.count(), 1);
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(changedSpy.count(), 0);
+    QCOMPARE(resetSpy.count(), 0);
+
+    QCOMPARE(model.rowCount(), 4);
+    QCOMPARE(model.data(model.index(0, 0), valueRole).toInt(), 4);
+    QCOMPARE(model.data(model.index(3, 0), valueRole).toInt(), 5);
+
+    // Keyed: reversed, with new rows in between
+    model.replaceData(QList<QVariantMap>({row(QStringLiteral("x"), 0), row(QStringLiteral("e"), 5), row(QStringLiteral("c"), 3),
+                                          row(QStringLiteral("y"), 0), row(QStringLiteral("b"), 20), row(QStringLiteral("d"), 4)}), QStringLiteral("id"));
+    QStringList ids;
+    for (int i = 0; i < model.rowCount(); ++i) {
+        ids << model.data(model.index(i, 0), Qt::UserRole + 1).toString();
+    }
+    QCOMPARE(ids, QStringList({QStringLiteral("x"), QStringLiteral("e"), QStringLiteral("c"), QStringLiteral("y"), QStringLiteral("b"), QStringLiteral("d")}));
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void ModelTest::testSessionDataModelBatching()
+{
+    auto row = [](int value) {
+        return QList<QVariantMap>({{{QStringLiteral("value"), value}}});
+    };
+
+    SessionDataModel model;
+    model.setBatchingEnabled(true);
+    model.insertData(0, QList<QVariantMap>() << row(0) << row(0) << row(0));
+
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy pendingSpy(&model, &SessionDataModel::changesPending);
+
+    // first change of a row goes out immediately, the following ones wait
+    model.updateData(0, row(1));
+    QCOMPARE(changedSpy.count(), 1);
+    model.updateData(0, row(2));
+    model.updateData(1, row(2));
+    model.updateData(0, row(3));
+    QCOMPARE(changedSpy.count(), 2);
+    QVERIFY(pendingSpy.count() > 0);
+    // storage is always up to date
+    QCOMPARE(model.data(model.index(0, 0)).toInt(), 3);
+
+    model.updateData(1, row(4));
+
+    // rows 0 and 1 merged in one range
+    changedSpy.clear();
+    model.flushPendingChanges();
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.first()[0].toModelIndex().row(), 0);
+    QCOMPARE(changedSpy.first()[1].toModelIndex().row(), 1);
+
+    // nothing pending anymore, the interval after is free
+    changedSpy.clear();
+    model.flushPendingChanges();
+    QCOMPARE(changedSpy.count(), 0);
+    model.updateData(0, row(5));
+    QCOMPARE(changedSpy.count(), 1);
+}
+
+void ModelTest::testSessionDataNestedModel()
+{
+    auto days = [](int count) {
+        QJsonArray array;
+        for (int i = 0; i < count; ++i) {
+            array.append(QJsonObject({{QStringLiteral("day"), i}, {QStringLiteral("hourly"), QJsonArray({1, 2, 3})}}));
+        }
+        return QJsonObject({{QStringLiteral("city"), QStringLiteral("Berlin")}, {QStringLiteral("days"), array}});
+    };
+
+    const QList<QVariantMap> rows = SessionDataModel::rowsFromJson(days(2).value(QStringLiteral("days")).toArray());
+    QCOMPARE(rows.count(), 2);
+    QCOMPARE(rows[1].value(QStringLiteral("day")).toInt(), 1);
+    QCOMPARE(rows[1].value(QStringLiteral("hourly")).toList().count(), 3);
+    QVERIFY(SessionDataModel::rowsFromJson(QJsonArray({1, 2})).isEmpty());
+
+    SessionDataMap map(QStringLiteral("mycroft.weather"), m_view);
+    map.setJsonValue(QStringLiteral("forecast"), days(2));
+
+    // objects are child maps, lists of objects models
+    SessionDataMap *forecast = map.value(QStringLiteral("forecast")).value<SessionDataMap *>();
+    QVERIFY(forecast);
+    QCOMPARE(forecast->value(QStringLiteral("city")).toString(), QStringLiteral("Berlin"));
+    QPointer<SessionDataModel> model = forecast->value(QStringLiteral("days")).value<SessionDataModel *>();
+    QVERIFY(model);
+    QCOMPARE(model->rowCount(), 2);
+    QCOMPARE(model->roleNames().value(Qt::UserRole + 1), QByteArray("day"));
+    QCOMPARE(model->data(model->index(1, 0), Qt::UserRole + 1).toInt(), 1);
+
+    // updated in place, only what changed notifies
+    QSignalSpy mapChangedSpy(&map, &QQmlPropertyMap::valueChanged);
+    QSignalSpy forecastChangedSpy(forecast, &QQmlPropertyMap::valueChanged);
+    map.setJsonValue(QStringLiteral("forecast"), days(3));
+    QCOMPARE(map.value(QStringLiteral("forecast")).value<SessionDataMap *>(), forecast);
+    QCOMPARE(forecast->value(QStringLiteral("days")).value<SessionDataModel *>(), model.data());
+    QCOMPARE(model->rowCount(), 3);
+    QCOMPARE(mapChangedSpy.count(), 0);
+    QCOMPARE(forecastChangedSpy.count(), 0);
+
+    QJsonObject paris = days(3);
+    paris[QStringLiteral("city")] = QStringLiteral("Paris");
+    map.setJsonValue(QStringLiteral("forecast"), paris);
+    QCOMPARE(forecastChangedSpy.count(), 1);
+    QCOMPARE(forecastChangedSpy.first().first().toString(), QStringLiteral("city"));
+    QCOMPARE(map.jsonValue(QStringLiteral("forecast")).toObject(), paris);
+
+    // gone with the key
+    map.clearAndNotify(QStringLiteral("forecast"));
+    QTRY_VERIFY(!model);
+}
+
+void ModelTest::testSkillMemory()
+{
+    // strings count their characters, containers their items
+    const qint64 shortString = SkillMemoryUsage::variantSize(QStringLiteral("a"));
+    QVERIFY(SkillMemoryUsage::variantSize(QStringLiteral("abcd")) > shortString);
+    QVERIFY(SkillMemoryUsage::variantSize(QVariantList({QStringLiteral("a"), QStringLiteral("a")})) > 2 * shortString);
+    QCOMPARE(SkillMemoryUsage::jsonSize(QJsonValue(QStringLiteral("abcd"))), SkillMemoryUsage::variantSize(QStringLiteral("abcd")));
+    QVERIFY(SkillMemoryUsage::itemTreeSize(m_skillsModel) > 0);
+    QCOMPARE(SkillMemoryUsage::itemTreeSize(nullptr), qint64(0));
+
+    AbstractSkillView view;
+    view.activeSkills()->insertSkills(0, QStringList({QStringLiteral("current"), QStringLiteral("previous")}));
+    const QString big(600 * 1024, QLatin1Char('x'));
+    view.sessionDataForSkill(QStringLiteral("current"))->insertAndNotify(QStringLiteral("text"), big);
+    view.sessionDataForSkill(QStringLiteral("previous"))->insertAndNotify(QStringLiteral("text"), big);
+
+    const QVariantMap usage = view.memoryUsage();
+    QCOMPARE(usage.count(), 2);
+    QVERIFY(usage.value(QStringLiteral("previous")).toMap().value(QStringLiteral("session_bytes")).toLongLong() > big.size() * 2);
+
+    // over budget: the least recently active skill without pages goes, never the current one
+    QSignalSpy destroyedSpy(view.sessionDataForSkill(QStringLiteral("previous")), &QObject::destroyed);
+    view.setMemoryBudget(2);
+    QVERIFY(destroyedSpy.wait());
+    QVERIFY(view.memoryUsage().value(QStringLiteral("current")).toMap().value(QStringLiteral("session_bytes")).toLongLong() > big.size() * 2);
+    QVERIFY(!view.memoryUsage().contains(QStringLiteral("previous")));
+}
+
+void ModelTest::testSessionSnapshot()
+{
+    SessionDataModel model;
+    model.insertData(0, QList<QVariantMap>({{{QStringLiteral("title"), QStringLiteral("first")}, {QStringLiteral("value"), 1}},
+                                            {{QStringLiteral("title"), QStringLiteral("second")}, {QStringLiteral("value"), 2}}}));
+    const QList<QVariantMap> rows = model.rows();
+    QCOMPARE(rows.count(), 2);
+    QCOMPARE(rows[1].value(QStringLiteral("title")).toString(), QStringLiteral("second"));
+    QCOMPARE(rows[1].value(QStringLiteral("value")).toInt(), 2);
+
+    const QList<QJsonObject> messages({
+        QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.list.insert")},
+                     {QStringLiteral("namespace"), QStringLiteral("mycroft.system.active_skills")},
+                     {QStringLiteral("position"), 0},
+                     {QStringLiteral("data"), QJsonArray({QJsonObject({{QStringLiteral("skill_id"), QStringLiteral("mycroft.weather")}})})}}),
+        QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.set")},
+                     {QStringLiteral("namespace"), QStringLiteral("mycroft.weather")},
+                     {QStringLiteral("data"), QJsonObject({{QStringLiteral("temperature"), 21}})}})
+    });
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("snapshots/test.snapshot"));
+
+    QVERIFY(SessionSnapshot::read(path).isEmpty());
+    QVERIFY(SessionSnapshot::writeFile(path, SessionSnapshot::serialize(messages)));
+    QCOMPARE(SessionSnapshot::read(path), messages);
+
+    // a truncated file is ignored
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() / 2));
+    file.close();
+    QVERIFY(SessionSnapshot::read(path).isEmpty());
+}
+
+void ModelTest::testLatencyHistogram()
+{
+    // every bucket holds the values it's asked for, within 12.5%
+    for (qint64 value : {qint64(0), qint64(15), qint64(16), qint64(17), qint64(1000), qint64(123456), qint64(1) << 33}) {
+        const qint64 bucketValue = LatencyHistogram::valueForBucket(LatencyHistogram::bucketForValue(value));
+        QVERIFY2(qAbs(bucketValue - value) <= value / 8, qPrintable(QStringLiteral("%1 -> %2").arg(value).arg(bucketValue)));
+    }
+
+    LatencyHistogram histogram;
+    QCOMPARE(histogram.percentile(50), qint64(0));
+    for (int i = 1; i <= 1000; ++i) {
+        histogram.record(i);
+    }
+    QCOMPARE(histogram.count(), quint64(1000));
+    QCOMPARE(histogram.max(), qint64(1000));
+    QCOMPARE(histogram.mean(), 500.5);
+    QVERIFY(qAbs(histogram.percentile(50) - 500) <= 500 / 8);
+    QVERIFY(qAbs(histogram.percentile(99) - 990) <= 990 / 8);
+    QCOMPARE(histogram.percentile(100), qint64(1000));
+
+    GuiMetrics *metrics = GuiMetrics::instance();
+    metrics->reset();
+    metrics->recordGuiMessage(QStringLiteral("mycroft.session.set"), QStringLiteral("mycroft.weather"), 100, 2000);
+    metrics->recordGuiMessage(QStringLiteral("mycroft.session.set"), QStringLiteral("mycroft.wiki"), 50, 4000);
+    const QVariantMap snapshot = metrics->snapshot();
+    const QVariantMap set = snapshot.value(QStringLiteral("gui")).toMap().value(QStringLiteral("mycroft.session.set")).toMap();
+    QCOMPARE(set.value(QStringLiteral("count")).toInt(), 2);
+    QCOMPARE(set.value(QStringLiteral("bytes")).toInt(), 150);
+    QCOMPARE(set.value(QStringLiteral("max_us")).toInt(), 4);
+    QCOMPARE(snapshot.value(QStringLiteral("skills")).toMap().count(), 2);
+}
+
+void ModelTest::testPriorityDispatcher()
+{
+    PriorityDispatcher *dispatcher = PriorityDispatcher::instance();
+    QStringList order;
+
+    // bulk work waits for the event loop, critical work doesn't
+    dispatcher->post(PriorityDispatcher::Bulk, this, [&order]() { order << QStringLiteral("bulk1"); });
+    dispatcher->post(PriorityDispatcher::Bulk, this, [&order]() { order << QStringLiteral("bulk2"); });
+    dispatcher->post(PriorityDispatcher::Critical, this, [&order]() { order << QStringLiteral("critical"); });
+    QCOMPARE(order, QStringList({QStringLiteral("critical")}));
+    QCOMPARE(dispatcher->pendingCount(), 2);
+    QTRY_COMPARE(order, QStringList({QStringLiteral("critical"), QStringLiteral("bulk1"), QStringLiteral("bulk2")}));
+
+    // work of destroyed contexts is dropped
+    QObject *context = new QObject;
+    dispatcher->post(PriorityDispatcher::Bulk, context, [&order]() { order << QStringLiteral("dropped"); });
+    delete context;
+    dispatcher->flush();
+    QCOMPARE(order.count(), 3);
+
+    // long work is spread over several slices
+    const int timeSlice = dispatcher->timeSlice();
+    dispatcher->setTimeSlice(1);
+    int done = 0;
+    for (int i = 0; i < 10; ++i) {
+        dispatcher->post(PriorityDispatcher::Bulk, this, [&done]() { QTest::qSleep(2); ++done; });
+    }
+    QTest::qWait(0);
+    QVERIFY(done < 10);
+    QTRY_COMPARE(done, 10);
+    dispatcher->setTimeSlice(timeSlice);
+}
+
+void ModelTest::testVoiceActivityDetector()
+{
+    VoiceActivityDetector vad(20);
+    QCOMPARE(vad.hangover(), 800);
+
+    auto feed = [&vad](float rms, int frames) {
+        VoiceActivityDetector::Event last = VoiceActivityDetector::NoEvent;
+        for (int i = 0; i < frames; ++i) {
+            const VoiceActivityDetector::Event event = vad.process(rms);
+            if (event != VoiceActivityDetector::NoEvent) {
+                last = event;
+            }
+        }
+        return last;
+    };
+
+    // steady noise doesn't count, even when it gets a bit louder
+    QCOMPARE(feed(0.05f, 50), VoiceActivityDetector::NoEvent);
+    QCOMPARE(feed(0.1f, 50), VoiceActivityDetector::NoEvent);
+    QVERIFY(!vad.inSpeech());
+
+    // noise floor down to near silence, a click is not speech
+    feed(0.001f, 50);
+    QCOMPARE(feed(0.3f, 1), VoiceActivityDetector::NoEvent);
+    QCOMPARE(feed(0.001f, 1), VoiceActivityDetector::NoEvent);
+
+    // speech starts after the onset
+    QCOMPARE(feed(0.3f, 2), VoiceActivityDetector::NoEvent);
+    QCOMPARE(feed(0.3f, 1), VoiceActivityDetector::SpeechStarted);
+    QVERIFY(vad.inSpeech());
+
+    // a pause between words is still speech
+    QCOMPARE(feed(0.001f, 20), VoiceActivityDetector::NoEvent);
+    QVERIFY(!vad.isVoiced());
+    QCOMPARE(feed(0.3f, 5), VoiceActivityDetector::NoEvent);
+    QVERIFY(vad.isVoiced());
+
+    // the hangover of silence ends it
+    QCOMPARE(feed(0.001f, 39), VoiceActivityDetector::NoEvent);
+    QCOMPARE(feed(0.001f, 1), VoiceActivityDetector::SpeechEnded);
+    QVERIFY(!vad.inSpeech());
+
+    vad.reset();
+    QVERIFY(vad.noiseFloor() < 0);
+
+    // speech since the first frame: the floor comes from its pauses, not from it
+    int startedAt = -1;
+    for (int i = 0; i < 10; ++i) {
+        if (vad.process(i % 5 == 4 ? 0.01f : 0.3f) == VoiceActivityDetector::SpeechStarted) {
+            startedAt = i;
+        }
+    }
+    QCOMPARE(startedAt, 9);
+    QVERIFY(vad.inSpeech());
+    QVERIFY(vad.noiseFloor() < 0.05f);
+}
+
+void ModelTest::testImageCache()
+{
+    QImage source(400, 200, QImage::Format_RGB32);
+    source.fill(Qt::red);
+    QByteArray png;
+    QBuffer buffer(&png);
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QVERIFY(source.save(&buffer, "PNG"));
+    buffer.close();
+
+    // decoded at the smallest size covering the request, never upscaled
+    auto decode = [&png](const QSize &size) {
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::ReadOnly);
+        QString error;
+        return ImageCache::decode(&buffer, size, &error);
+    };
+    QCOMPARE(decode(QSize()).size(), QSize(400, 200));
+    QCOMPARE(decode(QSize(100, 100)).size(), QSize(200, 100));
+    QCOMPARE(decode(QSize(100, 0)).size(), QSize(100, 50));
+    QCOMPARE(decode(QSize(800, 800)).size(), QSize(400, 200));
+
+    QByteArray garbage("not an image");
+    QBuffer invalid(&garbage);
+    QVERIFY(invalid.open(QIODevice::ReadOnly));
+    QString error;
+    QVERIFY(ImageCache::decode(&invalid, QSize(), &error).isNull());
+    QVERIFY(!error.isEmpty());
+
+    // the least recently used images go first once over budget
+    ImageCache *cache = ImageCache::instance();
+    const qint64 budget = cache->budget();
+    cache->clear();
+    QImage image(256, 256, QImage::Format_ARGB32); // 256 KiB
+    cache->setBudget(600 * 1024);
+
+    const QUrl url(QStringLiteral("file:///background.png"));
+    const QString first = ImageCache::key(url, QSize(256, 256));
+    const QString second = ImageCache::key(url, QSize(128, 128));
+    const QString third = ImageCache::key(QUrl(QStringLiteral("file:///other.png")), QSize(256, 256));
+    QVERIFY(first != second);
+
+    cache->insert(first, image);
+    cache->insert(second, image);
+    QVERIFY(!cache->find(first).isNull());
+    cache->insert(third, image);
+    QCOMPARE(cache->count(), 2);
+    QVERIFY(cache->contains(first));
+    QVERIFY(!cache->contains(second));
+    QVERIFY(cache->contains(third));
+    QVERIFY(cache->size() <= cache->budget());
+
+    // bigger than the whole budget: not kept
+    cache->insert(first, QImage(1024, 1024, QImage::Format_ARGB32));
+    QVERIFY(!cache->contains(first));
+
+    cache->clear();
+    cache->setBudget(budget);
+}
+
+void ModelTest::testNetworkCacheRevalidation()
+{
+    const QUrl url(QStringLiteral("http://core.local:8181/skills/weather/ui/WeatherDelegate.qml"));
+    QVERIFY(NetworkCache::instance()->takeRevalidation(url));
+    QVERIFY(!NetworkCache::instance()->takeRevalidation(url));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    RevalidatingDiskCache cache;
+    cache.setCacheDirectory(dir.path());
+
+    QNetworkCacheMetaData metaData;
+    metaData.setUrl(url);
+    metaData.setSaveToDisk(true);
+    metaData.setRawHeaders({qMakePair(QByteArray("ETag"), QByteArray("\"1\"")),
+                            qMakePair(QByteArray("cache-control"), QByteArray("max-age=3600"))});
+    QIODevice *device = cache.prepare(metaData);
+    QVERIFY(device);
+    device->write("Item {}");
+    cache.insert(device);
+
+    auto cacheControl = [](const QNetworkCacheMetaData &metaData) {
+        QByteArrayList values;
+        for (const auto &header : metaData.rawHeaders()) {
+            if (header.first.toLower() == "cache-control") {
+                values << header.second;
+            }
+        }
+        return values;
+    };
+
+    QCOMPARE(cacheControl(cache.metaData(url)), QByteArrayList({"max-age=3600"}));
+
+    // the next lookup only: stale, with its validators kept
+    cache.revalidate(url);
+    const QNetworkCacheMetaData revalidated = cache.metaData(url);
+    QCOMPARE(cacheControl(revalidated), QByteArrayList({"no-cache"}));
+    QVERIFY(revalidated.rawHeaders().contains(qMakePair(QByteArray("ETag"), QByteArray("\"1\""))));
+    QCOMPARE(cacheControl(cache.metaData(url)), QByteArrayList({"max-age=3600"}));
+}
+
+void ModelTest::testFileReader()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("weather")));
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("timer")));
+
+    auto touch = [](const QString &path, const QByteArray &contents) {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly) && file.write(contents) == contents.size();
+    };
+    const QString weather = dir.filePath(QStringLiteral("weather"));
+    const QString timer = dir.filePath(QStringLiteral("timer"));
+    QVERIFY(touch(weather + QStringLiteral("/README.md"), "# Weather"));
+
+    FileReader reader;
+    QCOMPARE(reader.checkForMeta(dir.path(), QStringLiteral("README.md")), QStringList({weather}));
+
+    // the index follows the disk
+    QVERIFY(touch(timer + QStringLiteral("/README.md"), "# Timer"));
+    QTRY_COMPARE(reader.checkForMeta(dir.path(), QStringLiteral("README.md")).count(), 2);
+    QVERIFY(QFile::remove(weather + QStringLiteral("/README.md")));
+    QTRY_COMPARE(reader.checkForMeta(dir.path(), QStringLiteral("README.md")), QStringList({timer}));
+    QVERIFY(QDir(timer).removeRecursively());
+    QTRY_VERIFY(reader.checkForMeta(dir.path(), QStringLiteral("README.md")).isEmpty());
+
+    // small files are read, big ones mapped
+    QJSEngine engine;
+    engine.globalObject().setProperty(QStringLiteral("results"), engine.newArray());
+    const QJSValue callback = engine.evaluate(QStringLiteral("(function(text, error) { results.push(error === null ? text.length : error); })"));
+    QVERIFY(callback.isCallable());
+
+    const QString small = dir.filePath(QStringLiteral("small.txt"));
+    const QString big = dir.filePath(QStringLiteral("big.txt"));
+    QVERIFY(touch(small, "héllo"));
+    QVERIFY(touch(big, QByteArray(1024 * 1024, 'a')));
+
+    reader.readAsync(small, callback);
+    QTRY_COMPARE(engine.globalObject().property(QStringLiteral("results")).property(QStringLiteral("length")).toInt(), 1);
+    reader.readAsync(big, callback);
+    QTRY_COMPARE(engine.globalObject().property(QStringLiteral("results")).property(QStringLiteral("length")).toInt(), 2);
+    reader.readAsync(dir.filePath(QStringLiteral("missing.txt")), callback);
+    QTRY_COMPARE(engine.globalObject().property(QStringLiteral("results")).property(QStringLiteral("length")).toInt(), 3);
+
+    const QJSValue results = engine.globalObject().property(QStringLiteral("results"));
+    QCOMPARE(results.property(0).toInt(), 5);
+    QCOMPARE(results.property(1).toInt(), 1024 * 1024);
+    QVERIFY(results.property(2).isString());
+}
+
+void ModelTest::testGlobalSettings()
+{
+    GlobalSettings settings;
+    GlobalSettings other;
+    const int size = settings.componentCacheSize();
+    QSignalSpy changedSpy(&settings, &GlobalSettings::componentCacheSizeChanged);
+    QSignalSpy otherChangedSpy(&other, &GlobalSettings::componentCacheSizeChanged);
+
+    // only real changes are notified
+    settings.setComponentCacheSize(size);
+    QCOMPARE(changedSpy.count(), 0);
+    settings.setComponentCacheSize(size + 1);
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(settings.componentCacheSize(), size + 1);
+
+    // the other instance keeps its snapshot until it reloads, like another process would
+    QCOMPARE(other.componentCacheSize(), size);
+    other.reload();
+    QCOMPARE(other.componentCacheSize(), size + 1);
+    QCOMPARE(otherChangedSpy.count(), 1);
+    QCOMPARE(other.imageCacheSize(), settings.imageCacheSize());
+
+    // nothing changed since
+    other.reload();
+    QCOMPARE(otherChangedSpy.count(), 1);
+
+    settings.setComponentCacheSize(size);
 }
 
 QTEST_MAIN(ModelTest);
@@ -0,0 +1,475 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <QtTest>
+#include <QWebSocket>
+#include <QWebSocketServer>
+#include <QQuickView>
+#include <QQmlEngine>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "../import/mycroftcontroller.h"
+#include "../import/abstractdelegate.h"
+#include "../import/filereader.h"
+#include "../import/globalsettings.h"
+#include "../import/activeskillsmodel.h"
+#include "../import/delegatesmodel.h"
+#include "../import/abstractskillview.h"
+#include "../import/sessiondatamap.h"
+#include "../import/sessiondatamodel.h"
+
+#include <functional>
+
+static const QString s_skill = QStringLiteral("benchmark.skill");
+
+/**
+ * QBENCHMARK performance suite, driving a real SkillView through the same
+ * fake core and gui servers as servertest and stresstest.
+ *
+ * Every benchmark waits for its messages to be applied, without fixed sleeps.
+ * For machine readable results, to compare between runs:
+ *   perfsuite -o perfsuite.xml,xml -o -,txt
+ * or the "benchmark" build target, which writes perfsuite.xml in the build directory.
+ */
+class PerfSuite : public QObject
+{
+    Q_OBJECT
+
+public Q_SLOTS:
+    void initTestCase();
+
+private Q_SLOTS:
+    void connectToServer();
+    void benchmarkMessageThroughput();
+    void benchmarkListInsert_data();
+    void benchmarkListInsert();
+    void benchmarkListUpdate_data();
+    void benchmarkListUpdate();
+    void benchmarkModelData();
+    void benchmarkDelegateCreation();
+    void benchmarkEventFanOut_data();
+    void benchmarkEventFanOut();
+
+private:
+    void send(const QJsonObject &message);
+    DelegatesModel *delegatesModel() const;
+    void insertPages(int count);
+    void removePages();
+
+    //Client
+    MycroftController *m_controller;
+    AbstractSkillView *m_view;
+    SessionDataMap *m_map = nullptr;
+
+    QQuickView *m_window;
+
+    //Server
+    QWebSocketServer *m_mainServerSocket;
+    QWebSocketServer *m_guiServerSocket;
+
+    QWebSocket *m_mainWebSocket;
+    QWebSocket *m_guiWebSocket;
+};
+
+
+static QObject *fileReaderSingletonProvider(QQmlEngine *engine, QJSEngine *scriptEngine)
+{
+    Q_UNUSED(engine)
+    Q_UNUSED(scriptEngine)
+
+    return new FileReader;
+}
+
+static QObject *globalSettingsSingletonProvider(QQmlEngine *engine, QJSEngine *scriptEngine)
+{
+    Q_UNUSED(engine)
+    Q_UNUSED(scriptEngine)
+
+    return new GlobalSettings;
+}
+
+static QObject *mycroftControllerSingletonProvider(QQmlEngine *engine, QJSEngine *scriptEngine)
+{
+    Q_UNUSED(engine);
+    Q_UNUSED(scriptEngine);
+
+    return MycroftController::instance();
+}
+
+// Spins the event loop until condition holds: the 50 ms polls of QTRY_* would be measured too
+static bool waitFor(const std::function<bool()> &condition, int timeout = 30000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.hasExpired(timeout)) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents);
+    }
+    return true;
+}
+
+static QJsonArray rows(int count, int offset = 0)
+{
+    QJsonArray array;
+    for (int i = 0; i < count; ++i) {
+        array.append(QJsonObject({{QStringLiteral("title"), QStringLiteral("Item %1").arg(i + offset)},
+                                  {QStringLiteral("value"), i + offset}}));
+    }
+    return array;
+}
+
+static QUrl pageUrl()
+{
+    return QUrl::fromLocalFile(QFINDTESTDATA("benchmarkdelegate.qml"));
+}
+
+void PerfSuite::send(const QJsonObject &message)
+{
+    m_guiWebSocket->sendTextMessage(QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact)));
+}
+
+DelegatesModel *PerfSuite::delegatesModel() const
+{
+    return m_view->activeSkills()->delegatesModelForSkill(s_skill);
+}
+
+void PerfSuite::insertPages(int count)
+{
+    QJsonArray pages;
+    for (int i = 0; i < count; ++i) {
+        pages.append(QJsonObject({{QStringLiteral("url"), pageUrl().toString()}}));
+    }
+
+    send(QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.gui.list.insert")},
+                      {QStringLiteral("namespace"), s_skill},
+                      {QStringLiteral("position"), 0},
+                      {QStringLiteral("data"), pages}}));
+    QVERIFY(waitFor([this, count]() {
+        return delegatesModel() && delegatesModel()->delegateCount() == count;
+    }));
+}
+
+void PerfSuite::removePages()
+{
+    const int count = delegatesModel() ? delegatesModel()->rowCount() : 0;
+    if (count == 0) {
+        return;
+    }
+
+    send(QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.gui.list.remove")},
+                      {QStringLiteral("namespace"), s_skill},
+                      {QStringLiteral("position"), 0},
+                      {QStringLiteral("items_number"), count}}));
+    QVERIFY(waitFor([this]() {
+        return delegatesModel()->rowCount() == 0;
+    }));
+    // Let deleteLater() of the removed delegates run
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void PerfSuite::initTestCase()
+{
+    m_mainServerSocket = new QWebSocketServer(QStringLiteral("core"),
+                                            QWebSocketServer::NonSecureMode, this);
+    m_mainServerSocket->listen(QHostAddress::Any, 8181);
+    m_guiServerSocket = new QWebSocketServer(QStringLiteral("gui"),
+                                            QWebSocketServer::NonSecureMode, this);
+    m_guiServerSocket->listen(QHostAddress::Any, 1818);
+    m_controller = MycroftController::instance();
+    m_window = new QQuickView;
+
+    bool pluginFound = false;
+    for (const auto &path : m_window->engine()->importPathList()) {
+        QDir importDir(path);
+        if (importDir.entryList().contains(QStringLiteral("Mycroft"))) {
+            pluginFound = true;
+            break;
+        }
+    }
+
+    if (!pluginFound) {
+        qmlRegisterSingletonType<MycroftController>("Mycroft", 1, 0, "MycroftController", mycroftControllerSingletonProvider);
+        qmlRegisterSingletonType<GlobalSettings>("Mycroft", 1, 0, "GlobalSettings", globalSettingsSingletonProvider);
+        qmlRegisterSingletonType<FileReader>("Mycroft", 1, 0, "FileReader", fileReaderSingletonProvider);
+        qmlRegisterType<AbstractSkillView>("Mycroft", 1, 0, "AbstractSkillView");
+        qmlRegisterType<AbstractDelegate>("Mycroft", 1, 0, "AbstractDelegate");
+
+        qmlRegisterType(QUrl(QStringLiteral("qrc:/qml/SkillView.qml")), "Mycroft", 1, 0, "SkillView");
+        qmlRegisterType(QUrl(QStringLiteral("qrc:/qml/BusyIndicator.qml")), "Mycroft", 1, 0, "BusyIndicator");
+
+        qmlRegisterUncreatableType<ActiveSkillsModel>("Mycroft", 1, 0, "ActiveSkillsModel", QStringLiteral("You cannot instantiate items of type ActiveSkillsModel"));
+        qmlRegisterUncreatableType<DelegatesModel>("Mycroft", 1, 0, "DelegatesModel", QStringLiteral("You cannot instantiate items of type DelegatesModel"));
+        qmlRegisterUncreatableType<SessionDataMap>("Mycroft", 1, 0, "SessionDataMap", QStringLiteral("You cannot instantiate items of type SessionDataMap"));
+
+        qmlRegisterType(QUrl::fromLocalFile(QFINDTESTDATA(QStringLiteral("../import/qml/Delegate.qml"))), "Mycroft", 1, 0, "Delegate");
+
+        qmlProtectModule("Mycroft", 1);
+    }
+
+    m_window->setResizeMode(QQuickView::SizeRootObjectToView);
+    m_window->resize(400, 800);
+
+    //Load the AbstractSkillview from our specialization in QML
+    m_window->setSource(QUrl::fromLocalFile(QFINDTESTDATA("../import/qml/SkillView.qml")));
+    if (m_window->errors().length() > 0) {
+        qWarning() << m_window->errors();
+    }
+    m_window->show();
+    m_view = qobject_cast<AbstractSkillView *>(m_window->rootObject());
+    QVERIFY(m_view);
+
+    // Every change applied as it arrives, so that all of them get measured
+    m_view->setUpdateInterval(-1);
+}
+
+void PerfSuite::connectToServer()
+{
+    QSignalSpy newConnectionSpy(m_mainServerSocket, &QWebSocketServer::newConnection);
+    m_controller->start();
+    QVERIFY(newConnectionSpy.wait());
+
+    m_mainWebSocket = m_mainServerSocket->nextPendingConnection();
+    QVERIFY(m_mainWebSocket);
+    QSignalSpy textFromMainSpy(m_mainWebSocket, &QWebSocket::textMessageReceived);
+    QVERIFY(textFromMainSpy.wait());
+
+    const auto doc = QJsonDocument::fromJson(textFromMainSpy.first().first().toString().toUtf8());
+    const QString guiId = doc[QStringLiteral("data")][QStringLiteral("gui_id")].toString();
+    QVERIFY(guiId.length() > 0);
+
+    QSignalSpy newGuiConnectionSpy(m_guiServerSocket, &QWebSocketServer::newConnection);
+    m_mainWebSocket->sendTextMessage(QStringLiteral("{\"type\": \"mycroft.gui.port\", \"data\": {\"gui_id\": \"%1\", \"port\": 1818}}").arg(guiId));
+    QVERIFY(newGuiConnectionSpy.wait());
+    m_guiWebSocket = m_guiServerSocket->nextPendingConnection();
+    QVERIFY(m_guiWebSocket);
+
+    send(QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.list.insert")},
+                      {QStringLiteral("namespace"), QStringLiteral("mycroft.system.active_skills")},
+                      {QStringLiteral("position"), 0},
+                      {QStringLiteral("data"), QJsonArray({QJsonObject({{QStringLiteral("skill_id"), s_skill}})})}}));
+    QVERIFY(waitFor([this]() {
+        return m_view->activeSkills()->containsSkill(s_skill);
+    }));
+
+    m_map = m_view->sessionDataForSkill(s_skill);
+    QVERIFY(m_map);
+}
+
+void PerfSuite::benchmarkMessageThroughput()
+{
+    const int count = 1000;
+
+    // Pre serialized: only the socket and the view are measured
+    QStringList messages;
+    for (int i = 0; i < count; ++i) {
+        messages << QString::fromUtf8(QJsonDocument(QJsonObject({
+            {QStringLiteral("type"), QStringLiteral("mycroft.session.set")},
+            {QStringLiteral("namespace"), s_skill},
+            {QStringLiteral("data"), QJsonObject({{QStringLiteral("value%1").arg(i % 10), i}})}})).toJson(QJsonDocument::Compact));
+    }
+
+    int iteration = 0;
+    QBENCHMARK {
+        ++iteration;
+        for (const QString &message : messages) {
+            m_guiWebSocket->sendTextMessage(message);
+        }
+        // Messages are applied in order: once the last one is there, all are
+        send(QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.set")},
+                          {QStringLiteral("namespace"), s_skill},
+                          {QStringLiteral("data"), QJsonObject({{QStringLiteral("done"), iteration}})}}));
+        QVERIFY(waitFor([this, iteration]() {
+            return m_map->value(QStringLiteral("done")).toInt() == iteration;
+        }));
+    }
+}
+
+void PerfSuite::benchmarkListInsert_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10 rows") << 10;
+    QTest::newRow("1k rows") << 1000;
+    QTest::newRow("100k rows") << 100000;
+}
+
+void PerfSuite::benchmarkListInsert()
+{
+    QFETCH(int, count);
+
+    const QString property = QStringLiteral("insert%1").arg(count);
+    const QString insert = QString::fromUtf8(QJsonDocument(QJsonObject({
+        {QStringLiteral("type"), QStringLiteral("mycroft.session.list.insert")},
+        {QStringLiteral("namespace"), s_skill},
+        {QStringLiteral("property"), property},
+        {QStringLiteral("position"), 0},
+        {QStringLiteral("data"), rows(count)}})).toJson(QJsonDocument::Compact));
+    const QString remove = QString::fromUtf8(QJsonDocument(QJsonObject({
+        {QStringLiteral("type"), QStringLiteral("mycroft.session.list.remove")},
+        {QStringLiteral("namespace"), s_skill},
+        {QStringLiteral("property"), property},
+        {QStringLiteral("position"), 0},
+        {QStringLiteral("items_number"), count}})).toJson(QJsonDocument::Compact));
+
+    auto model = [this, property]() {
+        return m_map->value(property).value<SessionDataModel *>();
+    };
+
+    // Emptied again at the end of every iteration, removing rows costs little next to parsing them
+    QBENCHMARK {
+        m_guiWebSocket->sendTextMessage(insert);
+        QVERIFY(waitFor([&]() {
+            return model() && model()->rowCount() == count;
+        }));
+        m_guiWebSocket->sendTextMessage(remove);
+        QVERIFY(waitFor([&]() {
+            return model()->rowCount() == 0;
+        }));
+    }
+}
+
+void PerfSuite::benchmarkListUpdate_data()
+{
+    benchmarkListInsert_data();
+}
+
+void PerfSuite::benchmarkListUpdate()
+{
+    QFETCH(int, count);
+
+    const QString property = QStringLiteral("update%1").arg(count);
+    send(QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.list.insert")},
+                      {QStringLiteral("namespace"), s_skill},
+                      {QStringLiteral("property"), property},
+                      {QStringLiteral("position"), 0},
+                      {QStringLiteral("data"), rows(count)}}));
+    QVERIFY(waitFor([this, property, count]() {
+        SessionDataModel *dm = m_map->value(property).value<SessionDataModel *>();
+        return dm && dm->rowCount() == count;
+    }));
+    SessionDataModel *dm = m_map->value(property).value<SessionDataModel *>();
+    const int valueRole = dm->roleNames().key("value");
+
+    // Alternates between two contents, so that every row really changes
+    QStringList updates;
+    for (int offset : {1, 0}) {
+        updates << QString::fromUtf8(QJsonDocument(QJsonObject({
+            {QStringLiteral("type"), QStringLiteral("mycroft.session.list.update")},
+            {QStringLiteral("namespace"), s_skill},
+            {QStringLiteral("property"), property},
+            {QStringLiteral("position"), 0},
+            {QStringLiteral("data"), rows(count, offset)}})).toJson(QJsonDocument::Compact));
+    }
+
+    int iteration = 0;
+    QBENCHMARK {
+        const int offset = ++iteration % 2;
+        m_guiWebSocket->sendTextMessage(updates[1 - offset]);
+        QVERIFY(waitFor([&]() {
+            return dm->data(dm->index(count - 1, 0), valueRole).toInt() == count - 1 + offset;
+        }));
+    }
+}
+
+void PerfSuite::benchmarkModelData()
+{
+    SessionDataModel model;
+    QList<QVariantMap> data;
+    for (int i = 0; i < 1000; ++i) {
+        data << QVariantMap({{QStringLiteral("title"), QStringLiteral("Item %1").arg(i)},
+                             {QStringLiteral("value"), i},
+                             {QStringLiteral("image"), QStringLiteral("image%1.png").arg(i)},
+                             {QStringLiteral("visible"), true}});
+    }
+    model.insertData(0, data);
+
+    const QList<int> roles = model.roleNames().keys();
+    QModelIndex index;
+    int hits = 0;
+
+    // What a ListView does while scrolling: every role of every row
+    QBENCHMARK {
+        for (int row = 0; row < model.rowCount(); ++row) {
+            index = model.index(row, 0);
+            for (int role : roles) {
+                hits += model.data(index, role).isValid();
+            }
+        }
+    }
+    QVERIFY(hits > 0);
+}
+
+void PerfSuite::benchmarkDelegateCreation()
+{
+    // The component is compiled once, outside of the measure
+    insertPages(1);
+    removePages();
+
+    QBENCHMARK {
+        insertPages(1);
+        removePages();
+    }
+}
+
+void PerfSuite::benchmarkEventFanOut_data()
+{
+    QTest::addColumn<int>("pages");
+
+    QTest::newRow("1 page") << 1;
+    QTest::newRow("10 pages") << 10;
+    QTest::newRow("50 pages") << 50;
+}
+
+void PerfSuite::benchmarkEventFanOut()
+{
+    QFETCH(int, pages);
+
+    insertPages(pages);
+
+    int received = 0;
+    for (AbstractDelegate *delegate : delegatesModel()->delegates()) {
+        connect(delegate, &AbstractDelegate::guiEvent, this, [&received]() {
+            ++received;
+        });
+    }
+
+    const QString event = QString::fromUtf8(QJsonDocument(QJsonObject({
+        {QStringLiteral("type"), QStringLiteral("mycroft.events.triggered")},
+        {QStringLiteral("namespace"), s_skill},
+        {QStringLiteral("event_name"), QStringLiteral("benchmark.event")},
+        {QStringLiteral("data"), QJsonObject({{QStringLiteral("value"), 1}})}})).toJson(QJsonDocument::Compact));
+
+    QBENCHMARK {
+        received = 0;
+        m_guiWebSocket->sendTextMessage(event);
+        QVERIFY(waitFor([&]() {
+            return received == pages;
+        }));
+    }
+
+    for (AbstractDelegate *delegate : delegatesModel()->delegates()) {
+        disconnect(delegate, &AbstractDelegate::guiEvent, this, nullptr);
+    }
+    removePages();
+}
+
+QTEST_MAIN(PerfSuite);
+
+#include "perfsuite.moc"
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <QWebSocket>
+#include <QWebSocketServer>
+#include "../import/buscapture.h"
+
+// Frames sent in one go at maximum speed, before letting the sockets write
+static const int s_maximumSpeedBatch = 100;
+
+/**
+ * Plays a bus capture back to a real gui, standing in for the core and gui
+ * servers of mycroft on the same ports as the autotests.
+ *
+ * Capture with MYCROFT_GUI_CAPTURE=traffic.mbus, then:
+ *   replayserver traffic.mbus [--speed 2]
+ * and start the gui pointed at this host. Once the gui socket is connected,
+ * what the gui received in the capture is sent again, with the same pauses
+ * divided by the speed; speed 0 sends everything as fast as possible.
+ */
+class ReplayServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    ReplayServer(const QVector<BusCapture::Frame> &frames, double speed, QObject *parent = nullptr);
+
+    bool listen();
+
+private:
+    void onMainConnection();
+    void onGuiConnection();
+    void sendNext();
+    void finish();
+
+    QVector<BusCapture::Frame> m_frames;
+    double m_speed;
+    int m_next = 0;
+    qint64 m_bytes = 0;
+    bool m_finished = false;
+
+    QWebSocketServer m_mainServer;
+    QWebSocketServer m_guiServer;
+    QWebSocket *m_mainSocket = nullptr;
+    QWebSocket *m_guiSocket = nullptr;
+
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+};
+
+static QString frameType(const BusCapture::Frame &frame)
+{
+    return QJsonDocument::fromJson(frame.payload).object().value(QStringLiteral("type")).toString();
+}
+
+ReplayServer::ReplayServer(const QVector<BusCapture::Frame> &frames, double speed, QObject *parent)
+    : QObject(parent),
+      m_speed(speed),
+      m_mainServer(QStringLiteral("core"), QWebSocketServer::NonSecureMode),
+      m_guiServer(QStringLiteral("gui"), QWebSocketServer::NonSecureMode)
+{
+    // Only what the gui received is replayed; the port is handed out again by the handshake
+    for (const auto &frame : frames) {
+        if (frame.outbound) {
+            continue;
+        }
+        if (frame.channel == BusCapture::MainChannel && !frame.binary
+            && frameType(frame) == QLatin1String("mycroft.gui.port")) {
+            continue;
+        }
+        m_frames.append(frame);
+    }
+
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &ReplayServer::sendNext);
+    connect(&m_mainServer, &QWebSocketServer::newConnection, this, &ReplayServer::onMainConnection);
+    connect(&m_guiServer, &QWebSocketServer::newConnection, this, &ReplayServer::onGuiConnection);
+}
+
+bool ReplayServer::listen()
+{
+    if (!m_mainServer.listen(QHostAddress::Any, 8181) || !m_guiServer.listen(QHostAddress::Any, 1818)) {
+        qWarning() << "Could not listen on the ports 8181 and 1818";
+        return false;
+    }
+
+    qInfo() << "Waiting for the gui to replay" << m_frames.count() << "frames";
+    return true;
+}
+
+void ReplayServer::onMainConnection()
+{
+    QWebSocket *socket = m_mainServer.nextPendingConnection();
+    if (m_mainSocket) {
+        qWarning() << "Only one gui at a time can be replayed to";
+        socket->close();
+        socket->deleteLater();
+        return;
+    }
+
+    m_mainSocket = socket;
+    connect(m_mainSocket, &QWebSocket::textMessageReceived, this, [this](const QString &message) {
+        const QJsonObject object = QJsonDocument::fromJson(message.toUtf8()).object();
+        if (object.value(QStringLiteral("type")).toString() != QLatin1String("mycroft.gui.connected")) {
+            return;
+        }
+
+        const QString guiId = object.value(QStringLiteral("data")).toObject().value(QStringLiteral("gui_id")).toString();
+        m_mainSocket->sendTextMessage(QStringLiteral("{\"type\": \"mycroft.gui.port\", \"data\": {\"gui_id\": \"%1\", \"port\": 1818}}").arg(guiId));
+    });
+    connect(m_mainSocket, &QWebSocket::disconnected, this, &ReplayServer::finish);
+}
+
+void ReplayServer::onGuiConnection()
+{
+    QWebSocket *socket = m_guiServer.nextPendingConnection();
+    if (m_guiSocket || !m_mainSocket) {
+        socket->close();
+        socket->deleteLater();
+        return;
+    }
+
+    m_guiSocket = socket;
+    connect(m_guiSocket, &QWebSocket::disconnected, this, &ReplayServer::finish);
+
+    qInfo() << "Gui connected, replaying at" << (m_speed > 0 ? QString::number(m_speed) + QLatin1Char('x') : QStringLiteral("maximum speed"));
+    m_clock.start();
+    sendNext();
+}
+
+void ReplayServer::sendNext()
+{
+    if (!m_guiSocket) {
+        return;
+    }
+
+    const qint64 base = m_frames.isEmpty() ? 0 : m_frames.first().timestamp;
+    int sent = 0;
+
+    while (m_next < m_frames.count()) {
+        const BusCapture::Frame &frame = m_frames.at(m_next);
+
+        if (m_speed > 0) {
+            const qint64 due = qint64((frame.timestamp - base) / m_speed / 1000);
+            const qint64 wait = due - m_clock.elapsed();
+            if (wait > 0) {
+                m_timer.start(int(qMin<qint64>(wait, 60000)));
+                return;
+            }
+        } else if (sent == s_maximumSpeedBatch) {
+            m_timer.start(0);
+            return;
+        }
+
+        QWebSocket *socket = frame.channel == BusCapture::GuiChannel ? m_guiSocket : m_mainSocket;
+        if (frame.binary) {
+            socket->sendBinaryMessage(frame.payload);
+        } else {
+            socket->sendTextMessage(QString::fromUtf8(frame.payload));
+        }
+
+        m_bytes += frame.payload.size();
+        ++m_next;
+        ++sent;
+    }
+
+    finish();
+}
+
+void ReplayServer::finish()
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    m_timer.stop();
+
+    const qint64 elapsed = qMax<qint64>(m_clock.isValid() ? m_clock.elapsed() : 0, 1);
+    qInfo().noquote() << QStringLiteral("Replayed %1 of %2 frames, %3 bytes in %4 ms, %5 frames/sec")
+        .arg(m_next)
+        .arg(m_frames.count())
+        .arg(m_bytes)
+        .arg(elapsed)
+        .arg(m_next * 1000.0 / elapsed, 0, 'f', 0);
+
+    // Let the sockets write what is still queued
+    QTimer::singleShot(1000, qApp, &QCoreApplication::quit);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Replays a mycroft gui bus capture"));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("capture"), QStringLiteral("Log written with MYCROFT_GUI_CAPTURE"));
+    QCommandLineOption speedOption(QStringLiteral("speed"), QStringLiteral("Speed factor, 0 for as fast as possible"),
+                                   QStringLiteral("factor"), QStringLiteral("1"));
+    parser.addOption(speedOption);
+    parser.process(app);
+
+    if (parser.positionalArguments().count() != 1) {
+        parser.showHelp(1);
+    }
+
+    bool ok = false;
+    const double speed = parser.value(speedOption).toDouble(&ok);
+    if (!ok || speed < 0) {
+        qWarning() << "Invalid speed" << parser.value(speedOption);
+        return 1;
+    }
+
+    QVector<BusCapture::Frame> frames;
+    if (!BusCapture::readLog(parser.positionalArguments().first(), frames)) {
+        return 1;
+    }
+
+    ReplayServer server(frames, speed);
+    if (!server.listen()) {
+        return 1;
+    }
+
+    return app.exec();
+}
+
+#include "replayserver.moc"
@@ -21,6 +21,8 @@
 #include <QAbstractItemModel>
 #include <QQuickView>
 #include <QQmlEngine>
+#include <QJsonArray>
+#include <QUrlQuery>
 #include "../import/mycroftcontroller.h"
 #include "../import/abstractdelegate.h"
 #include "../import/filereader.h"
@@ -48,9 +50,11 @@ private Q_SLOTS:
     void testShowSecondGuiPage();
     void testEventsFromServer();
     void testEventsFromClient();
+    void testEventsFromFollowerView();
     void testMoveGuiPage();
     void testRemoveGuiPage();
     void testSwitchSkill();
+    void testResumeSession();
 
 private:
     AbstractDelegate *delegateForSkill(const QString &skill, const QUrl &url);
@@ -519,9 +523,10 @@ void ServerTest::testClientToServerData()
     propertySpy.wait();
     doc = QJsonDocument::fromJson(propertySpy[1].first().toString().toUtf8());
 
-    QCOMPARE(doc[QStringLiteral("type")], QStringLiteral("mycroft.session.delete"));
+    // deletes are batched with the sets in a single mycroft.session.set
+    QCOMPARE(doc[QStringLiteral("type")], QStringLiteral("mycroft.session.set"));
     QCOMPARE(doc[QStringLiteral("namespace")], QStringLiteral("mycroft.weather"));
-    QCOMPARE(doc[QStringLiteral("property")], QStringLiteral("to_delete"));
+    QCOMPARE(doc[QStringLiteral("deleted")].toArray(), QJsonArray({QStringLiteral("to_delete")}));
 }
 
 void ServerTest::testShowSecondGuiPage()
@@ -572,6 +577,16 @@ void ServerTest::testEventsFromServer()
     eventSpy.wait(1000);
     QCOMPARE(eventSpy.count(), 2);
 
+    //Once it lists the events it wants, only those are delivered
+    delegate->setGuiEvents(QStringList({QStringLiteral("show_alert")}));
+    m_guiWebSocket->sendTextMessage(QStringLiteral("{\"type\": \"mycroft.events.triggered\", \"namespace\": \"system\", \"event_name\": \"system.next\", \"data\": {}}"));
+    m_guiWebSocket->sendTextMessage(QStringLiteral("{\"type\": \"mycroft.events.triggered\", \"namespace\": \"mycroft.weather\", \"event_name\": \"show_alert\", \"data\": {}}"));
+
+    eventSpy.wait();
+    QCOMPARE(eventSpy.count(), 3);
+    QCOMPARE(eventSpy[2].first(), QStringLiteral("show_alert"));
+    delegate->setGuiEvents(QStringList());
+
     //view switches again to current
     m_guiWebSocket->sendTextMessage(QStringLiteral("{\"type\": \"mycroft.events.triggered\", \"namespace\": \"mycroft.weather\", \"event_name\": \"page_gained_focus\", \"data\": {\"number\": 0}}"));
 
@@ -614,6 +629,28 @@ void ServerTest::testEventsFromClient()
 }
 
 
+void ServerTest::testEventsFromFollowerView()
+{
+    //a view following the shared connection has no socket of its own
+    AbstractSkillView *follower = new AbstractSkillView;
+    follower->setSharedConnection(m_view);
+    QCOMPARE(follower->status(), MycroftController::Open);
+
+    QSignalSpy eventSpy(m_guiWebSocket, &QWebSocket::textMessageReceived);
+
+    follower->triggerEvent(QStringLiteral("mycroft.weather"), QStringLiteral("mycroft.weather.refresh_forecast"), QVariantMap({{QStringLiteral("when"), QStringLiteral("Tuesday")}}));
+    QVERIFY(eventSpy.wait());
+
+    QJsonDocument doc = QJsonDocument::fromJson(eventSpy.first().first().toString().toUtf8());
+    QCOMPARE(doc[QStringLiteral("type")], QStringLiteral("mycroft.events.triggered"));
+    QCOMPARE(doc[QStringLiteral("namespace")], QStringLiteral("mycroft.weather"));
+    QCOMPARE(doc[QStringLiteral("event_name")], QStringLiteral("mycroft.weather.refresh_forecast"));
+    QCOMPARE(doc[QStringLiteral("parameters")][QStringLiteral("when")], QStringLiteral("Tuesday"));
+
+    delete follower;
+}
+
+
 void ServerTest::testMoveGuiPage()
 {
     QUrl currentUrl = QUrl::fromLocalFile(QFINDTESTDATA("currentweather.qml"));
@@ -697,6 +734,49 @@ void ServerTest::testSwitchSkill()
     QTest::qWait(3000);
 }
 
+void ServerTest::testResumeSession()
+{
+    QSignalSpy skillInsertedSpy(m_view->activeSkills(), &ActiveSkillsModel::rowsInserted);
+    QSignalSpy skillRemovedSpy(m_view->activeSkills(), &ActiveSkillsModel::rowsRemoved);
+
+    //a server not able to resume starts a new session, resending everything
+    m_guiWebSocket->sendTextMessage(QStringLiteral("{\"type\": \"mycroft.session.sync\", \"session\": \"session1\", \"sequence\": 10, \"resumed\": false}"));
+    skillRemovedSpy.wait();
+    QCOMPARE(m_view->activeSkills()->rowCount(), 0);
+
+    m_guiWebSocket->sendTextMessage(QStringLiteral("{\"type\": \"mycroft.session.list.insert\", \"namespace\": \"mycroft.system.active_skills\", \"position\": 0, \"seq\": 11, \"data\": [{\"skill_id\": \"mycroft.weather\"}]}"));
+    skillInsertedSpy.wait();
+    QCOMPARE(m_view->activeSkills()->rowCount(), 1);
+
+    //the connection drops: the state survives and the client asks for what it missed
+    QSignalSpy newGuiConnectionSpy(m_guiServerSocket, &QWebSocketServer::newConnection);
+    m_guiWebSocket->close();
+    QVERIFY(newGuiConnectionSpy.wait());
+    m_guiWebSocket = m_guiServerSocket->nextPendingConnection();
+    QVERIFY(m_guiWebSocket);
+    QCOMPARE(m_view->activeSkills()->rowCount(), 1);
+
+    const QUrlQuery query(m_guiWebSocket->requestUrl());
+    QCOMPARE(query.queryItemValue(QStringLiteral("session")), QStringLiteral("session1"));
+    QCOMPARE(query.queryItemValue(QStringLiteral("sequence")), QStringLiteral("11"));
+
+    //resumed: messages already applied are skipped, the missed ones applied
+    skillInsertedSpy.clear();
+    m_guiWebSocket->sendTextMessage(QStringLiteral("{\"type\": \"mycroft.session.sync\", \"session\": \"session1\", \"sequence\": 12, \"resumed\": true}"));
+    m_guiWebSocket->sendTextMessage(QStringLiteral("{\"type\": \"mycroft.session.list.insert\", \"namespace\": \"mycroft.system.active_skills\", \"position\": 0, \"seq\": 11, \"data\": [{\"skill_id\": \"mycroft.weather\"}]}"));
+    m_guiWebSocket->sendTextMessage(QStringLiteral("{\"type\": \"mycroft.session.list.insert\", \"namespace\": \"mycroft.system.active_skills\", \"position\": 1, \"seq\": 12, \"data\": [{\"skill_id\": \"mycroft.wiki\"}]}"));
+    skillInsertedSpy.wait();
+    QCOMPARE(skillInsertedSpy.count(), 1);
+    QCOMPARE(m_view->activeSkills()->rowCount(), 2);
+    QCOMPARE(m_view->activeSkills()->data(m_view->activeSkills()->index(1, 0), ActiveSkillsModel::SkillId).toString(), QStringLiteral("mycroft.wiki"));
+
+    //a restarted server has a new session: everything is torn down
+    skillRemovedSpy.clear();
+    m_guiWebSocket->sendTextMessage(QStringLiteral("{\"type\": \"mycroft.session.sync\", \"session\": \"session2\", \"sequence\": 0, \"resumed\": true}"));
+    skillRemovedSpy.wait();
+    QCOMPARE(m_view->activeSkills()->rowCount(), 0);
+}
+
 QTEST_MAIN(ServerTest);
 
 #include "servertest.moc"
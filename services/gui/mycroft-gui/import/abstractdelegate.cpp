@@ -17,11 +17,45 @@
 
 #include "abstractdelegate.h"
 #include "mycroftcontroller.h"
+#include "componentcache.h"
+#include "guimetrics.h"
+#include "startuptracer.h"
 
 #include <QQmlEngine>
 #include <QQmlContext>
+#include <QQmlIncubator>
+#include <QMetaMethod>
 
 
+/**
+ * Creates a delegate for a DelegateLoader, either all at once or a bit
+ * per frame, depending on the incubation mode of its view
+ */
+class DelegateIncubator : public QQmlIncubator
+{
+public:
+    DelegateIncubator(DelegateLoader *loader, IncubationMode mode)
+        : QQmlIncubator(mode),
+          m_loader(loader)
+    {}
+
+protected:
+    void setInitialState(QObject *object) override
+    {
+        m_loader->setInitialState(object);
+    }
+
+    void statusChanged(Status status) override
+    {
+        if (status == Ready || status == Error) {
+            m_loader->incubationFinished();
+        }
+    }
+
+private:
+    DelegateLoader *m_loader;
+};
+
 DelegateLoader::DelegateLoader(AbstractSkillView *parent)
     : QObject(parent),
       m_view(parent)
@@ -29,12 +63,18 @@ DelegateLoader::DelegateLoader(AbstractSkillView *parent)
 
 DelegateLoader::~DelegateLoader()
 {
+    // Aborts an incubation still in progress
+    delete m_incubator;
+
     if (m_delegate) {
         m_delegate->deleteLater();
     }
+    if (m_component && m_componentCache) {
+        m_componentCache->release(m_delegateUrl);
+    }
 }
 
-void DelegateLoader::init(const QString skillId, const QUrl &delegateUrl)
+void DelegateLoader::init(const QString skillId, const QUrl &delegateUrl, bool deferred)
 {
     if (!m_skillId.isEmpty()) {
         qWarning() << "Init already called";
@@ -42,23 +82,59 @@ void DelegateLoader::init(const QString skillId, const QUrl &delegateUrl)
 
     m_skillId = skillId;
     m_delegateUrl = delegateUrl;
-    QQmlEngine *engine = qmlEngine(m_view);
+    m_loadTimer.start();
     //This class should be *ALWAYS* created from QML
-    Q_ASSERT(engine);
+    Q_ASSERT(qmlEngine(m_view));
+
+    m_componentCache = m_view->componentCache();
+    if (deferred) {
+        m_deferred = true;
+        m_componentCache->prewarm({delegateUrl});
+        setLoading(true);
+        return;
+    }
+
+    acquireComponent();
+}
+
+void DelegateLoader::load()
+{
+    if (!m_deferred) {
+        return;
+    }
 
-    m_component = new QQmlComponent(engine, delegateUrl, m_view);
+    m_deferred = false;
+    m_loadTimer.start();
+    acquireComponent();
+}
+
+bool DelegateLoader::isDeferred() const
+{
+    return m_deferred;
+}
+
+void DelegateLoader::acquireComponent()
+{
+    m_component = m_componentCache ? m_componentCache->acquire(m_delegateUrl) : nullptr;
+    if (!m_component) {
+        setLoading(false);
+        return;
+    }
 
     switch(m_component->status()) {
     case QQmlComponent::Error:
-        qWarning() << "ERROR Loading QML file" << delegateUrl;
+        qWarning() << "ERROR Loading QML file" << m_delegateUrl;
         for (auto err : m_component->errors()) {
             qWarning() << err.toString();
         }
+        setLoading(false);
         break;
     case QQmlComponent::Ready:
+        setLoading(true);
         createObject();
         break;
     case QQmlComponent::Loading:
+        setLoading(true);
         connect(m_component, &QQmlComponent::statusChanged, this, &DelegateLoader::createObject);
         break;
     default:
@@ -76,46 +152,114 @@ QUrl DelegateLoader::translationsUrl() const
 
 void DelegateLoader::createObject()
 {
+    // The component is shared with other loaders: only its first final status matters
+    if (m_incubator || m_component->isLoading()) {
+        return;
+    }
+
+    if (m_component->isError()) {
+        qWarning() << "ERROR Loading QML file" << m_delegateUrl;
+        for (auto err : m_component->errors()) {
+            qWarning() << err.toString();
+        }
+        setLoading(false);
+        return;
+    }
+
     QQmlContext *context = QQmlEngine::contextForObject(m_view);
     //This class should be *ALWAYS* created from QML
     Q_ASSERT(context);
 
-    QObject *guiObject = m_component->beginCreate(context);
-    m_delegate = qobject_cast<AbstractDelegate *>(guiObject);
-    if (m_component->isError()) {
+    m_incubator = new DelegateIncubator(this, m_view->incubationMode());
+    m_component->create(*m_incubator, context);
+}
+
+void DelegateLoader::setInitialState(QObject *object)
+{
+    AbstractDelegate *delegate = qobject_cast<AbstractDelegate *>(object);
+    // Anything else gets reported once incubation is over
+    if (!delegate) {
+        return;
+    }
+
+    delegate->setSkillId(m_skillId);
+    delegate->setQmlUrl(m_delegateUrl);
+    delegate->setSkillView(m_view);
+    delegate->setSessionData(m_view->sessionDataForSkill(m_skillId));
+}
+
+void DelegateLoader::incubationFinished()
+{
+    if (m_incubator->isError()) {
         qWarning() << "ERROR Loading QML file" << m_delegateUrl;
-        for (auto err : m_component->errors()) {
+        for (auto err : m_incubator->errors()) {
             qWarning() << err.toString();
         }
+        setLoading(false);
         return;
     }
 
+    QObject *guiObject = m_incubator->object();
+    m_delegate = qobject_cast<AbstractDelegate *>(guiObject);
+
     if (!m_delegate) {
         qWarning()<<"ERROR: QML gui" << guiObject << "not a Mycroft.AbstractDelegate instance";
         guiObject->deleteLater();
+        setLoading(false);
         return;
     }
 
+    // Like beginCreate(), the loader owns what it created, not the JS garbage collector
+    QQmlEngine::setObjectOwnership(m_delegate, QQmlEngine::CppOwnership);
     connect(m_delegate, &QObject::destroyed, this, &QObject::deleteLater);
 
-    m_delegate->setSkillId(m_skillId);
-    m_delegate->setQmlUrl(m_delegateUrl);
-    m_delegate->setSkillView(m_view);
-    m_delegate->setSessionData(m_view->sessionDataForSkill(m_skillId));
-    m_component->completeCreate();
+    GuiMetrics::instance()->recordDelegateCreation(m_skillId, m_loadTimer.nsecsElapsed());
+    StartupTracer::mark(QStringLiteral("first_delegate_created"));
+    StartupTracer::markNextFrame(m_view->window(), QStringLiteral("first_frame_swapped"));
 
     emit delegateCreated();
+    setLoading(false);
 
     if (m_focus) {
         m_delegate->forceActiveFocus((Qt::FocusReason)AbstractSkillView::ServerEventFocusReason);
     }
-};
+}
+
+bool DelegateLoader::isLoading() const
+{
+    return m_loading;
+}
+
+void DelegateLoader::setLoading(bool loading)
+{
+    if (m_loading == loading) {
+        return;
+    }
+
+    m_loading = loading;
+    emit loadingChanged();
+}
 
 AbstractDelegate *DelegateLoader::delegate()
 {
     return m_delegate;
 }
 
+QString DelegateLoader::skillId() const
+{
+    return m_skillId;
+}
+
+QUrl DelegateLoader::delegateUrl() const
+{
+    return m_delegateUrl;
+}
+
+AbstractSkillView *DelegateLoader::view() const
+{
+    return m_view;
+}
+
 void DelegateLoader::setFocus(bool focus)
 {
     m_focus = focus;
@@ -139,6 +283,9 @@ AbstractDelegate::AbstractDelegate(QQuickItem *parent)
 
 AbstractDelegate::~AbstractDelegate()
 {
+    if (m_skillView) {
+        m_skillView->removeEventSubscriptions(this);
+    }
 }
 
 void AbstractDelegate::triggerGuiEvent(const QString &eventName, const QVariantMap &parameters)
@@ -256,6 +403,11 @@ void AbstractDelegate::componentComplete()
         }
     }
     QQuickItem::componentComplete();
+
+    m_completed = true;
+    if (m_skillView) {
+        m_skillView->updateEventSubscriptions(this);
+    }
 }
 
 bool AbstractDelegate::childMouseEventFilter(QQuickItem *item, QEvent *event)
@@ -553,4 +705,72 @@ QString AbstractDelegate::skillId() const
     return m_skillId;
 }
 
+bool AbstractDelegate::isRecyclable() const
+{
+    return m_recyclable;
+}
+
+QStringList AbstractDelegate::guiEvents() const
+{
+    return m_guiEvents;
+}
+
+void AbstractDelegate::setGuiEvents(const QStringList &events)
+{
+    if (m_guiEvents == events) {
+        return;
+    }
+
+    m_guiEvents = events;
+    // Before completion, the view isn't known yet
+    if (m_completed && m_skillView) {
+        m_skillView->updateEventSubscriptions(this);
+    }
+    emit guiEventsChanged();
+}
+
+bool AbstractDelegate::wantsGuiEvents() const
+{
+    static const QMetaMethod guiEventSignal = QMetaMethod::fromSignal(&AbstractDelegate::guiEvent);
+    return isSignalConnected(guiEventSignal);
+}
+
+bool AbstractDelegate::isSuspended() const
+{
+    return m_suspended;
+}
+
+void AbstractDelegate::setSuspended(bool suspended)
+{
+    if (m_suspended == suspended) {
+        return;
+    }
+
+    m_suspended = suspended;
+
+    if (suspended) {
+        // Animation and friends have running, AnimatedImage and AnimatedSprite playing
+        for (QObject *object : findChildren<QObject *>()) {
+            const QMetaObject *mo = object->metaObject();
+            if (mo->indexOfProperty("paused") < 0 || object->property("paused").toBool()) {
+                continue;
+            }
+            const char *activeProperty = mo->indexOfProperty("running") >= 0 ? "running" : "playing";
+            if (object->property(activeProperty).toBool()) {
+                object->setProperty("paused", true);
+                m_pausedAnimations << object;
+            }
+        }
+    } else {
+        for (const auto &object : m_pausedAnimations) {
+            if (object) {
+                object->setProperty("paused", false);
+            }
+        }
+        m_pausedAnimations.clear();
+    }
+
+    emit suspendedChanged();
+}
+
 #include "moc_abstractdelegate.cpp"
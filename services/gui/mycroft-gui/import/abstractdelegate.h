@@ -21,11 +21,13 @@
 #include <QQmlParserStatus>
 #include <QQmlPropertyMap>
 #include <QPointer>
+#include <QElapsedTimer>
 
 #include "sessiondatamap.h"
 #include "abstractskillview.h"
 
 class MycroftController;
+class DelegateIncubator;
 
 class DelegateLoader : public QObject {
     Q_OBJECT
@@ -33,25 +35,54 @@ public:
     DelegateLoader(AbstractSkillView *parent);
     ~DelegateLoader();
 
-    void init(const QString skillId, const QUrl &url);
+    /**
+     * A deferred loader only compiles its page in the background, until load() creates it
+     */
+    void init(const QString skillId, const QUrl &url, bool deferred = false);
+    void load();
+    bool isDeferred() const;
+
     AbstractDelegate *delegate();
 
+    QString skillId() const;
+    QUrl delegateUrl() const;
+    AbstractSkillView *view() const;
+
     void setFocus(bool focus);
 
     QUrl translationsUrl() const;
 
+    /**
+     * True while the delegate is deferred, being compiled or incubated
+     */
+    bool isLoading() const;
+
 Q_SIGNALS:
     void delegateCreated();
+    void loadingChanged();
 
 private:
+    void acquireComponent();
     void createObject();
+    void setInitialState(QObject *object);
+    void incubationFinished();
+    void setLoading(bool loading);
 
     QString m_skillId;
     QUrl m_delegateUrl;
     bool m_focus = false;
+    // Owned by the ComponentCache of the view
     QQmlComponent *m_component = nullptr;
+    QPointer<ComponentCache> m_componentCache;
+    DelegateIncubator *m_incubator = nullptr;
+    bool m_deferred = false;
+    bool m_loading = false;
+    // Since the page was asked for
+    QElapsedTimer m_loadTimer;
     AbstractSkillView *m_view;
     QPointer <AbstractDelegate> m_delegate;
+
+    friend class DelegateIncubator;
 };
 
 class AbstractDelegate: public QQuickItem
@@ -69,6 +100,28 @@ class AbstractDelegate: public QQuickItem
      */
     Q_PROPERTY(bool fillWidth MEMBER m_fillWidth NOTIFY fillWidthChanged)
 
+    /**
+     * When true, once removed the delegate may be kept and shown again the next time
+     * the skill shows the same page, instead of creating a new one. (default false)
+     * Only set it if the delegate resets whatever state it has in onRecycled.
+     * @see AbstractSkillView::delegatePoolSize
+     */
+    Q_PROPERTY(bool recyclable MEMBER m_recyclable NOTIFY recyclableChanged)
+
+    /**
+     * Names of the events, of the skill or system ones, this delegate wants in guiEvent.
+     * When empty, the default, every event is delivered.
+     * Listing them avoids waking up the delegate for events it doesn't handle.
+     */
+    Q_PROPERTY(QStringList guiEvents READ guiEvents WRITE setGuiEvents NOTIFY guiEventsChanged)
+
+    /**
+     * True while the device is idle and the delegate isn't visible: its running
+     * animations are paused. Anything else running, like a Timer, can bind to it.
+     * @see MycroftController::powerState
+     */
+    Q_PROPERTY(bool suspended READ isSuspended NOTIFY suspendedChanged)
+
     /**
      * The idle time after Mycroft stopped talking  before the delegate wants to return to the resting face expressed in milliseconds.
      * The view may or may not follow this.
@@ -193,6 +246,22 @@ public:
      */
     void setSkillId(const QString &skillId);
 
+    bool isRecyclable() const;
+
+    QStringList guiEvents() const;
+    void setGuiEvents(const QStringList &events);
+
+    bool isSuspended() const;
+    /**
+     * Pauses the animations running below the delegate, or resumes the ones it paused
+     */
+    void setSuspended(bool suspended);
+
+    /**
+     * @returns true if anything, like an onGuiEvent handler, is connected to guiEvent
+     */
+    bool wantsGuiEvents() const;
+
 public Q_SLOTS:
     /**
      * Trigger an event either for this skill or a system one
@@ -229,6 +298,17 @@ Q_SIGNALS:
      */
     void guiEvent(const QString &eventName, const QVariantMap &data);
 
+    /**
+     * Emitted when a recyclable delegate has been removed and kept for reuse:
+     * transient state, like scroll positions or running animations, should be reset here
+     */
+    void recycled();
+
+    /**
+     * Emitted when a recycled delegate is about to be shown again
+     */
+    void reused();
+
     //QML property notifiers
     void skillBackgroundSourceChanged();
     void skillBackgroundColorOverlayChanged();
@@ -238,6 +318,9 @@ Q_SIGNALS:
     void contentItemAutoHeightChanged();
     void timeoutChanged();
     void fillWidthChanged();
+    void recyclableChanged();
+    void guiEventsChanged();
+    void suspendedChanged();
     void leftPaddingChanged();
     void rightPaddingChanged();
     void topPaddingChanged();
@@ -275,6 +358,12 @@ private:
     QColor m_skillBackgroundColorOverlay = Qt::transparent;
     int m_timeout = 5000; //Completely arbitrary 5 seconds of timeout
     bool m_fillWidth = false;
+    bool m_recyclable = false;
+    bool m_completed = false;
+    QStringList m_guiEvents;
+    bool m_suspended = false;
+    // What setSuspended() paused, to resume only those
+    QList<QPointer<QObject>> m_pausedAnimations;
 
     /**
      * Padding adds a space between each edge of the content item and the background item, effectively controlling the size of the content item.
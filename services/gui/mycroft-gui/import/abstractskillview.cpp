@@ -19,9 +19,19 @@
 #include "abstractskillview.h"
 #include "activeskillsmodel.h"
 #include "abstractdelegate.h"
+#include "buscapture.h"
+#include "componentcache.h"
+#include "incubationcontroller.h"
 #include "sessiondatamap.h"
 #include "sessiondatamodel.h"
+#include "sessionsnapshot.h"
 #include "delegatesmodel.h"
+#include "globalsettings.h"
+#include "guimetrics.h"
+#include "messagedecoder.h"
+#include "prioritydispatcher.h"
+#include "skilltranslations.h"
+#include "startuptracer.h"
 
 #include <QWebSocket>
 #include <QUuid>
@@ -30,7 +40,14 @@
 #include <QJsonDocument>
 #include <QQmlContext>
 #include <QQmlEngine>
-#include <QTranslator>
+#include <QQuickWindow>
+#include <QUrlQuery>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+#include <QCborValue>
+#endif
+
+#include <algorithm>
 
 AbstractSkillView::AbstractSkillView(QQuickItem *parent)
     : QQuickItem(parent),
@@ -44,22 +61,46 @@ AbstractSkillView::AbstractSkillView(QQuickItem *parent)
 
     connect(m_guiWebSocket, &QWebSocket::connected, this,
             [this] () {
+                StartupTracer::mark(QStringLiteral("gui_socket_open"));
                 m_reconnectTimer.stop();
+                m_reconnectBackoff.reset();
+                m_reconnectTimer.setInterval(m_reconnectBackoff.next());
+                onGuiConnectionOpened();
                 emit statusChanged();
             });
 
     connect(m_guiWebSocket, &QWebSocket::disconnected, this, &AbstractSkillView::closed);
-
-    connect(m_guiWebSocket, &QWebSocket::disconnected, this, [this]() {
-        m_activeSkillsModel->removeRows(0, m_activeSkillsModel->rowCount());
-    });
+    connect(m_guiWebSocket, &QWebSocket::disconnected, this, &AbstractSkillView::onGuiConnectionLost);
 
     connect(m_guiWebSocket, &QWebSocket::stateChanged, this,
             [this] (QAbstractSocket::SocketState state) {
                 emit statusChanged();
             });
 
-    connect(m_guiWebSocket, &QWebSocket::textMessageReceived, this, &AbstractSkillView::onGuiSocketMessageReceived);
+    BusCapture::attach(m_guiWebSocket, BusCapture::GuiChannel);
+
+    // Everything on the gui socket is bulk work, applied in order in time slices
+    if (m_controller->settings()->threadedDecoding()) {
+        m_decoder = new MessageDecoder(false, this);
+        connect(m_guiWebSocket, &QWebSocket::textMessageReceived, m_decoder, &MessageDecoder::postText);
+        connect(m_guiWebSocket, &QWebSocket::binaryMessageReceived, m_decoder, &MessageDecoder::postBinary);
+        connect(m_decoder, &MessageDecoder::messageDecoded, this, [this](const DecodedMessage &decoded) {
+            PriorityDispatcher::instance()->post(PriorityDispatcher::Bulk, this, [this, decoded]() {
+                receiveGuiMessage(decoded);
+            });
+        });
+    } else {
+        connect(m_guiWebSocket, &QWebSocket::textMessageReceived, this, [this](const QString &message) {
+            PriorityDispatcher::instance()->post(PriorityDispatcher::Bulk, this, [this, message]() {
+                onGuiSocketMessageReceived(message);
+            });
+        });
+        connect(m_guiWebSocket, &QWebSocket::binaryMessageReceived, this, [this](const QByteArray &message) {
+            PriorityDispatcher::instance()->post(PriorityDispatcher::Bulk, this, [this, message]() {
+                onGuiSocketBinaryMessageReceived(message);
+            });
+        });
+    }
 
     connect(m_guiWebSocket, &QWebSocket::stateChanged, this,
             [this](QAbstractSocket::SocketState socketState) {
@@ -87,23 +128,54 @@ AbstractSkillView::AbstractSkillView(QQuickItem *parent)
                 }
             });
 
-    // Reconnect timer
-    m_reconnectTimer.setInterval(1000);
+    // Reconnect timer, every failed attempt waits longer before the next one
+    m_reconnectTimer.setInterval(m_reconnectBackoff.next());
     connect(&m_reconnectTimer, &QTimer::timeout, this, [this]() {
+        m_reconnectTimer.setInterval(m_reconnectBackoff.next());
         m_guiWebSocket->close();
-        m_guiWebSocket->open(m_url);
+        openGuiSocket();
     });
 
+    // Gave up waiting for the session to be resumed
+    m_resumeTimer.setSingleShot(true);
+    connect(&m_resumeTimer, &QTimer::timeout, this, &AbstractSkillView::resetSession);
+
+    // Coalesces the changes between snapshots
+    m_snapshotTimer.setSingleShot(true);
+    connect(&m_snapshotTimer, &QTimer::timeout, this, &AbstractSkillView::writeSnapshot);
+
+    connect(SkillTranslations::instance(), &SkillTranslations::catalogLoaded, this,
+            [this](const QString &skillId) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+                QQmlEngine *engine = qmlEngine(this);
+                if (engine && m_activeSkillsModel->containsSkill(skillId)) {
+                    engine->retranslate();
+                }
+#else
+                Q_UNUSED(skillId)
+#endif
+            });
+
     // Trim components cache timer
     m_trimComponentsTimer.setInterval(100);
     m_trimComponentsTimer.setSingleShot(true);
     connect(&m_trimComponentsTimer, &QTimer::timeout, this, [this]() {
-        QQmlEngine *engine = qmlEngine(this);
-        if (engine) {
-            engine->clearComponentCache();
+        if (m_componentCache) {
+            m_componentCache->trim();
         }
     });
 
+    // Batched session data changes, when a frame can't be waited for
+    m_batchTimer.setSingleShot(true);
+    connect(&m_batchTimer, &QTimer::timeout, this, &AbstractSkillView::flushBatchedChanges);
+
+    // Memory accounting, for GuiMetrics and memoryBudget
+    m_memoryTimer.setInterval(10000);
+    connect(&m_memoryTimer, &QTimer::timeout, this, &AbstractSkillView::updateMemoryUsage);
+    m_memoryTimer.start();
+
+    connect(m_controller, &MycroftController::powerStateChanged, this, &AbstractSkillView::updatePowerState);
+
     connect(m_controller, &MycroftController::utteranceManagedBySkill, this,
         [this](const QString &skillId) {
             m_activeSkillsModel->checkGuiActivation(skillId);
@@ -131,8 +203,174 @@ void AbstractSkillView::setUrl(const QUrl &url)
     //don't connect if the controller is offline
     if (m_controller->status() == MycroftController::Open) {
         m_guiWebSocket->close();
-        m_guiWebSocket->open(url);
+        openGuiSocket();
+    }
+}
+
+void AbstractSkillView::openGuiSocket()
+{
+    QUrl url(m_url);
+
+    if (!m_session.isEmpty()) {
+        // Asks the server for only what was missed since the last message applied
+        QUrlQuery query(url);
+        query.addQueryItem(QStringLiteral("session"), m_session);
+        query.addQueryItem(QStringLiteral("sequence"), QString::number(m_lastSequence));
+        url.setQuery(query);
+    }
+
+    m_guiWebSocket->open(url);
+}
+
+void AbstractSkillView::onGuiConnectionOpened()
+{
+    // The server may have nothing to send to replace the snapshot
+    if (m_stale && !m_resumeTimer.isActive()) {
+        m_resumeTimer.start(m_resumeTimeout);
+    }
+}
+
+void AbstractSkillView::onGuiConnectionLost()
+{
+    // Without a session to resume the server will send everything again
+    if (m_session.isEmpty() || m_resumeTimeout <= 0) {
+        resetSession();
+    } else if (!m_resumeTimer.isActive()) {
+        m_resumeTimer.start(m_resumeTimeout);
+    }
+}
+
+void AbstractSkillView::setSharedConnection(AbstractSkillView *owner)
+{
+    for (const auto &connection : m_ownerConnections) {
+        disconnect(connection);
+    }
+    m_ownerConnections.clear();
+
+    m_sharedConnection = true;
+    m_connectionOwner = owner;
+
+    if (owner) {
+        // Follows the connection of owner as if it was its own
+        m_ownerConnections << connect(owner, &AbstractSkillView::statusChanged, this, &AbstractSkillView::statusChanged)
+                           << connect(owner, &AbstractSkillView::closed, this, &AbstractSkillView::closed)
+                           << connect(owner->m_guiWebSocket, &QWebSocket::connected, this, &AbstractSkillView::onGuiConnectionOpened)
+                           << connect(owner->m_guiWebSocket, &QWebSocket::disconnected, this, &AbstractSkillView::onGuiConnectionLost);
+    }
+
+    emit statusChanged();
+}
+
+void AbstractSkillView::resetSession()
+{
+    m_resumeTimer.stop();
+    m_session.clear();
+    m_lastSequence = 0;
+    m_activeSkillsModel->removeRows(0, m_activeSkillsModel->rowCount());
+    setStale(false);
+}
+
+QString AbstractSkillView::snapshotPath() const
+{
+    return SessionSnapshot::defaultPath(objectName().isEmpty() ? QStringLiteral("skillview") : objectName());
+}
+
+QList<QJsonObject> AbstractSkillView::snapshotMessages() const
+{
+    QList<QJsonObject> messages;
+
+    for (int i = 0; i < m_activeSkillsModel->rowCount(); ++i) {
+        const QString skillId = m_activeSkillsModel->data(m_activeSkillsModel->index(i, 0), ActiveSkillsModel::SkillId).toString();
+
+        messages << QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.list.insert")},
+                                 {QStringLiteral("namespace"), QStringLiteral("mycroft.system.active_skills")},
+                                 {QStringLiteral("position"), i},
+                                 {QStringLiteral("data"), QJsonArray({QJsonObject({{QStringLiteral("skill_id"), skillId}})})}});
+
+        // Data first, so that the pages have it when created
+        SessionDataMap *map = m_skillData.value(skillId);
+        if (map) {
+            QJsonObject data;
+            for (const QString &key : map->keys()) {
+                const QVariant value = map->value(key);
+                SessionDataModel *dm = value.value<SessionDataModel *>();
+                if (!dm) {
+                    data[key] = map->jsonValue(key);
+                    continue;
+                }
+
+                QJsonArray rows;
+                for (const QVariantMap &row : dm->rows()) {
+                    rows.append(QJsonObject::fromVariantMap(row));
+                }
+                messages << QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.list.insert")},
+                                         {QStringLiteral("namespace"), skillId},
+                                         {QStringLiteral("property"), key},
+                                         {QStringLiteral("position"), 0},
+                                         {QStringLiteral("data"), rows}});
+            }
+
+            if (!data.isEmpty()) {
+                messages << QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.session.set")},
+                                         {QStringLiteral("namespace"), skillId},
+                                         {QStringLiteral("data"), data}});
+            }
+        }
+
+        DelegatesModel *delegatesModel = m_activeSkillsModel->delegatesModelForSkill(skillId);
+        if (delegatesModel && delegatesModel->rowCount() > 0) {
+            QJsonArray pages;
+            for (const QUrl &url : delegatesModel->delegateUrls()) {
+                pages.append(QJsonObject({{QStringLiteral("url"), url.toString()}}));
+            }
+            messages << QJsonObject({{QStringLiteral("type"), QStringLiteral("mycroft.gui.list.insert")},
+                                     {QStringLiteral("namespace"), skillId},
+                                     {QStringLiteral("position"), 0},
+                                     {QStringLiteral("data"), pages}});
+        }
     }
+
+    return messages;
+}
+
+void AbstractSkillView::writeSnapshot()
+{
+    // Don't overwrite a good snapshot with what was restored from it
+    if (m_snapshotInterval <= 0 || m_stale) {
+        return;
+    }
+
+    SessionSnapshot::writeFileAsync(snapshotPath(), SessionSnapshot::serialize(snapshotMessages()));
+}
+
+void AbstractSkillView::restoreSnapshot()
+{
+    if (m_snapshotInterval <= 0 || m_activeSkillsModel->rowCount() > 0) {
+        return;
+    }
+
+    const QList<QJsonObject> messages = SessionSnapshot::read(snapshotPath());
+    if (messages.isEmpty()) {
+        return;
+    }
+
+    m_restoringSnapshot = true;
+    for (const QJsonObject &message : messages) {
+        handleGuiMessage(message);
+    }
+    m_restoringSnapshot = false;
+
+    setStale(m_activeSkillsModel->rowCount() > 0);
+}
+
+void AbstractSkillView::setStale(bool stale)
+{
+    if (m_stale == stale) {
+        return;
+    }
+
+    m_stale = stale;
+    emit staleChanged();
 }
 
 QString AbstractSkillView::id() const
@@ -140,9 +378,69 @@ QString AbstractSkillView::id() const
     return m_id;
 }
 
+QStringList AbstractSkillView::supportedFrameFormats()
+{
+    return {QStringLiteral("json"),
+            QStringLiteral("binary_json"),
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+            QStringLiteral("cbor")
+#endif
+    };
+}
+
+AbstractSkillView::FrameFormat AbstractSkillView::frameFormat() const
+{
+    return m_frameFormat;
+}
+
+void AbstractSkillView::setFrameFormat(const QString &format)
+{
+    if (format.isEmpty() || format == QLatin1String("json")) {
+        m_frameFormat = TextJson;
+    } else if (format == QLatin1String("binary_json")) {
+        m_frameFormat = BinaryJson;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    } else if (format == QLatin1String("cbor")) {
+        m_frameFormat = Cbor;
+#endif
+    } else {
+        qWarning() << "Unsupported frame format" << format << "falling back to json";
+        m_frameFormat = TextJson;
+    }
+}
+
+void AbstractSkillView::sendGuiMessage(const QJsonObject &message)
+{
+    if (m_connectionOwner) {
+        m_connectionOwner->sendGuiMessage(message);
+        return;
+    }
+
+    QByteArray frame;
+    switch (m_frameFormat) {
+    case BinaryJson:
+        frame = QJsonDocument(message).toJson(QJsonDocument::Compact);
+        break;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    case Cbor:
+        frame = QCborValue::fromJsonValue(message).toCbor();
+        break;
+#endif
+    default: {
+        const QString text = QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact));
+        BusCapture::recordOutbound(BusCapture::GuiChannel, text);
+        m_guiWebSocket->sendTextMessage(text);
+        return;
+    }
+    }
+
+    BusCapture::recordOutbound(BusCapture::GuiChannel, frame);
+    m_guiWebSocket->sendBinaryMessage(frame);
+}
+
 void AbstractSkillView::triggerEvent(const QString &skillId, const QString &eventName, const QVariantMap &parameters)
 {
-    if (m_guiWebSocket->state() != QAbstractSocket::ConnectedState) {
+    if (status() != MycroftController::Open) {
         qWarning() << "Error: Mycroft gui connection not open!";
         return;
     }
@@ -153,13 +451,12 @@ void AbstractSkillView::triggerEvent(const QString &skillId, const QString &even
     root[QStringLiteral("event_name")] = eventName;
     root[QStringLiteral("parameters")] = QJsonObject::fromVariantMap(parameters);
 
-    QJsonDocument doc(root);
-    m_guiWebSocket->sendTextMessage(QString::fromUtf8(doc.toJson()));
+    sendGuiMessage(root);
 }
 
-void AbstractSkillView::writeProperties(const QString &skillId, const QVariantMap &data)
+void AbstractSkillView::writeProperties(const QString &skillId, const QVariantMap &data, const QStringList &deleted)
 {
-    if (m_guiWebSocket->state() != QAbstractSocket::ConnectedState) {
+    if (status() != MycroftController::Open) {
         qWarning() << "Error: Mycroft gui connection not open!";
         return;
     }
@@ -168,14 +465,16 @@ void AbstractSkillView::writeProperties(const QString &skillId, const QVariantMa
     root[QStringLiteral("type")] = QStringLiteral("mycroft.session.set");
     root[QStringLiteral("namespace")] = skillId;
     root[QStringLiteral("data")] = QJsonObject::fromVariantMap(data);
+    if (!deleted.isEmpty()) {
+        root[QStringLiteral("deleted")] = QJsonArray::fromStringList(deleted);
+    }
 
-    QJsonDocument doc(root);
-    m_guiWebSocket->sendTextMessage(QString::fromUtf8(doc.toJson()));
+    sendGuiMessage(root);
 }
 
 void AbstractSkillView::deleteProperty(const QString &skillId, const QString &property)
 {
-    if (m_guiWebSocket->state() != QAbstractSocket::ConnectedState) {
+    if (status() != MycroftController::Open) {
         qWarning() << "Error: Mycroft gui connection not open!";
         return;
     }
@@ -185,12 +484,15 @@ void AbstractSkillView::deleteProperty(const QString &skillId, const QString &pr
     root[QStringLiteral("namespace")] = skillId;
     root[QStringLiteral("property")] = property;
 
-    QJsonDocument doc(root);
-    m_guiWebSocket->sendTextMessage(QString::fromUtf8(doc.toJson()));
+    sendGuiMessage(root);
 }
 
 MycroftController::Status AbstractSkillView::status() const
 {
+    if (m_connectionOwner) {
+        return m_connectionOwner->status();
+    }
+
     if (m_reconnectTimer.isActive()) {
         return MycroftController::Connecting;
     }
@@ -217,590 +519,1270 @@ ActiveSkillsModel *AbstractSkillView::activeSkills() const
     return m_activeSkillsModel;
 }
 
-SessionDataMap *AbstractSkillView::sessionDataForSkill(const QString &skillId)
+ComponentCache *AbstractSkillView::componentCache()
 {
-    SessionDataMap *map = nullptr;
-
-    if (m_skillData.contains(skillId)) {
-        map = m_skillData[skillId];
-    } else if (m_activeSkillsModel->skillIndex(skillId).isValid()) {
-        map = new SessionDataMap(skillId, this);
-        m_skillData[skillId] = map;
+    if (!m_componentCache) {
+        // The engine is only known once the view has been created from QML
+        m_componentCache = new ComponentCache(qmlEngine(this), this);
+        m_componentCache->setBudget(m_controller->settings()->componentCacheSize());
     }
 
-    return map;
+    return m_componentCache;
 }
 
-QList<QVariantMap> variantListToOrderedMap(const QVariantList &data)
+QQmlIncubator::IncubationMode AbstractSkillView::incubationMode()
 {
-    QList<QVariantMap> ordMap;
+    QQmlEngine *engine = qmlEngine(this);
+    if (m_incubationBudget <= 0 || !engine) {
+        return QQmlIncubator::Synchronous;
+    }
 
-    QStringList roleNames;
+    if (!m_incubationController) {
+        m_incubationController = new FrameIncubationController(this);
+        m_incubationController->setBudget(m_incubationBudget);
+        m_incubationController->setWindow(window());
+        connect(this, &QQuickItem::windowChanged, m_incubationController, &FrameIncubationController::setWindow);
+    }
 
-    for (const auto &item : data) {
-        if (!item.canConvert<QVariantMap>()) {
-            qWarning() << "Error: Array data structure corrupted: " << data;
-            return ordMap;
-        }
-        const auto &map = item.value<QVariantMap>();
-        if (roleNames.isEmpty()) {
-            roleNames = map.keys();
-        } else if (roleNames != map.keys()) {
-            qWarning() << "WARNING: Item with a wrong set of roles encountered, some roles will be inaccessible from QML, expected: " << roleNames << "Encountered: " << map.keys();
-        }
-        ordMap << map;
+    // Replaces the controller of the window, if any: it has no budget that can be tuned
+    if (engine->incubationController() != m_incubationController) {
+        engine->setIncubationController(m_incubationController);
     }
 
-    return ordMap;
+    return QQmlIncubator::Asynchronous;
 }
 
-QStringList jsonModelToStringList(const QString &key, const QJsonValue &data)
+void AbstractSkillView::componentComplete()
 {
-    QStringList items;
+    QQuickItem::componentComplete();
 
-    if (!data.isArray()) {
-        qWarning() << "Error: Model data is not an Array" << data;
-        return items;
+    // Before the socket connects, to have something to show right away
+    restoreSnapshot();
+
+    const QStringList prewarm = m_controller->settings()->prewarmDelegates();
+    if (prewarm.isEmpty()) {
+        return;
     }
 
-    const auto &array = data.toArray();
-    for (const auto &item : array) {
-        if (!item.isObject()) {
-            qWarning() << "Error: Array data structure currupted: " << data;
-            items.clear();
-            return items;
-        }
-        const auto &obj = item.toObject();
-        if (obj.keys().length() != 1 || !obj.contains(key)) {
-            qWarning() << "Error: Item with a wrong key encountered, expected: " << key << "Encountered: " << obj.keys();
-            items.clear();
-            return items;
+    // Compiled asynchronously, after the rest of the startup
+    QTimer::singleShot(0, this, [this, prewarm]() {
+        QList<QUrl> urls;
+        for (const QString &delegate : prewarm) {
+            urls << QUrl::fromUserInput(delegate);
         }
-        const auto &value = obj.value(key);
-        if (!value.isString()) {
-            qWarning() << "Error: item in model not a string" << value;
+        componentCache()->prewarm(urls);
+    });
+}
+
+int AbstractSkillView::updateInterval() const
+{
+    return m_updateInterval;
+}
+
+void AbstractSkillView::setUpdateInterval(int interval)
+{
+    interval = qMax(-1, interval);
+    if (m_updateInterval == interval) {
+        return;
+    }
+
+    const bool batching = interval >= 0;
+    if (batching != (m_updateInterval >= 0)) {
+        for (auto *map : m_skillData) {
+            map->setBatchingEnabled(batching);
+            for (auto *dm : map->findChildren<SessionDataModel *>()) {
+                dm->setBatchingEnabled(batching);
+            }
         }
-        items << value.toString();
     }
 
-    return items;
+    m_updateInterval = interval;
+    emit updateIntervalChanged();
 }
 
-void AbstractSkillView::onGuiSocketMessageReceived(const QString &message)
+int AbstractSkillView::writeBackDelay() const
 {
-    QJsonParseError parseError;
-    auto doc = QJsonDocument::fromJson(message.toUtf8(), &parseError);
+    return m_writeBackDelay;
+}
 
-    if (doc.isEmpty()) {
-        qWarning() << "Empty or invalid JSON message arrived on the gui socket:" << message << "Error:" << parseError.errorString();
+void AbstractSkillView::setWriteBackDelay(int delay)
+{
+    delay = qMax(0, delay);
+    if (m_writeBackDelay == delay) {
         return;
     }
 
-    auto type = doc[QStringLiteral("type")].toString();
+    m_writeBackDelay = delay;
+    emit writeBackDelayChanged();
+}
 
-    if (type.isEmpty()) {
-        qWarning() << "Empty type in the JSON message on the gui socket";
+int AbstractSkillView::writeBackMaxLatency() const
+{
+    return m_writeBackMaxLatency;
+}
+
+void AbstractSkillView::setWriteBackMaxLatency(int latency)
+{
+    latency = qMax(0, latency);
+    if (m_writeBackMaxLatency == latency) {
         return;
     }
 
-    //qDebug() << "gui message type" << type;
+    m_writeBackMaxLatency = latency;
+    emit writeBackMaxLatencyChanged();
+}
 
-//BEGIN SKILLDATA
-    // The SkillData was updated by the server
-    if (type == QLatin1String("mycroft.session.set")) {
-        const QString skillId = doc[QStringLiteral("namespace")].toString();
-        const QVariantMap data = doc[QStringLiteral("data")].toVariant().toMap();
+int AbstractSkillView::incubationBudget() const
+{
+    return m_incubationBudget;
+}
 
-        if (skillId.isEmpty()) {
-            qWarning() << "Empty skill_id in mycroft.session.set";
-            return;
-        }
-        if (!m_activeSkillsModel->skillIndex(skillId).isValid()) {
-            qWarning() << "Invalid skill_id in mycroft.session.set:" << skillId;
-            return;
-        }
-        if (data.isEmpty()) {
-            qWarning() << "Empty data in mycroft.session.set";
-            return;
-        }
+void AbstractSkillView::setIncubationBudget(int budget)
+{
+    budget = qMax(0, budget);
+    if (m_incubationBudget == budget) {
+        return;
+    }
 
-        //we already checked, assume *map is valid
-        SessionDataMap *map = sessionDataForSkill(skillId);
-        if (!map) {
-            return;
-        }
-        QVariantMap::const_iterator i;
-        for (i = data.constBegin(); i != data.constEnd(); ++i) {
-            //insert it as a model
-            QList<QVariantMap> list = variantListToOrderedMap(i.value().value<QVariantList>());
-            SessionDataModel *dm = map->value(i.key()).value<SessionDataModel *>();
+    m_incubationBudget = budget;
+    if (m_incubationController && budget > 0) {
+        m_incubationController->setBudget(budget);
+    }
+    emit incubationBudgetChanged();
+}
 
-            if (!list.isEmpty()) {
-                if (!dm) {
-                    dm = new SessionDataModel(map);
-                    map->insertAndNotify(i.key(), QVariant::fromValue(dm));
-                } else {
-                    dm->clear();
-                }
-                dm->insertData(0, list);
+int AbstractSkillView::delegatePoolSize() const
+{
+    return m_delegatePoolSize;
+}
 
-            //insert it as is.
-            } else {
-                if (dm) {
-                    dm->deleteLater();
-                }
-                map->insertAndNotify(i.key(), i.value());
-            }
-            //qDebug() << "             " << i.key() << " = " << i.value();
-        }
+int AbstractSkillView::snapshotInterval() const
+{
+    return m_snapshotInterval;
+}
 
-    // The SkillData was removed by the server
-    } else if (type == QLatin1String("mycroft.session.delete")) {
-        const QString skillId = doc[QStringLiteral("namespace")].toString();
-        const QString property = doc[QStringLiteral("property")].toString();
-        if (skillId.isEmpty()) {
-            qWarning() << "No skill_id provided in mycroft.session.delete";
-            return;
-        }
-        if (!m_activeSkillsModel->skillIndex(skillId).isValid()) {
-            qWarning() << "Invalid skill_id in mycroft.session.delete:" << skillId;
-            return;
-        }
-        if (property.isEmpty()) {
-            qWarning() << "No property provided in mycroft.session.delete";
-            return;
-        }
+void AbstractSkillView::setSnapshotInterval(int interval)
+{
+    interval = qMax(0, interval);
+    if (m_snapshotInterval == interval) {
+        return;
+    }
 
-        SessionDataMap *map = sessionDataForSkill(skillId);
-        SessionDataModel *dm = map->value(property).value<SessionDataModel *>();
-        map->clearAndNotify(property);
-        //a model will need to be manually deleted
-        if (dm) {
-            dm->deleteLater();
-        }
-//END SKILLDATA
+    m_snapshotInterval = interval;
+    if (m_snapshotInterval == 0) {
+        m_snapshotTimer.stop();
+    }
+    emit snapshotIntervalChanged();
+}
 
+bool AbstractSkillView::isStale() const
+{
+    return m_stale;
+}
 
-//BEGIN ACTIVESKILLS
-    // Insert new active skill
-    } else if (type == QLatin1String("mycroft.session.list.insert") && doc[QStringLiteral("namespace")].toString() == QLatin1String("mycroft.system.active_skills")) {
-        const int position = doc[QStringLiteral("position")].toInt();
+int AbstractSkillView::memoryBudget() const
+{
+    return m_memoryBudget;
+}
 
-        if (position < 0 || position > m_activeSkillsModel->rowCount()) {
-            qWarning() << "Error: Invalid position in mycroft.session.list.insert of mycroft.system.active_skills";
-            return;
-        }
+void AbstractSkillView::setMemoryBudget(int budget)
+{
+    budget = qMax(0, budget);
+    if (m_memoryBudget == budget) {
+        return;
+    }
 
-        const QStringList skillList = jsonModelToStringList(QStringLiteral("skill_id"), doc[QStringLiteral("data")]);
+    m_memoryBudget = budget;
+    if (m_memoryBudget > 0) {
+        updateMemoryUsage();
+    }
+    emit memoryBudgetChanged();
+}
 
-        if (skillList.isEmpty()) {
-            qWarning() << "Error: no valid skills received in mycroft.session.list.insert of mycroft.system.active_skills";
-            return;
-        }
+QVariantMap AbstractSkillView::memoryUsage()
+{
+    QVariantMap map;
 
-        m_activeSkillsModel->insertSkills(position, skillList);
+    const QHash<QString, SkillMemoryUsage> usage = skillMemoryUsage();
+    for (auto it = usage.constBegin(); it != usage.constEnd(); ++it) {
+        map[it.key()] = it.value().toVariantMap();
+    }
 
+    return map;
+}
 
-    // Active skill removed
-    } else if (type == QLatin1String("mycroft.session.list.remove") && doc[QStringLiteral("namespace")].toString() == QLatin1String("mycroft.system.active_skills")) {
-        const int position = doc[QStringLiteral("position")].toInt();
-        const int itemsNumber = doc[QStringLiteral("items_number")].toInt();
+int AbstractSkillView::pagePrefetch() const
+{
+    return m_pagePrefetch;
+}
 
-        if (position < 0 || position > m_activeSkillsModel->rowCount() - 1) {
-            qWarning() << "Error: Invalid position in mycroft.session.list.remove of mycroft.system.active_skills";
-            return;
-        }
-        if (itemsNumber < 0 || itemsNumber > m_activeSkillsModel->rowCount() - position) {
-            qWarning() << "Error: Invalid items_number in mycroft.session.list.remove of mycroft.system.active_skills";
-            return;
-        }
+void AbstractSkillView::setPagePrefetch(int pages)
+{
+    pages = qMax(-1, pages);
+    if (m_pagePrefetch == pages) {
+        return;
+    }
 
-        for (int i = 0; i < itemsNumber; ++i) {
+    m_pagePrefetch = pages;
+    // Pages now within reach
+    for (auto *delegatesModel : m_activeSkillsModel->delegatesModels()) {
+        delegatesModel->schedulePrefetch();
+    }
+    emit pagePrefetchChanged();
+}
+
+bool AbstractSkillView::canPrefetchPages() const
+{
+    if (m_memoryBudget <= 0) {
+        return true;
+    }
 
-            const QString skillId = m_activeSkillsModel->data(m_activeSkillsModel->index(position+i, 0)).toString();
+    qint64 total = 0;
+    for (const SkillMemoryUsage &skill : skillMemoryUsage()) {
+        total += skill.total();
+    }
+    return total < qint64(m_memoryBudget) * 1024 * 1024;
+}
 
-            if (!m_translatorsForSkill.contains(skillId)) {
-                QTranslator *translator = m_translatorsForSkill[skillId];
-                QCoreApplication::removeTranslator(translator);
-                m_translatorsForSkill.remove(skillId);
-                delete translator;
-            }
-            //TODO: do this after an animation
-            {
-                auto i = m_skillData.find(skillId);
-                if (i != m_skillData.end()) {
-                    i.value()->deleteLater();
-                    m_skillData.erase(i);
-                }
+QHash<QString, SkillMemoryUsage> AbstractSkillView::skillMemoryUsage() const
+{
+    QHash<QString, SkillMemoryUsage> usage;
+
+    for (auto it = m_skillData.constBegin(); it != m_skillData.constEnd(); ++it) {
+        SkillMemoryUsage &skill = usage[it.key()];
+        QList<SessionDataMap *> maps = it.value()->findChildren<SessionDataMap *>();
+        maps.prepend(it.value());
+        for (SessionDataMap *map : maps) {
+            for (const QString &key : map->keys()) {
+                skill.sessionBytes += key.size() * 2 + SkillMemoryUsage::variantSize(map->value(key));
             }
         }
-        m_activeSkillsModel->removeRows(position, itemsNumber);
-
-    // Active skill moved
-    } else if (type == QLatin1String("mycroft.session.list.move") && doc[QStringLiteral("namespace")].toString() == QLatin1String("mycroft.system.active_skills")) {
-        const int from = doc[QStringLiteral("from")].toInt();
-        const int to = doc[QStringLiteral("to")].toInt();
-        const int itemsNumber = doc[QStringLiteral("items_number")].toInt();
-
-        if (from < 0 || from > m_activeSkillsModel->rowCount() - 1) {
-            qWarning() << "Error: Invalid from position in mycroft.session.list.move of mycroft.system.active_skills";
-            return;
+        for (auto *dm : it.value()->findChildren<SessionDataModel *>()) {
+            skill.modelBytes += dm->estimatedBytes();
         }
-        if (to < 0 || to > m_activeSkillsModel->rowCount() - 1) {
-            qWarning() << "Error: Invalid to position in mycroft.session.list.move of mycroft.system.active_skills";
-            return;
+    }
+
+    // Shown, pooled and removed ones waiting to be deleted: all of them are ours
+    for (auto *loader : findChildren<DelegateLoader *>(QString(), Qt::FindDirectChildrenOnly)) {
+        const qint64 size = SkillMemoryUsage::itemTreeSize(loader->delegate());
+        if (size == 0) {
+            continue;
         }
-        if (itemsNumber <= 0 || itemsNumber > m_activeSkillsModel->rowCount() - from) {
-            qWarning() << "Error: Invalid items_number in mycroft.session.list.move of mycroft.system.active_skills";
-            return;
+        SkillMemoryUsage &skill = usage[loader->skillId()];
+        if (m_delegatePool.contains(loader)) {
+            skill.pooledBytes += size;
+        } else {
+            skill.delegateBytes += size;
         }
+    }
 
-        m_activeSkillsModel->moveRows(QModelIndex(), from, itemsNumber, QModelIndex(), to);
-//END ACTIVESKILLS
+    return usage;
+}
 
+QStringList AbstractSkillView::skillsByActivity() const
+{
+    QStringList skills;
 
-//BEGIN GUI MODEL
-    // Insert new new gui delegates
-    } else if (type == QLatin1String("mycroft.gui.list.insert")) {
-        const QString skillId = doc[QStringLiteral("namespace")].toString();
-        if (skillId.isEmpty()) {
-            qWarning() << "No skill_id provided in mycroft.gui.list.insert";
-            return;
+    // Not active anymore, only their pooled delegates are left
+    for (const auto &loader : m_delegatePool) {
+        if (loader && !m_activeSkillsModel->containsSkill(loader->skillId()) && !skills.contains(loader->skillId())) {
+            skills << loader->skillId();
         }
+    }
 
-        const int position = doc[QStringLiteral("position")].toInt();
+    // The first row is the most recently active skill
+    for (int i = m_activeSkillsModel->rowCount() - 1; i >= 0; --i) {
+        skills << m_activeSkillsModel->data(m_activeSkillsModel->index(i, 0), ActiveSkillsModel::SkillId).toString();
+    }
 
-        DelegatesModel *delegatesModel = m_activeSkillsModel->delegatesModelForSkill(skillId);
+    return skills;
+}
 
-        if (!delegatesModel) {
-            qWarning() << "Error: no delegates model for skill" << skillId;
-            return;
+void AbstractSkillView::dropPooledDelegates(const QString &skillId)
+{
+    for (int i = m_delegatePool.count() - 1; i >= 0; --i) {
+        DelegateLoader *loader = m_delegatePool[i];
+        if (!loader || loader->skillId() == skillId) {
+            m_delegatePool.removeAt(i);
+            if (loader) {
+                loader->deleteLater();
+            }
         }
-        if (position < 0 || position > delegatesModel->rowCount()) {
-            qWarning() << "Error: Invalid position in mycroft.gui.list.insert";
+    }
+}
+
+void AbstractSkillView::enforceMemoryBudget(QHash<QString, SkillMemoryUsage> &usage)
+{
+    const qint64 budget = qint64(m_memoryBudget) * 1024 * 1024;
+    qint64 total = 0;
+    for (const SkillMemoryUsage &skill : usage) {
+        total += skill.total();
+    }
+    if (total <= budget) {
+        return;
+    }
+
+    const QStringList skills = skillsByActivity();
+
+    // Pooled delegates first: they only make reopening a page faster
+    for (const QString &skillId : skills) {
+        if (total <= budget) {
             return;
         }
+        SkillMemoryUsage &skill = usage[skillId];
+        if (skill.pooledBytes > 0) {
+            dropPooledDelegates(skillId);
+            total -= skill.pooledBytes;
+            skill.pooledBytes = 0;
+        }
+    }
 
-        const QStringList delegateUrls = jsonModelToStringList(QStringLiteral("url"), doc[QStringLiteral("data")]);
+    // Removed pages don't need their grace period anymore,
+    // they are accounted again at the next update
+    for (const QString &skillId : skills) {
+        if (DelegatesModel *delegatesModel = m_activeSkillsModel->delegatesModelForSkill(skillId)) {
+            delegatesModel->purgeReleased();
+        }
+    }
 
-        if (delegateUrls.isEmpty()) {
-            qWarning() << "Error: no valid skills received in mycroft.gui.list.insert";
+    // Then the data of skills not showing anything, it comes back with their next pages
+    const QString currentSkill = m_activeSkillsModel->rowCount() > 0
+        ? m_activeSkillsModel->data(m_activeSkillsModel->index(0, 0), ActiveSkillsModel::SkillId).toString()
+        : QString();
+    for (const QString &skillId : skills) {
+        if (total <= budget) {
             return;
         }
+        if (skillId == currentSkill) {
+            continue;
+        }
+        DelegatesModel *delegatesModel = m_activeSkillsModel->delegatesModelForSkill(skillId);
+        if (delegatesModel && delegatesModel->rowCount() > 0) {
+            continue;
+        }
+        auto it = m_skillData.find(skillId);
+        if (it == m_skillData.end()) {
+            continue;
+        }
 
-        qWarning() << "Arrived mycroft.gui.list.insert, delegateUrls are" << delegateUrls;
+        qWarning() << "Memory budget exceeded, dropping the session data of" << skillId;
+        // Its pooled delegates would be left without data
+        dropPooledDelegates(skillId);
+        it.value()->deleteLater();
+        m_skillData.erase(it);
+
+        SkillMemoryUsage &skill = usage[skillId];
+        total -= skill.sessionBytes + skill.modelBytes + skill.pooledBytes;
+        skill.sessionBytes = 0;
+        skill.modelBytes = 0;
+        skill.pooledBytes = 0;
+    }
+}
 
-        QList <DelegateLoader *> delegateLoaders;
-        for (const auto &urlString : delegateUrls) {
-            const QUrl delegateUrl = QUrl::fromUserInput(urlString);
+void AbstractSkillView::updateMemoryUsage()
+{
+    GuiMetrics *metrics = GuiMetrics::instance();
+    if (!metrics->isEnabled() && m_memoryBudget <= 0) {
+        return;
+    }
 
-            if (!delegateUrl.isValid()) {
-                continue;
+    QHash<QString, SkillMemoryUsage> usage = skillMemoryUsage();
+    if (m_memoryBudget > 0) {
+        enforceMemoryBudget(usage);
+    }
+
+    if (metrics->isEnabled()) {
+        QVariantMap skills;
+        for (auto it = usage.constBegin(); it != usage.constEnd(); ++it) {
+            if (it.value().total() > 0) {
+                skills[it.key()] = it.value().toVariantMap();
             }
+        }
+        metrics->setMemoryUsage(objectName().isEmpty() ? m_id : objectName(), skills);
+    }
+}
 
-            DelegateLoader *loader = new DelegateLoader(this);
-            loader->init(skillId, delegateUrl);
+int AbstractSkillView::resumeTimeout() const
+{
+    return m_resumeTimeout;
+}
 
-            qWarning() << "Created a new DelegateLoader" << loader << "which will load" << delegateUrl << "for the skill" << skillId;
+void AbstractSkillView::setResumeTimeout(int timeout)
+{
+    timeout = qMax(0, timeout);
+    if (m_resumeTimeout == timeout) {
+        return;
+    }
 
-            if (!m_translatorsForSkill.contains(skillId)) {
-                QTranslator *translator = new QTranslator(this);
-                // TODO: download translations if skills are remote
-                if (translator->load(QLocale(), skillId, QLatin1String("_"), loader->translationsUrl().path())) {
-                    QCoreApplication::installTranslator(translator);
-                    m_translatorsForSkill[skillId] = translator;
-                } else {
-                    translator->deleteLater();
-                }
-            }
+    m_resumeTimeout = timeout;
+    emit resumeTimeoutChanged();
+}
 
-            connect(loader, &QObject::destroyed, &m_trimComponentsTimer, QOverload<>::of(&QTimer::start));
+void AbstractSkillView::setDelegatePoolSize(int size)
+{
+    size = qMax(0, size);
+    if (m_delegatePoolSize == size) {
+        return;
+    }
 
-            delegateLoaders << loader;
-        }
+    m_delegatePoolSize = size;
+    m_delegatePool.removeAll(nullptr);
+    while (m_delegatePool.count() > m_delegatePoolSize) {
+        m_delegatePool.takeFirst()->deleteLater();
+    }
+    emit delegatePoolSizeChanged();
+}
 
-        if (delegateLoaders.count() > 0) {
-            delegatesModel->insertDelegateLoaders(position, delegateLoaders);
-            //give the focus to the first
-            delegateLoaders.first()->setFocus(true);
-        }
+bool AbstractSkillView::recycleDelegateLoader(DelegateLoader *loader)
+{
+    AbstractDelegate *delegate = loader->delegate();
+    if (m_delegatePoolSize <= 0 || !delegate || !delegate->isRecyclable()) {
+        return false;
+    }
 
+    loader->setFocus(false);
+    delegate->setParentItem(nullptr);
+    emit delegate->recycled();
 
-    // Gui delegates removed
-    } else if (type == QLatin1String("mycroft.gui.list.remove")) {
-        const QString skillId = doc[QStringLiteral("namespace")].toString();
-        if (skillId.isEmpty()) {
-            qWarning() << "No skill_id provided in mycroft.gui.list.remove";
-            return;
-        }
+    m_delegatePool.removeAll(nullptr);
+    m_delegatePool << loader;
+    while (m_delegatePool.count() > m_delegatePoolSize) {
+        m_delegatePool.takeFirst()->deleteLater();
+    }
 
-        const int position = doc[QStringLiteral("position")].toInt();
-        const int itemsNumber = doc[QStringLiteral("items_number")].toInt();
+    return true;
+}
 
-        //TODO: try with lifecycle managed by the view?
-        DelegatesModel *delegatesModel = m_activeSkillsModel->delegatesModelForSkill(skillId);
-        if (!delegatesModel) {
-            qWarning() << "Error: no delegates model for skill" << skillId;
-            return;
+DelegateLoader *AbstractSkillView::reuseDelegateLoader(const QString &skillId, const QUrl &url)
+{
+    // Most recently recycled first: the most likely to be still warm
+    for (int i = m_delegatePool.count() - 1; i >= 0; --i) {
+        DelegateLoader *loader = m_delegatePool[i];
+        if (loader && loader->delegate() && loader->skillId() == skillId && loader->delegateUrl() == url) {
+            m_delegatePool.removeAt(i);
+            updateEventSubscriptions(loader->delegate());
+            emit loader->delegate()->reused();
+            return loader;
         }
+    }
 
-        if (position < 0 || position > delegatesModel->rowCount() - 1) {
-            qWarning() << "Error: Invalid position in mycroft.gui.list.remove";
-            return;
-        }
+    return nullptr;
+}
 
-        if (itemsNumber < 0 || itemsNumber > delegatesModel->rowCount()) {
-            qWarning() << "Error: Invalid items_number in mycroft.gui.list.remove";
-            return;
+void AbstractSkillView::scheduleBatchFlush()
+{
+    if (m_batchFlushScheduled) {
+        return;
+    }
+    m_batchFlushScheduled = true;
+
+    QQuickWindow *win = window();
+    if (m_controller->powerState() == MycroftController::Idle) {
+        // Nothing much to look at: changes get applied, and rendered, once a second
+        m_batchTimer.start(qMax(m_updateInterval, 1000));
+    } else if (m_updateInterval == 0 && win && win->isExposed()) {
+        m_frameConnection = connect(win, &QQuickWindow::afterAnimating, this, &AbstractSkillView::flushBatchedChanges);
+        win->update();
+        // Nothing guarantees a frame will actually be rendered
+        m_batchTimer.start(100);
+    } else {
+        m_batchTimer.start(m_updateInterval > 0 ? m_updateInterval : 16);
+    }
+}
+
+void AbstractSkillView::updatePowerState()
+{
+    const bool idle = m_controller->powerState() == MycroftController::Idle;
+
+    // Shown, pooled and removed ones alike
+    for (auto *loader : findChildren<DelegateLoader *>(QString(), Qt::FindDirectChildrenOnly)) {
+        AbstractDelegate *delegate = loader->delegate();
+        if (delegate) {
+            delegate->setSuspended(idle && !delegate->isVisible());
         }
+    }
 
-        delegatesModel->removeRows(position, itemsNumber);
+    // Woken up: what was batched for later is shown right away
+    if (!idle && m_batchFlushScheduled) {
+        flushBatchedChanges();
+    }
+}
 
-    // Gui delegates moved
-    } else if (type == QLatin1String("mycroft.gui.list.move")) {
+void AbstractSkillView::flushBatchedChanges()
+{
+    disconnect(m_frameConnection);
+    m_batchTimer.stop();
+    m_batchFlushScheduled = false;
 
-        const QString skillId = doc[QStringLiteral("namespace")].toString();
-        if (skillId.isEmpty()) {
-            qWarning() << "No skill_id provided in mycroft.gui.list.move";
-            return;
-        }
+    emit flushPendingChanges();
+}
 
-        const int from = doc[QStringLiteral("from")].toInt();
-        const int to = doc[QStringLiteral("to")].toInt();
-        const int itemsNumber = doc[QStringLiteral("items_number")].toInt();
+SessionDataModel *AbstractSkillView::createSessionDataModel(SessionDataMap *map)
+{
+    SessionDataModel *dm = new SessionDataModel(map);
+    dm->setBatchingEnabled(m_updateInterval >= 0);
+    connect(dm, &SessionDataModel::changesPending, this, &AbstractSkillView::scheduleBatchFlush);
+    connect(this, &AbstractSkillView::flushPendingChanges, dm, &SessionDataModel::flushPendingChanges);
+    return dm;
+}
 
-        DelegatesModel *delegatesModel = m_activeSkillsModel->delegatesModelForSkill(skillId);
+SessionDataMap *AbstractSkillView::sessionDataForSkill(const QString &skillId)
+{
+    SessionDataMap *map = nullptr;
 
-        if (!delegatesModel) {
-            qWarning() << "Error: no delegates model for skill" << skillId;
-            return;
-        }
+    if (m_skillData.contains(skillId)) {
+        map = m_skillData[skillId];
+    } else if (m_activeSkillsModel->containsSkill(skillId)) {
+        map = new SessionDataMap(skillId, this);
+        map->setBatchingEnabled(m_updateInterval >= 0);
+        connect(map, &SessionDataMap::changesPending, this, &AbstractSkillView::scheduleBatchFlush);
+        connect(this, &AbstractSkillView::flushPendingChanges, map, &SessionDataMap::flushPendingChanges);
+        m_skillData[skillId] = map;
+    }
 
-        if (from < 0 || from > delegatesModel->rowCount() - 1) {
-            qWarning() << "Error: Invalid from position in mycroft.gui.list.move";
-            return;
+    return map;
+}
+
+QStringList jsonModelToStringList(const QString &key, const QJsonValue &data)
+{
+    QStringList items;
+
+    if (!data.isArray()) {
+        qWarning() << "Error: Model data is not an Array" << data;
+        return items;
+    }
+
+    const auto &array = data.toArray();
+    for (const auto &item : array) {
+        if (!item.isObject()) {
+            qWarning() << "Error: Array data structure currupted: " << data;
+            items.clear();
+            return items;
         }
-        if (to < 0 || to > delegatesModel->rowCount() - 1) {
-            qWarning() << "Error: Invalid to position in mycroft.gui.list.move";
-            return;
+        const auto &obj = item.toObject();
+        if (obj.keys().length() != 1 || !obj.contains(key)) {
+            qWarning() << "Error: Item with a wrong key encountered, expected: " << key << "Encountered: " << obj.keys();
+            items.clear();
+            return items;
         }
-        if (itemsNumber <= 0 || itemsNumber > delegatesModel->rowCount() - from) {
-            qWarning() << "Error: Invalid items_number in mycroft.gui.list.move";
-            return;
+        const auto &value = obj.value(key);
+        if (!value.isString()) {
+            qWarning() << "Error: item in model not a string" << value;
         }
-        delegatesModel->moveRows(QModelIndex(), from, itemsNumber, QModelIndex(), to);
-//END GUI MODELS
+        items << value.toString();
+    }
 
+    return items;
+}
 
-//TODO: manage nested models?
-//BEGIN DATA MODELS
-    // Insert new items in an existing list, or creates one under "property"
-    } else if (type == QLatin1String("mycroft.session.list.insert")) {
-        const QString skillId = doc[QStringLiteral("namespace")].toString();
-        if (skillId.isEmpty()) {
-            qWarning() << "No skill_id provided in mycroft.session.list.insert";
-            return;
-        }
-        const QString &property = doc[QStringLiteral("property")].toString();
-        if (property.isEmpty()) {
-            qWarning() << "Error: Invalid or empty \"property\" in mycroft.session.list.insert";
-            return;
-        }
+const QHash<QString, AbstractSkillView::MessageHandler> &AbstractSkillView::messageHandlers()
+{
+    // Built once: each message type is hashed a single time here, afterwards
+    // dispatching a message costs one hash lookup instead of a chain of compares
+    static const QHash<QString, MessageHandler> handlers({
+        {QStringLiteral("mycroft.session.sync"), &AbstractSkillView::handleSessionSync},
+        {QStringLiteral("mycroft.session.set"), &AbstractSkillView::handleSessionSet},
+        {QStringLiteral("mycroft.session.delete"), &AbstractSkillView::handleSessionDelete},
+        {QStringLiteral("mycroft.session.list.insert"), &AbstractSkillView::handleSessionListInsert},
+        {QStringLiteral("mycroft.session.list.update"), &AbstractSkillView::handleSessionListUpdate},
+        {QStringLiteral("mycroft.session.list.move"), &AbstractSkillView::handleSessionListMove},
+        {QStringLiteral("mycroft.session.list.remove"), &AbstractSkillView::handleSessionListRemove},
+        {QStringLiteral("mycroft.gui.list.insert"), &AbstractSkillView::handleGuiListInsert},
+        {QStringLiteral("mycroft.gui.list.remove"), &AbstractSkillView::handleGuiListRemove},
+        {QStringLiteral("mycroft.gui.list.move"), &AbstractSkillView::handleGuiListMove},
+        {QStringLiteral("mycroft.events.triggered"), &AbstractSkillView::handleEventTriggered}
+    });
+
+    return handlers;
+}
 
-        SessionDataMap *map = sessionDataForSkill(skillId);
-        SessionDataModel *dm = map->value(property).value<SessionDataModel *>();
+void AbstractSkillView::onGuiSocketMessageReceived(const QString &message)
+{
+    DecodedMessage decoded;
+    if (MessageDecoder::decode(message.toUtf8(), false, false, decoded)) {
+        receiveGuiMessage(decoded);
+    }
+}
 
-        if (!dm) {
-            dm = new SessionDataModel(map);
-            map->insertAndNotify(property, QVariant::fromValue(dm));
-        }
+void AbstractSkillView::onGuiSocketBinaryMessageReceived(const QByteArray &message)
+{
+    // Parse the frame as is, without the round trip through QString
+    DecodedMessage decoded;
+    if (MessageDecoder::decode(message, true, false, decoded)) {
+        receiveGuiMessage(decoded);
+    }
+}
 
-        const int position = doc[QStringLiteral("position")].toInt();
+void AbstractSkillView::receiveGuiMessage(const DecodedMessage &decoded)
+{
+    if (m_sharedConnection) {
+        m_controller->routeGuiMessage(decoded);
+    } else {
+        handleDecodedGuiMessage(decoded);
+    }
+}
 
-        if (position < 0 || position > dm->rowCount()) {
-            qWarning() << "Error: Invalid position in mycroft.session.list.insert";
-            return;
-        }
+void AbstractSkillView::handleDecodedGuiMessage(const DecodedMessage &decoded)
+{
+    // Includes the QML work done synchronously by the bindings of the delegates
+    QElapsedTimer timer;
+    timer.start();
+    handleGuiMessage(decoded.message);
+    GuiMetrics::instance()->recordGuiMessage(decoded.type, decoded.message.value(QStringLiteral("namespace")).toString(),
+                                             decoded.size, decoded.decodeTime + timer.nsecsElapsed());
+}
 
-        QList<QVariantMap> list = variantListToOrderedMap(doc[QStringLiteral("data")].toVariant().value<QVariantList>());
+void AbstractSkillView::handleGuiMessage(const QJsonObject &message)
+{
+    const QString type = message.value(QStringLiteral("type")).toString();
 
-        if (list.isEmpty()) {
-            qWarning() << "Error: invalid data in mycroft.session.list.insert:" << doc[QStringLiteral("data")];
-            return;
-        }
+    if (type.isEmpty()) {
+        qWarning() << "Empty type in the JSON message on the gui socket";
+        return;
+    }
 
-        dm->insertData(position, list);
+    //qDebug() << "gui message type" << type;
 
-    // Updates the value of items in an existing list, Error if under "property" no list exists
-    } else if (type == QLatin1String("mycroft.session.list.update")) {
-        const QString skillId = doc[QStringLiteral("namespace")].toString();
-        if (skillId.isEmpty()) {
-            qWarning() << "No skill_id provided in mycroft.session.list.update";
-            return;
+    if (!m_restoringSnapshot) {
+        // The first live message replaces what was restored from the snapshot
+        if (m_stale) {
+            m_resumeTimer.stop();
+            m_activeSkillsModel->removeRows(0, m_activeSkillsModel->rowCount());
+            setStale(false);
         }
-        const QString &property = doc[QStringLiteral("property")].toString();
-        if (property.isEmpty()) {
-            qWarning() << "Error: Invalid or empty \"property\" in mycroft.session.list.update";
-            return;
+        if (m_snapshotInterval > 0 && !m_snapshotTimer.isActive()) {
+            m_snapshotTimer.start(m_snapshotInterval);
         }
+    }
 
-        SessionDataMap *map = sessionDataForSkill(skillId);
-        SessionDataModel *dm = map->value(property).value<SessionDataModel *>();
-
-        if (!dm) {
-            qWarning() << "Error: no list model existing under property" << property << "in mycroft.session.list.update";
+    // Messages replayed when resuming may overlap with the ones already applied
+    const QJsonValue sequence = message.value(QStringLiteral("seq"));
+    if (!sequence.isUndefined()) {
+        const qint64 seq = qint64(sequence.toDouble());
+        if (seq <= m_lastSequence) {
             return;
         }
+        m_lastSequence = seq;
+    }
 
-        const int position = doc[QStringLiteral("position")].toInt();
+    const MessageHandler handler = messageHandlers().value(type);
+    if (!handler) {
+        qWarning() << "Unrecognized operation" << type;
+        return;
+    }
 
-        if (position < 0 || position > m_activeSkillsModel->rowCount()) {
-            qWarning() << "Error: Invalid position in mycroft.session.list.update";
-            return;
-        }
+    (this->*handler)(message);
+}
 
-        QList<QVariantMap> list = variantListToOrderedMap(doc[QStringLiteral("data")].toVariant().value<QVariantList>());
+// First message of every connection from servers supporting session resume
+void AbstractSkillView::handleSessionSync(const QJsonObject &message)
+{
+    const QString session = message.value(QStringLiteral("session")).toString();
 
-        if (list.isEmpty()) {
-            qWarning() << "Error: invalid data in mycroft.session.list.insert:" << doc[QStringLiteral("data")];
-            return;
-        }
+    if (session.isEmpty()) {
+        qWarning() << "Empty session in mycroft.session.sync";
+        return;
+    }
 
-        dm->updateData(position, list);
+    if (!message.value(QStringLiteral("resumed")).toBool() || session != m_session) {
+        // The server couldn't replay what was missed, it's sending everything again
+        resetSession();
+        m_lastSequence = qint64(message.value(QStringLiteral("sequence")).toDouble());
+    }
 
-    // Moves items within an existing list, Error if under "property" no list exists
-    } else if (type == QLatin1String("mycroft.session.list.move")) {
-        const QString skillId = doc[QStringLiteral("namespace")].toString();
-        if (skillId.isEmpty()) {
-            qWarning() << "No skill_id provided in mycroft.session.list.update";
-            return;
-        }
-        const QString &property = doc[QStringLiteral("property")].toString();
-        if (property.isEmpty()) {
-            qWarning() << "Error: Invalid or empty \"property\" in mycroft.session.list.move";
-            return;
-        }
+    m_resumeTimer.stop();
+    m_session = session;
+}
 
-        SessionDataMap *map = sessionDataForSkill(skillId);
-        SessionDataModel *dm = map->value(property).value<SessionDataModel *>();
+//BEGIN SKILLDATA
+// The SkillData was updated by the server
+void AbstractSkillView::handleSessionSet(const QJsonObject &message)
+{
+    const QString skillId = message.value(QStringLiteral("namespace")).toString();
+    // Converted key by key, see SessionDataMap::setJsonValue()
+    const QJsonObject data = message.value(QStringLiteral("data")).toObject();
+    // optional, for every list the key used to match rows between updates
+    const QJsonObject listKeys = message.value(QStringLiteral("list_keys")).toObject();
+
+    if (skillId.isEmpty()) {
+        qWarning() << "Empty skill_id in mycroft.session.set";
+        return;
+    }
+    if (!m_activeSkillsModel->containsSkill(skillId)) {
+        qWarning() << "Invalid skill_id in mycroft.session.set:" << skillId;
+        return;
+    }
+    if (data.isEmpty()) {
+        qWarning() << "Empty data in mycroft.session.set";
+        return;
+    }
 
-        if (!dm) {
-            qWarning() << "Error: no list model existing under property" << property << "in mycroft.session.list.move";
-            return;
-        }
+    //we already checked, assume *map is valid
+    SessionDataMap *map = sessionDataForSkill(skillId);
+    if (!map) {
+        return;
+    }
+    for (auto i = data.constBegin(); i != data.constEnd(); ++i) {
+        map->setJsonValue(i.key(), i.value(), listKeys.value(i.key()).toString());
+    }
+}
 
-        const int from = doc[QStringLiteral("from")].toInt();
-        const int to = doc[QStringLiteral("to")].toInt();
-        const int itemsNumber = doc[QStringLiteral("items_number")].toInt();
+// The SkillData was removed by the server
+void AbstractSkillView::handleSessionDelete(const QJsonObject &message)
+{
+    const QString skillId = message.value(QStringLiteral("namespace")).toString();
+    const QString property = message.value(QStringLiteral("property")).toString();
+    if (skillId.isEmpty()) {
+        qWarning() << "No skill_id provided in mycroft.session.delete";
+        return;
+    }
+    if (!m_activeSkillsModel->containsSkill(skillId)) {
+        qWarning() << "Invalid skill_id in mycroft.session.delete:" << skillId;
+        return;
+    }
+    if (property.isEmpty()) {
+        qWarning() << "No property provided in mycroft.session.delete";
+        return;
+    }
 
-        if (from < 0 || from > dm->rowCount() - 1) {
-            qWarning() << "Error: Invalid from position in mycroft.session.list.move";
-            return;
-        }
-        if (to < 0 || to > dm->rowCount()) {
-            qWarning() << "Error: Invalid to position in mycroft.session.list.move";
-            return;
-        }
-        if (itemsNumber <= 0 || itemsNumber > dm->rowCount() - from) {
-            qWarning() << "Error: Invalid items_number in mycroft.session.list.move";
-            return;
+    SessionDataMap *map = sessionDataForSkill(skillId);
+    map->clearAndNotify(property);
+}
+//END SKILLDATA
+
+
+//BEGIN ACTIVESKILLS
+// Insert new active skill
+void AbstractSkillView::insertActiveSkills(const QJsonObject &message)
+{
+    const int position = message.value(QStringLiteral("position")).toInt();
+
+    if (position < 0 || position > m_activeSkillsModel->rowCount()) {
+        qWarning() << "Error: Invalid position in mycroft.session.list.insert of mycroft.system.active_skills";
+        return;
+    }
+
+    const QStringList skillList = jsonModelToStringList(QStringLiteral("skill_id"), message.value(QStringLiteral("data")));
+
+    if (skillList.isEmpty()) {
+        qWarning() << "Error: no valid skills received in mycroft.session.list.insert of mycroft.system.active_skills";
+        return;
+    }
+
+    m_activeSkillsModel->insertSkills(position, skillList);
+}
+
+// Active skill removed
+void AbstractSkillView::removeActiveSkills(const QJsonObject &message)
+{
+    const int position = message.value(QStringLiteral("position")).toInt();
+    const int itemsNumber = message.value(QStringLiteral("items_number")).toInt();
+
+    if (position < 0 || position > m_activeSkillsModel->rowCount() - 1) {
+        qWarning() << "Error: Invalid position in mycroft.session.list.remove of mycroft.system.active_skills";
+        return;
+    }
+    if (itemsNumber < 0 || itemsNumber > m_activeSkillsModel->rowCount() - position) {
+        qWarning() << "Error: Invalid items_number in mycroft.session.list.remove of mycroft.system.active_skills";
+        return;
+    }
+
+    for (int i = 0; i < itemsNumber; ++i) {
+
+        const QString skillId = m_activeSkillsModel->data(m_activeSkillsModel->index(position+i, 0)).toString();
+
+        //TODO: do this after an animation
+        {
+            // Its pooled delegates would be left without data
+            dropPooledDelegates(skillId);
+            auto i = m_skillData.find(skillId);
+            if (i != m_skillData.end()) {
+                i.value()->deleteLater();
+                m_skillData.erase(i);
+            }
         }
-        dm->moveRows(QModelIndex(), from, itemsNumber, QModelIndex(), to);
+    }
+    m_activeSkillsModel->removeRows(position, itemsNumber);
+}
 
-    // Removes items from an existing list, Error if under "property" no list exists
-    } else if (type == QLatin1String("mycroft.session.list.remove")) {
-        const QString skillId = doc[QStringLiteral("namespace")].toString();
-        if (skillId.isEmpty()) {
-            qWarning() << "No skill_id provided in mycroft.session.list.update";
-            return;
+// Active skill moved
+void AbstractSkillView::moveActiveSkills(const QJsonObject &message)
+{
+    const int from = message.value(QStringLiteral("from")).toInt();
+    const int to = message.value(QStringLiteral("to")).toInt();
+    const int itemsNumber = message.value(QStringLiteral("items_number")).toInt();
+
+    if (from < 0 || from > m_activeSkillsModel->rowCount() - 1) {
+        qWarning() << "Error: Invalid from position in mycroft.session.list.move of mycroft.system.active_skills";
+        return;
+    }
+    if (to < 0 || to > m_activeSkillsModel->rowCount() - 1) {
+        qWarning() << "Error: Invalid to position in mycroft.session.list.move of mycroft.system.active_skills";
+        return;
+    }
+    if (itemsNumber <= 0 || itemsNumber > m_activeSkillsModel->rowCount() - from) {
+        qWarning() << "Error: Invalid items_number in mycroft.session.list.move of mycroft.system.active_skills";
+        return;
+    }
+
+    m_activeSkillsModel->moveRows(QModelIndex(), from, itemsNumber, QModelIndex(), to);
+}
+//END ACTIVESKILLS
+
+
+//BEGIN GUI MODEL
+// Insert new new gui delegates
+void AbstractSkillView::handleGuiListInsert(const QJsonObject &message)
+{
+    const QString skillId = message.value(QStringLiteral("namespace")).toString();
+    if (skillId.isEmpty()) {
+        qWarning() << "No skill_id provided in mycroft.gui.list.insert";
+        return;
+    }
+
+    const int position = message.value(QStringLiteral("position")).toInt();
+
+    // A skill showing something is a reason to wake up
+    if (!m_restoringSnapshot) {
+        m_controller->setPowerState(MycroftController::Active);
+    }
+
+    DelegatesModel *delegatesModel = m_activeSkillsModel->delegatesModelForSkill(skillId);
+
+    if (!delegatesModel) {
+        qWarning() << "Error: no delegates model for skill" << skillId;
+        return;
+    }
+    if (position < 0 || position > delegatesModel->rowCount()) {
+        qWarning() << "Error: Invalid position in mycroft.gui.list.insert";
+        return;
+    }
+
+    const QStringList delegateUrls = jsonModelToStringList(QStringLiteral("url"), message.value(QStringLiteral("data")));
+
+    if (delegateUrls.isEmpty()) {
+        qWarning() << "Error: no valid skills received in mycroft.gui.list.insert";
+        return;
+    }
+
+    qWarning() << "Arrived mycroft.gui.list.insert, delegateUrls are" << delegateUrls;
+
+    QList <DelegateLoader *> delegateLoaders;
+    for (const auto &urlString : delegateUrls) {
+        const QUrl delegateUrl = QUrl::fromUserInput(urlString);
+
+        if (!delegateUrl.isValid()) {
+            continue;
         }
-        const QString &property = doc[QStringLiteral("property")].toString();
-        if (property.isEmpty()) {
-            qWarning() << "Error: Invalid or empty \"property\" in mycroft.session.list.move";
-            return;
+
+        DelegateLoader *loader = reuseDelegateLoader(skillId, delegateUrl);
+        if (loader) {
+            delegateLoaders << loader;
+            continue;
         }
 
-        SessionDataMap *map = sessionDataForSkill(skillId);
-        SessionDataModel *dm = map->value(property).value<SessionDataModel *>();
+        loader = new DelegateLoader(this);
+        // Only the page getting the focus is needed right away, DelegatesModel prefetches the others
+        loader->init(skillId, delegateUrl, !delegateLoaders.isEmpty());
 
-        if (!dm) {
-            qWarning() << "Error: no list model existing under property" << property << "in mycroft.session.list.move";
-            return;
-        }
+        qWarning() << "Created a new DelegateLoader" << loader << "which will load" << delegateUrl << "for the skill" << skillId;
 
-        const int position = doc[QStringLiteral("position")].toInt();
-        const int itemsNumber = doc[QStringLiteral("items_number")].toInt();
+        // Loaded in the background, bindings get retranslated once it's there
+        SkillTranslations::instance()->load(skillId, loader->translationsUrl());
 
-        if (position < 0 || position > dm->rowCount() - 1) {
-            qWarning() << "Error: Invalid position in mycroft.session.list.remove of mycroft.system.active_skills";
-            return;
-        }
-        if (itemsNumber < 0 || itemsNumber > dm->rowCount() - position) {
-            qWarning() << "Error: Invalid items_number in mycroft.session.list.remove of mycroft.system.active_skills";
-            return;
+        connect(loader, &QObject::destroyed, &m_trimComponentsTimer, QOverload<>::of(&QTimer::start));
+
+        delegateLoaders << loader;
+    }
+
+    if (delegateLoaders.count() > 0) {
+        delegatesModel->insertDelegateLoaders(position, delegateLoaders);
+        //give the focus to the first
+        delegateLoaders.first()->setFocus(true);
+    }
+}
+
+// Gui delegates removed
+void AbstractSkillView::handleGuiListRemove(const QJsonObject &message)
+{
+    const QString skillId = message.value(QStringLiteral("namespace")).toString();
+    if (skillId.isEmpty()) {
+        qWarning() << "No skill_id provided in mycroft.gui.list.remove";
+        return;
+    }
+
+    const int position = message.value(QStringLiteral("position")).toInt();
+    const int itemsNumber = message.value(QStringLiteral("items_number")).toInt();
+
+    //TODO: try with lifecycle managed by the view?
+    DelegatesModel *delegatesModel = m_activeSkillsModel->delegatesModelForSkill(skillId);
+    if (!delegatesModel) {
+        qWarning() << "Error: no delegates model for skill" << skillId;
+        return;
+    }
+
+    if (position < 0 || position > delegatesModel->rowCount() - 1) {
+        qWarning() << "Error: Invalid position in mycroft.gui.list.remove";
+        return;
+    }
+
+    if (itemsNumber < 0 || itemsNumber > delegatesModel->rowCount()) {
+        qWarning() << "Error: Invalid items_number in mycroft.gui.list.remove";
+        return;
+    }
+
+    delegatesModel->removeRows(position, itemsNumber);
+}
+
+// Gui delegates moved
+void AbstractSkillView::handleGuiListMove(const QJsonObject &message)
+{
+    const QString skillId = message.value(QStringLiteral("namespace")).toString();
+    if (skillId.isEmpty()) {
+        qWarning() << "No skill_id provided in mycroft.gui.list.move";
+        return;
+    }
+
+    const int from = message.value(QStringLiteral("from")).toInt();
+    const int to = message.value(QStringLiteral("to")).toInt();
+    const int itemsNumber = message.value(QStringLiteral("items_number")).toInt();
+
+    DelegatesModel *delegatesModel = m_activeSkillsModel->delegatesModelForSkill(skillId);
+
+    if (!delegatesModel) {
+        qWarning() << "Error: no delegates model for skill" << skillId;
+        return;
+    }
+
+    if (from < 0 || from > delegatesModel->rowCount() - 1) {
+        qWarning() << "Error: Invalid from position in mycroft.gui.list.move";
+        return;
+    }
+    if (to < 0 || to > delegatesModel->rowCount() - 1) {
+        qWarning() << "Error: Invalid to position in mycroft.gui.list.move";
+        return;
+    }
+    if (itemsNumber <= 0 || itemsNumber > delegatesModel->rowCount() - from) {
+        qWarning() << "Error: Invalid items_number in mycroft.gui.list.move";
+        return;
+    }
+    delegatesModel->moveRows(QModelIndex(), from, itemsNumber, QModelIndex(), to);
+}
+//END GUI MODELS
+
+
+// Lists nested in other values are models of the child maps, see SessionDataMap::setJsonValue()
+//BEGIN DATA MODELS
+SessionDataModel *AbstractSkillView::sessionDataModelForMessage(const QJsonObject &message, const QString &skillId, QLatin1String type, bool create)
+{
+    if (skillId.isEmpty()) {
+        qWarning() << "No skill_id provided in" << type;
+        return nullptr;
+    }
+    const QString property = message.value(QStringLiteral("property")).toString();
+    if (property.isEmpty()) {
+        qWarning() << "Error: Invalid or empty \"property\" in" << type;
+        return nullptr;
+    }
+
+    SessionDataMap *map = sessionDataForSkill(skillId);
+    if (!map) {
+        qWarning() << "Invalid skill_id in" << type << ":" << skillId;
+        return nullptr;
+    }
+
+    SessionDataModel *dm = map->value(property).value<SessionDataModel *>();
+
+    if (!dm) {
+        if (!create) {
+            qWarning() << "Error: no list model existing under property" << property << "in" << type;
+            return nullptr;
         }
+        dm = createSessionDataModel(map);
+        map->insertAndNotify(property, QVariant::fromValue(dm));
+    }
+
+    return dm;
+}
+
+// Insert new items in an existing list, or creates one under "property"
+void AbstractSkillView::handleSessionListInsert(const QJsonObject &message)
+{
+    const QString skillId = message.value(QStringLiteral("namespace")).toString();
+    if (skillId == QLatin1String("mycroft.system.active_skills")) {
+        insertActiveSkills(message);
+        return;
+    }
+
+    SessionDataModel *dm = sessionDataModelForMessage(message, skillId, QLatin1String("mycroft.session.list.insert"), true);
+    if (!dm) {
+        return;
+    }
+
+    const int position = message.value(QStringLiteral("position")).toInt();
+
+    if (position < 0 || position > dm->rowCount()) {
+        qWarning() << "Error: Invalid position in mycroft.session.list.insert";
+        return;
+    }
+
+    const QJsonValue data = message.value(QStringLiteral("data"));
+    const QList<QVariantMap> list = SessionDataModel::rowsFromJson(data.toArray());
+
+    if (list.isEmpty()) {
+        qWarning() << "Error: invalid data in mycroft.session.list.insert:" << data;
+        return;
+    }
+
+    dm->insertData(position, list);
+}
+
+// Updates the value of items in an existing list, Error if under "property" no list exists
+void AbstractSkillView::handleSessionListUpdate(const QJsonObject &message)
+{
+    const QString skillId = message.value(QStringLiteral("namespace")).toString();
+    SessionDataModel *dm = sessionDataModelForMessage(message, skillId, QLatin1String("mycroft.session.list.update"), false);
+    if (!dm) {
+        return;
+    }
+
+    const int position = message.value(QStringLiteral("position")).toInt();
+
+    if (position < 0 || position > dm->rowCount() - 1) {
+        qWarning() << "Error: Invalid position in mycroft.session.list.update";
+        return;
+    }
+
+    const QJsonValue data = message.value(QStringLiteral("data"));
+    const QList<QVariantMap> list = SessionDataModel::rowsFromJson(data.toArray());
+
+    if (list.isEmpty()) {
+        qWarning() << "Error: invalid data in mycroft.session.list.update:" << data;
+        return;
+    }
+
+    dm->updateData(position, list);
+}
+
+// Moves items within an existing list, Error if under "property" no list exists
+void AbstractSkillView::handleSessionListMove(const QJsonObject &message)
+{
+    const QString skillId = message.value(QStringLiteral("namespace")).toString();
+    if (skillId == QLatin1String("mycroft.system.active_skills")) {
+        moveActiveSkills(message);
+        return;
+    }
+
+    SessionDataModel *dm = sessionDataModelForMessage(message, skillId, QLatin1String("mycroft.session.list.move"), false);
+    if (!dm) {
+        return;
+    }
+
+    const int from = message.value(QStringLiteral("from")).toInt();
+    const int to = message.value(QStringLiteral("to")).toInt();
+    const int itemsNumber = message.value(QStringLiteral("items_number")).toInt();
+
+    if (from < 0 || from > dm->rowCount() - 1) {
+        qWarning() << "Error: Invalid from position in mycroft.session.list.move";
+        return;
+    }
+    if (to < 0 || to > dm->rowCount()) {
+        qWarning() << "Error: Invalid to position in mycroft.session.list.move";
+        return;
+    }
+    if (itemsNumber <= 0 || itemsNumber > dm->rowCount() - from) {
+        qWarning() << "Error: Invalid items_number in mycroft.session.list.move";
+        return;
+    }
+    dm->moveRows(QModelIndex(), from, itemsNumber, QModelIndex(), to);
+}
+
+// Removes items from an existing list, Error if under "property" no list exists
+void AbstractSkillView::handleSessionListRemove(const QJsonObject &message)
+{
+    const QString skillId = message.value(QStringLiteral("namespace")).toString();
+    if (skillId == QLatin1String("mycroft.system.active_skills")) {
+        removeActiveSkills(message);
+        return;
+    }
+
+    SessionDataModel *dm = sessionDataModelForMessage(message, skillId, QLatin1String("mycroft.session.list.remove"), false);
+    if (!dm) {
+        return;
+    }
+
+    const int position = message.value(QStringLiteral("position")).toInt();
+    const int itemsNumber = message.value(QStringLiteral("items_number")).toInt();
+
+    if (position < 0 || position > dm->rowCount() - 1) {
+        qWarning() << "Error: Invalid position in mycroft.session.list.remove";
+        return;
+    }
+    if (itemsNumber < 0 || itemsNumber > dm->rowCount() - position) {
+        qWarning() << "Error: Invalid items_number in mycroft.session.list.remove";
+        return;
+    }
 
-        dm->removeRows(position, itemsNumber);
+    dm->removeRows(position, itemsNumber);
+}
 //END DATA MODELS
 
 
 //BEGIN EVENTS
-    // Action triggered from the server
-    } else if (type == QLatin1String("mycroft.events.triggered")) {
-        const QString skillOrSystem = doc[QStringLiteral("namespace")].toString();
+// Action triggered from the server
+void AbstractSkillView::handleEventTriggered(const QJsonObject &message)
+{
+    const QString skillOrSystem = message.value(QStringLiteral("namespace")).toString();
 
-        if (skillOrSystem.isEmpty()) {
-            qWarning() << "No namespace provided for mycroft.events.triggered";
-            return;
-        }
-        /*FIXME: do we need to keep this check? we need to also include skills without gui
-        // If it's a skill it must exist
-        if (skillOrSystem != QLatin1String("system") && !m_activeSkillsModel->skillIndex(skillOrSystem).isValid()) {
-            qWarning() << "Invalid skill id passed as namespace for mycroft.events.triggered:" << skillOrSystem;
-            return;
-        }*/
+    if (skillOrSystem.isEmpty()) {
+        qWarning() << "No namespace provided for mycroft.events.triggered";
+        return;
+    }
+    /*FIXME: do we need to keep this check? we need to also include skills without gui
+    // If it's a skill it must exist
+    if (skillOrSystem != QLatin1String("system") && !m_activeSkillsModel->containsSkill(skillOrSystem)) {
+        qWarning() << "Invalid skill id passed as namespace for mycroft.events.triggered:" << skillOrSystem;
+        return;
+    }*/
+
+    const QString eventName = message.value(QStringLiteral("event_name")).toString();
+    if (eventName.isEmpty()) {
+        qWarning() << "No event_name provided for mycroft.events.triggered";
+        return;
+    }
 
-        const QString eventName = doc[QStringLiteral("event_name")].toString();
-        if (eventName.isEmpty()) {
-            qWarning() << "No namespace provided for mycroft.events.triggered";
+    // data can also be empty
+    const QVariantMap data = message.value(QStringLiteral("data")).toVariant().toMap();
+
+    // page_gained_focus is special: interests only one single delegate
+    if (eventName == QLatin1String("page_gained_focus")) {
+        int pos = data.value(QStringLiteral("number")).toInt();
+        if (pos < 0) {
             return;
         }
+        AbstractDelegate *delegate = nullptr;
 
-        // data can also be empty
-        const QVariantMap data = doc[QStringLiteral("data")].toVariant().toMap();
-
-        QList<AbstractDelegate *> delegates;
+        DelegateLoader *loader = nullptr;
 
+        // Pages are counted whether they have been created yet or not
         if (skillOrSystem == QLatin1String("system")) {
             for (auto *delegatesModel : activeSkills()->delegatesModels()) {
-                delegates << delegatesModel->delegates();
+                const int count = delegatesModel->rowCount();
+                if (pos < count) {
+                    delegatesModel->setCurrentIndex(pos);
+                    loader = delegatesModel->delegateLoaderAt(pos);
+                    break;
+                }
+                pos -= count;
             }
         } else {
             DelegatesModel *delegatesModel = activeSkills()->delegatesModelForSkill(skillOrSystem);
-            if (delegatesModel) {
-                delegates << delegatesModel->delegates();
+            if (delegatesModel && pos < delegatesModel->rowCount()) {
+                delegatesModel->setCurrentIndex(pos);
+                loader = delegatesModel->delegateLoaderAt(pos);
             }
         }
 
-        // page_gained_focus is special: interests only one single delegate
-        if (eventName == QStringLiteral("page_gained_focus")) {
-            int pos = data.value(QStringLiteral("number")).toInt();
-            if (pos >= 0 && pos < delegates.count()) {
-                AbstractDelegate *delegate = delegates[pos];
-                delegate->forceActiveFocus((Qt::FocusReason)ServerEventFocusReason);
-                emit delegate->guiEvent(eventName, data);
+        if (loader) {
+            loader->load();
+            delegate = loader->delegate();
+            if (!delegate) {
+                // Still incubating: focused once created
+                loader->setFocus(true);
             }
-        } else if (eventName == QStringLiteral("mycroft.gui.close.screen")) {
-            emit activeSkillClosed();
-        } else {
-            for (auto *delegate : delegates) {
+        }
+
+        if (delegate) {
+            delegate->forceActiveFocus((Qt::FocusReason)ServerEventFocusReason);
+            emit delegate->guiEvent(eventName, data);
+        }
+    } else if (eventName == QLatin1String("mycroft.gui.close.screen")) {
+        emit activeSkillClosed();
+    } else if (skillOrSystem == QLatin1String("system")) {
+        // A shallow copy, in case a handler changes the subscriptions
+        const QHash<QString, EventSubscribers> subscribers = m_eventSubscribers;
+        for (auto it = subscribers.constBegin(); it != subscribers.constEnd(); ++it) {
+            // Delegates of a removed skill are still around until deleted
+            if (m_activeSkillsModel->containsSkill(it.key())) {
+                deliverEvent(*it, eventName, data);
+            }
+        }
+    } else if (activeSkills()->delegatesModelForSkill(skillOrSystem)) {
+        const EventSubscribers subscribers = m_eventSubscribers.value(skillOrSystem);
+        deliverEvent(subscribers, eventName, data);
+    }
+}
+
+void AbstractSkillView::deliverEvent(const EventSubscribers &subscribers, const QString &eventName, const QVariantMap &data)
+{
+    auto it = subscribers.byEvent.constFind(eventName);
+    if (it != subscribers.byEvent.constEnd()) {
+        for (const auto &delegate : *it) {
+            if (delegate && delegate->wantsGuiEvents()) {
                 emit delegate->guiEvent(eventName, data);
             }
         }
-    } else {
-        qWarning() << "Unrecognized operation" << type;
     }
-//END EVENTS
+
+    for (const auto &delegate : subscribers.all) {
+        if (delegate && delegate->wantsGuiEvents()) {
+            emit delegate->guiEvent(eventName, data);
+        }
+    }
+}
+
+void AbstractSkillView::updateEventSubscriptions(AbstractDelegate *delegate)
+{
+    removeEventSubscriptions(delegate);
+
+    DelegateSubscription &subscription = m_delegateSubscriptions[delegate];
+    subscription.skillId = delegate->skillId();
+    subscription.events = delegate->guiEvents();
+    subscription.events.removeDuplicates();
+
+    EventSubscribers &subscribers = m_eventSubscribers[subscription.skillId];
+    if (subscription.events.isEmpty()) {
+        subscribers.all << delegate;
+    }
+    for (const auto &event : subscription.events) {
+        subscribers.byEvent[event] << delegate;
+    }
+}
+
+void AbstractSkillView::removeEventSubscriptions(AbstractDelegate *delegate)
+{
+    auto it = m_delegateSubscriptions.find(delegate);
+    if (it == m_delegateSubscriptions.end()) {
+        return;
+    }
+
+    auto subscribersIt = m_eventSubscribers.find(it->skillId);
+    if (subscribersIt != m_eventSubscribers.end()) {
+        // Compared as pointers: the delegate may be being destroyed
+        auto isDelegate = [delegate](const QPointer<AbstractDelegate> &d) {
+            return d.data() == delegate || d.isNull();
+        };
+        EventSubscribers &subscribers = *subscribersIt;
+        if (it->events.isEmpty()) {
+            subscribers.all.erase(std::remove_if(subscribers.all.begin(), subscribers.all.end(), isDelegate), subscribers.all.end());
+        }
+        for (const auto &event : it->events) {
+            auto eventIt = subscribers.byEvent.find(event);
+            if (eventIt == subscribers.byEvent.end()) {
+                continue;
+            }
+            eventIt->erase(std::remove_if(eventIt->begin(), eventIt->end(), isDelegate), eventIt->end());
+            if (eventIt->isEmpty()) {
+                subscribers.byEvent.erase(eventIt);
+            }
+        }
+        if (subscribers.all.isEmpty() && subscribers.byEvent.isEmpty()) {
+            m_eventSubscribers.erase(subscribersIt);
+        }
+    }
+
+    m_delegateSubscriptions.erase(it);
 }
+//END EVENTS
 
 #include "moc_abstractskillview.cpp"
@@ -19,15 +19,25 @@
 #pragma once
 
 #include "mycroftcontroller.h"
+#include "reconnectbackoff.h"
+#include "skillmemory.h"
 
 #include <QQuickItem>
+#include <QQmlIncubator>
 #include <QPointer>
+#include <QVector>
 
 class ActiveSkillsModel;
 class AbstractSkillView;
+class ComponentCache;
+class FrameIncubationController;
 class AbstractDelegate;
+class DelegateLoader;
 class SessionDataMap;
-class QTranslator;
+class SessionDataModel;
+class MessageDecoder;
+struct DecodedMessage;
+class QJsonObject;
 
 class AbstractSkillView: public QQuickItem
 {
@@ -36,11 +46,91 @@ class AbstractSkillView: public QQuickItem
 
     Q_PROPERTY(ActiveSkillsModel *activeSkills READ activeSkills CONSTANT)
 
+    /**
+     * How often repeated changes of session data coming from the server are
+     * notified to QML: 0, the default, means once per rendered frame,
+     * a positive value is an interval in milliseconds, -1 disables batching.
+     */
+    Q_PROPERTY(int updateInterval READ updateInterval WRITE setUpdateInterval NOTIFY updateIntervalChanged)
+
+    /**
+     * Changes of session data done by the client are written back to the
+     * server once they didn't change for writeBackDelay milliseconds, but no
+     * later than writeBackMaxLatency milliseconds after the first change.
+     * @see SessionDataMap::setWritePriority
+     */
+    Q_PROPERTY(int writeBackDelay READ writeBackDelay WRITE setWriteBackDelay NOTIFY writeBackDelayChanged)
+    Q_PROPERTY(int writeBackMaxLatency READ writeBackMaxLatency WRITE setWriteBackMaxLatency NOTIFY writeBackMaxLatencyChanged)
+
+    /**
+     * When positive, delegates are created asynchronously, spending at most
+     * incubationBudget milliseconds per frame on them; DelegatesModel reports
+     * them as loading meanwhile. 0, the default, creates them synchronously.
+     */
+    Q_PROPERTY(int incubationBudget READ incubationBudget WRITE setIncubationBudget NOTIFY incubationBudgetChanged)
+
+    /**
+     * How many removed delegates marked as recyclable are kept for reuse,
+     * across all skills. 0 disables recycling.
+     * @see AbstractDelegate::recyclable
+     */
+    Q_PROPERTY(int delegatePoolSize READ delegatePoolSize WRITE setDelegatePoolSize NOTIFY delegatePoolSizeChanged)
+
+    /**
+     * How long, in milliseconds, pages and session data survive a lost gui
+     * socket: when reconnecting within this time a server supporting it
+     * only sends what was missed. 0 tears everything down right away.
+     */
+    Q_PROPERTY(int resumeTimeout READ resumeTimeout WRITE setResumeTimeout NOTIFY resumeTimeoutChanged)
+
+    /**
+     * When positive, the skills, pages and session data are saved at most
+     * every snapshotInterval milliseconds, and restored when the view is
+     * created, before the server is reachable. 0, the default, disables it.
+     * @see SessionSnapshot
+     */
+    Q_PROPERTY(int snapshotInterval READ snapshotInterval WRITE setSnapshotInterval NOTIFY snapshotIntervalChanged)
+
+    /**
+     * True while the view shows what was restored from the snapshot,
+     * until the live state arrives from the server
+     */
+    Q_PROPERTY(bool stale READ isStale NOTIFY staleChanged)
+
+    /**
+     * When positive, megabytes the skills may hold in session data and
+     * delegates, as estimated by SkillMemoryUsage. Over it, first the pooled
+     * delegates then the session data of skills without pages are dropped,
+     * least recently active skill first; the current skill is never touched.
+     * 0, the default, only accounts it.
+     */
+    Q_PROPERTY(int memoryBudget READ memoryBudget WRITE setMemoryBudget NOTIFY memoryBudgetChanged)
+
+    /**
+     * Of the pages a skill shows at once, only the first is created right
+     * away; the others are compiled, then created in the background while
+     * nothing else is going on, nearest to the current page first.
+     * pagePrefetch is how many pages on each side of the current one get
+     * created this way, the farther ones wait until they get that close.
+     * -1, the default, prefetches every page. No page is prefetched over
+     * memoryBudget.
+     */
+    Q_PROPERTY(int pagePrefetch READ pagePrefetch WRITE setPagePrefetch NOTIFY pagePrefetchChanged)
+
 public:
     enum CustomFocusReasons {
         ServerEventFocusReason = Qt::OtherFocusReason
     };
 
+    /**
+     * How messages are framed on the gui socket, negotiated with mycroft.gui.port
+     */
+    enum FrameFormat {
+        TextJson,   // compact JSON in text frames, the default
+        BinaryJson, // compact JSON in binary frames, no UTF-16 round trip
+        Cbor        // CBOR in binary frames, needs Qt 5.12
+    };
+
     AbstractSkillView(QQuickItem *parent = nullptr);
     ~AbstractSkillView();
 
@@ -48,6 +138,40 @@ public:
 
     ActiveSkillsModel *activeSkills() const;
 
+    int updateInterval() const;
+    void setUpdateInterval(int interval);
+
+    int writeBackDelay() const;
+    void setWriteBackDelay(int delay);
+
+    int writeBackMaxLatency() const;
+    void setWriteBackMaxLatency(int latency);
+
+    int incubationBudget() const;
+    void setIncubationBudget(int budget);
+
+    int delegatePoolSize() const;
+    void setDelegatePoolSize(int size);
+
+    int resumeTimeout() const;
+    void setResumeTimeout(int timeout);
+
+    int snapshotInterval() const;
+    void setSnapshotInterval(int interval);
+
+    bool isStale() const;
+
+    int memoryBudget() const;
+    void setMemoryBudget(int budget);
+
+    /**
+     * @returns for every skill holding something, its SkillMemoryUsage::toVariantMap()
+     */
+    Q_INVOKABLE QVariantMap memoryUsage();
+
+    int pagePrefetch() const;
+    void setPagePrefetch(int pages);
+
 
     //API for MycroftController, NOT QML
     /**
@@ -65,6 +189,25 @@ public:
      */
     QString id() const;
 
+    /**
+     * Frame formats this GUI can speak, announced in mycroft.gui.connected
+     */
+    static QStringList supportedFrameFormats();
+
+    /**
+     * Format used for outgoing messages on the gui socket.
+     * Incoming messages are accepted in any supported format.
+     */
+    FrameFormat frameFormat() const;
+    void setFrameFormat(const QString &format);
+
+    /**
+     * @internal for GlobalSettings::sharedGuiConnection: owner is the view
+     * holding the socket, nullptr for that view itself. Received messages
+     * are routed by the controller, outgoing ones sent through owner.
+     */
+    void setSharedConnection(AbstractSkillView *owner);
+
     /**
      * @internal triggers an event: invoked by the c++ side of the delegates via AbstractDelegate::triggerEvent
      */
@@ -77,9 +220,54 @@ public:
      */
     SessionDataMap *sessionDataForSkill(const QString &skillId);
 
-    void writeProperties(const QString &skillId, const QVariantMap &data);
+    /**
+     * @internal asks for flushPendingChanges() to be emitted at the end of the
+     * current batch interval, either the next frame or after updateInterval
+     */
+    void scheduleBatchFlush();
+
+    /**
+     * Sends a mycroft.session.set for skillId, deleted keys are listed in its "deleted" field
+     */
+    void writeProperties(const QString &skillId, const QVariantMap &data, const QStringList &deleted = QStringList());
     void deleteProperty(const QString &skillId, const QString &property);
 
+    /**
+     * @internal compiled delegate components, shared by all the DelegateLoaders of this view
+     */
+    ComponentCache *componentCache();
+
+    /**
+     * @internal how DelegateLoaders should create their delegates, following incubationBudget
+     */
+    QQmlIncubator::IncubationMode incubationMode();
+
+    /**
+     * @internal takes a loader DelegatesModel removed, detaching its delegate for reuse.
+     * @returns false if it can't be recycled: the caller has to delete it then
+     */
+    bool recycleDelegateLoader(DelegateLoader *loader);
+
+    /**
+     * @internal @returns a recycled loader for the page url of skillId, or nullptr
+     */
+    DelegateLoader *reuseDelegateLoader(const QString &skillId, const QUrl &url);
+
+    /**
+     * @internal (re)indexes the delegate for the mycroft.events.triggered it wants,
+     * following AbstractDelegate::guiEvents
+     */
+    void updateEventSubscriptions(AbstractDelegate *delegate);
+    void removeEventSubscriptions(AbstractDelegate *delegate);
+
+    /**
+     * @internal whether DelegatesModel may create pages that aren't shown yet
+     */
+    bool canPrefetchPages() const;
+
+protected:
+    void componentComplete() override;
+
 Q_SIGNALS:
     /**
      * The skill that was open due voice interaction has been closed either due to timeout or user interaction
@@ -88,19 +276,161 @@ Q_SIGNALS:
     //socket stuff
     void statusChanged();
     void closed();
+    void updateIntervalChanged();
+    void writeBackDelayChanged();
+    void writeBackMaxLatencyChanged();
+    void incubationBudgetChanged();
+    void delegatePoolSizeChanged();
+    void resumeTimeoutChanged();
+    void snapshotIntervalChanged();
+    void staleChanged();
+    void memoryBudgetChanged();
+    void pagePrefetchChanged();
+
+    /**
+     * @internal end of a batch interval: session data maps and models
+     * apply their delayed changes
+     */
+    void flushPendingChanges();
 
 private:
+    typedef void (AbstractSkillView::*MessageHandler)(const QJsonObject &message);
+
+    /**
+     * Delegates of a skill interested in mycroft.events.triggered
+     */
+    struct EventSubscribers {
+        QHash<QString, QVector<QPointer<AbstractDelegate>>> byEvent;
+        // Delegates without guiEvents, they get every event
+        QVector<QPointer<AbstractDelegate>> all;
+    };
+
+    struct DelegateSubscription {
+        QString skillId;
+        QStringList events;
+    };
+
+    void deliverEvent(const EventSubscribers &subscribers, const QString &eventName, const QVariantMap &data);
+
+    /**
+     * Table of the handlers for every message type the server can send,
+     * indexed by message "type"
+     */
+    static const QHash<QString, MessageHandler> &messageHandlers();
+
+    void openGuiSocket();
+    void onGuiConnectionOpened();
+    void onGuiConnectionLost();
+    /**
+     * Forgets the session, removing all skills with their pages and data
+     */
+    void resetSession();
+
+    QString snapshotPath() const;
+    /**
+     * @returns the messages rebuilding the current state from scratch
+     */
+    QList<QJsonObject> snapshotMessages() const;
+    void writeSnapshot();
+    void restoreSnapshot();
+    void setStale(bool stale);
+
+    QHash<QString, SkillMemoryUsage> skillMemoryUsage() const;
+    /**
+     * @returns the skills that have been active, least recently active first
+     */
+    QStringList skillsByActivity() const;
+    void dropPooledDelegates(const QString &skillId);
+    /**
+     * Evicts until usage fits in memoryBudget, updating usage
+     */
+    void enforceMemoryBudget(QHash<QString, SkillMemoryUsage> &usage);
+    void updateMemoryUsage();
+
     void onGuiSocketMessageReceived(const QString &message);
+    void onGuiSocketBinaryMessageReceived(const QByteArray &message);
+    void receiveGuiMessage(const DecodedMessage &decoded);
+    void sendGuiMessage(const QJsonObject &message);
+    void flushBatchedChanges();
+    /**
+     * Follows MycroftController::powerState: suspends the invisible delegates while idle
+     */
+    void updatePowerState();
+    SessionDataModel *createSessionDataModel(SessionDataMap *map);
+    void handleGuiMessage(const QJsonObject &message);
+    /**
+     * handleGuiMessage, accounted in GuiMetrics
+     */
+    void handleDecodedGuiMessage(const DecodedMessage &decoded);
+
+    void handleSessionSync(const QJsonObject &message);
+    void handleSessionSet(const QJsonObject &message);
+    void handleSessionDelete(const QJsonObject &message);
+    void handleSessionListInsert(const QJsonObject &message);
+    void handleSessionListUpdate(const QJsonObject &message);
+    void handleSessionListMove(const QJsonObject &message);
+    void handleSessionListRemove(const QJsonObject &message);
+    void handleGuiListInsert(const QJsonObject &message);
+    void handleGuiListRemove(const QJsonObject &message);
+    void handleGuiListMove(const QJsonObject &message);
+    void handleEventTriggered(const QJsonObject &message);
+
+    void insertActiveSkills(const QJsonObject &message);
+    void removeActiveSkills(const QJsonObject &message);
+    void moveActiveSkills(const QJsonObject &message);
+
+    /**
+     * @returns the list model under "property" of the message for skillId,
+     * creating it if create is true. nullptr, with a warning, on invalid messages
+     */
+    SessionDataModel *sessionDataModelForMessage(const QJsonObject &message, const QString &skillId, QLatin1String type, bool create);
 
     QTimer m_reconnectTimer;
+    ReconnectBackoff m_reconnectBackoff;
+    QTimer m_resumeTimer;
+    QTimer m_snapshotTimer;
     QTimer m_trimComponentsTimer;
+    QTimer m_batchTimer;
+    QTimer m_memoryTimer;
+    QMetaObject::Connection m_frameConnection;
+    int m_updateInterval = 0;
+    int m_writeBackDelay = 50;
+    int m_writeBackMaxLatency = 200;
+    int m_incubationBudget = 0;
+    int m_delegatePoolSize = 8;
+    int m_resumeTimeout = 30000;
+    int m_snapshotInterval = 0;
+    int m_memoryBudget = 0;
+    int m_pagePrefetch = -1;
+    bool m_stale = false;
+    bool m_restoringSnapshot = false;
+    bool m_batchFlushScheduled = false;
     QString m_id;
     QUrl m_url;
+    // Session of the server and "seq" of the last message applied from it
+    QString m_session;
+    qint64 m_lastSequence = 0;
     QHash<QString, SessionDataMap *> m_skillData;
-    QHash<QString, QTranslator *> m_translatorsForSkill;
+    // Least recently recycled first
+    QList<QPointer<DelegateLoader>> m_delegatePool;
+    // Event subscribers by skill id
+    QHash<QString, EventSubscribers> m_eventSubscribers;
+    QHash<AbstractDelegate *, DelegateSubscription> m_delegateSubscriptions;
 
     MycroftController *m_controller;
     QWebSocket *m_guiWebSocket;
+    // GlobalSettings::sharedGuiConnection: m_connectionOwner is null for the view owning the socket
+    bool m_sharedConnection = false;
+    QPointer<AbstractSkillView> m_connectionOwner;
+    QVector<QMetaObject::Connection> m_ownerConnections;
+    MessageDecoder *m_decoder = nullptr;
+    ComponentCache *m_componentCache = nullptr;
+    FrameIncubationController *m_incubationController = nullptr;
+    FrameFormat m_frameFormat = TextJson;
     ActiveSkillsModel *m_activeSkillsModel;
+
+    friend class MycroftController;
+    friend class GuiMessageBenchmark;
+    friend class SessionDataMap;
 };
 
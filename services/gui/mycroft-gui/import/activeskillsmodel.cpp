@@ -21,6 +21,16 @@
 
 #include <QDebug>
 
+// QSet::fromList() is deprecated, the range constructor needs Qt 5.14
+static QSet<QString> toSet(const QStringList &list)
+{
+    QSet<QString> set;
+    set.reserve(list.count());
+    for (const auto &item : list) {
+        set.insert(item);
+    }
+    return set;
+}
 
 ActiveSkillsModel::ActiveSkillsModel(QObject *parent)
     : QAbstractListModel(parent)
@@ -74,6 +84,7 @@ void ActiveSkillsModel::setBlackList(const QStringList &list)
     }
 
     m_blackList = list;
+    m_blackListSet = toSet(list);
 
     // TODO: delete/create delegates?
     emit blackListChanged();
@@ -91,6 +102,7 @@ void ActiveSkillsModel::setWhiteList(const QStringList &list)
     }
 
     m_whiteList = list;
+    m_whiteListSet = toSet(list);
 
     emit whiteListChanged();
 }
@@ -102,18 +114,18 @@ void ActiveSkillsModel::checkGuiActivation(const QString &skillId)
         return;
     }
 
-    if (activeSkills().isEmpty()) {
+    if (m_skills.isEmpty()) {
         return;
     }
 
-    if (activeSkills().first() == skillId) {
+    if (m_skills.first() == skillId) {
         emit skillActivated(skillId);
     }
 }
 
 bool ActiveSkillsModel::skillAllowed(const QString skillId) const
 {
-    return !m_blackList.contains(skillId) && (m_whiteList.isEmpty() || m_whiteList.contains(skillId));
+    return !m_blackListSet.contains(skillId) && (m_whiteListSet.isEmpty() || m_whiteListSet.contains(skillId));
 }
 
 void ActiveSkillsModel::insertSkills(int position, const QStringList &skillList)
@@ -123,13 +135,14 @@ void ActiveSkillsModel::insertSkills(int position, const QStringList &skillList)
     }
 
     QStringList filteredList;
+    QSet<QString> seen;
 
-    std::copy_if(skillList.begin(), skillList.end(),
-                 std::back_inserter(filteredList),
-                 [this](const QString &val)
-                 {
-                     return !m_skills.contains(val);
-                 });
+    for (const auto &skillId : skillList) {
+        if (!m_rows.contains(skillId) && !seen.contains(skillId)) {
+            seen.insert(skillId);
+            filteredList << skillId;
+        }
+    }
 
     if (filteredList.isEmpty()) {
         return;
@@ -142,6 +155,7 @@ void ActiveSkillsModel::insertSkills(int position, const QStringList &skillList)
         m_skills.insert(position + i, skillId);
         ++i;
     }
+    reindex(position);
     //First syncactiveindex then endInserRows as it could make the view think we don't have any delegates for current skill
     syncActiveIndex();
     endInsertRows();
@@ -159,15 +173,31 @@ QStringList ActiveSkillsModel::activeSkills() const
 
 QModelIndex ActiveSkillsModel::skillIndex(const QString &skillId)
 {
-    const int row = m_skills.indexOf(skillId);
+    const auto it = m_rows.constFind(skillId);
 
-    if (row >= 0) {
-        return index(row, 0, QModelIndex());
+    if (it != m_rows.constEnd()) {
+        return index(*it, 0, QModelIndex());
     }
 
     return QModelIndex();
 }
 
+bool ActiveSkillsModel::containsSkill(const QString &skillId) const
+{
+    return m_rows.contains(skillId);
+}
+
+void ActiveSkillsModel::reindex(int first, int last)
+{
+    if (last < 0 || last >= m_skills.count()) {
+        last = m_skills.count() - 1;
+    }
+
+    for (int row = first; row <= last; ++row) {
+        m_rows[m_skills[row]] = row;
+    }
+}
+
 DelegatesModel *ActiveSkillsModel::delegatesModelForSkill(const QString &skillId)
 {
 
@@ -175,7 +205,7 @@ DelegatesModel *ActiveSkillsModel::delegatesModelForSkill(const QString &skillId
         return nullptr;
     }
 
-    if (!skillId.isEmpty() && !m_skills.contains(skillId)) {
+    if (!skillId.isEmpty() && !m_rows.contains(skillId)) {
         return nullptr;
     }
 
@@ -183,14 +213,14 @@ DelegatesModel *ActiveSkillsModel::delegatesModelForSkill(const QString &skillId
     if (!model) {
         model = new DelegatesModel(this);
         m_delegatesModels[skillId] = model;
-        const int row = m_skills.indexOf(skillId);
+        const int row = m_rows.value(skillId, -1);
         emit dataChanged(index(row, 0), index(row, 0), {Delegates});
     }
 
     return model;
 }
 
-QHash<QString, DelegatesModel*> ActiveSkillsModel::delegatesModels() const
+const QHash<QString, DelegatesModel*> &ActiveSkillsModel::delegatesModels() const
 {
     return m_delegatesModels;
 }
@@ -221,6 +251,8 @@ bool ActiveSkillsModel::moveRows(const QModelIndex &sourceParent, int sourceRow,
             m_skills.move(sourceRow + i, destinationChild + i);
         }
     }
+    // Only the rows between source and destination changed
+    reindex(qMin(sourceRow, destinationChild), qMax(sourceLast, destinationChild));
 
     endMoveRows();
 
@@ -245,8 +277,10 @@ bool ActiveSkillsModel::removeRows(int row, int count, const QModelIndex &parent
             model->deleteLater();
             m_delegatesModels.remove(*it);
         }
+        m_rows.remove(*it);
     }
     m_skills.erase(m_skills.begin() + row, m_skills.begin() + row + count);
+    reindex(row);
 
     endRemoveRows();
     syncActiveIndex();
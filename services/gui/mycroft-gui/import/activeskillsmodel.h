@@ -19,6 +19,8 @@
 
 #include <QAbstractListModel>
 #include <QSortFilterProxyModel>
+#include <QHash>
+#include <QSet>
 
 class AbstractDelegate;
 class DelegatesModel;
@@ -60,10 +62,15 @@ public:
      */
     QModelIndex skillIndex(const QString &skillId);
 
+    /**
+     * @returns true if skillId is an active skill, in constant time
+     */
+    bool containsSkill(const QString &skillId) const;
+
     QStringList activeSkills() const;
 
     DelegatesModel *delegatesModelForSkill(const QString &skillId);
-    QHash<QString, DelegatesModel*> delegatesModels() const;
+    const QHash<QString, DelegatesModel*> &delegatesModels() const;
 
 //REIMPLEMENTED
     bool moveRows(const QModelIndex &sourceParent, int sourceRow, int count, const QModelIndex &destinationParent, int destinationChild) override;
@@ -81,10 +88,19 @@ Q_SIGNALS:
 
 private:
     void syncActiveIndex();
+    /**
+     * Updates m_rows for the skills from row first to row last, -1 meaning the end
+     */
+    void reindex(int first, int last = -1);
+
     int m_activeIndex = -1;
-    QList<QString> m_skills;
-    QList<QString> m_blackList;
-    QList<QString> m_whiteList;
+    QStringList m_skills;
+    // row of every skill in m_skills
+    QHash<QString, int> m_rows;
+    QStringList m_blackList;
+    QStringList m_whiteList;
+    QSet<QString> m_blackListSet;
+    QSet<QString> m_whiteListSet;
     //TODO
     QHash<QString, DelegatesModel*> m_delegatesModels;
 };
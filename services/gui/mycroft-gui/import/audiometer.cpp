@@ -0,0 +1,63 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "audiometer.h"
+
+#if defined(MYCROFT_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define METER_SIMD_SSE2
+#elif defined(MYCROFT_SIMD) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define METER_SIMD_NEON
+#endif
+
+const int AudioMeter::s_chunkFrames;
+
+void AudioMeter::accumulate(const float *samples, int count, float sums[4], float peaks[4])
+{
+#if defined(METER_SIMD_SSE2)
+    // Clearing the sign bit is the absolute value
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 sum = _mm_loadu_ps(sums);
+    __m128 peak = _mm_loadu_ps(peaks);
+    for (int i = 0; i < count; i += 4) {
+        const __m128 value = _mm_loadu_ps(samples + i);
+        sum = _mm_add_ps(sum, _mm_mul_ps(value, value));
+        peak = _mm_max_ps(peak, _mm_and_ps(value, absMask));
+    }
+    _mm_storeu_ps(sums, sum);
+    _mm_storeu_ps(peaks, peak);
+#elif defined(METER_SIMD_NEON)
+    float32x4_t sum = vld1q_f32(sums);
+    float32x4_t peak = vld1q_f32(peaks);
+    for (int i = 0; i < count; i += 4) {
+        const float32x4_t value = vld1q_f32(samples + i);
+        sum = vmlaq_f32(sum, value, value);
+        peak = vmaxq_f32(peak, vabsq_f32(value));
+    }
+    vst1q_f32(sums, sum);
+    vst1q_f32(peaks, peak);
+#else
+    for (int i = 0; i < count; i += 4) {
+        for (int lane = 0; lane < 4; ++lane) {
+            const float value = samples[i + lane];
+            sums[lane] += value * value;
+            peaks[lane] = qMax(peaks[lane], std::abs(value));
+        }
+    }
+#endif
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <cmath>
+#include <limits>
+
+/**
+ * Peak and RMS of the two channels of an audio stream, from 0 to 1.
+ * Mono streams report the same values on both channels.
+ */
+struct AudioLevels
+{
+    float peakLeft = 0;
+    float peakRight = 0;
+    float rmsLeft = 0;
+    float rmsRight = 0;
+};
+
+/**
+ * Conversion of interleaved samples of any common format to floats from
+ * -1 to 1, with the peak and RMS metering of every channel.
+ * The conversion is specialized per sample type at compile time, the
+ * accumulation runs on SSE2 or NEON when built with MYCROFT_SIMD.
+ */
+class AudioMeter
+{
+public:
+    /**
+     * Meters frameCount interleaved frames of data, and hands the first
+     * channel converted to float to sink(const float *samples, int count)
+     * in chunks.
+     */
+    template<typename Sample, typename Sink>
+    static AudioLevels process(const Sample *data, int frameCount, int channelCount, Sink sink);
+
+    /**
+     * @internal Adds the squares and maximum of the absolute values of
+     * count interleaved stereo (or mono) floats to the 4 lanes of sums and
+     * peaks: lanes 0 and 2 are the left channel, 1 and 3 the right one.
+     * count must be a multiple of 4.
+     */
+    static void accumulate(const float *samples, int count, float sums[4], float peaks[4]);
+
+private:
+    static const int s_chunkFrames = 256;
+};
+
+// Normalization of one sample of each supported type to [-1, 1]
+inline float toFloatSample(qint8 sample) { return sample / 128.0f; }
+inline float toFloatSample(quint8 sample) { return (int(sample) - 128) / 128.0f; }
+inline float toFloatSample(qint16 sample) { return sample / 32768.0f; }
+inline float toFloatSample(quint16 sample) { return (int(sample) - 32768) / 32768.0f; }
+inline float toFloatSample(qint32 sample) { return float(sample / 2147483648.0); }
+inline float toFloatSample(quint32 sample) { return float((double(sample) - 2147483648.0) / 2147483648.0); }
+inline float toFloatSample(float sample) { return std::isfinite(sample) ? qBound(-1.0f, sample, 1.0f) : 0.0f; }
+
+template<typename Sample, typename Sink>
+AudioLevels AudioMeter::process(const Sample *data, int frameCount, int channelCount, Sink sink)
+{
+    AudioLevels levels;
+    if (frameCount <= 0 || channelCount <= 0) {
+        return levels;
+    }
+
+    // Only the first two channels get metered
+    const int metered = qMin(channelCount, 2);
+    float sums[4] = {0, 0, 0, 0};
+    float peaks[4] = {0, 0, 0, 0};
+    // Interleaved left/right (or mono), then the first channel alone
+    float interleaved[s_chunkFrames * 2];
+    float firstChannel[s_chunkFrames];
+
+    for (int start = 0; start < frameCount; start += s_chunkFrames) {
+        const int frames = qMin(s_chunkFrames, frameCount - start);
+        const Sample *in = data + start * channelCount;
+
+        for (int i = 0; i < frames; ++i) {
+            const float value = toFloatSample(in[i * channelCount]);
+            firstChannel[i] = value;
+            interleaved[i * metered] = value;
+            if (metered == 2) {
+                interleaved[i * metered + 1] = toFloatSample(in[i * channelCount + 1]);
+            }
+        }
+
+        // Pad to the vector width, zeros don't change sums nor peaks
+        int count = frames * metered;
+        while (count % 4) {
+            interleaved[count++] = 0;
+        }
+        accumulate(interleaved, count, sums, peaks);
+
+        sink(firstChannel, frames);
+    }
+
+    if (metered == 2) {
+        levels.peakLeft = qMax(peaks[0], peaks[2]);
+        levels.peakRight = qMax(peaks[1], peaks[3]);
+        levels.rmsLeft = std::sqrt((sums[0] + sums[2]) / frameCount);
+        levels.rmsRight = std::sqrt((sums[1] + sums[3]) / frameCount);
+    } else {
+        levels.peakLeft = levels.peakRight = qMax(qMax(peaks[0], peaks[1]), qMax(peaks[2], peaks[3]));
+        levels.rmsLeft = levels.rmsRight = std::sqrt((sums[0] + sums[1] + sums[2] + sums[3]) / frameCount);
+    }
+
+    return levels;
+}
@@ -5,24 +5,62 @@
 #include <QFile>
 #include <QDir>
 #include <QDebug>
-#include <QAudioBuffer>
-#include <QIODevice>
+#include <QAudioDeviceInfo>
+#include <QtEndian>
+
+static const char s_streamMagic[] = "MAUD";
+
+// Duration of the audio in each streamed chunk
+static const int s_chunkMsecs = 100;
 
 AudioRec::AudioRec(QObject *parent) :
     QObject(parent),
-    m_controller(MycroftController::instance())
+    m_controller(MycroftController::instance()),
+    m_engine(new CaptureEngine(this))
+{
+    connect(m_engine, &CaptureEngine::samplesAvailable, this, &AudioRec::captureDataFromDevice);
+    connect(m_engine, &CaptureEngine::finished, this, &AudioRec::finishRecording);
+    connect(m_engine, &CaptureEngine::levelsChanged, this, [this](float peak, float rms) {
+        Q_UNUSED(rms)
+        // Nobody looks at the level meter while idle
+        if (m_controller->powerState() != MycroftController::Idle) {
+            emit micAudioLevelChanged(peak);
+        }
+    });
+}
+
+bool AudioRec::isStreaming() const
+{
+    return m_streaming;
+}
+
+void AudioRec::setStreaming(bool streaming)
+{
+    if (streaming == m_streaming) {
+        return;
+    }
+
+    m_streaming = streaming;
+    emit streamingChanged();
+}
+
+bool AudioRec::voiceActivityDetection() const
 {
+    return m_voiceActivityDetection;
+}
 
+void AudioRec::setVoiceActivityDetection(bool detection)
+{
+    if (detection == m_voiceActivityDetection) {
+        return;
+    }
+
+    m_voiceActivityDetection = detection;
+    emit voiceActivityDetectionChanged();
 }
 
 void AudioRec::recordTStart()
 {
-//    destinationFile.setFileName(QStringLiteral("/tmp/mycroft_in.raw"));
-//    destinationFile.open( QIODevice::WriteOnly | QIODevice::Truncate );
-    QByteArray byteArray;
-    QBuffer buffer(&byteArray);
-    buffer.open( QIODevice::ReadWrite | QIODevice::Truncate );
-    //connect(&buffer, &QBuffer::bytesWritten, this, &AudioRec::bytesWritten);
     QAudioFormat format;
     format.setSampleRate(8000);
     format.setChannelCount(1);
@@ -37,25 +75,89 @@ void AudioRec::recordTStart()
          format = info.nearestFormat(format);
      }
 
-    audio = new QAudioInput(format, this);
-    //audio->start(&destinationFile);
-    device = audio->start();
-    destinationFile.setFileName(QStringLiteral("/tmp/mycroft_in.raw"));
-    destinationFile.open( QIODevice::WriteOnly | QIODevice::Truncate );
-    connect(device, &QIODevice::readyRead, this, &AudioRec::captureDataFromDevice);
-    //audio->start();
+    if (m_recording) {
+        // Restarting: whatever is left of the previous one is dropped
+        destinationFile.close();
+    }
+    m_format = format;
+    m_recording = true;
+
+    m_streamingRecording = m_streaming;
+    if (m_streamingRecording) {
+        m_chunk.clear();
+        m_chunkSize = format.bytesForDuration(s_chunkMsecs * 1000);
+        if (m_chunkSize <= 0) {
+            // Invalid format, never loop on empty chunks
+            m_chunkSize = 1024;
+        }
+        m_sequence = 0;
+    } else {
+        destinationFile.setFileName(QStringLiteral("/tmp/mycroft_in.raw"));
+        destinationFile.open( QIODevice::WriteOnly | QIODevice::Truncate );
+    }
+
+    m_engine->start(format, m_voiceActivityDetection);
 }
 
 void AudioRec::recordTStop()
 {
-    qDebug() << "I SHOULD NOT BE HERE";
-    audio->stop();
-    destinationFile.close();
+    if (!m_recording) {
+        // Already completed by the voice activity detection
+        return;
+    }
+
+    // Completes once the capture thread handed over its last samples
+    m_engine->stop();
+}
+
+void AudioRec::finishRecording()
+{
+    if (!m_recording) {
+        return;
+    }
+    m_recording = false;
+
+    captureDataFromDevice();
+    if (m_streamingRecording) {
+        // Whatever is left, possibly nothing, closes the utterance
+        sendChunk(m_chunk, EndFlag);
+        m_chunk.clear();
+    } else {
+        destinationFile.close();
+    }
     emit recordTStatus(QStringLiteral("Completed"));
 }
 
+void AudioRec::sendChunk(const QByteArray &samples, quint8 flags)
+{
+    if (m_sequence == 0) {
+        flags |= BeginFlag;
+    }
+
+    const QAudioFormat &format = m_format;
+    QByteArray frame;
+    frame.reserve(15 + samples.size());
+    frame.append(s_streamMagic, 4);
+    frame.append(char(flags));
+
+    uchar numbers[8];
+    qToLittleEndian<quint32>(m_sequence++, numbers);
+    qToLittleEndian<quint32>(quint32(format.sampleRate()), numbers + 4);
+    frame.append(reinterpret_cast<const char *>(numbers), 8);
+    frame.append(char(format.channelCount()));
+    frame.append(char(format.sampleSize()));
+    frame.append(samples);
+
+    m_controller->sendBinaryFrame(frame);
+}
+
 void AudioRec::readStream()
 {
+    if (m_streamingRecording) {
+        // Already sent while recording
+        return;
+    }
+
     QFile inputFile;
     QDir::setCurrent(QStringLiteral("/tmp"));
     inputFile.setFileName(QStringLiteral("mycroft_in.raw"));
@@ -70,6 +172,10 @@ void AudioRec::readStream()
 
 void AudioRec::returnStream()
 {
+    if (m_streamingRecording) {
+        return;
+    }
+
     QJsonObject dataObject;
     QByteArray utteranceArray;
     utteranceArray.push_front(m_audStream.toHex());
@@ -80,23 +186,20 @@ void AudioRec::returnStream()
 
 void AudioRec::captureDataFromDevice()
 {
-    QByteArray inputByteArray = device->readAll();
-    destinationFile.write(inputByteArray);
-    const int channelbytes = audio->format().sampleSize() / 8;
-    const int samplebytes = audio->format().channelCount() * channelbytes;
-    const int samplecount = inputByteArray.size() / samplebytes;
-    quint32 maxvalue= 0;
-    quint32 value = 0;
-    quint32 amp = 255;
-    const unsigned char* ptr = reinterpret_cast<const unsigned char*>(inputByteArray.data());
-    for (int i = 0; i < samplecount; ++i) {
-        for (int j = 0; j < audio->format().channelCount(); ++j) {
-            value = *reinterpret_cast<const quint8*>(ptr);
+    const QByteArray inputByteArray = m_engine->takeSamples();
+    if (inputByteArray.isEmpty()) {
+        return;
+    }
+
+    if (m_streamingRecording) {
+        m_chunk.append(inputByteArray);
+        int sent = 0;
+        while (m_chunk.size() - sent >= m_chunkSize) {
+            sendChunk(m_chunk.mid(sent, m_chunkSize), 0);
+            sent += m_chunkSize;
         }
-        maxvalue = qMax(value, maxvalue);
-        ptr += channelbytes;
+        m_chunk.remove(0, sent);
+    } else {
+        destinationFile.write(inputByteArray);
     }
-    maxvalue = qMin(maxvalue, amp);
-    qreal m_level = qreal(maxvalue) / amp;
-    emit micAudioLevelChanged(m_level);
 }
@@ -6,15 +6,45 @@
 #include <QtWebSockets>
 #include "mycroftcontroller.h"
 #include "controllerconfig.h"
+#include "captureengine.h"
 
-#include <QAudioInput>
+#include <QAudioFormat>
 
+/**
+ * Records the microphone for remote STT.
+ *
+ * By default the recording is written to a file and sent all at once when
+ * it stops. In streaming mode fixed size chunks of raw PCM are sent as
+ * binary frames on the main bus while recording, so the server can start
+ * recognizing while the user is still talking:
+ *   "MAUD" magic, one flags byte (0x01 first chunk, 0x02 last chunk),
+ *   quint32 sequence number, quint32 sample rate, quint8 channel count,
+ *   quint8 bits per sample, then the PCM samples. Numbers are little endian.
+ *
+ * The capture runs on its own thread, see CaptureEngine. With voice
+ * activity detection the silence around the speech is left out and the
+ * recording completes by itself when the user stops talking.
+ */
 class AudioRec : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(bool streaming READ isStreaming WRITE setStreaming NOTIFY streamingChanged)
+    Q_PROPERTY(bool voiceActivityDetection READ voiceActivityDetection WRITE setVoiceActivityDetection NOTIFY voiceActivityDetectionChanged)
+
 public:
+    enum StreamFlag {
+        BeginFlag = 0x01,
+        EndFlag = 0x02
+    };
+
     explicit AudioRec(QObject *parent = nullptr);
 
+    bool isStreaming() const;
+    void setStreaming(bool streaming);
+
+    bool voiceActivityDetection() const;
+    void setVoiceActivityDetection(bool detection);
+
 public Q_SLOTS:
     void recordTStart();
     void recordTStop();
@@ -25,14 +55,28 @@ public Q_SLOTS:
 Q_SIGNALS:
     void recordTStatus(const QString &recStatus);
     void micAudioLevelChanged(const qreal &micLevel);
+    void streamingChanged();
+    void voiceActivityDetectionChanged();
 
 private:
+    void sendChunk(const QByteArray &samples, quint8 flags);
+    void finishRecording();
+
     MycroftController *m_controller;
     QFile destinationFile;
     QByteArray m_audStream;
     qint16 m_audStream_size;
-    QAudioInput *audio;
-    QIODevice *device;
+    CaptureEngine *m_engine;
+    QAudioFormat m_format;
+    bool m_recording = false;
+    bool m_voiceActivityDetection = true;
+
+    bool m_streaming = false;
+    // Whether the current or last recording has been streamed
+    bool m_streamingRecording = false;
+    QByteArray m_chunk;
+    int m_chunkSize = 0;
+    quint32 m_sequence = 0;
 };
 
 #endif // AUDIOREC_H
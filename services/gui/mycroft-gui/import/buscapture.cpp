@@ -0,0 +1,155 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "buscapture.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QWebSocket>
+#include <QtEndian>
+
+static const char s_captureVariable[] = "MYCROFT_GUI_CAPTURE";
+static const char s_logMagic[] = "MBUS";
+static const quint8 s_logVersion = 1;
+static const int s_recordHeaderSize = 13;
+
+bool BusCapture::isEnabled()
+{
+    static const bool enabled = qEnvironmentVariableIsSet(s_captureVariable);
+    return enabled;
+}
+
+BusCapture *BusCapture::instance()
+{
+    static BusCapture *s_self = nullptr;
+    if (!s_self) {
+        s_self = new BusCapture(QCoreApplication::instance());
+    }
+    return s_self;
+}
+
+BusCapture::BusCapture(QObject *parent)
+    : QObject(parent)
+{
+    m_file.setFileName(QString::fromLocal8Bit(qgetenv(s_captureVariable)));
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Could not open the bus capture" << m_file.fileName() << m_file.errorString();
+        return;
+    }
+
+    m_file.write(s_logMagic, 4);
+    m_file.write(reinterpret_cast<const char *>(&s_logVersion), 1);
+    m_clock.start();
+
+    // Buffered by QFile, what is captured reaches the disk at most a second later
+    m_flushTimer.setInterval(1000);
+    connect(&m_flushTimer, &QTimer::timeout, this, [this]() {
+        m_file.flush();
+    });
+    m_flushTimer.start();
+
+    qInfo() << "Capturing the bus traffic to" << m_file.fileName();
+}
+
+BusCapture::~BusCapture()
+{
+    m_file.flush();
+}
+
+void BusCapture::attach(QWebSocket *socket, Channel channel)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    BusCapture *capture = instance();
+    connect(socket, &QWebSocket::textMessageReceived, capture, [capture, channel](const QString &message) {
+        capture->record(channel, 0, message.toUtf8());
+    });
+    connect(socket, &QWebSocket::binaryMessageReceived, capture, [capture, channel](const QByteArray &frame) {
+        capture->record(channel, Binary, frame);
+    });
+}
+
+void BusCapture::recordOutbound(Channel channel, const QString &message)
+{
+    if (isEnabled()) {
+        instance()->record(channel, Outbound, message.toUtf8());
+    }
+}
+
+void BusCapture::recordOutbound(Channel channel, const QByteArray &frame)
+{
+    if (isEnabled()) {
+        instance()->record(channel, Outbound | Binary, frame);
+    }
+}
+
+void BusCapture::record(Channel channel, quint8 flags, const QByteArray &payload)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    uchar header[s_recordHeaderSize];
+    qToLittleEndian<quint32>(quint32(payload.size()), header);
+    header[4] = quint8(channel & ChannelMask) | flags;
+    qToLittleEndian<quint64>(quint64(m_clock.nsecsElapsed() / 1000), header + 5);
+
+    m_file.write(reinterpret_cast<const char *>(header), s_recordHeaderSize);
+    m_file.write(payload);
+}
+
+bool BusCapture::readLog(const QString &path, QVector<Frame> &frames)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open the bus capture" << path << file.errorString();
+        return false;
+    }
+
+    const QByteArray data = file.readAll();
+    if (!data.startsWith(s_logMagic) || data.size() < 5 || quint8(data.at(4)) != s_logVersion) {
+        qWarning() << path << "is not a bus capture of a supported version";
+        return false;
+    }
+
+    const uchar *raw = reinterpret_cast<const uchar *>(data.constData());
+    int offset = 5;
+    while (offset + s_recordHeaderSize <= data.size()) {
+        const quint32 size = qFromLittleEndian<quint32>(raw + offset);
+        if (size > quint32(data.size() - offset - s_recordHeaderSize)) {
+            qWarning() << "Truncated record at the end of the bus capture" << path;
+            return true;
+        }
+
+        Frame frame;
+        const quint8 flags = raw[offset + 4];
+        frame.channel = Channel(flags & ChannelMask);
+        frame.outbound = flags & Outbound;
+        frame.binary = flags & Binary;
+        frame.timestamp = qint64(qFromLittleEndian<quint64>(raw + offset + 5));
+        frame.payload = data.mid(offset + s_recordHeaderSize, int(size));
+        frames.append(frame);
+
+        offset += s_recordHeaderSize + int(size);
+    }
+
+    return true;
+}
+
+#include "moc_buscapture.cpp"
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+#include <QVector>
+
+class QWebSocket;
+
+/**
+ * Records every frame going through the main and gui sockets, with when it
+ * happened, to replay the same traffic later with replayserver from autotests.
+ *
+ * Only enabled when the MYCROFT_GUI_CAPTURE environment variable is set,
+ * frames are appended to the file it names.
+ *
+ * The log is "MBUS" and a version byte, then one record per frame:
+ *   payload size, quint32 little endian
+ *   flags, one byte: channel in the low bits, Outbound and Binary flags
+ *   microseconds since the start of the capture, quint64 little endian
+ *   the payload as sent on the socket
+ */
+class BusCapture : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Channel {
+        MainChannel = 0,
+        GuiChannel = 1
+    };
+
+    enum Flag {
+        ChannelMask = 0x0F,
+        Outbound = 0x10,
+        Binary = 0x20
+    };
+
+    struct Frame {
+        qint64 timestamp = 0;
+        Channel channel = MainChannel;
+        bool outbound = false;
+        bool binary = false;
+        QByteArray payload;
+    };
+
+    static bool isEnabled();
+
+    /**
+     * Records all the frames received on socket
+     */
+    static void attach(QWebSocket *socket, Channel channel);
+
+    /**
+     * Records a frame about to be sent
+     */
+    static void recordOutbound(Channel channel, const QString &message);
+    static void recordOutbound(Channel channel, const QByteArray &frame);
+
+    /**
+     * Reads a whole log written by a capture
+     * @returns false, with a warning, if path is not a valid log. Frames until
+     *          a truncated record at the end are still returned
+     */
+    static bool readLog(const QString &path, QVector<Frame> &frames);
+
+private:
+    static BusCapture *instance();
+    explicit BusCapture(QObject *parent = nullptr);
+    ~BusCapture() override;
+
+    void record(Channel channel, quint8 flags, const QByteArray &payload);
+
+    QFile m_file;
+    QElapsedTimer m_clock;
+    QTimer m_flushTimer;
+};
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "bussyncthrottle.h"
+#include "mycroftcontroller.h"
+
+BusSyncThrottle::BusSyncThrottle(MycroftController *controller, QObject *parent)
+    : QObject(parent),
+      m_controller(controller)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &BusSyncThrottle::sendDue);
+}
+
+int BusSyncThrottle::interval() const
+{
+    return m_interval;
+}
+
+void BusSyncThrottle::setInterval(int interval)
+{
+    m_interval = qMax(0, interval);
+    if (m_interval == 0) {
+        flush();
+    }
+}
+
+void BusSyncThrottle::send(const QString &type, const QVariantMap &data)
+{
+    Channel &channel = m_channels[type];
+
+    if (channel.hasPending) {
+        // A later value supersedes the pending one, unless it goes back to what was sent
+        if (channel.hasSent && data == channel.lastSent) {
+            channel.hasPending = false;
+            channel.pending.clear();
+        } else {
+            channel.pending = data;
+        }
+        return;
+    }
+
+    if (channel.hasSent && data == channel.lastSent) {
+        return;
+    }
+
+    if (m_interval == 0 || !channel.sinceSent.isValid() || channel.sinceSent.elapsed() >= m_interval) {
+        sendNow(type, channel, data);
+        return;
+    }
+
+    channel.pending = data;
+    channel.hasPending = true;
+    const int remaining = int(m_interval - channel.sinceSent.elapsed());
+    if (!m_timer.isActive() || m_timer.remainingTime() > remaining) {
+        m_timer.start(qMax(0, remaining));
+    }
+}
+
+void BusSyncThrottle::flush()
+{
+    m_timer.stop();
+    for (auto it = m_channels.begin(); it != m_channels.end(); ++it) {
+        if (it.value().hasPending) {
+            sendNow(it.key(), it.value(), it.value().pending);
+        }
+    }
+}
+
+void BusSyncThrottle::sendNow(const QString &type, Channel &channel, const QVariantMap &data)
+{
+    m_controller->sendRequest(type, data);
+
+    // What couldn't be sent must not hide the next identical value, it will be needed after a reconnection
+    channel.hasSent = m_controller->status() == MycroftController::Open;
+    channel.lastSent = channel.hasSent ? data : QVariantMap();
+    channel.sinceSent.start();
+    // Last, data may be a reference to it
+    channel.hasPending = false;
+    channel.pending.clear();
+}
+
+void BusSyncThrottle::sendDue()
+{
+    int next = -1;
+
+    for (auto it = m_channels.begin(); it != m_channels.end(); ++it) {
+        Channel &channel = it.value();
+        if (!channel.hasPending) {
+            continue;
+        }
+
+        const int remaining = int(m_interval - channel.sinceSent.elapsed());
+        if (remaining <= 0) {
+            sendNow(it.key(), channel, channel.pending);
+        } else if (next < 0 || remaining < next) {
+            next = remaining;
+        }
+    }
+
+    if (next >= 0) {
+        m_timer.start(next);
+    }
+}
+
+#include "moc_bussyncthrottle.cpp"
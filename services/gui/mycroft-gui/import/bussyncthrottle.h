@@ -0,0 +1,66 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTimer>
+#include <QVariantMap>
+
+class MycroftController;
+
+/**
+ * Rate limiter for state sync messages sent on the main bus.
+ * For every message type, a message equal to the last one sent is dropped,
+ * the first change is sent right away and further changes within the
+ * interval are coalesced, so only the latest one is sent when it expires.
+ */
+class BusSyncThrottle : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BusSyncThrottle(MycroftController *controller, QObject *parent = nullptr);
+
+    // Minimum time between two messages of the same type, in ms; 0 disables the throttling
+    int interval() const;
+    void setInterval(int interval);
+
+    void send(const QString &type, const QVariantMap &data);
+
+    // Sends everything still pending right away
+    void flush();
+
+private:
+    struct Channel {
+        QVariantMap lastSent;
+        bool hasSent = false;
+        QVariantMap pending;
+        bool hasPending = false;
+        QElapsedTimer sinceSent;
+    };
+
+    void sendNow(const QString &type, Channel &channel, const QVariantMap &data);
+    void sendDue();
+
+    MycroftController *m_controller;
+    QHash<QString, Channel> m_channels;
+    QTimer m_timer;
+    int m_interval = 250;
+};
@@ -0,0 +1,325 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "captureengine.h"
+#include "audiometer.h"
+
+#include <QAudioDeviceInfo>
+#include <QDebug>
+
+#include <cmath>
+
+// Over 5 seconds of 48 kHz 16 bit stereo
+static const int s_bufferBytes = 1024 * 1024;
+static const int s_frameMsecs = 20;
+static const int s_levelsMsecs = 50;
+// Silence kept before and after the speech
+static const int s_preRollMsecs = 300;
+static const int s_tailMsecs = 200;
+// Gives up when no speech started in that time
+static const int s_noSpeechMsecs = 5000;
+
+template<typename Sample>
+static AudioLevels meterFrame(const char *data, int frameCount, int channelCount)
+{
+    return AudioMeter::process(reinterpret_cast<const Sample *>(data), frameCount, channelCount,
+                               [](const float *, int) {});
+}
+
+// @returns false for formats that can't be metered
+static bool meterFrame(const QAudioFormat &format, const char *data, int frameCount, AudioLevels &levels)
+{
+    const int channels = format.channelCount();
+
+    switch (format.sampleType()) {
+    case QAudioFormat::SignedInt:
+        if (format.sampleSize() == 32) {
+            levels = meterFrame<qint32>(data, frameCount, channels);
+        } else if (format.sampleSize() == 16) {
+            levels = meterFrame<qint16>(data, frameCount, channels);
+        } else if (format.sampleSize() == 8) {
+            levels = meterFrame<qint8>(data, frameCount, channels);
+        } else {
+            return false;
+        }
+        return true;
+    case QAudioFormat::UnSignedInt:
+        if (format.sampleSize() == 32) {
+            levels = meterFrame<quint32>(data, frameCount, channels);
+        } else if (format.sampleSize() == 16) {
+            levels = meterFrame<quint16>(data, frameCount, channels);
+        } else if (format.sampleSize() == 8) {
+            levels = meterFrame<quint8>(data, frameCount, channels);
+        } else {
+            return false;
+        }
+        return true;
+    case QAudioFormat::Float:
+        if (format.sampleSize() != 32) {
+            return false;
+        }
+        levels = meterFrame<float>(data, frameCount, channels);
+        return true;
+    default:
+        return false;
+    }
+}
+
+CaptureEngine::CaptureEngine(QObject *parent)
+    : QObject(parent),
+      m_worker(new CaptureEngineWorker(&m_samples, &m_notified)),
+      m_samples(s_bufferBytes)
+{
+    qRegisterMetaType<QAudioFormat>();
+
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &CaptureEngineWorker::samplesAvailable, this, &CaptureEngine::samplesAvailable);
+    connect(m_worker, &CaptureEngineWorker::levelsChanged, this, &CaptureEngine::levelsChanged);
+    connect(m_worker, &CaptureEngineWorker::speechStarted, this, &CaptureEngine::speechStarted);
+    connect(m_worker, &CaptureEngineWorker::speechEnded, this, &CaptureEngine::speechEnded);
+    connect(m_worker, &CaptureEngineWorker::finished, this, &CaptureEngine::finished);
+
+    m_thread.setObjectName(QStringLiteral("CaptureEngine"));
+    m_thread.start();
+}
+
+CaptureEngine::~CaptureEngine()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void CaptureEngine::start(const QAudioFormat &format, bool voiceActivityDetection)
+{
+    // Leftovers of the previous recording
+    m_notified = false;
+    m_samples.skip(m_samples.availableRead());
+
+    QMetaObject::invokeMethod(m_worker, "start", Qt::QueuedConnection,
+                              Q_ARG(QAudioFormat, format), Q_ARG(bool, voiceActivityDetection));
+}
+
+void CaptureEngine::stop()
+{
+    QMetaObject::invokeMethod(m_worker, "stop", Qt::QueuedConnection);
+}
+
+QByteArray CaptureEngine::takeSamples()
+{
+    // Before reading: samples written from now on notify again
+    m_notified = false;
+
+    QByteArray samples(m_samples.availableRead(), Qt::Uninitialized);
+    samples.resize(m_samples.read(samples.data(), samples.size()));
+    return samples;
+}
+
+CaptureEngineWorker::CaptureEngineWorker(SpscRingBuffer<char> *samples, std::atomic<bool> *notified)
+    : QObject(nullptr),
+      m_samples(samples),
+      m_notified(notified),
+      m_vad(s_frameMsecs)
+{
+}
+
+void CaptureEngineWorker::start(const QAudioFormat &format, bool voiceActivityDetection)
+{
+    if (m_input) {
+        m_input->stop();
+        delete m_input;
+        m_device = nullptr;
+    }
+
+    m_format = format;
+    const int bytesPerFrame = qMax(1, format.bytesPerFrame());
+    m_frameBytes = qMax(bytesPerFrame, format.bytesForDuration(s_frameMsecs * 1000) / bytesPerFrame * bytesPerFrame);
+
+    // Metering no frame at all tells whether the format is supported
+    AudioLevels levels;
+    m_metered = meterFrame(format, nullptr, 0, levels);
+    m_vadEnabled = voiceActivityDetection && m_metered;
+    if (voiceActivityDetection && !m_metered) {
+        qWarning() << "Can't detect voice activity in" << format << "recording everything";
+    }
+
+    m_pending.clear();
+    m_held.clear();
+    m_vad.reset();
+    m_speechStarted = false;
+    m_peak = 0;
+    m_squares = 0;
+    m_meteredFrames = 0;
+    m_overrunWarned = false;
+
+    m_input = new QAudioInput(format, this);
+    m_device = m_input->start();
+    if (!m_device) {
+        qWarning() << "Could not start capturing the microphone";
+        finish();
+        return;
+    }
+    connect(m_device, &QIODevice::readyRead, this, &CaptureEngineWorker::readDevice);
+
+    m_elapsed.start();
+    m_levelsTimer.start();
+}
+
+void CaptureEngineWorker::stop()
+{
+    if (!m_input) {
+        return;
+    }
+
+    readDevice();
+    if (!m_input) {
+        // Stopped by itself while reading the last samples
+        return;
+    }
+
+    if (!m_vadEnabled) {
+        push(m_pending.constData(), m_pending.size());
+    } else if (m_speechStarted) {
+        // Stopped in a pause: only a margin of it
+        const int tail = m_format.bytesForDuration(s_tailMsecs * 1000);
+        push(m_held.constData(), qMin(tail, m_held.size()));
+        if (m_held.isEmpty()) {
+            push(m_pending.constData(), m_pending.size());
+        }
+    }
+    finish();
+}
+
+void CaptureEngineWorker::readDevice()
+{
+    if (!m_device) {
+        return;
+    }
+
+    m_pending.append(m_device->readAll());
+
+    int offset = 0;
+    while (m_input && m_pending.size() - offset >= m_frameBytes) {
+        processFrame(m_pending.constData() + offset);
+        offset += m_frameBytes;
+    }
+    m_pending.remove(0, offset);
+}
+
+void CaptureEngineWorker::processFrame(const char *data)
+{
+    AudioLevels levels;
+    if (m_metered) {
+        meterFrame(m_format, data, m_frameBytes / m_format.bytesPerFrame(), levels);
+
+        m_peak = qMax(m_peak, qMax(levels.peakLeft, levels.peakRight));
+        m_squares += (levels.rmsLeft * levels.rmsLeft + levels.rmsRight * levels.rmsRight) / 2;
+        ++m_meteredFrames;
+        if (m_levelsTimer.elapsed() >= s_levelsMsecs) {
+            emit levelsChanged(m_peak, std::sqrt(m_squares / m_meteredFrames));
+            m_peak = 0;
+            m_squares = 0;
+            m_meteredFrames = 0;
+            m_levelsTimer.restart();
+        }
+    }
+
+    if (!m_vadEnabled) {
+        push(data, m_frameBytes);
+        return;
+    }
+
+    const VoiceActivityDetector::Event event = m_vad.process(qMax(levels.rmsLeft, levels.rmsRight));
+
+    if (!m_speechStarted) {
+        if (event == VoiceActivityDetector::SpeechStarted) {
+            m_speechStarted = true;
+            push(m_held.constData(), m_held.size());
+            m_held.clear();
+            push(data, m_frameBytes);
+            emit speechStarted();
+            return;
+        }
+
+        m_held.append(data, m_frameBytes);
+        const int preRoll = m_format.bytesForDuration(s_preRollMsecs * 1000) / m_frameBytes * m_frameBytes;
+        if (m_held.size() > preRoll) {
+            m_held.remove(0, m_held.size() - preRoll);
+        }
+
+        if (m_elapsed.elapsed() >= s_noSpeechMsecs) {
+            qDebug() << "No speech in" << s_noSpeechMsecs << "ms, stop recording";
+            emit speechEnded();
+            finish();
+        }
+        return;
+    }
+
+    if (event == VoiceActivityDetector::SpeechEnded) {
+        // Only a margin of the hangover silence
+        const int tail = m_format.bytesForDuration(s_tailMsecs * 1000);
+        push(m_held.constData(), qMin(tail, m_held.size()));
+        m_held.clear();
+        emit speechEnded();
+        finish();
+        return;
+    }
+
+    if (m_vad.isVoiced()) {
+        // The pause was part of the speech
+        push(m_held.constData(), m_held.size());
+        m_held.clear();
+        push(data, m_frameBytes);
+    } else {
+        m_held.append(data, m_frameBytes);
+    }
+}
+
+void CaptureEngineWorker::push(const char *data, int size)
+{
+    if (size <= 0) {
+        return;
+    }
+
+    const int written = m_samples->write(data, size);
+    if (written < size && !m_overrunWarned) {
+        qWarning() << "Capture buffer full, dropping" << (size - written) << "bytes";
+        m_overrunWarned = true;
+    }
+
+    if (!m_notified->exchange(true)) {
+        emit samplesAvailable();
+    }
+}
+
+void CaptureEngineWorker::finish()
+{
+    if (m_input) {
+        m_input->stop();
+        // Not delete: finish() may run from the readyRead of its device
+        m_input->deleteLater();
+        m_input = nullptr;
+    }
+    m_device = nullptr;
+    m_pending.clear();
+    m_held.clear();
+
+    emit levelsChanged(0, 0);
+    emit finished();
+}
+
+#include "moc_captureengine.cpp"
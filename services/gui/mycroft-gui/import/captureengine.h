@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QAudioFormat>
+#include <QAudioInput>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QThread>
+
+#include <atomic>
+
+#include "spscringbuffer.h"
+#include "voiceactivitydetector.h"
+
+class CaptureEngineWorker;
+
+/**
+ * Captures the microphone on a dedicated thread.
+ *
+ * Every 20 ms of audio is metered, whatever the sample format, and goes
+ * through a VoiceActivityDetector when it is enabled: the silence before
+ * and after the speech is trimmed, keeping a short margin, and the capture
+ * stops by itself once the speech ended, or when nobody talked at all.
+ * The samples kept are handed over in a lock free ring buffer, read on
+ * the GUI thread with takeSamples() after samplesAvailable().
+ */
+class CaptureEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CaptureEngine(QObject *parent = nullptr);
+    ~CaptureEngine() override;
+
+    /**
+     * Starts capturing the default input device, stopping any capture in progress.
+     * format must be supported by the device.
+     */
+    void start(const QAudioFormat &format, bool voiceActivityDetection);
+
+    /**
+     * Stops the capture, finished() arrives once the last samples are in the buffer
+     */
+    void stop();
+
+    /**
+     * Everything captured since the last call
+     */
+    QByteArray takeSamples();
+
+Q_SIGNALS:
+    // Emitted once until takeSamples() is called
+    void samplesAvailable();
+    // At most every 50 ms, from 0 to 1
+    void levelsChanged(float peak, float rms);
+    void speechStarted();
+    // The capture is about to stop by itself
+    void speechEnded();
+    void finished();
+
+private:
+    QThread m_thread;
+    CaptureEngineWorker *m_worker;
+    SpscRingBuffer<char> m_samples;
+    std::atomic<bool> m_notified{false};
+};
+
+/**
+ * @internal Lives in the capture thread, producer of the ring buffer
+ */
+class CaptureEngineWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    CaptureEngineWorker(SpscRingBuffer<char> *samples, std::atomic<bool> *notified);
+
+public Q_SLOTS:
+    void start(const QAudioFormat &format, bool voiceActivityDetection);
+    void stop();
+
+Q_SIGNALS:
+    void samplesAvailable();
+    void levelsChanged(float peak, float rms);
+    void speechStarted();
+    void speechEnded();
+    void finished();
+
+private:
+    void readDevice();
+    void processFrame(const char *data);
+    void push(const char *data, int size);
+    void finish();
+
+    SpscRingBuffer<char> *m_samples;
+    std::atomic<bool> *m_notified;
+
+    QPointer<QAudioInput> m_input;
+    QIODevice *m_device = nullptr;
+    QAudioFormat m_format;
+    bool m_metered = false;
+
+    // Bytes of one detector frame, and what is left of the last read
+    int m_frameBytes = 0;
+    QByteArray m_pending;
+
+    VoiceActivityDetector m_vad;
+    bool m_vadEnabled = false;
+    bool m_speechStarted = false;
+    // Before the speech: its last frames. During: the silence since the last voiced frame
+    QByteArray m_held;
+    QElapsedTimer m_elapsed;
+
+    QElapsedTimer m_levelsTimer;
+    float m_peak = 0;
+    float m_squares = 0;
+    int m_meteredFrames = 0;
+
+    bool m_overrunWarned = false;
+};
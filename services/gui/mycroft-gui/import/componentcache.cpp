@@ -0,0 +1,156 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "componentcache.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QQmlComponent>
+#include <QQmlEngine>
+
+#include <algorithm>
+
+ComponentCache::ComponentCache(QQmlEngine *engine, QObject *parent)
+    : QObject(parent),
+      m_engine(engine)
+{
+}
+
+ComponentCache::~ComponentCache()
+{
+    for (const Entry &e : qAsConst(m_entries)) {
+        delete e.component;
+    }
+}
+
+QDateTime ComponentCache::lastModified(const QUrl &url)
+{
+    return url.isLocalFile() ? QFileInfo(url.toLocalFile()).lastModified() : QDateTime();
+}
+
+ComponentCache::Entry &ComponentCache::entry(const QUrl &url, bool asynchronous)
+{
+    auto it = m_entries.find(url);
+    if (it != m_entries.end() && it->users == 0 && !it->component->isLoading()
+        && it->modified != lastModified(url)) {
+        delete it->component;
+        m_entries.erase(it);
+        // Otherwise the engine would hand out its stale compiled version again
+        m_engine->trimComponentCache();
+        it = m_entries.end();
+    }
+
+    if (it == m_entries.end()) {
+        it = m_entries.insert(url, Entry());
+        it->modified = lastModified(url);
+        it->component = new QQmlComponent(m_engine, url,
+                                          asynchronous ? QQmlComponent::Asynchronous : QQmlComponent::PreferSynchronous,
+                                          this);
+    }
+
+    it->lastUse = ++m_useCounter;
+    return *it;
+}
+
+QQmlComponent *ComponentCache::acquire(const QUrl &url)
+{
+    if (!m_engine) {
+        qWarning() << "ComponentCache used without an engine";
+        return nullptr;
+    }
+
+    Entry &e = entry(url, false);
+    ++e.users;
+    return e.component;
+}
+
+void ComponentCache::release(const QUrl &url)
+{
+    auto it = m_entries.find(url);
+    if (it == m_entries.end() || it->users == 0) {
+        qWarning() << "Releasing a component which isn't in use" << url;
+        return;
+    }
+
+    --it->users;
+    it->lastUse = ++m_useCounter;
+}
+
+void ComponentCache::prewarm(const QList<QUrl> &urls)
+{
+    if (!m_engine) {
+        return;
+    }
+
+    for (const QUrl &url : urls) {
+        if (url.isValid() && !m_entries.contains(url)) {
+            entry(url, true);
+        }
+    }
+}
+
+int ComponentCache::budget() const
+{
+    return m_budget;
+}
+
+void ComponentCache::setBudget(int budget)
+{
+    m_budget = qMax(0, budget);
+}
+
+int ComponentCache::count() const
+{
+    return m_entries.count();
+}
+
+bool ComponentCache::contains(const QUrl &url) const
+{
+    return m_entries.contains(url);
+}
+
+void ComponentCache::trim()
+{
+    QVector<QHash<QUrl, Entry>::iterator> unused;
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        // Still compiling components are kept: a prewarm or a delegate is waiting for them
+        if (it->users == 0 && !it->component->isLoading()) {
+            unused << it;
+        }
+    }
+
+    if (unused.count() > m_budget) {
+        std::sort(unused.begin(), unused.end(), [](QHash<QUrl, Entry>::iterator a, QHash<QUrl, Entry>::iterator b) {
+            return a->lastUse < b->lastUse;
+        });
+
+        QList<QUrl> evicted;
+        for (int i = 0; i < unused.count() - m_budget; ++i) {
+            evicted << unused[i].key();
+            delete unused[i]->component;
+        }
+        for (const QUrl &url : evicted) {
+            m_entries.remove(url);
+        }
+    }
+
+    if (m_engine) {
+        m_engine->trimComponentCache();
+    }
+}
+
+#include "moc_componentcache.cpp"
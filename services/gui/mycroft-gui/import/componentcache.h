@@ -0,0 +1,89 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <QPointer>
+#include <QUrl>
+#include <QVector>
+
+class QQmlComponent;
+class QQmlEngine;
+
+/**
+ * Keeps the compiled QQmlComponents of skill delegates around, keyed by url,
+ * so that showing the same page again doesn't recompile its QML.
+ *
+ * Components used by a live delegate are never evicted; of the unused ones
+ * only the most recently used budget() are kept. An unused component whose
+ * local file changed on disk is compiled again, so updated skills show up.
+ */
+class ComponentCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ComponentCache(QQmlEngine *engine, QObject *parent = nullptr);
+    ~ComponentCache() override;
+
+    /**
+     * Returns the component for url, compiling it if it isn't cached yet,
+     * and marks it used until release() is called.
+     * The component is owned by the cache and must not be deleted.
+     */
+    QQmlComponent *acquire(const QUrl &url);
+    void release(const QUrl &url);
+
+    /**
+     * Starts compiling urls in the background, without using them
+     */
+    void prewarm(const QList<QUrl> &urls);
+
+    /**
+     * How many unused components are kept
+     */
+    int budget() const;
+    void setBudget(int budget);
+
+    int count() const;
+    bool contains(const QUrl &url) const;
+
+    /**
+     * Evicts the least recently used components over budget and lets the
+     * engine drop the compiled data nothing references anymore
+     */
+    void trim();
+
+private:
+    struct Entry {
+        QQmlComponent *component = nullptr;
+        int users = 0;
+        quint64 lastUse = 0;
+        QDateTime modified;
+    };
+
+    Entry &entry(const QUrl &url, bool asynchronous);
+    static QDateTime lastModified(const QUrl &url);
+
+    QPointer<QQmlEngine> m_engine;
+    QHash<QUrl, Entry> m_entries;
+    quint64 m_useCounter = 0;
+    int m_budget = 16;
+};
@@ -16,6 +16,7 @@
  */
 #include "delegatesmodel.h"
 #include "abstractdelegate.h"
+#include "prioritydispatcher.h"
 
 #include <QTimer>
 #include <QDebug>
@@ -28,12 +29,7 @@ DelegatesModel::DelegatesModel(QObject *parent)
     m_deleteTimer->setSingleShot(true);
     m_deleteTimer->setInterval(2000);
 
-    connect(m_deleteTimer, &QTimer::timeout, this, [this]() {
-        for (auto d : m_delegateLoadersToDelete) {
-            d->deleteLater();
-        }
-        m_delegateLoadersToDelete.clear();
-    });
+    connect(m_deleteTimer, &QTimer::timeout, this, &DelegatesModel::purgeReleased);
 }
 
 DelegatesModel::~DelegatesModel()
@@ -58,10 +54,10 @@ void DelegatesModel::insertDelegateLoaders(int position, QList<DelegateLoader *>
     int i = 0;
     for (auto *loader : loaders) {
         m_delegateLoaders.insert(position + i, loader);
-        if (!loader->delegate()) {
-            connect(loader, &DelegateLoader::delegateCreated, this, [this, loader]() {
+        if (loader->isLoading()) {
+            connect(loader, &DelegateLoader::loadingChanged, this, [this, loader]() {
                 int row = m_delegateLoaders.indexOf(loader);
-                emit dataChanged(index(row, 0), index(row, 0), {DelegateUi});
+                emit dataChanged(index(row, 0), index(row, 0), {DelegateUi, DelegateLoading});
             });
         }
         connect(loader, &QObject::destroyed, this, [this](QObject *obj) {
@@ -78,16 +74,88 @@ void DelegatesModel::insertDelegateLoaders(int position, QList<DelegateLoader *>
 
     m_currentIndex = m_delegateLoaders.indexOf(loaders.first());
     emit currentIndexChanged();
+
+    loaders.first()->load();
+    schedulePrefetch();
+}
+
+int DelegatesModel::currentIndex() const
+{
+    return m_currentIndex;
+}
+
+void DelegatesModel::setCurrentIndex(int index)
+{
+    // Views write -1 while they are empty
+    if (index == m_currentIndex || index < 0 || index >= m_delegateLoaders.count()) {
+        return;
+    }
+
+    m_currentIndex = index;
+    emit currentIndexChanged();
+
+    // Swiped further than what was prefetched: right away
+    if (DelegateLoader *loader = delegateLoaderAt(index)) {
+        loader->load();
+    }
+    schedulePrefetch();
+}
+
+DelegateLoader *DelegatesModel::delegateLoaderAt(int row) const
+{
+    return m_delegateLoaders.value(row);
+}
+
+void DelegatesModel::schedulePrefetch()
+{
+    if (m_prefetchScheduled) {
+        return;
+    }
+
+    m_prefetchScheduled = true;
+    PriorityDispatcher::instance()->post(PriorityDispatcher::Bulk, this, [this]() {
+        prefetch();
+    });
+}
+
+void DelegatesModel::prefetch()
+{
+    m_prefetchScheduled = false;
+    if (m_delegateLoaders.isEmpty()) {
+        return;
+    }
+
+    AbstractSkillView *view = m_delegateLoaders.first()->view();
+    const int count = m_delegateLoaders.count();
+    const int reach = view->pagePrefetch() < 0 ? count : view->pagePrefetch();
+
+    // Nearest first, the next page before the previous one
+    for (int offset = 1; offset <= reach; ++offset) {
+        for (const int row : {m_currentIndex + offset, m_currentIndex - offset}) {
+            DelegateLoader *loader = delegateLoaderAt(row);
+            if (!loader || !loader->isDeferred()) {
+                continue;
+            }
+            // Over the memory budget the pages stay compiled only, until they are shown
+            if (!view->canPrefetchPages()) {
+                return;
+            }
+            loader->load();
+            // The next one once the event loop had a chance to run
+            schedulePrefetch();
+            return;
+        }
+    }
 }
 
 void DelegatesModel::clear()
 {
-    
     beginResetModel();
-    m_delegateLoadersToDelete = m_delegateLoaders;
-    m_deleteTimer->start();
+    const QList<DelegateLoader *> loaders = m_delegateLoaders;
     m_delegateLoaders.clear();
     endResetModel();
+
+    releaseDelegateLoaders(loaders);
 }
 
 QList<AbstractDelegate *> DelegatesModel::delegates() const
@@ -103,6 +171,54 @@ QList<AbstractDelegate *> DelegatesModel::delegates() const
     return delegates;
 }
 
+int DelegatesModel::delegateCount() const
+{
+    int count = 0;
+    for (auto c : m_delegateLoaders) {
+        if (c->delegate()) {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+AbstractDelegate *DelegatesModel::delegateAt(int index) const
+{
+    if (index < 0) {
+        return nullptr;
+    }
+
+    for (auto c : m_delegateLoaders) {
+        if (c->delegate() && index-- == 0) {
+            return c->delegate();
+        }
+    }
+
+    return nullptr;
+}
+
+QList<QUrl> DelegatesModel::delegateUrls() const
+{
+    QList<QUrl> urls;
+    urls.reserve(m_delegateLoaders.count());
+
+    for (auto c : m_delegateLoaders) {
+        urls << c->delegateUrl();
+    }
+
+    return urls;
+}
+
+void DelegatesModel::purgeReleased()
+{
+    m_deleteTimer->stop();
+    for (auto d : m_delegateLoadersToDelete) {
+        d->deleteLater();
+    }
+    m_delegateLoadersToDelete.clear();
+}
+
 bool DelegatesModel::moveRows(const QModelIndex &sourceParent, int sourceRow, int count, const QModelIndex &destinationParent, int destinationChild)
 {
     if (sourceParent.isValid() || destinationParent.isValid()) {
@@ -141,15 +257,33 @@ bool DelegatesModel::removeRows(int row, int count, const QModelIndex &parent)
     }
 
     beginRemoveRows(parent, row, row + count - 1);
-    std::copy(m_delegateLoaders.begin() + row, m_delegateLoaders.begin() + row + count,
-              std::back_inserter(m_delegateLoadersToDelete));
-    m_deleteTimer->start();
+    const QList<DelegateLoader *> loaders = m_delegateLoaders.mid(row, count);
     m_delegateLoaders.erase(m_delegateLoaders.begin() + row, m_delegateLoaders.begin() + row + count);
-
     endRemoveRows();
+
+    releaseDelegateLoaders(loaders);
     return true;
 }
 
+void DelegatesModel::releaseDelegateLoaders(const QList<DelegateLoader *> &loaders)
+{
+    for (auto *loader : loaders) {
+        // They may come back in another model
+        disconnect(loader, nullptr, this, nullptr);
+        // Out of the model, no more events until it is shown again
+        if (loader->delegate()) {
+            loader->view()->removeEventSubscriptions(loader->delegate());
+        }
+        if (!loader->view()->recycleDelegateLoader(loader)) {
+            m_delegateLoadersToDelete << loader;
+        }
+    }
+
+    if (!m_delegateLoadersToDelete.isEmpty()) {
+        m_deleteTimer->start();
+    }
+}
+
 
 int DelegatesModel::rowCount(const QModelIndex &parent) const
 {
@@ -166,17 +300,25 @@ QVariant DelegatesModel::data(const QModelIndex &index, int role) const
     }
     const int row = index.row();
 
-    if (row < 0 || row >= m_delegateLoaders.count() || role != DelegateUi) {
+    if (row < 0 || row >= m_delegateLoaders.count()) {
         return QVariant();
     }
 
-    return QVariant::fromValue(m_delegateLoaders[row]->delegate());
+    switch (role) {
+    case DelegateUi:
+        return QVariant::fromValue(m_delegateLoaders[row]->delegate());
+    case DelegateLoading:
+        return m_delegateLoaders[row]->isLoading();
+    default:
+        return QVariant();
+    }
 }
 
 QHash<int, QByteArray> DelegatesModel::roleNames() const
 {
     return {
-        {DelegateUi, "delegateUi"}
+        {DelegateUi, "delegateUi"},
+        {DelegateLoading, "delegateLoading"}
     };
 }
 
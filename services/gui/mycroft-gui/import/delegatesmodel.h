@@ -29,11 +29,16 @@ class DelegateLoader;
 class DelegatesModel : public QAbstractListModel
 {
     Q_OBJECT
-    Q_PROPERTY(int currentIndex MEMBER m_currentIndex NOTIFY currentIndexChanged)
+    /**
+     * The page shown. Setting it creates that page, if it was deferred, and
+     * prefetches its neighbours, as far as AbstractSkillView::pagePrefetch
+     */
+    Q_PROPERTY(int currentIndex READ currentIndex WRITE setCurrentIndex NOTIFY currentIndexChanged)
 
 public:
     enum Roles {
-        DelegateUi = Qt::UserRole + 1
+        DelegateUi = Qt::UserRole + 1,
+        DelegateLoading // true until DelegateUi is available, or failed to load
     };
 
     explicit DelegatesModel(QObject *parent = nullptr);
@@ -44,6 +49,20 @@ public:
      */
     void insertDelegateLoaders(int position, QList<DelegateLoader *> loaders);
 
+    int currentIndex() const;
+    void setCurrentIndex(int index);
+
+    /**
+     * @returns the loader of the page at row, nullptr out of range
+     */
+    DelegateLoader *delegateLoaderAt(int row) const;
+
+    /**
+     * @internal creates the deferred pages around the current one, one at a
+     * time, on the bulk lane of PriorityDispatcher
+     */
+    void schedulePrefetch();
+
     /**
      * clears the whole model
      */
@@ -54,6 +73,23 @@ public:
      */
     QList<AbstractDelegate *> delegates() const;
 
+    /**
+     * Number of delegates already created, and the one at index among them,
+     * like delegates() without building the list
+     */
+    int delegateCount() const;
+    AbstractDelegate *delegateAt(int index) const;
+
+    /**
+     * @returns the urls of all pages, including the ones still loading
+     */
+    QList<QUrl> delegateUrls() const;
+
+    /**
+     * Deletes the removed loaders now rather than after their grace period
+     */
+    void purgeReleased();
+
     bool moveRows(const QModelIndex &sourceParent, int sourceRow, int count, const QModelIndex &destinationParent, int destinationChild) override;
     bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
@@ -64,8 +100,15 @@ Q_SIGNALS:
     void currentIndexChanged();
 
 private:
+    /**
+     * Removed loaders are either recycled by their view or deleted a bit later
+     */
+    void releaseDelegateLoaders(const QList<DelegateLoader *> &loaders);
+    void prefetch();
+
     QList<DelegateLoader *> m_delegateLoaders;
     QList<DelegateLoader *> m_delegateLoadersToDelete;
     QTimer *m_deleteTimer;
     int m_currentIndex = 0;
+    bool m_prefetchScheduled = false;
 };
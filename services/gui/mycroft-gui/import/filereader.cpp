@@ -19,9 +19,28 @@
 #include <QFile>
 #include <QDir>
 #include <QDebug>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QDirIterator>
+#include <QThreadPool>
+
+#include <limits>
+
+// Smaller files are cheaper to read than to map
+static const qint64 s_mapThreshold = 64 * 1024;
+
+// QSet::fromList() is deprecated, the range constructor needs Qt 5.14
+static QSet<QString> toSet(const QStringList &list)
+{
+    QSet<QString> set;
+    set.reserve(list.count());
+    for (const auto &item : list) {
+        set.insert(item);
+    }
+    return set;
+}
 
 FileReader::FileReader(QObject *parent) 
     : QObject(parent)
@@ -37,23 +56,168 @@ QByteArray FileReader::read(const QString &filename)
     return file.readAll();
 }
 
+void FileReader::readAsync(const QString &filename, const QJSValue &callback)
+{
+    if (!callback.isCallable()) {
+        qWarning() << "FileReader.readAsync needs a callback to read" << filename;
+        return;
+    }
+
+    FileReadJob *job = new FileReadJob(filename);
+    // Queued from the worker thread, dropped if the reader goes away first
+    connect(job, &FileReadJob::finished, this, [callback](const QString &text, const QString &error) {
+        QJSValue function(callback);
+        function.call({QJSValue(text), error.isNull() ? QJSValue(QJSValue::NullValue) : QJSValue(error)});
+    });
+    connect(job, &FileReadJob::finished, job, &QObject::deleteLater);
+
+    QThreadPool::globalInstance()->start(job);
+}
+
 bool FileReader::file_exists_local(const QString &filename) {
     return QFile(filename).exists();
 }
 
 QStringList FileReader::checkForMeta(const QString &rootDir, const QString &findFile){
-    QStringList dirList;
+    if (!m_metaIndex.contains(rootDir)) {
+        // Nothing to watch yet: not indexed, so it's found once it's created
+        if (!QFileInfo(rootDir).isDir()) {
+            return QStringList();
+        }
+        scanMetaRoot(rootDir);
+    }
+
+    MetaIndex &index = m_metaIndex[rootDir];
+    if (!index.matches.contains(findFile)) {
+        QSet<QString> &matches = index.matches[findFile];
+        for (const QString &entry : index.entries) {
+            if (file_exists_local(entry + QStringLiteral("/") + findFile)) {
+                matches.insert(entry);
+            }
+        }
+    }
+
+    const QSet<QString> &matches = index.matches[findFile];
     QStringList containsMeta;
+    for (const QString &entry : index.entries) {
+        if (matches.contains(entry)) {
+            containsMeta.append(entry);
+        }
+    }
+    return containsMeta;
+}
+
+void FileReader::directoryChanged(const QString &path)
+{
+    if (m_metaIndex.contains(path)) {
+        scanMetaRoot(path);
+    }
+
+    auto it = m_metaEntryRoots.constFind(path);
+    if (it != m_metaEntryRoots.constEnd()) {
+        auto indexIt = m_metaIndex.find(it.value());
+        if (indexIt != m_metaIndex.end()) {
+            updateMetaEntry(*indexIt, path);
+        }
+    }
+}
+
+void FileReader::scanMetaRoot(const QString &rootDir)
+{
+    if (!m_watcher) {
+        m_watcher = new QFileSystemWatcher(this);
+        connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &FileReader::directoryChanged);
+    }
+
+    const bool indexed = m_metaIndex.contains(rootDir);
+    MetaIndex &index = m_metaIndex[rootDir];
+    if (!indexed) {
+        m_watcher->addPath(rootDir);
+    }
+
+    QStringList entries;
     QDirIterator iter(rootDir);
     while(iter.hasNext()){
-        dirList.append(iter.next());
+        entries.append(iter.next());
     }
-    int count = dirList.count();
-    for(int i=0; i<count; i++){
-       bool metaExist = file_exists_local(dirList[i] + QStringLiteral("/") + findFile);
-       if(metaExist){
-            containsMeta.append(dirList[i]);
-       }
+
+    const QSet<QString> oldEntries = toSet(index.entries);
+    const QSet<QString> newEntries = toSet(entries);
+    index.entries = entries;
+
+    for (const QString &entry : oldEntries) {
+        if (newEntries.contains(entry)) {
+            continue;
+        }
+        for (QSet<QString> &matches : index.matches) {
+            matches.remove(entry);
+        }
+        if (m_metaEntryRoots.remove(entry)) {
+            m_watcher->removePath(entry);
+        }
+    }
+
+    for (const QString &entry : entries) {
+        const QString name = QFileInfo(entry).fileName();
+        // Files of rootDir itself changed, they are under "."
+        if (name == QLatin1String(".")) {
+            updateMetaEntry(index, entry);
+            continue;
+        }
+        if (oldEntries.contains(entry) || name == QLatin1String("..")) {
+            continue;
+        }
+
+        if (QFileInfo(entry).isDir() && m_watcher->addPath(entry)) {
+            m_metaEntryRoots.insert(entry, rootDir);
+        }
+        updateMetaEntry(index, entry);
+    }
+}
+
+void FileReader::updateMetaEntry(MetaIndex &index, const QString &entry)
+{
+    for (auto it = index.matches.begin(); it != index.matches.end(); ++it) {
+        if (file_exists_local(entry + QStringLiteral("/") + it.key())) {
+            it->insert(entry);
+        } else {
+            it->remove(entry);
+        }
     }
-    return containsMeta;
 }
+
+FileReadJob::FileReadJob(const QString &filename)
+    : m_filename(filename)
+{
+    // Deleted in the GUI thread once finished
+    setAutoDelete(false);
+}
+
+void FileReadJob::run()
+{
+    QFile file(m_filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        emit finished(QString(), file.errorString());
+        return;
+    }
+
+    const qint64 size = file.size();
+    if (size > std::numeric_limits<int>::max()) {
+        emit finished(QString(), QStringLiteral("File too big"));
+        return;
+    }
+
+    // Decoding straight from the mapping saves copying the whole file
+    uchar *data = size >= s_mapThreshold ? file.map(0, size) : nullptr;
+    if (data) {
+        const QString text = QString::fromUtf8(reinterpret_cast<const char *>(data), int(size));
+        file.unmap(data);
+        emit finished(text, QString());
+        return;
+    }
+
+    // Also for what can't be mapped, like sequential files
+    emit finished(QString::fromUtf8(file.readAll()), QString());
+}
+
+#include "moc_filereader.cpp"
@@ -21,9 +21,15 @@
 #include <QObject>
 #include <QStringList>
 #include <QDir>
+#include <QHash>
+#include <QJSValue>
+#include <QRunnable>
+#include <QSet>
 #include <QTextStream>
 #include <QDataStream>
 
+class QFileSystemWatcher;
+
 class FileReader : public QObject
 {
     Q_OBJECT
@@ -33,8 +39,55 @@ public:
     
 public Q_SLOTS:
     QByteArray read(const QString &filename);
+    /**
+     * Reads filename as UTF-8 text in a worker thread, memory mapped if it's
+     * big, then calls callback(text, error) in the GUI thread.
+     * error is null on success.
+     */
+    void readAsync(const QString &filename, const QJSValue &callback);
     bool file_exists_local(const QString &filename);
+    /**
+     * The entries of rootDir having a findFile inside.
+     * The first call for a rootDir lists it, later ones are answered from an
+     * index kept up to date by watching rootDir and its subdirectories.
+     */
     QStringList checkForMeta(const QString &rootDir, const QString &findFile);
+
+private:
+    struct MetaIndex {
+        // In the order the directory is listed
+        QStringList entries;
+        // The entries having each file asked for
+        QHash<QString, QSet<QString>> matches;
+    };
+
+    void directoryChanged(const QString &path);
+    void scanMetaRoot(const QString &rootDir);
+    void updateMetaEntry(MetaIndex &index, const QString &entry);
+
+    QFileSystemWatcher *m_watcher = nullptr;
+    QHash<QString, MetaIndex> m_metaIndex;
+    // Watched entry -> rootDir it's in
+    QHash<QString, QString> m_metaEntryRoots;
+};
+
+/**
+ * @internal One readAsync(), lives in the GUI thread and runs in the thread pool
+ */
+class FileReadJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    explicit FileReadJob(const QString &filename);
+
+    void run() override;
+
+Q_SIGNALS:
+    void finished(const QString &text, const QString &error);
+
+private:
+    QString m_filename;
 };
 
 #endif // FILEREADER_H
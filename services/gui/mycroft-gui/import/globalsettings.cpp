@@ -16,23 +16,154 @@
  */
 
 #include <QDebug>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include "globalsettings.h"
 #include "controllerconfig.h"
 
+// @returns true if current had to change to value
+template<typename T>
+static bool updateValue(T &current, const T &value)
+{
+    if (current == value) {
+        return false;
+    }
+
+    current = value;
+    return true;
+}
+
 GlobalSettings::GlobalSettings(QObject *parent) :
     QObject(parent)
 {
+    m_values = readValues();
+
+    m_reloadTimer.setSingleShot(true);
+    m_reloadTimer.setInterval(100);
+    connect(&m_reloadTimer, &QTimer::timeout, this, &GlobalSettings::reload);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, &m_reloadTimer, QOverload<>::of(&QTimer::start));
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, &m_reloadTimer, QOverload<>::of(&QTimer::start));
+    watchFile();
+}
+
+GlobalSettings::Values GlobalSettings::readValues() const
+{
+    Values values;
+#ifndef Q_OS_ANDROID
+    values.webSocketAddress = m_settings.value(QStringLiteral("webSocketAddress"), QStringLiteral("ws://0.0.0.0")).toString();
+    values.displayRemoteConfig = m_settings.value(QStringLiteral("displayRemoteConfig"), true).toBool();
+#else
+    values.webSocketAddress = m_settings.value(QStringLiteral("webSocketAddress"), QStringLiteral("ws://104.248.21.254")).toString();
+    values.displayRemoteConfig = m_settings.value(QStringLiteral("displayRemoteConfig"), false).toBool();
+#endif
+    values.autoConnect = m_settings.value(QStringLiteral("autoConnect"), true).toBool();
+    values.usesRemoteTTS = m_settings.value(QStringLiteral("usesRemoteTTS"), false).toBool();
+    values.usePTTClient = m_settings.value(QStringLiteral("usePTTClient"), false).toBool();
+    values.useHivemindProtocol = m_settings.value(QStringLiteral("useHivemindProtocol"), false).toBool();
+    values.threadedDecoding = m_settings.value(QStringLiteral("threadedDecoding"), false).toBool();
+    values.prewarmDelegates = m_settings.value(QStringLiteral("prewarmDelegates")).toStringList();
+    values.componentCacheSize = m_settings.value(QStringLiteral("componentCacheSize"), 16).toInt();
+    values.imageCacheSize = m_settings.value(QStringLiteral("imageCacheSize"), 64).toInt();
+    values.networkCacheSize = m_settings.value(QStringLiteral("networkCacheSize"), 50).toInt();
+    values.prefetchRemoteSkills = m_settings.value(QStringLiteral("prefetchRemoteSkills"), false).toBool();
+    values.sharedGuiConnection = m_settings.value(QStringLiteral("sharedGuiConnection"), false).toBool();
+    return values;
+}
+
+void GlobalSettings::watchFile()
+{
+    if (m_settings.format() != QSettings::NativeFormat && m_settings.format() != QSettings::IniFormat) {
+        return;
+    }
+
+    const QFileInfo file(m_settings.fileName());
+    // Not on platforms keeping settings elsewhere, like the registry
+    if (!file.isAbsolute()) {
+        return;
+    }
+
+    // The directory, for a file created or replaced by a rename
+    if (file.dir().exists() && !m_watcher.directories().contains(file.absolutePath())) {
+        m_watcher.addPath(file.absolutePath());
+    }
+    if (file.exists() && !m_watcher.files().contains(file.absoluteFilePath())) {
+        m_watcher.addPath(file.absoluteFilePath());
+    }
+}
+
+void GlobalSettings::reload()
+{
+    watchFile();
+
+    // Also writes what is still pending of ours
+    m_settings.sync();
+    const Values values = readValues();
+
+    if (updateValue(m_values.webSocketAddress, values.webSocketAddress)) {
+        emit webSocketChanged();
+    }
+    if (updateValue(m_values.autoConnect, values.autoConnect)) {
+        emit autoConnectChanged();
+    }
+    if (updateValue(m_values.usesRemoteTTS, values.usesRemoteTTS)) {
+        emit usesRemoteTTSChanged();
+    }
+    if (updateValue(m_values.displayRemoteConfig, values.displayRemoteConfig)) {
+        emit displayRemoteConfigChanged();
+    }
+    if (updateValue(m_values.usePTTClient, values.usePTTClient)) {
+        emit usePTTClientChanged();
+    }
+    if (updateValue(m_values.useHivemindProtocol, values.useHivemindProtocol)) {
+        emit useHivemindProtocolChanged();
+    }
+    if (updateValue(m_values.threadedDecoding, values.threadedDecoding)) {
+        emit threadedDecodingChanged();
+    }
+    if (updateValue(m_values.prewarmDelegates, values.prewarmDelegates)) {
+        emit prewarmDelegatesChanged();
+    }
+    if (updateValue(m_values.componentCacheSize, values.componentCacheSize)) {
+        emit componentCacheSizeChanged();
+    }
+    if (updateValue(m_values.imageCacheSize, values.imageCacheSize)) {
+        emit imageCacheSizeChanged();
+    }
+    if (updateValue(m_values.networkCacheSize, values.networkCacheSize)) {
+        emit networkCacheSizeChanged();
+    }
+    if (updateValue(m_values.prefetchRemoteSkills, values.prefetchRemoteSkills)) {
+        emit prefetchRemoteSkillsChanged();
+    }
+    if (updateValue(m_values.sharedGuiConnection, values.sharedGuiConnection)) {
+        emit sharedGuiConnectionChanged();
+    }
+}
+
+QString GlobalSettings::webSocketAddress() const
+{
+    return m_values.webSocketAddress;
+}
+
+void GlobalSettings::setWebSocketAddress(const QString &webSocketAddress)
+{
+    if (!updateValue(m_values.webSocketAddress, webSocketAddress)) {
+        return;
+    }
+
+    m_settings.setValue(QStringLiteral("webSocketAddress"), webSocketAddress);
+    emit webSocketChanged();
 }
 
 bool GlobalSettings::autoConnect() const
 {
-    return m_settings.value(QStringLiteral("autoConnect"), true).toBool();
+    return m_values.autoConnect;
 }
 
 void GlobalSettings::setAutoConnect(bool autoConnect)
 {
-    if (GlobalSettings::autoConnect() == autoConnect) {
+    if (!updateValue(m_values.autoConnect, autoConnect)) {
         return;
     }
 
@@ -42,12 +173,12 @@ void GlobalSettings::setAutoConnect(bool autoConnect)
 
 bool GlobalSettings::usesRemoteTTS() const
 {
-    return m_settings.value(QStringLiteral("usesRemoteTTS"), false).toBool();
+    return m_values.usesRemoteTTS;
 }
 
 void GlobalSettings::setUsesRemoteTTS(bool usesRemoteTTS)
 {
-    if (GlobalSettings::usesRemoteTTS() == usesRemoteTTS) {
+    if (!updateValue(m_values.usesRemoteTTS, usesRemoteTTS)) {
         return;
     }
 
@@ -57,16 +188,12 @@ void GlobalSettings::setUsesRemoteTTS(bool usesRemoteTTS)
 
 bool GlobalSettings::displayRemoteConfig() const
 {
-#ifndef Q_OS_ANDROID
-    return m_settings.value(QStringLiteral("displayRemoteConfig"), true).toBool();
-#else
-    return m_settings.value(QStringLiteral("displayRemoteConfig"), false).toBool();
-#endif
+    return m_values.displayRemoteConfig;
 }
 
 void GlobalSettings::setDisplayRemoteConfig(bool displayRemoteConfig)
 {
-    if (GlobalSettings::displayRemoteConfig() == displayRemoteConfig) {
+    if (!updateValue(m_values.displayRemoteConfig, displayRemoteConfig)) {
         return;
     }
 
@@ -76,12 +203,12 @@ void GlobalSettings::setDisplayRemoteConfig(bool displayRemoteConfig)
 
 bool GlobalSettings::usePTTClient() const
 {
-    return m_settings.value(QStringLiteral("usePTTClient"), false).toBool();
+    return m_values.usePTTClient;
 }
 
 void GlobalSettings::setUsePTTClient(bool usePTTClient)
 {
-    if (GlobalSettings::usePTTClient() == usePTTClient) {
+    if (!updateValue(m_values.usePTTClient, usePTTClient)) {
         return;
     }
 
@@ -91,15 +218,120 @@ void GlobalSettings::setUsePTTClient(bool usePTTClient)
 
 bool GlobalSettings::useHivemindProtocol() const
 {
-    return m_settings.value(QStringLiteral("useHivemindProtocol"), false).toBool();
+    return m_values.useHivemindProtocol;
 }
 
 void GlobalSettings::setUseHivemindProtocol(bool useHivemindProtocol)
 {
-    if (GlobalSettings::useHivemindProtocol() == useHivemindProtocol) {
+    if (!updateValue(m_values.useHivemindProtocol, useHivemindProtocol)) {
         return;
     }
 
     m_settings.setValue(QStringLiteral("useHivemindProtocol"), useHivemindProtocol);
     emit useHivemindProtocolChanged();
 }
+
+bool GlobalSettings::threadedDecoding() const
+{
+    return m_values.threadedDecoding;
+}
+
+void GlobalSettings::setThreadedDecoding(bool threadedDecoding)
+{
+    if (!updateValue(m_values.threadedDecoding, threadedDecoding)) {
+        return;
+    }
+
+    m_settings.setValue(QStringLiteral("threadedDecoding"), threadedDecoding);
+    emit threadedDecodingChanged();
+}
+
+QStringList GlobalSettings::prewarmDelegates() const
+{
+    return m_values.prewarmDelegates;
+}
+
+void GlobalSettings::setPrewarmDelegates(const QStringList &prewarmDelegates)
+{
+    if (!updateValue(m_values.prewarmDelegates, prewarmDelegates)) {
+        return;
+    }
+
+    m_settings.setValue(QStringLiteral("prewarmDelegates"), prewarmDelegates);
+    emit prewarmDelegatesChanged();
+}
+
+int GlobalSettings::componentCacheSize() const
+{
+    return m_values.componentCacheSize;
+}
+
+void GlobalSettings::setComponentCacheSize(int componentCacheSize)
+{
+    if (!updateValue(m_values.componentCacheSize, componentCacheSize)) {
+        return;
+    }
+
+    m_settings.setValue(QStringLiteral("componentCacheSize"), componentCacheSize);
+    emit componentCacheSizeChanged();
+}
+
+int GlobalSettings::imageCacheSize() const
+{
+    return m_values.imageCacheSize;
+}
+
+void GlobalSettings::setImageCacheSize(int imageCacheSize)
+{
+    if (!updateValue(m_values.imageCacheSize, imageCacheSize)) {
+        return;
+    }
+
+    m_settings.setValue(QStringLiteral("imageCacheSize"), imageCacheSize);
+    emit imageCacheSizeChanged();
+}
+
+int GlobalSettings::networkCacheSize() const
+{
+    return m_values.networkCacheSize;
+}
+
+void GlobalSettings::setNetworkCacheSize(int networkCacheSize)
+{
+    if (!updateValue(m_values.networkCacheSize, networkCacheSize)) {
+        return;
+    }
+
+    m_settings.setValue(QStringLiteral("networkCacheSize"), networkCacheSize);
+    emit networkCacheSizeChanged();
+}
+
+bool GlobalSettings::prefetchRemoteSkills() const
+{
+    return m_values.prefetchRemoteSkills;
+}
+
+void GlobalSettings::setPrefetchRemoteSkills(bool prefetchRemoteSkills)
+{
+    if (!updateValue(m_values.prefetchRemoteSkills, prefetchRemoteSkills)) {
+        return;
+    }
+
+    m_settings.setValue(QStringLiteral("prefetchRemoteSkills"), prefetchRemoteSkills);
+    emit prefetchRemoteSkillsChanged();
+}
+
+bool GlobalSettings::sharedGuiConnection() const
+{
+    return m_values.sharedGuiConnection;
+}
+
+void GlobalSettings::setSharedGuiConnection(bool sharedGuiConnection)
+{
+    if (!updateValue(m_values.sharedGuiConnection, sharedGuiConnection)) {
+        return;
+    }
+
+    m_settings.setValue(QStringLiteral("sharedGuiConnection"), sharedGuiConnection);
+    emit sharedGuiConnectionChanged();
+}
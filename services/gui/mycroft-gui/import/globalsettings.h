@@ -21,12 +21,18 @@
 #include <QSettings>
 #include <QCoreApplication>
 #include <QDebug>
+#include <QFileSystemWatcher>
+#include <QStringList>
+#include <QTimer>
 
-#define SettingPropertyKey(type, name, setOption, signalName, settingKey, defaultValue) \
-    inline type name() const { return m_settings.value(settingKey, defaultValue).value<type>(); } \
-    inline void setOption (const type &value) { m_settings.setValue(settingKey, value); emit signalName(); qDebug() << "emitted"; }
-
-class QSettings;
+/**
+ * Settings of the GUI, persisted with QSettings.
+ *
+ * They are read once into plain members, the getters don't go through
+ * QSettings. The file is watched: when another process changes it, the
+ * values are read again and only the ones that actually changed are
+ * notified.
+ */
 class GlobalSettings : public QObject
 {
     Q_OBJECT
@@ -34,17 +40,21 @@ class GlobalSettings : public QObject
     Q_PROPERTY(bool autoConnect READ autoConnect WRITE setAutoConnect NOTIFY autoConnectChanged)
     Q_PROPERTY(bool usesRemoteTTS READ usesRemoteTTS WRITE setUsesRemoteTTS NOTIFY usesRemoteTTSChanged)
     Q_PROPERTY(bool displayRemoteConfig READ displayRemoteConfig WRITE setDisplayRemoteConfig NOTIFY displayRemoteConfigChanged)
-    Q_PROPERTY(bool usePTTClient READ usePTTClient WRITE setUsePTTClient NOTIFY usePTTClient)
+    Q_PROPERTY(bool usePTTClient READ usePTTClient WRITE setUsePTTClient NOTIFY usePTTClientChanged)
     Q_PROPERTY(bool useHivemindProtocol READ useHivemindProtocol WRITE setUseHivemindProtocol NOTIFY useHivemindProtocolChanged)
+    Q_PROPERTY(bool threadedDecoding READ threadedDecoding WRITE setThreadedDecoding NOTIFY threadedDecodingChanged)
+    Q_PROPERTY(QStringList prewarmDelegates READ prewarmDelegates WRITE setPrewarmDelegates NOTIFY prewarmDelegatesChanged)
+    Q_PROPERTY(int componentCacheSize READ componentCacheSize WRITE setComponentCacheSize NOTIFY componentCacheSizeChanged)
+    Q_PROPERTY(int imageCacheSize READ imageCacheSize WRITE setImageCacheSize NOTIFY imageCacheSizeChanged)
+    Q_PROPERTY(int networkCacheSize READ networkCacheSize WRITE setNetworkCacheSize NOTIFY networkCacheSizeChanged)
+    Q_PROPERTY(bool prefetchRemoteSkills READ prefetchRemoteSkills WRITE setPrefetchRemoteSkills NOTIFY prefetchRemoteSkillsChanged)
+    Q_PROPERTY(bool sharedGuiConnection READ sharedGuiConnection WRITE setSharedGuiConnection NOTIFY sharedGuiConnectionChanged)
 
 public:
     explicit GlobalSettings(QObject *parent=0);
-#ifndef Q_OS_ANDROID
-    SettingPropertyKey(QString, webSocketAddress, setWebSocketAddress, webSocketChanged, QStringLiteral("webSocketAddress"), QStringLiteral("ws://0.0.0.0"))
-#else
-    SettingPropertyKey(QString, webSocketAddress, setWebSocketAddress, webSocketChanged, QStringLiteral("webSocketAddress"), QStringLiteral("ws://104.248.21.254"))
-#endif
 
+    QString webSocketAddress() const;
+    void setWebSocketAddress(const QString &webSocketAddress);
     bool autoConnect() const;
     void setAutoConnect(bool autoconnect);
     bool usesRemoteTTS() const;
@@ -55,6 +65,48 @@ public:
     void setUsePTTClient(bool usePttClient);
     bool useHivemindProtocol() const;
     void setUseHivemindProtocol(bool useHivemindProtocol);
+    /**
+     * Decode the messages of the websockets in a worker thread, applies to new connections
+     */
+    bool threadedDecoding() const;
+    void setThreadedDecoding(bool threadedDecoding);
+    /**
+     * Delegate QML files compiled in the background at startup, paths or urls.
+     * Applies to views created afterwards
+     */
+    QStringList prewarmDelegates() const;
+    void setPrewarmDelegates(const QStringList &prewarmDelegates);
+    /**
+     * How many compiled delegate components not currently shown are kept in memory
+     */
+    int componentCacheSize() const;
+    void setComponentCacheSize(int componentCacheSize);
+    /**
+     * MiB of decoded images kept by the image://mycroft/ provider, shared by all the views
+     */
+    int imageCacheSize() const;
+    void setImageCacheSize(int imageCacheSize);
+    /**
+     * MiB of remote skill QML and assets kept on disk. Applies after a restart
+     */
+    int networkCacheSize() const;
+    void setNetworkCacheSize(int networkCacheSize);
+    /**
+     * Download every file in the ui manifest of a remote skill the first time it shows a page
+     */
+    bool prefetchRemoteSkills() const;
+    void setPrefetchRemoteSkills(bool prefetchRemoteSkills);
+    /**
+     * All the views of the process share a single gui socket, instead of one each.
+     * Applies to views created afterwards
+     */
+    bool sharedGuiConnection() const;
+    void setSharedGuiConnection(bool sharedGuiConnection);
+
+    /**
+     * Reads the settings file again, for changes done by another process
+     */
+    void reload();
 
 Q_SIGNALS:
     void webSocketChanged();
@@ -63,9 +115,40 @@ Q_SIGNALS:
     void displayRemoteConfigChanged();
     void usePTTClientChanged();
     void useHivemindProtocolChanged();
+    void threadedDecodingChanged();
+    void prewarmDelegatesChanged();
+    void componentCacheSizeChanged();
+    void imageCacheSizeChanged();
+    void networkCacheSizeChanged();
+    void prefetchRemoteSkillsChanged();
+    void sharedGuiConnectionChanged();
 
 private:
+    struct Values {
+        QString webSocketAddress;
+        bool autoConnect = true;
+        bool usesRemoteTTS = false;
+        bool displayRemoteConfig = true;
+        bool usePTTClient = false;
+        bool useHivemindProtocol = false;
+        bool threadedDecoding = false;
+        QStringList prewarmDelegates;
+        int componentCacheSize = 16;
+        int imageCacheSize = 64;
+        int networkCacheSize = 50;
+        bool prefetchRemoteSkills = false;
+        bool sharedGuiConnection = false;
+    };
+
+    Values readValues() const;
+    // Again after the file got replaced rather than written in place
+    void watchFile();
+
     QSettings m_settings;
+    Values m_values;
+    QFileSystemWatcher m_watcher;
+    // Coalesces the notifications of a single write
+    QTimer m_reloadTimer;
 };
 
 #endif // GLOBALSETTINGS_H
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "guimetrics.h"
+
+#include <QCoreApplication>
+
+static const int s_linearBuckets = 16;
+static const int s_subBuckets = 8;
+// log2 of s_linearBuckets and s_subBuckets
+static const int s_linearBits = 4;
+static const int s_subBits = 3;
+
+int LatencyHistogram::bucketForValue(qint64 value)
+{
+    if (value < s_linearBuckets) {
+        return int(qMax<qint64>(0, value));
+    }
+
+    int exponent = s_linearBits;
+    while ((value >> (exponent + 1)) != 0) {
+        ++exponent;
+    }
+
+    const int bucket = s_linearBuckets + (exponent - s_linearBits) * s_subBuckets
+        + int((value >> (exponent - s_subBits)) & (s_subBuckets - 1));
+    return qMin(bucket, BucketCount - 1);
+}
+
+qint64 LatencyHistogram::valueForBucket(int bucket)
+{
+    if (bucket < s_linearBuckets) {
+        return bucket;
+    }
+
+    const int exponent = (bucket - s_linearBuckets) / s_subBuckets + s_linearBits;
+    const qint64 sub = (bucket - s_linearBuckets) % s_subBuckets;
+    // The middle of the bucket
+    const qint64 width = qint64(1) << (exponent - s_subBits);
+    return ((s_subBuckets + sub) << (exponent - s_subBits)) + width / 2;
+}
+
+void LatencyHistogram::record(qint64 microseconds)
+{
+    ++m_buckets[bucketForValue(microseconds)];
+    ++m_count;
+    m_sum += microseconds;
+    m_max = qMax(m_max, microseconds);
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return m_count;
+}
+
+qint64 LatencyHistogram::max() const
+{
+    return m_max;
+}
+
+double LatencyHistogram::mean() const
+{
+    return m_count > 0 ? double(m_sum) / m_count : 0;
+}
+
+qint64 LatencyHistogram::percentile(double percentile) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+
+    const quint64 rank = qMax<quint64>(1, quint64(m_count * qBound(0.0, percentile, 100.0) / 100.0 + 0.5));
+    if (rank >= m_count) {
+        return m_max;
+    }
+
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < BucketCount; ++bucket) {
+        seen += m_buckets[bucket];
+        if (seen >= rank) {
+            return qMin(valueForBucket(bucket), m_max);
+        }
+    }
+
+    return m_max;
+}
+
+GuiMetrics *GuiMetrics::instance()
+{
+    static GuiMetrics *s_self = nullptr;
+    if (!s_self) {
+        s_self = new GuiMetrics(QCoreApplication::instance());
+    }
+    return s_self;
+}
+
+GuiMetrics::GuiMetrics(QObject *parent)
+    : QObject(parent)
+{
+    m_uptime.start();
+}
+
+bool GuiMetrics::isEnabled() const
+{
+    return m_enabled;
+}
+
+void GuiMetrics::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+
+    m_enabled = enabled;
+    emit enabledChanged();
+}
+
+void GuiMetrics::recordGuiMessage(const QString &type, const QString &skillId, int bytes, qint64 nanoseconds)
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    const qint64 microseconds = nanoseconds / 1000;
+
+    Metric &metric = m_guiMessages[type];
+    metric.bytes += bytes;
+    metric.latency.record(microseconds);
+
+    if (!skillId.isEmpty()) {
+        Metric &skill = m_skills[skillId];
+        skill.bytes += bytes;
+        skill.latency.record(microseconds);
+    }
+}
+
+void GuiMetrics::recordBusMessage(const QString &type, int bytes, qint64 nanoseconds)
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    Metric &metric = m_busMessages[type];
+    metric.bytes += bytes;
+    metric.latency.record(nanoseconds / 1000);
+}
+
+void GuiMetrics::recordDelegateCreation(const QString &skillId, qint64 nanoseconds)
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    m_delegates[skillId].latency.record(nanoseconds / 1000);
+}
+
+void GuiMetrics::setMemoryUsage(const QString &view, const QVariantMap &skills)
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    m_memory[view] = skills;
+}
+
+QVariantMap GuiMetrics::metricsMap(const QHash<QString, Metric> &metrics)
+{
+    QVariantMap map;
+
+    for (auto it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+        const LatencyHistogram &latency = it.value().latency;
+        map[it.key()] = QVariantMap({{QStringLiteral("count"), latency.count()},
+                                     {QStringLiteral("bytes"), it.value().bytes},
+                                     {QStringLiteral("mean_us"), latency.mean()},
+                                     {QStringLiteral("p50_us"), latency.percentile(50)},
+                                     {QStringLiteral("p90_us"), latency.percentile(90)},
+                                     {QStringLiteral("p99_us"), latency.percentile(99)},
+                                     {QStringLiteral("max_us"), latency.max()}});
+    }
+
+    return map;
+}
+
+QVariantMap GuiMetrics::snapshot() const
+{
+    return QVariantMap({{QStringLiteral("gui"), metricsMap(m_guiMessages)},
+                        {QStringLiteral("bus"), metricsMap(m_busMessages)},
+                        {QStringLiteral("skills"), metricsMap(m_skills)},
+                        {QStringLiteral("delegates"), metricsMap(m_delegates)},
+                        {QStringLiteral("memory"), m_memory},
+                        {QStringLiteral("uptime_ms"), m_uptime.elapsed()}});
+}
+
+void GuiMetrics::reset()
+{
+    m_guiMessages.clear();
+    m_busMessages.clear();
+    m_skills.clear();
+    m_delegates.clear();
+}
+
+#include "moc_guimetrics.cpp"
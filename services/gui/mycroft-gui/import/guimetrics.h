@@ -0,0 +1,128 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVariantMap>
+
+/**
+ * Latency histogram with a bounded relative error, in the spirit of
+ * HdrHistogram: values are microseconds, exact up to 16, then counted in
+ * buckets of 8 per power of two, so percentiles are within 12.5%.
+ * Recording is a few shifts and an increment, no allocation.
+ */
+class LatencyHistogram
+{
+public:
+    void record(qint64 microseconds);
+
+    quint64 count() const;
+    qint64 max() const;
+    double mean() const;
+
+    /**
+     * @returns the value below which percentile percent of the values are
+     */
+    qint64 percentile(double percentile) const;
+
+    static int bucketForValue(qint64 microseconds);
+    static qint64 valueForBucket(int bucket);
+
+    static const int BucketCount = 16 + 32 * 8;
+
+private:
+    quint32 m_buckets[BucketCount] = {};
+    quint64 m_count = 0;
+    qint64 m_sum = 0;
+    qint64 m_max = 0;
+};
+
+/**
+ * Always on registry of how much the messages cost the GUI: counters, bytes
+ * and latency histograms per message type of the gui socket and of the
+ * messagebus, per skill, and of the creation of delegates.
+ *
+ * Exposed to QML as the GuiMetrics singleton, and sent as
+ * mycroft.gui.metrics.response to mycroft.gui.metrics requests on the bus.
+ */
+class GuiMetrics : public QObject
+{
+    Q_OBJECT
+
+    /**
+     * Recording can be disabled, the registry then costs one branch per message
+     */
+    Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+
+public:
+    static GuiMetrics *instance();
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    /**
+     * A gui socket message, decoded and applied in nanoseconds
+     */
+    void recordGuiMessage(const QString &type, const QString &skillId, int bytes, qint64 nanoseconds);
+
+    /**
+     * A messagebus message, decoded and handled in nanoseconds
+     */
+    void recordBusMessage(const QString &type, int bytes, qint64 nanoseconds);
+
+    /**
+     * Time from asking for a page of skillId to the delegate being created
+     */
+    void recordDelegateCreation(const QString &skillId, qint64 nanoseconds);
+
+    /**
+     * Latest SkillMemoryUsage of the skills of view, replacing the previous one
+     */
+    void setMemoryUsage(const QString &view, const QVariantMap &skills);
+
+    /**
+     * @returns every metric: for "gui", "bus", "skills" and "delegates" a map
+     * by message type or skill id of count, bytes, mean_us, p50_us, p90_us,
+     * p99_us and max_us, "memory" by view then skill id, plus "uptime_ms"
+     */
+    Q_INVOKABLE QVariantMap snapshot() const;
+
+    Q_INVOKABLE void reset();
+
+Q_SIGNALS:
+    void enabledChanged();
+
+private:
+    struct Metric {
+        quint64 bytes = 0;
+        LatencyHistogram latency;
+    };
+
+    explicit GuiMetrics(QObject *parent = nullptr);
+    static QVariantMap metricsMap(const QHash<QString, Metric> &metrics);
+
+    QHash<QString, Metric> m_guiMessages;
+    QHash<QString, Metric> m_busMessages;
+    QHash<QString, Metric> m_skills;
+    QHash<QString, Metric> m_delegates;
+    QVariantMap m_memory;
+    QElapsedTimer m_uptime;
+    bool m_enabled = true;
+};
@@ -0,0 +1,286 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "imagecache.h"
+#include "networkcache.h"
+
+#include <QBuffer>
+#include <QDebug>
+#include <QFile>
+#include <QImageReader>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QQmlFile>
+#include <QThread>
+#include <QtMath>
+
+ImageCache::ImageCache()
+{
+    setBudget(qint64(64) * 1024 * 1024);
+}
+
+ImageCache *ImageCache::instance()
+{
+    static ImageCache s_cache;
+    return &s_cache;
+}
+
+QString ImageCache::key(const QUrl &url, const QSize &size)
+{
+    return QStringLiteral("%1@%2x%3").arg(url.toString(QUrl::FullyEncoded)).arg(size.width()).arg(size.height());
+}
+
+QImage ImageCache::decode(QIODevice *device, const QSize &requestedSize, QString *error)
+{
+    QImageReader reader(device);
+    reader.setAutoTransform(true);
+
+    const QSize size = reader.size();
+    if (size.isValid() && (requestedSize.width() > 0 || requestedSize.height() > 0)) {
+        // requestedSize is for the image as shown, after its EXIF rotation
+        QSize wanted = requestedSize;
+        if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+            wanted.transpose();
+        }
+
+        const qreal scale = qMax(wanted.width() > 0 ? qreal(wanted.width()) / size.width() : 0,
+                                 wanted.height() > 0 ? qreal(wanted.height()) / size.height() : 0);
+        if (scale < 1) {
+            // JPEG decodes straight at the smaller size, other formats are scaled once decoded
+            reader.setScaledSize(QSize(qCeil(size.width() * scale), qCeil(size.height() * scale)));
+        }
+    }
+
+    const QImage image = reader.read();
+    if (image.isNull() && error) {
+        *error = reader.errorString();
+    }
+    return image;
+}
+
+QImage ImageCache::find(const QString &key)
+{
+    QMutexLocker locker(&m_mutex);
+    QImage *image = m_images.object(key);
+    return image ? *image : QImage();
+}
+
+bool ImageCache::contains(const QString &key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_images.contains(key);
+}
+
+void ImageCache::insert(const QString &key, const QImage &image)
+{
+    const int cost = qMax(1, int(qint64(image.bytesPerLine()) * image.height() / 1024));
+
+    QMutexLocker locker(&m_mutex);
+    // Images bigger than the whole budget are not kept
+    m_images.insert(key, new QImage(image), cost);
+}
+
+void ImageCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_images.clear();
+}
+
+qint64 ImageCache::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return qint64(m_images.maxCost()) * 1024;
+}
+
+void ImageCache::setBudget(qint64 budget)
+{
+    QMutexLocker locker(&m_mutex);
+    m_images.setMaxCost(int(qBound(qint64(0), budget / 1024, qint64(INT_MAX))));
+}
+
+qint64 ImageCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return qint64(m_images.totalCost()) * 1024;
+}
+
+int ImageCache::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_images.count();
+}
+
+static bool isRemote(const QUrl &url)
+{
+    return url.scheme() == QLatin1String("http") || url.scheme() == QLatin1String("https");
+}
+
+SkillImageProvider::SkillImageProvider()
+    : m_downloader(new ImageDownloader)
+{
+    // A page often shows several images at once, leave some cores to the rest of the gui
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+SkillImageProvider::~SkillImageProvider()
+{
+    m_pool.waitForDone();
+    m_downloader->deleteLater();
+}
+
+QQuickImageResponse *SkillImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    QUrl url(QUrl::fromPercentEncoding(id.toUtf8()));
+    if (url.isRelative()) {
+        url = QUrl::fromLocalFile(url.toString());
+    }
+
+    auto *response = new SkillImageResponse(url, requestedSize, &m_pool);
+    if (isRemote(url) && !ImageCache::instance()->contains(ImageCache::key(url, requestedSize))) {
+        response->fetch(m_downloader);
+    } else {
+        m_pool.start(response);
+    }
+    return response;
+}
+
+ImageDownloader::ImageDownloader(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void ImageDownloader::download(const QUrl &url)
+{
+    if (m_pending.contains(url)) {
+        return;
+    }
+
+    if (!m_manager) {
+        m_manager = NetworkCache::instance()->create(this);
+    }
+
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+
+    m_pending.insert(url);
+    QNetworkReply *reply = m_manager->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, url]() {
+        reply->deleteLater();
+        m_pending.remove(url);
+
+        if (reply->error() != QNetworkReply::NoError) {
+            qWarning() << "Cannot download image" << url << reply->errorString();
+            emit downloaded(url, QByteArray(), reply->errorString());
+            return;
+        }
+
+        emit downloaded(url, reply->readAll(), QString());
+    });
+}
+
+SkillImageResponse::SkillImageResponse(const QUrl &url, const QSize &requestedSize, QThreadPool *pool)
+    : m_url(url),
+      m_requestedSize(requestedSize),
+      m_pool(pool)
+{
+    // Deleted by the engine once finished
+    setAutoDelete(false);
+}
+
+void SkillImageResponse::fetch(ImageDownloader *downloader)
+{
+    // The downloader lives in the GUI thread: queued both ways
+    m_downloadConnection = connect(downloader, &ImageDownloader::downloaded, this, &SkillImageResponse::onDownloaded);
+    QMetaObject::invokeMethod(downloader, "download", Qt::QueuedConnection, Q_ARG(QUrl, m_url));
+}
+
+void SkillImageResponse::onDownloaded(const QUrl &url, const QByteArray &data, const QString &error)
+{
+    if (url != m_url) {
+        return;
+    }
+
+    disconnect(m_downloadConnection);
+    if (!error.isEmpty()) {
+        m_error = error;
+        finishLater();
+        return;
+    }
+
+    m_data = data;
+    m_pool->start(this);
+}
+
+QQuickTextureFactory *SkillImageResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage(m_image);
+}
+
+QString SkillImageResponse::errorString() const
+{
+    return m_error;
+}
+
+void SkillImageResponse::cancel()
+{
+    m_cancelled.store(1);
+
+    // Still waiting for the download: nothing else will finish it
+    if (disconnect(m_downloadConnection)) {
+        finishLater();
+    }
+}
+
+void SkillImageResponse::run()
+{
+    if (!m_cancelled.load()) {
+        const QString key = ImageCache::key(m_url, m_requestedSize);
+        m_image = ImageCache::instance()->find(key);
+
+        if (m_image.isNull() && !m_data.isEmpty()) {
+            QBuffer buffer(&m_data);
+            buffer.open(QIODevice::ReadOnly);
+            m_image = ImageCache::decode(&buffer, m_requestedSize, &m_error);
+            m_data.clear();
+        } else if (m_image.isNull()) {
+            const QString path = QQmlFile::urlToLocalFileOrQrc(m_url);
+            QFile file(path);
+            if (path.isEmpty()) {
+                m_error = QStringLiteral("Unsupported image url %1").arg(m_url.toString());
+            } else if (!file.open(QIODevice::ReadOnly)) {
+                m_error = QStringLiteral("Cannot open %1: %2").arg(path, file.errorString());
+            } else {
+                m_image = ImageCache::decode(&file, m_requestedSize, &m_error);
+            }
+        }
+
+        if (!m_image.isNull()) {
+            ImageCache::instance()->insert(key, m_image);
+        } else {
+            qWarning() << "Cannot load image" << m_url << m_error;
+        }
+    }
+
+    finishLater();
+}
+
+void SkillImageResponse::finishLater()
+{
+    QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+}
+
+#include "moc_imagecache.cpp"
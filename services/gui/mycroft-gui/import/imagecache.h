@@ -0,0 +1,153 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QAtomicInt>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QQuickAsyncImageProvider>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <QUrl>
+
+class QIODevice;
+class QNetworkAccessManager;
+
+/**
+ * Decoded images shared by all the engines of the process, keyed by url and
+ * by the size they were decoded at. The least recently used ones are dropped
+ * once the decoded bytes go over budget(). Thread safe.
+ */
+class ImageCache
+{
+public:
+    static ImageCache *instance();
+
+    static QString key(const QUrl &url, const QSize &size);
+
+    /**
+     * Decodes the image straight at the smallest size that still covers
+     * requestedSize with its aspect ratio kept, never upscaling.
+     * An empty requestedSize decodes it whole.
+     * @returns a null image, with the reason in error, if it can't be decoded
+     */
+    static QImage decode(QIODevice *device, const QSize &requestedSize, QString *error);
+
+    QImage find(const QString &key);
+    bool contains(const QString &key) const;
+    void insert(const QString &key, const QImage &image);
+    void clear();
+
+    /**
+     * Bytes of decoded images kept
+     */
+    qint64 budget() const;
+    void setBudget(qint64 budget);
+    qint64 size() const;
+    int count() const;
+
+private:
+    ImageCache();
+
+    mutable QMutex m_mutex;
+    // Costs in KiB, QCache counts in int
+    QCache<QString, QImage> m_images;
+};
+
+class ImageDownloader;
+
+/**
+ * The "mycroft" image provider: image://mycroft/<percent encoded url> loads
+ * the url at the sourceSize of the Image, decoding it off the GUI thread and
+ * through the ImageCache. file, qrc, http and https urls are supported.
+ */
+class SkillImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    SkillImageProvider();
+    ~SkillImageProvider() override;
+
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+
+private:
+    QThreadPool m_pool;
+    ImageDownloader *m_downloader;
+};
+
+/**
+ * @internal Lives in the GUI thread, downloads every url once for all the
+ * responses waiting for it
+ */
+class ImageDownloader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImageDownloader(QObject *parent = nullptr);
+
+public Q_SLOTS:
+    void download(const QUrl &url);
+
+Q_SIGNALS:
+    void downloaded(const QUrl &url, const QByteArray &data, const QString &error);
+
+private:
+    QNetworkAccessManager *m_manager = nullptr;
+    QSet<QUrl> m_pending;
+};
+
+/**
+ * @internal One image request, decoded in the provider's thread pool
+ */
+class SkillImageResponse : public QQuickImageResponse, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    SkillImageResponse(const QUrl &url, const QSize &requestedSize, QThreadPool *pool);
+
+    /**
+     * Downloads the image first, for remote urls
+     */
+    void fetch(ImageDownloader *downloader);
+
+    QQuickTextureFactory *textureFactory() const override;
+    QString errorString() const override;
+    void cancel() override;
+
+    void run() override;
+
+private Q_SLOTS:
+    void onDownloaded(const QUrl &url, const QByteArray &data, const QString &error);
+
+private:
+    // The engine connects to finished() after the response has been returned
+    void finishLater();
+
+    const QUrl m_url;
+    const QSize m_requestedSize;
+    QThreadPool *m_pool;
+    QMetaObject::Connection m_downloadConnection;
+    QByteArray m_data;
+    QImage m_image;
+    QString m_error;
+    QAtomicInt m_cancelled;
+};
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "incubationcontroller.h"
+
+#include <QQuickWindow>
+
+FrameIncubationController::FrameIncubationController(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setInterval(16);
+    connect(&m_timer, &QTimer::timeout, this, &FrameIncubationController::incubate);
+}
+
+int FrameIncubationController::budget() const
+{
+    return m_budget;
+}
+
+void FrameIncubationController::setBudget(int budget)
+{
+    m_budget = qMax(1, budget);
+}
+
+void FrameIncubationController::setWindow(QQuickWindow *window)
+{
+    if (m_window == window) {
+        return;
+    }
+
+    disconnect(m_frameConnection);
+    m_timer.stop();
+    m_window = window;
+
+    if (incubatingObjectCount() > 0) {
+        schedule();
+    }
+}
+
+void FrameIncubationController::incubatingObjectCountChanged(int count)
+{
+    if (count > 0) {
+        schedule();
+    } else {
+        disconnect(m_frameConnection);
+        m_timer.stop();
+    }
+}
+
+void FrameIncubationController::schedule()
+{
+    if (!m_window) {
+        m_timer.start();
+        return;
+    }
+
+    if (!m_frameConnection) {
+        // Emitted on the GUI thread once per frame, before the scene is synchronized
+        m_frameConnection = connect(m_window.data(), &QQuickWindow::afterAnimating,
+                                    this, &FrameIncubationController::incubate);
+    }
+    m_window->update();
+}
+
+void FrameIncubationController::incubate()
+{
+    incubateFor(m_budget);
+
+    // Keeps frames coming until everything is incubated
+    if (m_window && incubatingObjectCount() > 0) {
+        m_window->update();
+    }
+}
+
+#include "moc_incubationcontroller.cpp"
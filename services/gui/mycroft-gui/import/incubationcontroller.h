@@ -0,0 +1,56 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QQmlIncubationController>
+#include <QTimer>
+
+class QQuickWindow;
+
+/**
+ * Incubates asynchronously created objects of an engine for at most
+ * budget() milliseconds per frame of the window, so that the rest of the
+ * scene keeps animating while a heavy delegate is being created.
+ * Without a window, a 16ms timer stands in for the frames.
+ */
+class FrameIncubationController : public QObject, public QQmlIncubationController
+{
+    Q_OBJECT
+
+public:
+    explicit FrameIncubationController(QObject *parent = nullptr);
+
+    int budget() const;
+    void setBudget(int budget);
+
+    void setWindow(QQuickWindow *window);
+
+protected:
+    void incubatingObjectCountChanged(int count) override;
+
+private:
+    void incubate();
+    void schedule();
+
+    QPointer<QQuickWindow> m_window;
+    QMetaObject::Connection m_frameConnection;
+    QTimer m_timer;
+    int m_budget = 4;
+};
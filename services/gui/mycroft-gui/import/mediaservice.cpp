@@ -16,6 +16,7 @@
  */
 
 #include "mediaservice.h"
+#include "bussyncthrottle.h"
 #include <QAudioProbe>
 #include <QMediaObject>
 #include <QMediaPlayer>
@@ -24,39 +25,254 @@
 #include <QAudioInput>
 #include <QAudioRecorder>
 
+#include <algorithm>
+
 MediaService::MediaService(QObject *parent)
     : QObject(parent),
       m_controller(MycroftController::instance()),
       mVideoSurface(nullptr)
 {
-    if (m_controller->status() == MycroftController::Open){
-        connect(m_controller, &MycroftController::intentRecevied, this,
-                &MediaService::onMainSocketIntentReceived);
-    }
+    m_controller->subscribe({QStringLiteral("gui.player.media.service.play"),
+                             QStringLiteral("gui.player.media.service.pause"),
+                             QStringLiteral("gui.player.media.service.stop"),
+                             QStringLiteral("gui.player.media.service.resume"),
+                             QStringLiteral("gui.player.media.service.set.meta"),
+                             QStringLiteral("gui.player.media.service.preload")},
+                            this, [this](const QString &type, const QVariantMap &data) {
+        onMainSocketIntentReceived(type, data);
+    });
 
+    m_busSync = new BusSyncThrottle(m_controller, this);
     calculator = new FFTCalc(this);
-    m_player = new QMediaPlayer;
-    connect(calculator, &FFTCalc::calculatedSpectrum, this, [this](QVector<double> spectrum) {
-        int size = 20;
-        m_spectrum.resize(size);
-        int j = 0;
-        for (int i = 0; i < spectrum.size(); i += spectrum.size()/(size - 1)) {
-            m_spectrum[j] = spectrum[i];
-            ++j;
-        }
+    m_player = new QMediaPlayer(this);
+    m_nextPlayer = new QMediaPlayer(this);
+    connect(calculator, &FFTCalc::calculatedSpectrum, this, [this]() {
+        // Copy in place, no need to share the buffer with the processor
+        const QVector<double> &spectrum = calculator->spectrum();
+        m_spectrum.resize(spectrum.size());
+        std::copy(spectrum.constBegin(), spectrum.constEnd(), m_spectrum.begin());
         emit spectrumChanged();
     });
+    auto updatePowerState = [this]() {
+        m_meteringPaused = m_controller->powerState() == MycroftController::Idle;
+        calculator->setPaused(m_meteringPaused);
+    };
+    connect(m_controller, &MycroftController::powerStateChanged, this, updatePowerState);
+    updatePowerState();
 
-    connect(m_player, &QMediaPlayer::mediaStatusChanged, this, &MediaService::onMediaStatusChanged);
+    connectPlayer(m_player);
+    connectPlayer(m_nextPlayer);
     setupProbeSource();
 }
 
+void MediaService::connectPlayer(QMediaPlayer *player)
+{
+    // Both slots stay connected for their whole life, only the current one gets through
+    connect(player, &QMediaPlayer::mediaStatusChanged, this, [this, player](QMediaPlayer::MediaStatus status) {
+        if (player == m_player) {
+            onMediaStatusChanged(status);
+        }
+    });
+    connect(player, &QMediaPlayer::durationChanged, this, [this, player](qint64 dur) {
+        if (player == m_player) {
+            emit durationChanged(dur);
+        }
+    });
+    connect(player, &QMediaPlayer::positionChanged, this, [this, player](qint64 pos) {
+        // Paused or stalled backends keep reporting the same position
+        if (player == m_player && pos != m_lastPosition) {
+            m_lastPosition = pos;
+            emit positionChanged(pos);
+        }
+    });
+    player->setNotifyInterval(m_positionInterval);
+}
+
 void MediaService::setupProbeSource()
 {
-    QAudioProbe *probe = new QAudioProbe;
-    probe->setSource(m_player);
-    connect(probe, SIGNAL(audioBufferProbed(QAudioBuffer)), this, SLOT(processBuffer(QAudioBuffer)));
-    return;
+    for (QMediaPlayer *player : {m_player, m_nextPlayer}) {
+        if (m_probes.contains(player)) {
+            continue;
+        }
+        QAudioProbe *probe = new QAudioProbe(this);
+        probe->setSource(player);
+        connect(probe, &QAudioProbe::audioBufferProbed, this, [this, player](const QAudioBuffer &buffer) {
+            if (player == m_player) {
+                processBuffer(buffer);
+            }
+        });
+        m_probes.insert(player, probe);
+    }
+}
+
+int MediaService::syncInterval() const
+{
+    return m_busSync->interval();
+}
+
+void MediaService::setSyncInterval(int interval)
+{
+    if (interval == m_busSync->interval()) {
+        return;
+    }
+
+    m_busSync->setInterval(interval);
+    emit syncIntervalChanged();
+}
+
+int MediaService::positionInterval() const
+{
+    return m_positionInterval;
+}
+
+void MediaService::setPositionInterval(int interval)
+{
+    if (interval == m_positionInterval || interval <= 0) {
+        return;
+    }
+
+    m_positionInterval = interval;
+    m_player->setNotifyInterval(m_positionInterval);
+    m_nextPlayer->setNotifyInterval(m_positionInterval);
+    emit positionIntervalChanged();
+}
+
+bool MediaService::isGapless() const
+{
+    return m_gapless;
+}
+
+void MediaService::setGapless(bool gapless)
+{
+    if (gapless == m_gapless) {
+        return;
+    }
+
+    m_gapless = gapless;
+    if (!m_gapless) {
+        clearNextTrack();
+    }
+    emit gaplessChanged();
+}
+
+void MediaService::clearNextTrack()
+{
+    m_nextTrack.clear();
+    m_nextPlayer->setMedia(QMediaContent());
+}
+
+bool MediaService::isNextTrackReady() const
+{
+    if (m_nextTrack.isEmpty()) {
+        return false;
+    }
+
+    const QMediaPlayer::MediaStatus status = m_nextPlayer->mediaStatus();
+    return status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::BufferingMedia
+        || status == QMediaPlayer::BufferedMedia;
+}
+
+void MediaService::switchToNextTrack()
+{
+    QMediaPlayer *previous = m_player;
+    m_player = m_nextPlayer;
+    m_nextPlayer = previous;
+
+    if (mVideoSurface) {
+        previous->setVideoOutput(static_cast<QAbstractVideoSurface *>(nullptr));
+        m_player->setVideoOutput(mVideoSurface);
+    }
+    m_player->play();
+
+    m_track = m_nextTrack.toString();
+    m_switchedTrack = m_nextTrack;
+    m_nextTrack.clear();
+    m_preloadRequested = false;
+    m_lastPosition = -1;
+    previous->stop();
+    previous->setMedia(QMediaContent());
+
+    setPlaybackState(QMediaPlayer::PlayingState);
+    emit durationChanged(m_player->duration());
+    onMediaStatusChanged(m_player->mediaStatus());
+
+    QVariantMap data;
+    data.insert(QStringLiteral("track"), m_track);
+    m_controller->sendRequest(QStringLiteral("gui.player.media.service.sync.track"), data);
+    // For the UI to update, as if the server asked this track to be played
+    emit playRequested();
+}
+
+qreal MediaService::peakLeft() const
+{
+    return m_levels.peakLeft;
+}
+
+qreal MediaService::peakRight() const
+{
+    return m_levels.peakRight;
+}
+
+qreal MediaService::rmsLeft() const
+{
+    return m_levels.rmsLeft;
+}
+
+qreal MediaService::rmsRight() const
+{
+    return m_levels.rmsRight;
+}
+
+int MediaService::spectrumBands() const
+{
+    return m_spectrumBands;
+}
+
+void MediaService::setSpectrumBands(int bands)
+{
+    if (bands == m_spectrumBands) {
+        return;
+    }
+    if (bands < 1) {
+        qWarning() << "Invalid spectrum band count" << bands;
+        return;
+    }
+
+    m_spectrumBands = bands;
+    calculator->setBands(m_spectrumBands, FFTCalc::BandMapping(m_spectrumMapping));
+    emit spectrumBandsChanged();
+}
+
+MediaService::SpectrumMapping MediaService::spectrumMapping() const
+{
+    return m_spectrumMapping;
+}
+
+void MediaService::setSpectrumMapping(SpectrumMapping mapping)
+{
+    if (mapping == m_spectrumMapping) {
+        return;
+    }
+
+    m_spectrumMapping = mapping;
+    calculator->setBands(m_spectrumBands, FFTCalc::BandMapping(m_spectrumMapping));
+    emit spectrumMappingChanged();
+}
+
+int MediaService::spectrumMaxFps() const
+{
+    return m_spectrumMaxFps;
+}
+
+void MediaService::setSpectrumMaxFps(int maxFps)
+{
+    if (maxFps == m_spectrumMaxFps) {
+        return;
+    }
+
+    m_spectrumMaxFps = qMax(0, maxFps);
+    calculator->setMaxFps(m_spectrumMaxFps);
+    emit spectrumMaxFpsChanged();
 }
 
 QAbstractVideoSurface *MediaService::videoSurface() const
@@ -75,81 +291,87 @@ void MediaService::setVidSurface(QAbstractVideoSurface *videoSurface)
     }
 }
 
-void MediaService::processBuffer(QAudioBuffer buffer)
+template<typename Sample>
+static AudioLevels meterBuffer(const QAudioBuffer &buffer, FFTCalc *calculator)
 {
-    qreal peakValue;
-    int duration;
-
-    if(buffer.frameCount() < 512)
-        return;
-
-    levelLeft = levelRight = 0;
+    const int sampleRate = buffer.format().sampleRate();
+    return AudioMeter::process(buffer.constData<Sample>(), buffer.frameCount(), buffer.format().channelCount(),
+                               [calculator, sampleRate](const float *samples, int count) {
+        calculator->pushSamples(samples, count, sampleRate);
+    });
+}
 
-    if(buffer.format().channelCount() != 2)
+void MediaService::processBuffer(QAudioBuffer buffer)
+{
+    if(buffer.frameCount() < 512 || m_meteringPaused)
         return;
 
-    sample.resize(buffer.frameCount());
-    if(buffer.format().sampleType() == QAudioFormat::SignedInt){
-        QAudioBuffer::S16S *data = buffer.data<QAudioBuffer::S16S>();
-        if (buffer.format().sampleSize() == 32)
-            peakValue=INT_MAX;
-        else if (buffer.format().sampleSize() == 16)
-            peakValue=SHRT_MAX;
-        else
-            peakValue=CHAR_MAX;
-
-        for(int i=0; i<buffer.frameCount(); i++){
-            sample[i] = data[i].left/peakValue;
-            levelLeft+= abs(data[i].left)/peakValue;
-            levelRight+= abs(data[i].right)/peakValue;
+    const QAudioFormat format = buffer.format();
+    AudioLevels levels;
+
+    switch (format.sampleType()) {
+    case QAudioFormat::SignedInt:
+        if (format.sampleSize() == 32) {
+            levels = meterBuffer<qint32>(buffer, calculator);
+        } else if (format.sampleSize() == 16) {
+            levels = meterBuffer<qint16>(buffer, calculator);
+        } else if (format.sampleSize() == 8) {
+            levels = meterBuffer<qint8>(buffer, calculator);
+        } else {
+            return;
         }
-    }
-
-    else if(buffer.format().sampleType() == QAudioFormat::UnSignedInt){
-        QAudioBuffer::S16U *data = buffer.data<QAudioBuffer::S16U>();
-        if (buffer.format().sampleSize() == 32)
-            peakValue=UINT_MAX;
-        else if (buffer.format().sampleSize() == 16)
-            peakValue=USHRT_MAX;
-        else
-            peakValue=UCHAR_MAX;
-        for(int i=0; i<buffer.frameCount(); i++){
-            sample[i] = data[i].left/peakValue;
-            levelLeft+= abs(data[i].left)/peakValue;
-            levelRight+= abs(data[i].right)/peakValue;
+        break;
+    case QAudioFormat::UnSignedInt:
+        if (format.sampleSize() == 32) {
+            levels = meterBuffer<quint32>(buffer, calculator);
+        } else if (format.sampleSize() == 16) {
+            levels = meterBuffer<quint16>(buffer, calculator);
+        } else if (format.sampleSize() == 8) {
+            levels = meterBuffer<quint8>(buffer, calculator);
+        } else {
+            return;
         }
-    }
-
-    else if(buffer.format().sampleType() == QAudioFormat::Float){
-        QAudioBuffer::S32F *data = buffer.data<QAudioBuffer::S32F>();
-        peakValue = 1.00003;
-        for(int i=0; i<buffer.frameCount(); i++){
-            sample[i] = data[i].left/peakValue;
-            if(sample[i] != sample[i]){
-                sample[i] = 0;
-            }
-            else{
-                levelLeft+= abs(data[i].left)/peakValue;
-                levelRight+= abs(data[i].right)/peakValue;
-            }
+        break;
+    case QAudioFormat::Float:
+        if (format.sampleSize() != 32) {
+            return;
         }
+        levels = meterBuffer<float>(buffer, calculator);
+        break;
+    default:
+        return;
     }
-    duration = buffer.format().durationForBytes(buffer.frameCount())/1000;
-    calculator->calc(sample, duration);
-    emit levels(levelLeft/buffer.frameCount(), levelRight/buffer.frameCount());
+
+    m_levels = levels;
+    emit levelsChanged();
+    emit this->levels(m_levels.rmsLeft, m_levels.rmsRight);
 }
 
 void MediaService::playURL(const QString &filename)
 {
-    m_player->setMedia(QUrl(filename));
+    const QUrl url(filename);
+
+    // We switched to it already, this is only the UI catching up
+    if (!m_switchedTrack.isEmpty() && url == m_switchedTrack) {
+        m_switchedTrack.clear();
+        return;
+    }
+    m_switchedTrack.clear();
+
+    if (m_gapless && url == m_nextTrack && isNextTrackReady()) {
+        switchToNextTrack();
+        m_switchedTrack.clear();
+        return;
+    }
+
+    m_preloadRequested = false;
+    m_lastPosition = -1;
+    if (url == m_nextTrack) {
+        clearNextTrack();
+    }
+    m_player->setMedia(url);
     m_player->play();
     setPlaybackState(QMediaPlayer::PlayingState);
-    connect(m_player, &QMediaPlayer::durationChanged, this, [&](qint64 dur) {
-        emit durationChanged(dur);
-    });
-    connect(m_player, &QMediaPlayer::positionChanged, this, [&](qint64 pos) {
-        emit positionChanged(pos);
-    });
 }
 
 void MediaService::playerStop()
@@ -172,8 +394,10 @@ void MediaService::playerContinue()
 
 void MediaService::playerRestart()
 {
-    m_player->stop();
-    playURL(m_track);
+    // Same media, no need to load it again
+    m_player->setPosition(0);
+    m_player->play();
+    setPlaybackState(QMediaPlayer::PlayingState);
 }
 
 void MediaService::playerNext()
@@ -206,9 +430,8 @@ void MediaService::setPlaybackState(QMediaPlayer::State playbackState)
     m_playerState = playbackState;
     emit playbackStateChanged(playbackState);
 
-    m_playerStateSync.clear();
-    m_playerStateSync.insert(QStringLiteral("state"), playbackState);
-    m_controller->sendRequest(QStringLiteral("gui.player.media.service.sync.status"), m_playerStateSync);
+    m_busSync->send(QStringLiteral("gui.player.media.service.sync.status"),
+                    QVariantMap({{QStringLiteral("state"), playbackState}}));
 }
 
 void MediaService::playerSeek(qint64 seekvalue)
@@ -257,36 +480,43 @@ QMediaPlayer::State MediaService::playbackState() const
 
 void MediaService::onMediaStatusChanged(QMediaPlayer::MediaStatus status)
 {
+    if (status == QMediaPlayer::EndOfMedia && m_gapless && isNextTrackReady()) {
+        switchToNextTrack();
+        return;
+    }
+
     emit mediaStatusChanged(status);
 
-    m_currentMediaStatus.clear();
-    m_currentMediaStatus.insert(QStringLiteral("status"), status);
-    m_controller->sendRequest(QStringLiteral("gui.player.media.service.current.media.status"), m_currentMediaStatus);
+    m_busSync->send(QStringLiteral("gui.player.media.service.current.media.status"),
+                    QVariantMap({{QStringLiteral("status"), status}}));
 
     if (status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::BufferedMedia)
     {
-        QStringList metadataAvailableList = m_player->availableMetaData();
-        int availableListSize = metadataAvailableList.size();
-        QString availableMetaKey;
-        QVariant availableMetaVal;
-
         m_metadataList.clear();
-        for (int idx = 0; idx < availableListSize; idx++)
+        const QStringList metadataAvailableList = m_player->availableMetaData();
+        for (const QString &availableMetaKey : metadataAvailableList)
         {
-            availableMetaKey = metadataAvailableList.at(idx);
-            availableMetaVal = m_player->metaData(availableMetaKey);
+            const QVariant availableMetaVal = m_player->metaData(availableMetaKey);
             m_metadataList.insert(availableMetaKey, availableMetaVal);
 
-            if(availableMetaKey == QStringLiteral("Title")){
-                m_title = m_player->metaData(availableMetaKey).toString();
+            if(availableMetaKey == QLatin1String("Title")){
+                m_title = availableMetaVal.toString();
             }
-            if(availableMetaKey == QStringLiteral("Artist")){
-                m_artist = m_player->metaData(availableMetaKey).toString();
+            if(availableMetaKey == QLatin1String("Artist")){
+                m_artist = availableMetaVal.toString();
             }
         }
 
         emit metaUpdated();
-        m_controller->sendRequest(QStringLiteral("gui.player.media.service.get.meta"), m_metadataList);
+        m_busSync->send(QStringLiteral("gui.player.media.service.get.meta"), m_metadataList);
+
+        // Ask for the next track early enough to have it buffered at the end of this one
+        if (m_gapless && !m_repeat && !m_preloadRequested && m_nextTrack.isEmpty()) {
+            m_preloadRequested = true;
+            QVariantMap data;
+            data.insert(QStringLiteral("preload"), true);
+            m_controller->sendRequest(QStringLiteral("gui.player.media.service.get.next"), data);
+        }
     }
 }
 
@@ -300,6 +530,15 @@ void MediaService::onMainSocketIntentReceived(const QString &type, const QVarian
         emit playRequested();
     }
 
+    if(type == QStringLiteral("gui.player.media.service.preload")) {
+        const QUrl track(data[QStringLiteral("track")].toString());
+        if(m_gapless && track.isValid() && track != m_nextTrack){
+            m_nextTrack = track;
+            // Loading starts right away, playback only when switching to it
+            m_nextPlayer->setMedia(track);
+        }
+    }
+
     if(type == QStringLiteral("gui.player.media.service.pause")) {
         playerPause();
         emit pauseRequested();
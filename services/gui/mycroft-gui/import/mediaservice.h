@@ -26,22 +26,70 @@
 #include <QJsonDocument>
 #include "thirdparty/fftcalc.h"
 #include "mycroftcontroller.h"
+#include "audiometer.h"
+
+class BusSyncThrottle;
 
 class MediaService : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(QVector<double> spectrum READ spectrum NOTIFY spectrumChanged)
+    // Levels of the last probed buffer, from 0 to 1; mono streams have both channels equal
+    Q_PROPERTY(qreal peakLeft READ peakLeft NOTIFY levelsChanged)
+    Q_PROPERTY(qreal peakRight READ peakRight NOTIFY levelsChanged)
+    Q_PROPERTY(qreal rmsLeft READ rmsLeft NOTIFY levelsChanged)
+    Q_PROPERTY(qreal rmsRight READ rmsRight NOTIFY levelsChanged)
+    // Layout of the spectrum: only what the visualizer draws gets computed
+    Q_PROPERTY(int spectrumBands READ spectrumBands WRITE setSpectrumBands NOTIFY spectrumBandsChanged)
+    Q_PROPERTY(SpectrumMapping spectrumMapping READ spectrumMapping WRITE setSpectrumMapping NOTIFY spectrumMappingChanged)
+    // Maximum updates per second of spectrum, 0 for one per analyzed chunk
+    Q_PROPERTY(int spectrumMaxFps READ spectrumMaxFps WRITE setSpectrumMaxFps NOTIFY spectrumMaxFpsChanged)
     Q_PROPERTY(QMediaPlayer::State playbackState READ playbackState NOTIFY playbackStateChanged)
     Q_PROPERTY(QAbstractVideoSurface* videoSurface READ videoSurface WRITE setVidSurface NOTIFY signalVideoSurfaceChanged)
+    /**
+     * Gapless playback: once a track is loaded, the next one is asked with a
+     * gui.player.media.service.get.next having "preload": true, which the
+     * server answers with gui.player.media.service.preload {"track": url}.
+     * That track gets buffered in a second player, which takes over as soon
+     * as the current track ends, then gui.player.media.service.sync.track
+     * tells the server which track is now playing.
+     */
+    Q_PROPERTY(bool gapless READ isGapless WRITE setGapless NOTIFY gaplessChanged)
+    // Minimum time between two state, status or metadata syncs to the bus, in ms (250); 0 for no limit
+    Q_PROPERTY(int syncInterval READ syncInterval WRITE setSyncInterval NOTIFY syncIntervalChanged)
+    // Time between two positionChanged(), in ms (1000)
+    Q_PROPERTY(int positionInterval READ positionInterval WRITE setPositionInterval NOTIFY positionIntervalChanged)
 
 public:
+    enum SpectrumMapping {
+        LogSpectrum = FFTCalc::LogBands,
+        MelSpectrum = FFTCalc::MelBands
+    };
+    Q_ENUM(SpectrumMapping)
+
     explicit MediaService(QObject *parent = Q_NULLPTR);
 
     QMediaPlayer::State playerState() const {return m_playerState;}
     QVector<double> spectrum() const {return m_spectrum;}
+    qreal peakLeft() const;
+    qreal peakRight() const;
+    qreal rmsLeft() const;
+    qreal rmsRight() const;
+    int spectrumBands() const;
+    void setSpectrumBands(int bands);
+    SpectrumMapping spectrumMapping() const;
+    void setSpectrumMapping(SpectrumMapping mapping);
+    int spectrumMaxFps() const;
+    void setSpectrumMaxFps(int maxFps);
     QAbstractVideoSurface *videoSurface() const;
     void setVidSurface(QAbstractVideoSurface *videoSurface);
     QMediaPlayer::State getPlaybackState();
+    int syncInterval() const;
+    void setSyncInterval(int interval);
+    int positionInterval() const;
+    void setPositionInterval(int interval);
+    bool isGapless() const;
+    void setGapless(bool gapless);
 
 public Q_SLOTS:
     void setupProbeSource();
@@ -79,19 +127,37 @@ Q_SIGNALS:
     void shuffleRequested();
     void metaReceived();
     void metaUpdated();
+    void gaplessChanged();
+    void syncIntervalChanged();
+    void positionIntervalChanged();
 
 private:
     MycroftController *m_controller;
     QAbstractVideoSurface *mVideoSurface;
     void onMainSocketIntentReceived(const QString &type, const QVariantMap &data);
     void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void connectPlayer(QMediaPlayer *player);
+    void clearNextTrack();
+    bool isNextTrackReady() const;
+    void switchToNextTrack();
 
-    QVector<double> sample;
     QVector<double> m_spectrum;
+    int m_spectrumBands = DEFAULTBANDS;
+    SpectrumMapping m_spectrumMapping = LogSpectrum;
+    int m_spectrumMaxFps = DEFAULTMAXFPS;
     QMediaPlayer::State m_playerState;
-    double levelLeft, levelRight;
+    AudioLevels m_levels;
     FFTCalc *calculator;
+    // MycroftController::Idle: no levels nor spectrum
+    bool m_meteringPaused = false;
+    // The current track, and the preloaded next one
     QMediaPlayer *m_player;
+    QMediaPlayer *m_nextPlayer;
+    QHash<QMediaPlayer *, QAudioProbe *> m_probes;
+    bool m_gapless = false;
+    bool m_preloadRequested = false;
+    QUrl m_nextTrack;
+    QUrl m_switchedTrack;
     QString m_track;
     QString m_artist;
     QString m_album;
@@ -100,12 +166,18 @@ private:
     bool m_repeat;
     QVariantMap m_emptyData;
     QVariantMap m_metadataList;
-    QVariantMap m_playerStateSync;
-    QVariantMap m_currentMediaStatus;
+    BusSyncThrottle *m_busSync;
+    int m_positionInterval = 1000;
+    qint64 m_lastPosition = -1;
 
 signals:
-    int levels(double left, double right);
+    // RMS of both channels
+    void levels(double left, double right);
+    void levelsChanged();
     void spectrumChanged();
+    void spectrumBandsChanged();
+    void spectrumMappingChanged();
+    void spectrumMaxFpsChanged();
 };
 
 #endif // MEDIASERVICE_H
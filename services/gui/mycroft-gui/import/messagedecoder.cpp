@@ -0,0 +1,181 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "messagedecoder.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+#include <QCborValue>
+#include <QCborMap>
+#endif
+
+MessageDecoder::MessageDecoder(bool withData, QObject *parent)
+    : QObject(parent),
+      m_worker(new MessageDecoderWorker(withData))
+{
+    qRegisterMetaType<DecodedMessage>();
+
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    // Both ends live in different threads: queued, so the order is preserved
+    connect(m_worker, &MessageDecoderWorker::messageDecoded, this, &MessageDecoder::messageDecoded);
+
+    m_thread.setObjectName(QStringLiteral("MessageDecoder"));
+    m_thread.start();
+}
+
+MessageDecoder::~MessageDecoder()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+bool MessageDecoder::decode(const QByteArray &frame, bool binary, bool withData, DecodedMessage &decoded)
+{
+    if (frame.isEmpty()) {
+        qWarning() << "Empty message arrived on the socket";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bool cbor = false;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    // A JSON object always starts with '{' or whitespace, a CBOR map has major type 5
+    cbor = binary && (quint8(frame.at(0)) & 0xE0) == 0xA0;
+    if (cbor) {
+        QCborParserError parseError;
+        const QCborValue value = QCborValue::fromCbor(frame, &parseError);
+
+        if (parseError.error != QCborError::NoError || !value.isMap()) {
+            qWarning() << "Invalid CBOR message arrived on the socket, Error:" << parseError.errorString();
+            return false;
+        }
+
+        decoded.message = value.toMap().toJsonObject();
+    }
+#else
+    Q_UNUSED(binary)
+#endif
+
+    if (!cbor) {
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(frame, &parseError);
+
+        if (doc.isEmpty()) {
+            qWarning() << "Empty or invalid JSON message arrived on the socket:" << frame.left(256) << "Error:" << parseError.errorString();
+            return false;
+        }
+
+        decoded.message = doc.object();
+    }
+
+    decoded.type = decoded.message.value(QStringLiteral("type")).toString();
+    if (withData) {
+        decoded.data = decoded.message.value(QStringLiteral("data")).toVariant().toMap();
+        decoded.hasData = true;
+    }
+
+    decoded.size = frame.size();
+    decoded.decodeTime = timer.nsecsElapsed();
+    return true;
+}
+
+QString MessageDecoder::peekType(const QString &message)
+{
+    const QLatin1String typeKey("\"type\"");
+    const int size = message.size();
+    int i = 0;
+
+    auto skipSpaces = [&]() {
+        while (i < size && message.at(i).isSpace()) {
+            ++i;
+        }
+    };
+    auto expect = [&](QChar c) -> bool {
+        skipSpaces();
+        if (i < size && message.at(i) == c) {
+            ++i;
+            return true;
+        }
+        return false;
+    };
+
+    if (!expect(QLatin1Char('{'))) {
+        return QString();
+    }
+    skipSpaces();
+    if (!message.midRef(i, typeKey.size()).startsWith(typeKey)) {
+        return QString();
+    }
+    i += typeKey.size();
+    if (!expect(QLatin1Char(':')) || !expect(QLatin1Char('"'))) {
+        return QString();
+    }
+
+    const int start = i;
+    while (i < size) {
+        const QChar c = message.at(i);
+        if (c == QLatin1Char('"')) {
+            return message.mid(start, i - start);
+        } else if (c == QLatin1Char('\\')) {
+            // escapes: leave it to the real parser
+            return QString();
+        }
+        ++i;
+    }
+
+    return QString();
+}
+
+void MessageDecoder::postText(const QString &message)
+{
+    QMetaObject::invokeMethod(m_worker, "decodeText", Qt::QueuedConnection, Q_ARG(QString, message));
+}
+
+void MessageDecoder::postBinary(const QByteArray &message)
+{
+    QMetaObject::invokeMethod(m_worker, "decodeBinary", Qt::QueuedConnection, Q_ARG(QByteArray, message));
+}
+
+MessageDecoderWorker::MessageDecoderWorker(bool withData)
+    : QObject(nullptr),
+      m_withData(withData)
+{
+}
+
+void MessageDecoderWorker::decodeText(const QString &message)
+{
+    DecodedMessage decoded;
+    if (MessageDecoder::decode(message.toUtf8(), false, m_withData, decoded)) {
+        emit messageDecoded(decoded);
+    }
+}
+
+void MessageDecoderWorker::decodeBinary(const QByteArray &message)
+{
+    DecodedMessage decoded;
+    if (MessageDecoder::decode(message, true, m_withData, decoded)) {
+        emit messageDecoded(decoded);
+    }
+}
+
+#include "moc_messagedecoder.cpp"
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QJsonObject>
+#include <QThread>
+#include <QVariantMap>
+
+/**
+ * A message from one of the sockets, already parsed
+ */
+struct DecodedMessage
+{
+    QString type;
+    QJsonObject message;
+    // "data" of the message converted to a variant map, only when asked for
+    QVariantMap data;
+    bool hasData = false;
+    // Size of the frame and nanoseconds spent decoding it
+    int size = 0;
+    qint64 decodeTime = 0;
+};
+
+Q_DECLARE_METATYPE(DecodedMessage)
+
+class MessageDecoderWorker;
+
+/**
+ * Decodes the frames arriving on a websocket, either in the calling thread
+ * with decode() or on a dedicated worker thread with post(), so that big
+ * messages don't block the GUI thread.
+ * Messages posted are delivered by messageDecoded() in the same order.
+ */
+class MessageDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param withData also convert the "data" field of every message to a QVariantMap
+     */
+    explicit MessageDecoder(bool withData, QObject *parent = nullptr);
+    ~MessageDecoder() override;
+
+    /**
+     * Synchronous decoding, JSON for text frames; JSON or CBOR for binary frames
+     * @returns false, with a warning, on invalid messages
+     */
+    static bool decode(const QByteArray &frame, bool binary, bool withData, DecodedMessage &decoded);
+
+    /**
+     * Cheap scan for the message type, without parsing the whole message.
+     * Only succeeds when "type" is the first key of the object and needs no unescaping.
+     * @returns the type or a null string if it couldn't be found this way
+     */
+    static QString peekType(const QString &message);
+
+    /**
+     * Asynchronous decoding on the worker thread, the result arrives with messageDecoded()
+     */
+    void postText(const QString &message);
+    void postBinary(const QByteArray &message);
+
+Q_SIGNALS:
+    void messageDecoded(const DecodedMessage &message);
+
+private:
+    QThread m_thread;
+    MessageDecoderWorker *m_worker;
+};
+
+/**
+ * @internal Lives in the decoder thread
+ */
+class MessageDecoderWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MessageDecoderWorker(bool withData);
+
+public Q_SLOTS:
+    void decodeText(const QString &message);
+    void decodeBinary(const QByteArray &message);
+
+Q_SIGNALS:
+    void messageDecoded(const DecodedMessage &message);
+
+private:
+    bool m_withData;
+};
@@ -0,0 +1,375 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "meteritems.h"
+
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+
+// Reuses or creates a node drawing count rectangles of color, two triangles each
+static QSGGeometryNode *rectanglesNode(QSGNode *oldNode, int count, const QColor &color)
+{
+    QSGGeometryNode *node = static_cast<QSGGeometryNode *>(oldNode);
+    if (!node) {
+        node = new QSGGeometryNode;
+        QSGGeometry *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), count * 6);
+        geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+        node->setGeometry(geometry);
+        node->setMaterial(new QSGFlatColorMaterial);
+        node->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+    } else if (node->geometry()->vertexCount() != count * 6) {
+        node->geometry()->allocate(count * 6);
+    }
+
+    QSGFlatColorMaterial *material = static_cast<QSGFlatColorMaterial *>(node->material());
+    if (material->color() != color) {
+        material->setColor(color);
+        node->markDirty(QSGNode::DirtyMaterial);
+    }
+    node->markDirty(QSGNode::DirtyGeometry);
+    return node;
+}
+
+static void setRectangle(QSGGeometry::Point2D *vertices, const QRectF &rect)
+{
+    const float left = float(rect.left());
+    const float top = float(rect.top());
+    const float right = float(rect.right());
+    const float bottom = float(rect.bottom());
+    vertices[0].set(left, top);
+    vertices[1].set(right, top);
+    vertices[2].set(left, bottom);
+    vertices[3].set(right, top);
+    vertices[4].set(right, bottom);
+    vertices[5].set(left, bottom);
+}
+
+// Rises at once, falls by at most fall. @returns whether it still has to fall
+static bool decayTowards(double &displayed, double target, double fall)
+{
+    if (target >= displayed || fall < 0) {
+        displayed = target;
+        return false;
+    }
+    displayed = qMax(target, displayed - fall);
+    return displayed > target;
+}
+
+// Bars of count of the whole width of rect, grown from its bottom
+static QRectF barRect(const QRectF &rect, int index, int count, qreal spacing, qreal value)
+{
+    const qreal width = qMax<qreal>(0, (rect.width() - spacing * (count - 1)) / count);
+    const qreal height = qBound<qreal>(0, value, 1) * rect.height();
+    return QRectF(rect.left() + index * (width + spacing), rect.bottom() - height, width, height);
+}
+
+SpectrumItem::SpectrumItem(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents, true);
+    m_clock.start();
+}
+
+MediaService *SpectrumItem::source() const
+{
+    return m_source;
+}
+
+void SpectrumItem::setSource(MediaService *source)
+{
+    if (source == m_source) {
+        return;
+    }
+
+    if (m_source) {
+        disconnect(m_source.data(), nullptr, this, nullptr);
+    }
+    m_source = source;
+    if (m_source) {
+        connect(m_source.data(), &MediaService::spectrumChanged, this, &SpectrumItem::updateSpectrum);
+    }
+
+    updateSpectrum();
+    emit sourceChanged();
+}
+
+QColor SpectrumItem::color() const
+{
+    return m_color;
+}
+
+void SpectrumItem::setColor(const QColor &color)
+{
+    if (color == m_color) {
+        return;
+    }
+
+    m_color = color;
+    update();
+    emit colorChanged();
+}
+
+qreal SpectrumItem::spacing() const
+{
+    return m_spacing;
+}
+
+void SpectrumItem::setSpacing(qreal spacing)
+{
+    if (qFuzzyCompare(spacing, m_spacing)) {
+        return;
+    }
+
+    m_spacing = qMax<qreal>(0, spacing);
+    update();
+    emit spacingChanged();
+}
+
+qreal SpectrumItem::decay() const
+{
+    return m_decay;
+}
+
+void SpectrumItem::setDecay(qreal decay)
+{
+    if (qFuzzyCompare(decay, m_decay)) {
+        return;
+    }
+
+    m_decay = qMax<qreal>(0, decay);
+    emit decayChanged();
+}
+
+void SpectrumItem::updateSpectrum()
+{
+    // Implicitly shared, nothing is copied
+    m_target = m_source ? m_source->spectrum() : QVector<double>();
+    if (m_displayed.size() != m_target.size()) {
+        m_displayed.fill(0, m_target.size());
+    }
+    update();
+}
+
+QSGNode *SpectrumItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+
+    const int count = m_target.size();
+    if (count == 0 || width() <= 0 || height() <= 0) {
+        delete oldNode;
+        return nullptr;
+    }
+
+    // The gui thread is blocked meanwhile, the item can be used from here
+    const qint64 now = m_clock.elapsed();
+    const qreal fall = m_decay > 0 ? m_decay * (now - m_lastFrame) / 1000 : -1;
+    m_lastFrame = now;
+
+    QSGGeometryNode *node = rectanglesNode(oldNode, count, m_color);
+    QSGGeometry::Point2D *vertices = node->geometry()->vertexDataAsPoint2D();
+    const QRectF rect = boundingRect();
+    bool falling = false;
+
+    for (int i = 0; i < count; ++i) {
+        falling |= decayTowards(m_displayed[i], m_target.at(i), fall);
+        setRectangle(vertices + i * 6, barRect(rect, i, count, m_spacing, m_displayed.at(i)));
+    }
+
+    if (falling) {
+        // From the render thread: next frame, once the gui thread runs again
+        QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+    }
+    return node;
+}
+
+LevelMeterItem::LevelMeterItem(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents, true);
+    m_clock.start();
+}
+
+MediaService *LevelMeterItem::source() const
+{
+    return m_source;
+}
+
+void LevelMeterItem::setSource(MediaService *source)
+{
+    if (source == m_source) {
+        return;
+    }
+
+    if (m_source) {
+        disconnect(m_source.data(), nullptr, this, nullptr);
+    }
+    m_source = source;
+    if (m_source) {
+        connect(m_source.data(), &MediaService::levelsChanged, this, &LevelMeterItem::updateLevels);
+    }
+
+    updateLevels();
+    emit sourceChanged();
+}
+
+QColor LevelMeterItem::color() const
+{
+    return m_color;
+}
+
+void LevelMeterItem::setColor(const QColor &color)
+{
+    if (color == m_color) {
+        return;
+    }
+
+    m_color = color;
+    update();
+    emit colorChanged();
+}
+
+QColor LevelMeterItem::peakColor() const
+{
+    return m_peakColor;
+}
+
+void LevelMeterItem::setPeakColor(const QColor &color)
+{
+    if (color == m_peakColor) {
+        return;
+    }
+
+    m_peakColor = color;
+    update();
+    emit peakColorChanged();
+}
+
+qreal LevelMeterItem::spacing() const
+{
+    return m_spacing;
+}
+
+void LevelMeterItem::setSpacing(qreal spacing)
+{
+    if (qFuzzyCompare(spacing, m_spacing)) {
+        return;
+    }
+
+    m_spacing = qMax<qreal>(0, spacing);
+    update();
+    emit spacingChanged();
+}
+
+qreal LevelMeterItem::decay() const
+{
+    return m_decay;
+}
+
+void LevelMeterItem::setDecay(qreal decay)
+{
+    if (qFuzzyCompare(decay, m_decay)) {
+        return;
+    }
+
+    m_decay = qMax<qreal>(0, decay);
+    emit decayChanged();
+}
+
+int LevelMeterItem::peakHold() const
+{
+    return m_peakHold;
+}
+
+void LevelMeterItem::setPeakHold(int msecs)
+{
+    if (msecs == m_peakHold) {
+        return;
+    }
+
+    m_peakHold = qMax(0, msecs);
+    emit peakHoldChanged();
+}
+
+void LevelMeterItem::updateLevels()
+{
+    const double peaks[2] = {m_source ? m_source->peakLeft() : 0, m_source ? m_source->peakRight() : 0};
+    m_rms[0] = m_source ? m_source->rmsLeft() : 0;
+    m_rms[1] = m_source ? m_source->rmsRight() : 0;
+
+    const qint64 now = m_clock.elapsed();
+    for (int i = 0; i < 2; ++i) {
+        if (peaks[i] >= m_peak[i]) {
+            m_peak[i] = peaks[i];
+            m_peakTime[i] = now;
+        }
+    }
+    update();
+}
+
+QSGNode *LevelMeterItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+
+    if (width() <= 0 || height() <= 0) {
+        delete oldNode;
+        return nullptr;
+    }
+
+    // The gui thread is blocked meanwhile, the item can be used from here
+    const qint64 now = m_clock.elapsed();
+    const qreal fall = m_decay > 0 ? m_decay * (now - m_lastFrame) / 1000 : -1;
+    m_lastFrame = now;
+
+    QSGNode *root = oldNode;
+    if (!root) {
+        root = new QSGNode;
+    }
+    QSGGeometryNode *bars = rectanglesNode(root->firstChild(), 2, m_color);
+    QSGGeometryNode *peaks = rectanglesNode(root->firstChild() ? root->firstChild()->nextSibling() : nullptr, 2, m_peakColor);
+    if (!root->firstChild()) {
+        root->appendChildNode(bars);
+        root->appendChildNode(peaks);
+    }
+
+    QSGGeometry::Point2D *barVertices = bars->geometry()->vertexDataAsPoint2D();
+    QSGGeometry::Point2D *peakVertices = peaks->geometry()->vertexDataAsPoint2D();
+    const QRectF rect = boundingRect();
+    const qreal markerHeight = qMax<qreal>(2, rect.height() / 50);
+    bool falling = false;
+
+    for (int i = 0; i < 2; ++i) {
+        falling |= decayTowards(m_displayed[i], m_rms[i], fall);
+        setRectangle(barVertices + i * 6, barRect(rect, i, 2, m_spacing, m_displayed[i]));
+
+        if (now - m_peakTime[i] >= m_peakHold) {
+            falling |= decayTowards(m_peak[i], m_displayed[i], fall);
+        } else {
+            falling = true;
+        }
+        QRectF marker = barRect(rect, i, 2, m_spacing, m_peak[i]);
+        marker.setHeight(qMin(markerHeight, rect.bottom() - marker.top()));
+        setRectangle(peakVertices + i * 6, marker);
+    }
+
+    if (falling) {
+        // From the render thread: next frame, once the gui thread runs again
+        QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+    }
+    return root;
+}
+
+#include "moc_meteritems.cpp"
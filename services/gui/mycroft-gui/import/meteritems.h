@@ -0,0 +1,146 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QQuickItem>
+#include <QColor>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QVector>
+
+#include "mediaservice.h"
+
+/**
+ * Bars of the spectrum of a MediaService, drawn by the scene graph as a
+ * single geometry node: no QML item nor binding per band.
+ *
+ * Bars rise at once and fall at most by decay, so they keep moving
+ * smoothly between two spectra.
+ */
+class SpectrumItem : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(MediaService *source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+    // Pixels between two bars
+    Q_PROPERTY(qreal spacing READ spacing WRITE setSpacing NOTIFY spacingChanged)
+    // Fraction of the height bars fall per second, 0 to follow the spectrum exactly
+    Q_PROPERTY(qreal decay READ decay WRITE setDecay NOTIFY decayChanged)
+
+public:
+    explicit SpectrumItem(QQuickItem *parent = nullptr);
+
+    MediaService *source() const;
+    void setSource(MediaService *source);
+
+    QColor color() const;
+    void setColor(const QColor &color);
+
+    qreal spacing() const;
+    void setSpacing(qreal spacing);
+
+    qreal decay() const;
+    void setDecay(qreal decay);
+
+Q_SIGNALS:
+    void sourceChanged();
+    void colorChanged();
+    void spacingChanged();
+    void decayChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+
+private:
+    void updateSpectrum();
+
+    QPointer<MediaService> m_source;
+    QColor m_color = Qt::white;
+    qreal m_spacing = 2;
+    qreal m_decay = 2;
+
+    QVector<double> m_target;
+    QVector<double> m_displayed;
+    QElapsedTimer m_clock;
+    qint64 m_lastFrame = 0;
+};
+
+/**
+ * RMS bars of both channels of a MediaService, with a marker on the
+ * recent peak that holds for peakHold ms then falls like the bars.
+ */
+class LevelMeterItem : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(MediaService *source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+    Q_PROPERTY(QColor peakColor READ peakColor WRITE setPeakColor NOTIFY peakColorChanged)
+    Q_PROPERTY(qreal spacing READ spacing WRITE setSpacing NOTIFY spacingChanged)
+    Q_PROPERTY(qreal decay READ decay WRITE setDecay NOTIFY decayChanged)
+    Q_PROPERTY(int peakHold READ peakHold WRITE setPeakHold NOTIFY peakHoldChanged)
+
+public:
+    explicit LevelMeterItem(QQuickItem *parent = nullptr);
+
+    MediaService *source() const;
+    void setSource(MediaService *source);
+
+    QColor color() const;
+    void setColor(const QColor &color);
+
+    QColor peakColor() const;
+    void setPeakColor(const QColor &color);
+
+    qreal spacing() const;
+    void setSpacing(qreal spacing);
+
+    qreal decay() const;
+    void setDecay(qreal decay);
+
+    int peakHold() const;
+    void setPeakHold(int msecs);
+
+Q_SIGNALS:
+    void sourceChanged();
+    void colorChanged();
+    void peakColorChanged();
+    void spacingChanged();
+    void decayChanged();
+    void peakHoldChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+
+private:
+    void updateLevels();
+
+    QPointer<MediaService> m_source;
+    QColor m_color = Qt::white;
+    QColor m_peakColor = Qt::red;
+    qreal m_spacing = 2;
+    qreal m_decay = 2;
+    int m_peakHold = 1000;
+
+    // Left and right
+    double m_rms[2] = {0, 0};
+    double m_displayed[2] = {0, 0};
+    double m_peak[2] = {0, 0};
+    qint64 m_peakTime[2] = {0, 0};
+    QElapsedTimer m_clock;
+    qint64 m_lastFrame = 0;
+};
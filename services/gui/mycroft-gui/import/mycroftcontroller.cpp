@@ -21,7 +21,13 @@
 #include "abstractdelegate.h"
 #include "activeskillsmodel.h"
 #include "abstractskillview.h"
+#include "buscapture.h"
 #include "controllerconfig.h"
+#include "messagedecoder.h"
+#include "prioritydispatcher.h"
+#include "remotettsplayer.h"
+#include "guimetrics.h"
+#include "startuptracer.h"
 
 #include <QJsonObject>
 #include <QJsonArray>
@@ -34,7 +40,7 @@
 #include <QQmlContext>
 #include <QUuid>
 #include <QWebSocket>
-#include <QMediaPlayer>
+#include <QSet>
 
 MycroftController *MycroftController::instance()
 {
@@ -48,11 +54,21 @@ MycroftController *MycroftController::instance()
 
 MycroftController::MycroftController(QObject *parent)
     : QObject(parent),
-      m_appSettingObj(new GlobalSettings)
+      m_appSettingObj(new GlobalSettings(this)),
+      m_useHivemindProtocol(m_appSettingObj->useHivemindProtocol())
 {
+    // Read on every message sent, don't go through QSettings each time
+    connect(m_appSettingObj, &GlobalSettings::useHivemindProtocolChanged, this, [this]() {
+        m_useHivemindProtocol = m_appSettingObj->useHivemindProtocol();
+        m_cachedRequests.clear();
+    });
+
     connect(&m_mainWebSocket, &QWebSocket::connected, this,
             [this] () {
+                StartupTracer::mark(QStringLiteral("main_socket_connected"));
                 m_reconnectTimer.stop();
+                m_reconnectBackoff.reset();
+                m_reconnectTimer.setInterval(m_reconnectBackoff.next());
                 emit socketStatusChanged();
             });
     connect(&m_mainWebSocket, &QWebSocket::disconnected, this, &MycroftController::closed);
@@ -62,12 +78,13 @@ MycroftController::MycroftController(QObject *parent)
                 if (state == QAbstractSocket::ConnectedState) {
                     qWarning() << "Main Socket connected, trying to connect gui";
                     for (const auto &guiId : m_views.keys()) {
-                        sendRequest(QStringLiteral("mycroft.gui.connected"),
-                                    QVariantMap({{QStringLiteral("gui_id"), guiId}}));
+                        if (!m_sharedConnectionFollowers.contains(guiId)) {
+                            announceGui(guiId);
+                        }
                     }
                     m_reannounceGuiTimer.start();
 
-                    sendRequest(QStringLiteral("mycroft.skills.all_loaded"), QVariantMap());
+                    sendCachedRequest(QStringLiteral("mycroft.skills.all_loaded"), QStringLiteral("mycroft.skills.all_loaded"), QVariantMap());
                 } else {
                     if (m_serverReady) {
                         m_serverReady = false;
@@ -76,10 +93,25 @@ MycroftController::MycroftController(QObject *parent)
                 }
             });
 
-    connect(&m_mainWebSocket, &QWebSocket::textMessageReceived, this, &MycroftController::onMainSocketMessageReceived);
+    BusCapture::attach(&m_mainWebSocket, BusCapture::MainChannel);
+
+    if (m_appSettingObj->threadedDecoding()) {
+        m_decoder = new MessageDecoder(false, this);
+        connect(&m_mainWebSocket, &QWebSocket::textMessageReceived, this, &MycroftController::postMainSocketMessage);
+        connect(m_decoder, &MessageDecoder::messageDecoded, this, [this](const DecodedMessage &decoded) {
+            PriorityDispatcher::instance()->post(PriorityDispatcher::Bulk, this, [this, decoded]() {
+                handleMainMessage(decoded);
+            });
+        });
+    } else {
+        connect(&m_mainWebSocket, &QWebSocket::textMessageReceived, this, &MycroftController::onMainSocketMessageReceived);
+    }
+    connect(&m_mainWebSocket, &QWebSocket::binaryMessageReceived, this, &MycroftController::onMainSocketBinaryMessageReceived);
 
-    m_reconnectTimer.setInterval(1000);
+    // Every failed attempt waits longer before the next one
+    m_reconnectTimer.setInterval(m_reconnectBackoff.next());
     connect(&m_reconnectTimer, &QTimer::timeout, this, [this]() {
+        m_reconnectTimer.setInterval(m_reconnectBackoff.next());
         QString socket = m_appSettingObj->webSocketAddress() + QStringLiteral(":8181/core");
         m_mainWebSocket.open(QUrl(socket));
     });
@@ -90,10 +122,9 @@ MycroftController::MycroftController(QObject *parent)
             return;
         }
         for (const auto &guiId : m_views.keys()) {
-            if (m_views[guiId]->status() != Open) {
+            if (!m_sharedConnectionFollowers.contains(guiId) && m_views[guiId]->status() != Open) {
                 qWarning()<<"Retrying to announce gui";
-                sendRequest(QStringLiteral("mycroft.gui.connected"),
-                            QVariantMap({{QStringLiteral("gui_id"), guiId}}));
+                announceGui(guiId);
             }
         }
     });
@@ -161,7 +192,9 @@ void MycroftController::reconnect()
 {
     qDebug() << "in reconnect";
     m_mainWebSocket.close();
-    m_reconnectTimer.start();
+    // Asked explicitly, don't wait for the delay of the previous failures
+    m_reconnectBackoff.reset();
+    m_reconnectTimer.start(m_reconnectBackoff.next());
     emit socketStatusChanged();
 }
 
@@ -170,38 +203,238 @@ void MycroftController::startPTTClient()
     QProcess::startDetached(QStringLiteral("mycroft-gui-ptt-loader"), QStringList());
 }
 
+bool MycroftController::isNoise(const QString &type)
+{
+    //filter out the noise so we can print debug stuff later without drowning in noise
+    return type.startsWith(QLatin1String("enclosure")) || type.startsWith(QLatin1String("mycroft-date"));
+}
+
+bool MycroftController::isCriticalMessage(const QString &type)
+{
+    // Behind isListening, isSpeaking, powerState, stopped() and notUnderstood()
+    static const QSet<QString> criticalTypes({
+        QStringLiteral("recognizer_loop:wakeword"),
+        QStringLiteral("recognizer_loop:record_begin"),
+        QStringLiteral("recognizer_loop:record_end"),
+        QStringLiteral("recognizer_loop:audio_output_start"),
+        QStringLiteral("recognizer_loop:audio_output_end"),
+        QStringLiteral("mycroft.stop"),
+        QStringLiteral("mycroft.stop.handled"),
+        QStringLiteral("active_skill_request"),
+        QStringLiteral("complete_intent_failure"),
+        QStringLiteral("mycroft.speech.recognition.unknown"),
+        // Changes powerState: never applied after a wakeword that came later
+        QStringLiteral("screen.close.idle.event")
+    });
+
+    return criticalTypes.contains(type);
+}
+
+bool MycroftController::wantsMessage(const QString &type) const
+{
+    // Handled by handleMainMessage itself
+    static const QSet<QString> internalTypes({
+        QStringLiteral("speak"),
+        QStringLiteral("mycroft.mic.listen"),
+        QStringLiteral("remote.tts.audio"),
+        QStringLiteral("active_skill_request"),
+        QStringLiteral("complete_intent_failure"),
+        QStringLiteral("mycroft.speech.recognition.unknown"),
+        QStringLiteral("mycroft.skill.handler.start"),
+        QStringLiteral("mycroft.skill.handler.complete"),
+        QStringLiteral("mycroft.stop.handled"),
+        QStringLiteral("mycroft.stop"),
+        QStringLiteral("mycroft.gui.port"),
+        QStringLiteral("mycroft.skills.all_loaded.response"),
+        QStringLiteral("mycroft.ready"),
+        QStringLiteral("mycroft.gui.metrics"),
+        QStringLiteral("screen.close.idle.event")
+    });
+
+    if (isNoise(type)) {
+        return false;
+    }
+
+    // recognizer_loop:* and the utterances recognized as intents contain ':'
+    return internalTypes.contains(type) || type.contains(QLatin1Char(':'))
+        || m_subscriptions.contains(type) || m_intentTypes.contains(type);
+}
+
+void MycroftController::subscribe(const QStringList &types, QObject *receiver, const MessageCallback &callback)
+{
+    Q_ASSERT(receiver);
+
+    for (const auto &type : types) {
+        m_subscriptions[type].append({receiver, callback});
+    }
+
+    connect(receiver, &QObject::destroyed, this, [this](QObject *receiver) {
+        unsubscribe(receiver);
+    });
+}
+
+void MycroftController::unsubscribe(QObject *receiver)
+{
+    for (auto it = m_subscriptions.begin(); it != m_subscriptions.end();) {
+        QVector<Subscription> &subscriptions = it.value();
+        for (int i = subscriptions.count() - 1; i >= 0; --i) {
+            if (subscriptions[i].receiver == receiver || !subscriptions[i].receiver) {
+                subscriptions.remove(i);
+            }
+        }
+
+        if (subscriptions.isEmpty()) {
+            it = m_subscriptions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MycroftController::declareIntentTypes(const QStringList &types, QObject *receiver)
+{
+    if (!receiver) {
+        qWarning() << "declareIntentTypes needs a receiver for" << types;
+        return;
+    }
+
+    if (!m_intentReceivers.contains(receiver)) {
+        connect(receiver, &QObject::destroyed, this, [this](QObject *receiver) {
+            for (const auto &type : m_intentReceivers.take(receiver)) {
+                auto it = m_intentTypes.find(type);
+                if (it != m_intentTypes.end() && --it.value() <= 0) {
+                    m_intentTypes.erase(it);
+                }
+            }
+        });
+    }
+
+    QStringList &declared = m_intentReceivers[receiver];
+    for (const auto &type : types) {
+        if (!declared.contains(type)) {
+            declared << type;
+            ++m_intentTypes[type];
+        }
+    }
+}
+
 void MycroftController::onMainSocketMessageReceived(const QString &message)
 {
-    auto doc = QJsonDocument::fromJson(message.toUtf8());
+    // Drop what nobody is interested in, before paying for the parsing
+    const QString type = MessageDecoder::peekType(message);
+    if (!type.isNull() && !wantsMessage(type)) {
+        return;
+    }
 
-    if (doc.isEmpty()) {
-        qWarning() << "Empty or invalid JSON message arrived on the main socket:" << message;
+    const PriorityDispatcher::Lane lane = isCriticalMessage(type) ? PriorityDispatcher::Critical : PriorityDispatcher::Bulk;
+    PriorityDispatcher::instance()->post(lane, this, [this, message]() {
+        DecodedMessage decoded;
+        if (MessageDecoder::decode(message.toUtf8(), false, false, decoded)) {
+            handleMainMessage(decoded);
+        }
+    });
+}
+
+void MycroftController::onMainSocketBinaryMessageReceived(const QByteArray &message)
+{
+    if (RemoteTtsPlayer::isStreamFrame(message)) {
+        if (m_appSettingObj->usesRemoteTTS()) {
+            ttsPlayer()->handleStreamFrame(message);
+        }
         return;
     }
 
-    auto type = doc[QStringLiteral("type")].toString();
+    if (m_decoder) {
+        m_decoder->postBinary(message);
+        return;
+    }
+
+    PriorityDispatcher::instance()->post(PriorityDispatcher::Bulk, this, [this, message]() {
+        DecodedMessage decoded;
+        if (MessageDecoder::decode(message, true, false, decoded)) {
+            handleMainMessage(decoded);
+        }
+    });
+}
+
+RemoteTtsPlayer *MycroftController::ttsPlayer()
+{
+    if (!m_ttsPlayer) {
+        m_ttsPlayer = new RemoteTtsPlayer(this);
+    }
+    return m_ttsPlayer;
+}
+
+void MycroftController::postMainSocketMessage(const QString &message)
+{
+    const QString type = MessageDecoder::peekType(message);
+    if (!type.isNull() && !wantsMessage(type)) {
+        return;
+    }
+
+    // Small ones: not worth waiting behind what the worker thread is decoding
+    if (isCriticalMessage(type)) {
+        onMainSocketMessageReceived(message);
+        return;
+    }
+
+    m_decoder->postText(message);
+}
+
+void MycroftController::handleMainMessage(const DecodedMessage &message)
+{
+    const QString &type = message.type;
 
     if (type.isEmpty()) {
         qWarning() << "Empty type in the JSON message on the main socket";
         return;
     }
 
-    //filter out the noise so we can print debug stuff later without drowning in noise
-    if (type.startsWith(QStringLiteral("enclosure")) || type.startsWith(QStringLiteral("mycroft-date"))) {
+    if (!wantsMessage(type)) {
         return;
     }
 
+    QElapsedTimer timer;
+    timer.start();
+    applyMainMessage(message);
+    GuiMetrics::instance()->recordBusMessage(type, message.size, message.decodeTime + timer.nsecsElapsed());
+}
+
+void MycroftController::applyMainMessage(const DecodedMessage &message)
+{
+    const QString &type = message.type;
+
 #ifdef DEBUG_MYCROFT_MESSAGEBUS
     qDebug() << "type" << type;
 #endif
 
-    emit intentRecevied(type, doc[QStringLiteral("data")].toVariant().toMap());
+    const QJsonObject data = message.message.value(QStringLiteral("data")).toObject();
+
+    // Only pay for the variant conversion if somebody is going to use it
+    const QVector<Subscription> subscriptions = m_subscriptions.value(type);
+    const bool legacyConsumers = m_intentTypes.contains(type);
+    QVariantMap variantData;
+    if (message.hasData) {
+        variantData = message.data;
+    } else if (legacyConsumers || !subscriptions.isEmpty() || type == QLatin1String("speak")) {
+        variantData = data.toVariantMap();
+    }
+
+    for (const auto &subscription : subscriptions) {
+        if (subscription.receiver) {
+            subscription.callback(type, variantData);
+        }
+    }
+
+    if (legacyConsumers) {
+        emit intentRecevied(type, variantData);
+    }
 
 #ifdef Q_OS_ANDROID
     if (type == QLatin1String("speak") && m_speech->state() != QTextToSpeech::Speaking) {
-        m_speech->say(doc[QStringLiteral("data")][QStringLiteral("utterance")].toString());
+        m_speech->say(data[QStringLiteral("utterance")].toString());
     } else if (type == QLatin1String("speak") && m_speech->state() == QTextToSpeech::Speaking) {
-        ttsqueue.enqueue(doc[QStringLiteral("data")][QStringLiteral("utterance")].toString());
+        ttsqueue.enqueue(data[QStringLiteral("utterance")].toString());
     }
     
     if (type == QLatin1String("mycroft.mic.listen")) {
@@ -210,26 +443,15 @@ void MycroftController::onMainSocketMessageReceived(const QString &message)
 #endif
 
     if (type == QLatin1String("remote.tts.audio") && m_appSettingObj->usesRemoteTTS()) {
-        QString aud = doc[QStringLiteral("data")][QStringLiteral("wave")].toString();
-        auto innerdoc = QJsonDocument::fromJson(aud.toUtf8());
-        QJsonValue qjv = innerdoc[QStringLiteral("py/b64")];
-        QString aud_values = qjv.toString();
-        QByteArray audioopt;
-        audioopt.append(qUtf8Printable(aud_values));
-        QByteArray aud_array = QByteArray::fromBase64(audioopt, QByteArray::Base64UrlEncoding);
-        QByteArray ret_aud = QByteArray::fromBase64(aud_array);
-        QFile file(QStringLiteral("/tmp/incoming.wav"));
-        file.open(QIODevice::WriteOnly);
-        file.write(ret_aud);
-        file.close();
-        QMediaPlayer *player = new QMediaPlayer;
-        player->setMedia(QUrl::fromLocalFile(QStringLiteral("/tmp/incoming.wav")));
-        player->play();
+        // The wave is a jsonpickled, twice base64 encoded WAV file
+        const QJsonDocument innerdoc = QJsonDocument::fromJson(data[QStringLiteral("wave")].toString().toUtf8());
+        const QByteArray encoded = innerdoc[QStringLiteral("py/b64")].toString().toLatin1();
+        ttsPlayer()->playWav(QByteArray::fromBase64(QByteArray::fromBase64(encoded, QByteArray::Base64UrlEncoding)));
     }
 
     // Try catching intent_failure from another method because of issue: https://github.com/MycroftAI/mycroft-core/issues/2490
     if (type == QLatin1String("active_skill_request")) {         
-        QString skill_id = doc[QStringLiteral("data")][QStringLiteral("skill_id")].toString();
+        QString skill_id = data[QStringLiteral("skill_id")].toString();
         if (skill_id == QStringLiteral("fallback-unknown.mycroftai")) {
             m_isListening = false;
             emit isListeningChanged();
@@ -244,6 +466,7 @@ void MycroftController::onMainSocketMessageReceived(const QString &message)
         emit notUnderstood();
     }
     if (type == QLatin1String("recognizer_loop:audio_output_start")) {
+        setPowerState(Active);
         m_isSpeaking = true;
         emit isSpeakingChanged();
         return;
@@ -254,11 +477,13 @@ void MycroftController::onMainSocketMessageReceived(const QString &message)
         return;
     }
     if (type == QLatin1String("recognizer_loop:wakeword")) {
+        setPowerState(Active);
         m_isListening = true;
         emit isListeningChanged();
         return;
     }
     if (type == QLatin1String("recognizer_loop:record_begin") && !m_isListening) {
+        setPowerState(Active);
         m_isListening = true;
         emit isListeningChanged();
         return;
@@ -274,20 +499,20 @@ void MycroftController::onMainSocketMessageReceived(const QString &message)
     }
 
     if (type == QLatin1String("mycroft.skill.handler.start")) {
-        m_currentSkill = doc[QStringLiteral("data")][QStringLiteral("name")].toString();
+        m_currentSkill = data[QStringLiteral("name")].toString();
         qDebug() << "Current intent:" << m_currentIntent;
         emit currentIntentChanged();
     } else if (type == QLatin1String("mycroft.skill.handler.complete")) {
         m_currentSkill = QString();
         emit currentSkillChanged();
     } else if (type == QLatin1String("speak")) {
-        emit fallbackTextRecieved(m_currentSkill, doc[QStringLiteral("data")].toVariant().toMap());
+        emit fallbackTextRecieved(m_currentSkill, variantData);
     } else if (type == QLatin1String("mycroft.stop.handled") || type == QLatin1String("mycroft.stop")) {
         emit stopped();
 
     } else if (type == QLatin1String("mycroft.gui.port")) {
-        const int port = doc[QStringLiteral("data")][QStringLiteral("port")].toInt();
-        const QString guiId = doc[QStringLiteral("data")][QStringLiteral("gui_id")].toString();
+        const int port = data[QStringLiteral("port")].toInt();
+        const QString guiId = data[QStringLiteral("gui_id")].toString();
         if (port < 0 || port > 65535) {
             qWarning() << "Invalid port from mycroft.gui.port";
             return;
@@ -300,25 +525,32 @@ void MycroftController::onMainSocketMessageReceived(const QString &message)
         }
 
         QUrl url(QStringLiteral("%1:%2/gui").arg(m_appSettingObj->webSocketAddress()).arg(port));
+        // Servers not knowing about frame formats keep getting plain JSON text frames
+        m_views[guiId]->setFrameFormat(data[QStringLiteral("frame_format")].toString());
         m_views[guiId]->setUrl(url);
         m_reannounceGuiTimer.stop();
     } else if (type == QLatin1String("mycroft.skills.all_loaded.response")) {
-        if (doc[QStringLiteral("data")][QStringLiteral("status")].toBool() == true) {
+        if (data[QStringLiteral("status")].toBool() == true) {
+            StartupTracer::mark(QStringLiteral("server_ready"));
             m_serverReady = true;
             emit serverReadyChanged();
         }
     } else if (type == QLatin1String("mycroft.ready")) {
+        StartupTracer::mark(QStringLiteral("server_ready"));
         m_serverReady = true;
         emit serverReadyChanged();
+    } else if (type == QLatin1String("mycroft.gui.metrics")) {
+        sendRequest(QStringLiteral("mycroft.gui.metrics.response"), GuiMetrics::instance()->snapshot());
     }
     
     if (type == QLatin1String("screen.close.idle.event")) {
-        QString skill_idle_event_id = doc[QStringLiteral("data")][QStringLiteral("skill_idle_event_id")].toString();
+        QString skill_idle_event_id = data[QStringLiteral("skill_idle_event_id")].toString();
         emit skillTimeoutReceived(skill_idle_event_id);
+        setPowerState(Idle);
     }
 
     // Check if it's an utterance recognized as an intent
-    if (type.contains(QLatin1Char(':')) && !doc[QStringLiteral("data")][QStringLiteral("utterance")].toString().isEmpty()) {
+    if (type.contains(QLatin1Char(':')) && !data[QStringLiteral("utterance")].toString().isEmpty()) {
         const QString skill = type.split(QLatin1Char(':')).first();
         if (skill.contains(QLatin1Char('.'))) {
             m_currentSkill = skill;
@@ -329,23 +561,46 @@ void MycroftController::onMainSocketMessageReceived(const QString &message)
     }
 }
 
+QString MycroftController::serializeRequest(const QString &type, const QVariantMap &data, const QVariantMap &context) const
+{
+    QJsonObject root;
+
+    root[QStringLiteral("type")] = type;
+    root[QStringLiteral("data")] = QJsonObject::fromVariantMap(data);
+
+    if (m_useHivemindProtocol) {
+        root[QStringLiteral("context")] = QJsonObject::fromVariantMap(context);
+    }
+
+    return QString::fromUtf8(QJsonDocument(root).toJson(QJsonDocument::Compact));
+}
+
 void MycroftController::sendRequest(const QString &type, const QVariantMap &data, const QVariantMap &context)
 {
     if (m_mainWebSocket.state() != QAbstractSocket::ConnectedState) {
         qWarning() << "mycroft connection not open!";
         return;
     }
-    QJsonObject root;
 
-    root[QStringLiteral("type")] = type;
-    root[QStringLiteral("data")] = QJsonObject::fromVariantMap(data);
+    const QString message = serializeRequest(type, data, context);
+    BusCapture::recordOutbound(BusCapture::MainChannel, message);
+    m_mainWebSocket.sendTextMessage(message);
+}
 
-    if(m_appSettingObj->useHivemindProtocol()){
-        root[QStringLiteral("context")] = QJsonObject::fromVariantMap(context);
+void MycroftController::sendCachedRequest(const QString &key, const QString &type, const QVariantMap &data)
+{
+    if (m_mainWebSocket.state() != QAbstractSocket::ConnectedState) {
+        qWarning() << "mycroft connection not open!";
+        return;
     }
 
-    QJsonDocument doc(root);
-    m_mainWebSocket.sendTextMessage(QString::fromUtf8(doc.toJson()));
+    auto it = m_cachedRequests.find(key);
+    if (it == m_cachedRequests.end()) {
+        it = m_cachedRequests.insert(key, serializeRequest(type, data, QVariantMap()));
+    }
+
+    BusCapture::recordOutbound(BusCapture::MainChannel, *it);
+    m_mainWebSocket.sendTextMessage(*it);
 }
 
 void MycroftController::sendBinary(const QString &type, const QJsonObject &data, const QVariantMap &context)
@@ -358,19 +613,30 @@ void MycroftController::sendBinary(const QString &type, const QJsonObject &data,
     socketObject[QStringLiteral("type")] = type;
     socketObject[QStringLiteral("data")] = data;
 
-    if(m_appSettingObj->useHivemindProtocol()){
+    if (m_useHivemindProtocol) {
         socketObject[QStringLiteral("context")] = QJsonObject::fromVariantMap(context);
     }
 
     QJsonDocument doc;
     doc.setObject(socketObject);
     QByteArray docbin = doc.toJson(QJsonDocument::Compact);
+    BusCapture::recordOutbound(BusCapture::MainChannel, docbin);
     m_mainWebSocket.sendBinaryMessage(docbin);
 }
 
+void MycroftController::sendBinaryFrame(const QByteArray &frame)
+{
+    if (m_mainWebSocket.state() != QAbstractSocket::ConnectedState) {
+        qWarning() << "mycroft connection not open!";
+        return;
+    }
+    BusCapture::recordOutbound(BusCapture::MainChannel, frame);
+    m_mainWebSocket.sendBinaryMessage(frame);
+}
+
 void MycroftController::sendText(const QString &message)
 {
-    if(!m_appSettingObj->useHivemindProtocol()){
+    if (!m_useHivemindProtocol) {
         sendRequest(QStringLiteral("recognizer_loop:utterance"), QVariantMap({{QStringLiteral("utterances"), QStringList({message})}}), QVariantMap({{QStringLiteral("source"), QStringLiteral("debug_cli")}, {QStringLiteral("destination"), QStringLiteral("skills")}}));
     } else {
         sendRequest(QStringLiteral("recognizer_loop:utterance"), QVariantMap({{QStringLiteral("utterances"), QStringList({message})}}), QVariantMap({{QStringLiteral("source"), QStringLiteral("mycroft-gui")}, {QStringLiteral("destination"), QStringLiteral("skills")}}));
@@ -381,14 +647,91 @@ void MycroftController::registerView(AbstractSkillView *view)
 {
     Q_ASSERT(!view->id().isEmpty());
     Q_ASSERT(!m_views.contains(view->id()));
-    m_views[view->id()] = view;
-//TODO: manage view destruction
+    const QString guiId = view->id();
+    m_views[guiId] = view;
+    connect(view, &QObject::destroyed, this, [this, guiId]() {
+        unregisterView(guiId);
+    });
+
+    if (m_appSettingObj->sharedGuiConnection()) {
+        AbstractSkillView *owner = m_views.value(m_sharedConnectionOwner);
+        if (owner) {
+            // Fed from the connection of owner, never announced
+            m_sharedConnectionFollowers.insert(guiId);
+            view->setSharedConnection(owner);
+            return;
+        }
+        m_sharedConnectionOwner = guiId;
+        view->setSharedConnection(nullptr);
+    }
+
+    if (m_mainWebSocket.state() == QAbstractSocket::ConnectedState) {
+        announceGui(guiId);
+    }
+}
+
+void MycroftController::unregisterView(const QString &guiId)
+{
+    m_views.remove(guiId);
+    m_sharedConnectionFollowers.remove(guiId);
+
+    if (guiId != m_sharedConnectionOwner) {
+        return;
+    }
+
+    m_sharedConnectionOwner.clear();
+    if (m_sharedConnectionFollowers.isEmpty()) {
+        return;
+    }
+
+    // One of the followers takes the connection over
+    m_sharedConnectionOwner = *m_sharedConnectionFollowers.begin();
+    m_sharedConnectionFollowers.remove(m_sharedConnectionOwner);
+    AbstractSkillView *owner = m_views.value(m_sharedConnectionOwner);
+    owner->setSharedConnection(nullptr);
+    for (const auto &follower : m_sharedConnectionFollowers) {
+        m_views[follower]->setSharedConnection(owner);
+    }
+
     if (m_mainWebSocket.state() == QAbstractSocket::ConnectedState) {
-        sendRequest(QStringLiteral("mycroft.gui.connected"),
-                    QVariantMap({{QStringLiteral("gui_id"), view->id()}}));
+        announceGui(m_sharedConnectionOwner);
+        m_reannounceGuiTimer.start();
+    }
+}
+
+void MycroftController::routeGuiMessage(const DecodedMessage &message)
+{
+    // Messages for a single gui carry its id, everything else is shared state
+    const QString guiId = message.message.value(QStringLiteral("gui_id")).toString();
+    if (!guiId.isEmpty()) {
+        AbstractSkillView *view = m_views.value(guiId);
+        if (view) {
+            view->handleDecodedGuiMessage(message);
+        }
+        return;
+    }
+
+    if (m_views.contains(m_sharedConnectionOwner)) {
+        m_views[m_sharedConnectionOwner]->handleDecodedGuiMessage(message);
+    }
+    for (const auto &follower : m_sharedConnectionFollowers) {
+        m_views[follower]->handleDecodedGuiMessage(message);
     }
 }
 
+void MycroftController::announceGui(const QString &guiId)
+{
+    // Sent again every 10 seconds until the gui is connected
+    sendCachedRequest(QStringLiteral("mycroft.gui.connected ") + guiId, QStringLiteral("mycroft.gui.connected"),
+                      QVariantMap({{QStringLiteral("gui_id"), guiId},
+                                   {QStringLiteral("frame_formats"), AbstractSkillView::supportedFrameFormats()}}));
+}
+
+GlobalSettings *MycroftController::settings() const
+{
+    return m_appSettingObj;
+}
+
 MycroftController::Status MycroftController::status() const
 {
     if (m_reconnectTimer.isActive()) {
@@ -423,6 +766,23 @@ QString MycroftController::currentIntent() const
     return m_currentIntent;
 }
 
+MycroftController::PowerState MycroftController::powerState() const
+{
+    return m_powerState;
+}
+
+void MycroftController::setPowerState(PowerState state)
+{
+    if (m_powerState == state) {
+        return;
+    }
+
+    m_powerState = state;
+    // Nothing is shown while idle, pages of a gui not announced yet can wait longer
+    m_reannounceGuiTimer.setInterval(state == Idle ? 60000 : 10000);
+    emit powerStateChanged();
+}
+
 bool MycroftController::isSpeaking() const
 {
     return m_isSpeaking;
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include "reconnectbackoff.h"
+
 #include <QObject>
 #include <QWebSocket>
 #include <QPointer>
@@ -28,12 +30,18 @@
 #include <QQueue>
 #endif
 
+#include <QSet>
 #include <QTimer>
 
+#include <functional>
+
 class GlobalSettings;
 class QQmlPropertyMap;
 class ActiveSkillsModel;
 class AbstractSkillView;
+class MessageDecoder;
+class RemoteTtsPlayer;
+struct DecodedMessage;
 
 class MycroftController : public QObject
 {
@@ -48,7 +56,15 @@ class MycroftController : public QObject
 
     Q_PROPERTY(bool serverReady READ serverReady NOTIFY serverReadyChanged)
 
+    /**
+     * Idle after a screen.close.idle.event: views, MediaService and AudioRec
+     * stop the work nobody sees. Back to Active on the wakeword, on speech
+     * or when a skill shows a page; QML can set it too, on touch.
+     */
+    Q_PROPERTY(PowerState powerState READ powerState WRITE setPowerState NOTIFY powerStateChanged)
+
     Q_ENUMS(Status)
+    Q_ENUMS(PowerState)
 public:
     enum Status {
         Connecting,
@@ -57,6 +73,10 @@ public:
         Closed,
         Error
     };
+    enum PowerState {
+        Active,
+        Idle
+    };
     static MycroftController* instance();
 
     bool isSpeaking() const;
@@ -65,9 +85,34 @@ public:
     Status status() const;
     QString currentSkill() const;
     QString currentIntent() const;
+    PowerState powerState() const;
+    void setPowerState(PowerState state);
 
     //Public API NOT to be used with QML
     void registerView(AbstractSkillView *view);
+    /**
+     * With the shared gui connection, delivers a message received by the
+     * view owning it to the views it's meant for, decoded only once
+     */
+    void routeGuiMessage(const DecodedMessage &message);
+    GlobalSettings *settings() const;
+
+    typedef std::function<void(const QString &type, const QVariantMap &data)> MessageCallback;
+
+    /**
+     * Calls callback for every message of the main bus whose type is in types,
+     * until receiver gets destroyed or unsubscribe() is called.
+     * Messages of which no subscriber nor the controller itself is interested
+     * get dropped without even being parsed.
+     */
+    void subscribe(const QStringList &types, QObject *receiver, const MessageCallback &callback);
+    void unsubscribe(QObject *receiver);
+
+    /**
+     * The QML side of subscribe(): intentRecevied is only emitted for the
+     * types declared here, until receiver gets destroyed.
+     */
+    Q_INVOKABLE void declareIntentTypes(const QStringList &types, QObject *receiver);
 
 Q_SIGNALS:
     //socket stuff
@@ -83,8 +128,10 @@ Q_SIGNALS:
     void currentIntentChanged();
     void serverReadyChanged();
     void speechRequestedChanged(bool expectingResponse);
+    void powerStateChanged();
 
-    //signal with nearly all data
+    //signal with the messages of the types passed to declareIntentTypes(), only emitted when connected
+    //prefer subscribe() from C++
     //TODO: remove?
     void intentRecevied(const QString &type, const QVariantMap &data);
 
@@ -101,25 +148,60 @@ public Q_SLOTS:
     void reconnect();
     void sendRequest(const QString &type, const QVariantMap &data, const QVariantMap &context = QVariantMap({}));
     void sendBinary(const QString &type, const QJsonObject &data, const QVariantMap &context = QVariantMap({}));
+    //sends an already framed binary message as is
+    void sendBinaryFrame(const QByteArray &frame);
     void sendText(const QString &message);
     void startPTTClient();
 
 private:
     explicit MycroftController(QObject *parent = nullptr);
+    struct Subscription {
+        QPointer<QObject> receiver;
+        MessageCallback callback;
+    };
+
+    static bool isNoise(const QString &type);
+    /**
+     * State transitions applied on arrival, ahead of the bulk work of PriorityDispatcher
+     */
+    static bool isCriticalMessage(const QString &type);
+    bool wantsMessage(const QString &type) const;
     void onMainSocketMessageReceived(const QString &message);
+    void postMainSocketMessage(const QString &message);
+    void onMainSocketBinaryMessageReceived(const QByteArray &message);
+    RemoteTtsPlayer *ttsPlayer();
+    void handleMainMessage(const DecodedMessage &message);
+    void applyMainMessage(const DecodedMessage &message);
+    void unregisterView(const QString &guiId);
+    void announceGui(const QString &guiId);
+    QString serializeRequest(const QString &type, const QVariantMap &data, const QVariantMap &context) const;
+    // For messages that never change: serialized once, with key
+    void sendCachedRequest(const QString &key, const QString &type, const QVariantMap &data);
 
     QWebSocket m_mainWebSocket;
 
     QTimer m_reconnectTimer;
+    ReconnectBackoff m_reconnectBackoff;
     QTimer m_reannounceGuiTimer;
 
     GlobalSettings *m_appSettingObj;
+    bool m_useHivemindProtocol;
+    QHash<QString, QString> m_cachedRequests;
+    MessageDecoder *m_decoder = nullptr;
+    RemoteTtsPlayer *m_ttsPlayer = nullptr;
 
     //TODO: remove
     QString m_currentSkill;
     QString m_currentIntent;
 
     QHash<QString, AbstractSkillView *> m_views;
+    // GlobalSettings::sharedGuiConnection: the view holding the socket and the others
+    QString m_sharedConnectionOwner;
+    QSet<QString> m_sharedConnectionFollowers;
+    QHash<QString, QVector<Subscription>> m_subscriptions;
+    // Receivers of intentRecevied per declared type
+    QHash<QString, int> m_intentTypes;
+    QHash<QObject *, QStringList> m_intentReceivers;
 
     QHash<QString, QQmlPropertyMap*> m_skillData;
 
@@ -133,5 +215,6 @@ private:
     bool m_isListening = false;
     bool m_mycroftLaunched = false;
     bool m_serverReady = false;
+    PowerState m_powerState = Active;
 };
 
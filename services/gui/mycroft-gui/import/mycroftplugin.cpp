@@ -21,7 +21,11 @@
 
 #include "mycroftcontroller.h"
 #include "globalsettings.h"
+#include "guimetrics.h"
 #include "filereader.h"
+#include "imagecache.h"
+#include "networkcache.h"
+#include "remoteskillassets.h"
 #include "abstractdelegate.h"
 #include "abstractskillview.h"
 #include "activeskillsmodel.h"
@@ -29,6 +33,10 @@
 #include "sessiondatamap.h"
 #include "audiorec.h"
 #include "mediaservice.h"
+#include "meteritems.h"
+#ifdef MYCROFT_NATIVE_LOTTIE
+#include "nativelottieanimation.h"
+#endif
 
 #include <QQmlEngine>
 #include <QQmlContext>
@@ -44,10 +52,11 @@ static QObject *fileReaderSingletonProvider(QQmlEngine *engine, QJSEngine *scrip
 
 static QObject *globalSettingsSingletonProvider(QQmlEngine *engine, QJSEngine *scriptEngine)
 {
-    Q_UNUSED(engine)
-    Q_UNUSED(scriptEngine)
+    Q_UNUSED(scriptEngine);
 
-    return new GlobalSettings;
+    //the same instance as the controller, so it sees the changes done from qml
+    engine->setObjectOwnership(MycroftController::instance()->settings(), QQmlEngine::CppOwnership);
+    return MycroftController::instance()->settings();
 }
 
 static QObject *mycroftControllerSingletonProvider(QQmlEngine *engine, QJSEngine *scriptEngine)
@@ -59,6 +68,15 @@ static QObject *mycroftControllerSingletonProvider(QQmlEngine *engine, QJSEngine
     return MycroftController::instance();
 }
 
+static QObject *guiMetricsSingletonProvider(QQmlEngine *engine, QJSEngine *scriptEngine)
+{
+    Q_UNUSED(scriptEngine);
+
+    //singleton managed internally, qml should never delete it
+    engine->setObjectOwnership(GuiMetrics::instance(), QQmlEngine::CppOwnership);
+    return GuiMetrics::instance();
+}
+
 static QObject *audioRecSingletonProvider(QQmlEngine *engine, QJSEngine *scriptEngine)
 {
     Q_UNUSED(engine)
@@ -82,12 +100,19 @@ void MycroftPlugin::registerTypes(const char *uri)
     qmlRegisterSingletonType<MycroftController>(uri, 1, 0, "MycroftController", mycroftControllerSingletonProvider);
     qmlRegisterSingletonType<GlobalSettings>(uri, 1, 0, "GlobalSettings", globalSettingsSingletonProvider);
     qmlRegisterSingletonType<FileReader>(uri, 1, 0, "FileReader", fileReaderSingletonProvider);
+    qmlRegisterSingletonType<GuiMetrics>(uri, 1, 0, "GuiMetrics", guiMetricsSingletonProvider);
     qmlRegisterSingletonType<AudioRec>(uri, 1, 0, "AudioRec", audioRecSingletonProvider);
     qmlRegisterSingletonType<MediaService>(uri, 1, 0, "MediaService", mediaServiceSingletonProvider);
     qmlRegisterSingletonType(QUrl(QStringLiteral("qrc:/qml/Units.qml")), uri, 1, 0, "Units");
     qmlRegisterSingletonType(QUrl(QStringLiteral("qrc:/qml/SoundEffects.qml")), uri, 1, 0, "SoundEffects");
     qmlRegisterType<AbstractSkillView>(uri, 1, 0, "AbstractSkillView");
     qmlRegisterType<AbstractDelegate>(uri, 1, 0, "AbstractDelegate");
+    qmlRegisterType<SpectrumItem>(uri, 1, 0, "SpectrumItem");
+    qmlRegisterType<LevelMeterItem>(uri, 1, 0, "LevelMeterItem");
+#ifdef MYCROFT_NATIVE_LOTTIE
+    // Picked up by LottieAnimation of org.kde.lottie when available
+    qmlRegisterType<NativeLottieAnimation>(uri, 1, 0, "NativeLottieAnimation");
+#endif
     qmlRegisterType(QUrl(QStringLiteral("qrc:/qml/AudioPlayer.qml")), uri, 1, 0, "AudioPlayer");
     qmlRegisterType(QUrl(QStringLiteral("qrc:/qml/AutoFitLabel.qml")), uri, 1, 0, "AutoFitLabel");
     qmlRegisterType(QUrl(QStringLiteral("qrc:/qml/Delegate.qml")), uri, 1, 0, "Delegate");
@@ -111,5 +136,37 @@ void MycroftPlugin::registerTypes(const char *uri)
    // qmlProtectModule(uri, 1);
 }
 
+void MycroftPlugin::initializeEngine(QQmlEngine *engine, const char *uri)
+{
+    Q_UNUSED(uri)
+
+    GlobalSettings *settings = MycroftController::instance()->settings();
+    auto updateImageBudget = [settings]() {
+        ImageCache::instance()->setBudget(qint64(settings->imageCacheSize()) * 1024 * 1024);
+    };
+    auto updatePrefetch = [settings]() {
+        RemoteSkillAssets::instance()->setPrefetch(settings->prefetchRemoteSkills());
+    };
+
+    // The caches are shared by every engine of the process, follow the settings only once
+    static bool s_settingsConnected = false;
+    if (!s_settingsConnected) {
+        updateImageBudget();
+        updatePrefetch();
+        NetworkCache::instance()->setMaximumCacheSize(qint64(settings->networkCacheSize()) * 1024 * 1024);
+        connect(settings, &GlobalSettings::imageCacheSizeChanged, this, updateImageBudget);
+        connect(settings, &GlobalSettings::prefetchRemoteSkillsChanged, this, updatePrefetch);
+        s_settingsConnected = true;
+    }
+
+    // Remote skill QML and assets; applications can install their own factory first
+    if (!engine->networkAccessManagerFactory()) {
+        engine->setNetworkAccessManagerFactory(NetworkCache::instance());
+    }
+
+    // image://mycroft/<percent encoded url>
+    engine->addImageProvider(QStringLiteral("mycroft"), new SkillImageProvider);
+}
+
 #include "moc_mycroftplugin.cpp"
 
@@ -0,0 +1,565 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nativelottieanimation.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QJSValue>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QQmlFile>
+#include <QQuickWindow>
+#include <QSGSimpleTextureNode>
+
+#include <rlottie.h>
+
+// Values of Image.status
+enum {
+    StatusNull = 0,
+    StatusReady = 1,
+    StatusLoading = 2,
+    StatusError = 3
+};
+
+// Values of Image.fillMode
+enum {
+    Stretch = 0,
+    PreserveAspectFit = 1,
+    PreserveAspectCrop = 2,
+    Pad = 6
+};
+
+namespace {
+
+/**
+ * Owns the textures of the rasterized frames, on the render thread
+ */
+class LottieNode : public QSGSimpleTextureNode
+{
+public:
+    ~LottieNode() override
+    {
+        clearFrames();
+    }
+
+    void clearFrames()
+    {
+        qDeleteAll(frames);
+        frames.clear();
+        delete scratch;
+        scratch = nullptr;
+        bytes = 0;
+    }
+
+    QHash<int, QSGTexture *> frames;
+    // Last frame rasterized when the cache is full
+    QSGTexture *scratch = nullptr;
+    qint64 bytes = 0;
+    int generation = -1;
+    QSize size;
+};
+
+}
+
+NativeLottieAnimation::NativeLottieAnimation(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents);
+
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_frameTimer, &QTimer::timeout, this, &NativeLottieAnimation::advance);
+}
+
+NativeLottieAnimation::~NativeLottieAnimation()
+{
+    if (m_reply) {
+        m_reply->disconnect(this);
+        m_reply->abort();
+        m_reply->deleteLater();
+    }
+}
+
+QVariant NativeLottieAnimation::source() const
+{
+    return m_source;
+}
+
+void NativeLottieAnimation::setSource(const QVariant &source)
+{
+    if (m_source == source) {
+        return;
+    }
+
+    m_source = source;
+    emit sourceChanged();
+
+    if (m_reply) {
+        m_reply->disconnect(this);
+        m_reply->abort();
+        m_reply->deleteLater();
+    }
+    m_animation.reset();
+    ++m_generation;
+    update();
+
+    QVariant value = source;
+    if (value.userType() == qMetaTypeId<QJSValue>()) {
+        value = value.value<QJSValue>().toVariant();
+    }
+
+    // Already parsed by JavaScript
+    if (value.type() == QVariant::Map) {
+        load(QJsonDocument::fromVariant(value).toJson(QJsonDocument::Compact), QString());
+        return;
+    }
+
+    QUrl url;
+    if (value.type() == QVariant::Url) {
+        url = value.toUrl();
+    } else {
+        const QString string = value.toString().trimmed();
+        if (string.startsWith(QLatin1Char('{'))) {
+            load(string.toUtf8(), QString());
+            return;
+        }
+        url = string.startsWith(QLatin1Char('/')) ? QUrl::fromLocalFile(string) : QUrl(string);
+    }
+
+    if (url.isEmpty()) {
+        setStatus(StatusNull);
+        return;
+    }
+
+    QQmlContext *context = qmlContext(this);
+    if (context) {
+        url = context->resolvedUrl(url);
+    }
+
+    // The url is the key of the animations parsed by rlottie, shared by all the items
+    const QString localFile = QQmlFile::urlToLocalFileOrQrc(url);
+    if (!localFile.isEmpty()) {
+        QFile file(localFile);
+        if (!file.open(QIODevice::ReadOnly)) {
+            setStatus(StatusError, file.errorString());
+            return;
+        }
+        load(file.readAll(), url.toString());
+        return;
+    }
+
+    QQmlEngine *engine = qmlEngine(this);
+    if (!engine) {
+        setStatus(StatusError, QStringLiteral("Can't download %1 without a QML engine").arg(url.toString()));
+        return;
+    }
+
+    setStatus(StatusLoading);
+    QNetworkReply *reply = engine->networkAccessManager()->get(QNetworkRequest(url));
+    m_reply = reply;
+    connect(reply, &QNetworkReply::finished, this, [this, reply, url]() {
+        reply->deleteLater();
+        if (reply->error() != QNetworkReply::NoError) {
+            setStatus(StatusError, reply->errorString());
+            return;
+        }
+        load(reply->readAll(), url.toString());
+    });
+}
+
+void NativeLottieAnimation::load(const QByteArray &json, const QString &cacheKey)
+{
+    m_animation = rlottie::Animation::loadFromData(std::string(json.constData(), json.size()),
+                                                   cacheKey.toStdString(), std::string(), !cacheKey.isEmpty());
+    if (!m_animation) {
+        setStatus(StatusError, QStringLiteral("Invalid Lottie animation"));
+        return;
+    }
+
+    size_t width = 0;
+    size_t height = 0;
+    m_animation->size(width, height);
+    m_nativeSize = QSize(int(width), int(height));
+    m_frameRate = m_animation->frameRate();
+
+    if (m_nativeSize.isEmpty() || totalFrames() <= 0 || m_frameRate <= 0) {
+        m_animation.reset();
+        setStatus(StatusError, QStringLiteral("Animation data does not contain valid size information"));
+        return;
+    }
+
+    setImplicitSize(width, height);
+    ++m_generation;
+    m_played = 0;
+    m_currentLoop = 0;
+    m_frame = frameAt(0);
+    setStatus(StatusReady);
+
+    if (m_running) {
+        start();
+    }
+    update();
+}
+
+int NativeLottieAnimation::status() const
+{
+    return m_status;
+}
+
+QString NativeLottieAnimation::errorString() const
+{
+    return m_errorString;
+}
+
+void NativeLottieAnimation::setStatus(int status, const QString &errorString)
+{
+    if (status == StatusError) {
+        qWarning() << "Could not load Lottie animation" << m_source << errorString;
+    }
+
+    if (m_status == status && m_errorString == errorString) {
+        return;
+    }
+
+    m_status = status;
+    m_errorString = errorString;
+    emit statusChanged();
+}
+
+bool NativeLottieAnimation::isRunning() const
+{
+    return m_running;
+}
+
+void NativeLottieAnimation::setRunning(bool running)
+{
+    if (running) {
+        start();
+    } else {
+        pause();
+    }
+}
+
+int NativeLottieAnimation::loops() const
+{
+    return m_loops;
+}
+
+void NativeLottieAnimation::setLoops(int loops)
+{
+    if (m_loops == loops) {
+        return;
+    }
+
+    m_loops = loops;
+    emit loopsChanged();
+}
+
+qreal NativeLottieAnimation::speed() const
+{
+    return m_speed;
+}
+
+void NativeLottieAnimation::setSpeed(qreal speed)
+{
+    if (qFuzzyCompare(m_speed, speed)) {
+        return;
+    }
+
+    // What was played so far counts at the old speed
+    if (m_frameTimer.isActive()) {
+        m_played = playedFrames();
+        m_clock.start();
+    }
+
+    m_speed = speed;
+    if (m_frameTimer.isActive()) {
+        start();
+    }
+    emit speedChanged();
+}
+
+bool NativeLottieAnimation::reverse() const
+{
+    return m_reverse;
+}
+
+void NativeLottieAnimation::setReverse(bool reverse)
+{
+    if (m_reverse == reverse) {
+        return;
+    }
+
+    m_reverse = reverse;
+    m_frame = frameAt(playedFrames());
+    update();
+    emit reverseChanged();
+}
+
+int NativeLottieAnimation::fillMode() const
+{
+    return m_fillMode;
+}
+
+void NativeLottieAnimation::setFillMode(int fillMode)
+{
+    if (m_fillMode == fillMode) {
+        return;
+    }
+
+    m_fillMode = fillMode;
+    update();
+    emit fillModeChanged();
+}
+
+int NativeLottieAnimation::cacheBudget() const
+{
+    return m_cacheBudget;
+}
+
+void NativeLottieAnimation::setCacheBudget(int budget)
+{
+    if (m_cacheBudget == budget) {
+        return;
+    }
+
+    m_cacheBudget = budget;
+    ++m_generation;
+    update();
+    emit cacheBudgetChanged();
+}
+
+void NativeLottieAnimation::start()
+{
+    if (!m_running) {
+        m_running = true;
+        emit runningChanged();
+    }
+
+    // Starts playing once loaded
+    if (!m_animation) {
+        return;
+    }
+
+    if (m_frameTimer.isActive()) {
+        m_played = playedFrames();
+    } else if (m_loops >= 0 && m_played >= qMax(1, m_loops) * totalFrames() - 1) {
+        // Finished: play again from the start
+        m_played = 0;
+        m_currentLoop = 0;
+    }
+
+    m_cleared = false;
+    m_clock.start();
+    // A tick per frame of the animation, within what a display can show
+    const qreal frameInterval = m_speed > 0 ? 1000 / (m_frameRate * m_speed) : 100;
+    m_frameTimer.start(int(qBound<qreal>(8, frameInterval, 100)));
+}
+
+void NativeLottieAnimation::pause()
+{
+    m_played = playedFrames();
+    m_frameTimer.stop();
+
+    if (m_running) {
+        m_running = false;
+        emit runningChanged();
+    }
+}
+
+void NativeLottieAnimation::stop()
+{
+    pause();
+
+    m_played = 0;
+    m_currentLoop = 0;
+    m_frame = frameAt(0);
+    update();
+}
+
+void NativeLottieAnimation::clear()
+{
+    m_cleared = true;
+    update();
+}
+
+int NativeLottieAnimation::totalFrames() const
+{
+    return m_animation ? int(m_animation->totalFrame()) : 0;
+}
+
+qreal NativeLottieAnimation::playedFrames() const
+{
+    if (!m_frameTimer.isActive()) {
+        return m_played;
+    }
+    return m_played + m_clock.nsecsElapsed() / 1e9 * m_frameRate * m_speed;
+}
+
+int NativeLottieAnimation::frameAt(qreal played) const
+{
+    const int total = totalFrames();
+    if (total <= 0) {
+        return 0;
+    }
+
+    const int frame = int(played) % total;
+    return m_reverse ? total - 1 - frame : frame;
+}
+
+void NativeLottieAnimation::advance()
+{
+    const int total = totalFrames();
+    if (total <= 0) {
+        m_frameTimer.stop();
+        return;
+    }
+
+    qreal played = playedFrames();
+    bool finishedPlaying = false;
+
+    // Animation.Infinite is negative
+    if (m_loops >= 0 && played >= qMax(1, m_loops) * total - 1) {
+        played = qMax(1, m_loops) * total - 1;
+        finishedPlaying = true;
+    }
+
+    const int loop = int(played) / total;
+    while (m_currentLoop < loop) {
+        emit loopFinished(++m_currentLoop);
+    }
+
+    const int frame = frameAt(played);
+    if (frame != m_frame) {
+        m_frame = frame;
+        update();
+    }
+
+    if (finishedPlaying) {
+        pause();
+        m_played = played;
+        emit loopFinished(m_currentLoop + 1);
+        emit finished();
+    }
+}
+
+void NativeLottieAnimation::renderGeometry(QSize &size, QRectF &target, QRectF &sourceRect) const
+{
+    const QSizeF itemSize(width(), height());
+    const QSizeF nativeSize(m_nativeSize);
+    const qreal dpr = window() ? window()->effectiveDevicePixelRatio() : 1;
+
+    QSizeF scaled;
+    switch (m_fillMode) {
+    case PreserveAspectFit:
+        scaled = nativeSize.scaled(itemSize, Qt::KeepAspectRatio);
+        break;
+    case PreserveAspectCrop:
+        scaled = nativeSize.scaled(itemSize, Qt::KeepAspectRatioByExpanding);
+        break;
+    case Pad:
+        scaled = nativeSize;
+        break;
+    default:
+        scaled = itemSize;
+        break;
+    }
+
+    size = (scaled * dpr).toSize();
+    const QRectF frameRect(QPointF((itemSize.width() - scaled.width()) / 2, (itemSize.height() - scaled.height()) / 2), scaled);
+
+    // Cropped to the item, in pixels of the frame
+    target = frameRect.intersected(QRectF(QPointF(0, 0), itemSize));
+    sourceRect = QRectF((target.x() - frameRect.x()) * dpr, (target.y() - frameRect.y()) * dpr,
+                        target.width() * dpr, target.height() * dpr);
+}
+
+QSGNode *NativeLottieAnimation::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+
+    LottieNode *node = static_cast<LottieNode *>(oldNode);
+
+    QSize size;
+    QRectF target;
+    QRectF sourceRect;
+    if (m_animation && !m_cleared) {
+        renderGeometry(size, target, sourceRect);
+    }
+
+    if (size.isEmpty() || target.isEmpty()) {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node) {
+        node = new LottieNode;
+        node->setFiltering(QSGTexture::Linear);
+    }
+
+    if (node->generation != m_generation || node->size != size) {
+        node->clearFrames();
+        node->generation = m_generation;
+        node->size = size;
+    }
+
+    // The gui thread is blocked meanwhile, the animation can be used from here
+    QSGTexture *texture = node->frames.value(m_frame);
+    QSGTexture *previousScratch = nullptr;
+    if (!texture) {
+        QImage image(size, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        rlottie::Surface surface(reinterpret_cast<uint32_t *>(image.bits()), size_t(size.width()), size_t(size.height()), size_t(image.bytesPerLine()));
+        m_animation->renderSync(size_t(m_frame), surface, false);
+
+        // Small frames share the atlas texture of the window
+        texture = window()->createTextureFromImage(image, QQuickWindow::TextureCanUseAtlas);
+        const qint64 bytes = qint64(image.bytesPerLine()) * image.height();
+
+        // Frames are shown in a cycle: evicting would only make every one
+        // of them miss, the first ones fitting in the budget are kept
+        if (node->bytes + bytes <= m_cacheBudget) {
+            node->frames.insert(m_frame, texture);
+            node->bytes += bytes;
+        } else {
+            previousScratch = node->scratch;
+            node->scratch = texture;
+        }
+    }
+
+    node->setTexture(texture);
+    node->setRect(target);
+    node->setSourceRect(sourceRect);
+    delete previousScratch;
+
+    return node;
+}
+
+void NativeLottieAnimation::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+
+    if (newGeometry.size() != oldGeometry.size()) {
+        update();
+    }
+}
+
+#include "moc_nativelottieanimation.cpp"
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QQuickItem>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+#include <QVariant>
+
+#include <memory>
+
+class QNetworkReply;
+
+namespace rlottie {
+class Animation;
+}
+
+/**
+ * Plays a Lottie animation natively with rlottie, with the same QML API as
+ * LottieAnimation of org.kde.lottie, which uses it when the plugin has been
+ * built with it instead of interpreting the animation in JavaScript.
+ *
+ * The animation is parsed once. Rasterized frames are kept as textures for
+ * as long as they fit in cacheBudget, so an animation played in a loop is
+ * only rasterized during the first one.
+ */
+class NativeLottieAnimation : public QQuickItem
+{
+    Q_OBJECT
+
+    /**
+     * Url of an animation JSON file, JSON data or a JavaScript object
+     */
+    Q_PROPERTY(QVariant source READ source WRITE setSource NOTIFY sourceChanged)
+    // Image.Null, Image.Ready, Image.Loading or Image.Error
+    Q_PROPERTY(int status READ status NOTIFY statusChanged)
+    Q_PROPERTY(QString errorString READ errorString NOTIFY statusChanged)
+    Q_PROPERTY(bool running READ isRunning WRITE setRunning NOTIFY runningChanged)
+    // Times the animation is played, Animation.Infinite for ever
+    Q_PROPERTY(int loops READ loops WRITE setLoops NOTIFY loopsChanged)
+    Q_PROPERTY(qreal speed READ speed WRITE setSpeed NOTIFY speedChanged)
+    Q_PROPERTY(bool reverse READ reverse WRITE setReverse NOTIFY reverseChanged)
+    // Image.Stretch, Image.PreserveAspectFit, Image.PreserveAspectCrop or Image.Pad
+    Q_PROPERTY(int fillMode READ fillMode WRITE setFillMode NOTIFY fillModeChanged)
+    // Bytes of rasterized frames kept as textures, 0 rasterizes every frame
+    Q_PROPERTY(int cacheBudget READ cacheBudget WRITE setCacheBudget NOTIFY cacheBudgetChanged)
+
+public:
+    explicit NativeLottieAnimation(QQuickItem *parent = nullptr);
+    ~NativeLottieAnimation() override;
+
+    QVariant source() const;
+    void setSource(const QVariant &source);
+
+    int status() const;
+    QString errorString() const;
+
+    bool isRunning() const;
+    void setRunning(bool running);
+
+    int loops() const;
+    void setLoops(int loops);
+
+    qreal speed() const;
+    void setSpeed(qreal speed);
+
+    bool reverse() const;
+    void setReverse(bool reverse);
+
+    int fillMode() const;
+    void setFillMode(int fillMode);
+
+    int cacheBudget() const;
+    void setCacheBudget(int budget);
+
+    Q_INVOKABLE void start();
+    Q_INVOKABLE void pause();
+    Q_INVOKABLE void stop();
+    Q_INVOKABLE void clear();
+
+Q_SIGNALS:
+    void sourceChanged();
+    void statusChanged();
+    void runningChanged();
+    void loopsChanged();
+    void speedChanged();
+    void reverseChanged();
+    void fillModeChanged();
+    void cacheBudgetChanged();
+    void finished();
+    void loopFinished(int currentLoop);
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private:
+    void load(const QByteArray &json, const QString &cacheKey);
+    void setStatus(int status, const QString &errorString = QString());
+    void advance();
+    int totalFrames() const;
+    // Frames played since the last stop(), loops included
+    qreal playedFrames() const;
+    int frameAt(qreal played) const;
+    // Size of the rasterized frames, where they go in the item and what part of them is visible
+    void renderGeometry(QSize &size, QRectF &target, QRectF &sourceRect) const;
+
+    QVariant m_source;
+    QPointer<QNetworkReply> m_reply;
+    std::unique_ptr<rlottie::Animation> m_animation;
+    QSize m_nativeSize;
+    qreal m_frameRate = 0;
+
+    int m_status = 0;
+    QString m_errorString;
+    bool m_running = false;
+    int m_loops = 0;
+    qreal m_speed = 1;
+    bool m_reverse = false;
+    int m_fillMode = 0;
+    int m_cacheBudget = 16 * 1024 * 1024;
+
+    // Played frames when m_clock was started, or in total when not running
+    qreal m_played = 0;
+    int m_frame = 0;
+    int m_currentLoop = 0;
+    QElapsedTimer m_clock;
+    QTimer m_frameTimer;
+
+    // Bumped when the frames cached in the paint node can't be used any more
+    int m_generation = 0;
+    bool m_cleared = false;
+};
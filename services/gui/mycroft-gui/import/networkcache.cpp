@@ -0,0 +1,130 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "networkcache.h"
+
+#include <QStandardPaths>
+
+NetworkCache::NetworkCache()
+    : m_maximumCacheSize(qint64(50) * 1024 * 1024)
+{
+}
+
+NetworkCache *NetworkCache::instance()
+{
+    // The engines don't own their factory
+    static NetworkCache s_cache;
+    return &s_cache;
+}
+
+QNetworkAccessManager *NetworkCache::create(QObject *parent)
+{
+    return new CachingNetworkAccessManager(parent);
+}
+
+QString NetworkCache::cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/network");
+}
+
+qint64 NetworkCache::maximumCacheSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maximumCacheSize;
+}
+
+void NetworkCache::setMaximumCacheSize(qint64 maximumCacheSize)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maximumCacheSize = maximumCacheSize;
+}
+
+bool NetworkCache::takeRevalidation(const QUrl &url)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_revalidated.contains(url)) {
+        return false;
+    }
+
+    m_revalidated.insert(url);
+    return true;
+}
+
+RevalidatingDiskCache::RevalidatingDiskCache(QObject *parent)
+    : QNetworkDiskCache(parent)
+{
+}
+
+void RevalidatingDiskCache::revalidate(const QUrl &url)
+{
+    m_revalidate.insert(url);
+}
+
+QNetworkCacheMetaData RevalidatingDiskCache::metaData(const QUrl &url)
+{
+    // Only for the lookup deciding whether to send the request: the access
+    // manager reads the metadata again when merging a 304 reply
+    const bool revalidate = m_revalidate.remove(url);
+    QNetworkCacheMetaData metaData = QNetworkDiskCache::metaData(url);
+    if (!metaData.isValid() || !revalidate) {
+        return metaData;
+    }
+
+    // The access manager then sends the validators of the cached reply
+    // and uses it again on 304 Not Modified
+    QNetworkCacheMetaData::RawHeaderList headers;
+    for (const auto &header : metaData.rawHeaders()) {
+        if (qstricmp(header.first.constData(), "Cache-Control") != 0) {
+            headers << header;
+        }
+    }
+    headers << qMakePair(QByteArray("Cache-Control"), QByteArray("no-cache"));
+    metaData.setRawHeaders(headers);
+
+    return metaData;
+}
+
+CachingNetworkAccessManager::CachingNetworkAccessManager(QObject *parent)
+    : QNetworkAccessManager(parent),
+      m_cache(new RevalidatingDiskCache(this))
+{
+    m_cache->setCacheDirectory(NetworkCache::cacheDirectory());
+    m_cache->setMaximumCacheSize(NetworkCache::instance()->maximumCacheSize());
+    setCache(m_cache);
+}
+
+QNetworkReply *CachingNetworkAccessManager::createRequest(Operation op, const QNetworkRequest &request, QIODevice *outgoingData)
+{
+    const QString scheme = request.url().scheme();
+    const bool http = scheme == QLatin1String("http") || scheme == QLatin1String("https");
+
+    // Requests choosing their own cache policy keep it
+    if (op != GetOperation || !http || request.attribute(QNetworkRequest::CacheLoadControlAttribute).isValid()) {
+        return QNetworkAccessManager::createRequest(op, request, outgoingData);
+    }
+
+    QNetworkRequest cachedRequest(request);
+    if (NetworkCache::instance()->takeRevalidation(request.url())) {
+        m_cache->revalidate(request.url());
+    } else {
+        cachedRequest.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+    }
+
+    return QNetworkAccessManager::createRequest(op, cachedRequest, outgoingData);
+}
+
+#include "moc_networkcache.cpp"
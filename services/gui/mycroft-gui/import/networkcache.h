@@ -0,0 +1,101 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QMutex>
+#include <QNetworkAccessManager>
+#include <QNetworkDiskCache>
+#include <QQmlNetworkAccessManagerFactory>
+#include <QSet>
+#include <QUrl>
+
+/**
+ * Network access of the QML engines and of the skill assets: remote skill
+ * QML, images and translations all go through an HTTP cache on disk.
+ *
+ * A cached url is revalidated with the server (If-None-Match or
+ * If-Modified-Since) the first time the process asks for it; afterwards the
+ * cached copy is used as long as there is one, so showing a page again
+ * doesn't touch the network.
+ */
+class NetworkCache : public QQmlNetworkAccessManagerFactory
+{
+public:
+    static NetworkCache *instance();
+
+    /**
+     * A manager using the cache, can be called from any thread
+     */
+    QNetworkAccessManager *create(QObject *parent) override;
+
+    static QString cacheDirectory();
+
+    /**
+     * Bytes kept on disk, applies to the managers created afterwards
+     */
+    qint64 maximumCacheSize() const;
+    void setMaximumCacheSize(qint64 maximumCacheSize);
+
+    /**
+     * @returns true the first time it's called for url in the process
+     */
+    bool takeRevalidation(const QUrl &url);
+
+private:
+    NetworkCache();
+
+    mutable QMutex m_mutex;
+    QSet<QUrl> m_revalidated;
+    qint64 m_maximumCacheSize;
+};
+
+/**
+ * @internal A disk cache that can make the next request of a url revalidate
+ * its cached reply, however fresh the server said it was
+ */
+class RevalidatingDiskCache : public QNetworkDiskCache
+{
+    Q_OBJECT
+
+public:
+    explicit RevalidatingDiskCache(QObject *parent = nullptr);
+
+    void revalidate(const QUrl &url);
+
+    QNetworkCacheMetaData metaData(const QUrl &url) override;
+
+private:
+    QSet<QUrl> m_revalidate;
+};
+
+/**
+ * @internal
+ */
+class CachingNetworkAccessManager : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    explicit CachingNetworkAccessManager(QObject *parent = nullptr);
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &request, QIODevice *outgoingData) override;
+
+private:
+    RevalidatingDiskCache *m_cache;
+};
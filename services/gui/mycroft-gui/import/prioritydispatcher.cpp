@@ -0,0 +1,105 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "prioritydispatcher.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+PriorityDispatcher *PriorityDispatcher::instance()
+{
+    static PriorityDispatcher *s_self = nullptr;
+    if (!s_self) {
+        s_self = new PriorityDispatcher(QCoreApplication::instance());
+    }
+    return s_self;
+}
+
+PriorityDispatcher::PriorityDispatcher(QObject *parent)
+    : QObject(parent)
+{
+    // Zero timer: whatever is already waiting in the event loop goes first
+    m_sliceTimer.setSingleShot(true);
+    m_sliceTimer.setInterval(0);
+    connect(&m_sliceTimer, &QTimer::timeout, this, &PriorityDispatcher::runSlice);
+}
+
+void PriorityDispatcher::post(Lane lane, QObject *context, const std::function<void()> &work)
+{
+    if (lane == Critical) {
+        work();
+        return;
+    }
+
+    m_bulk.enqueue({context, work});
+    if (!m_running) {
+        m_sliceTimer.start();
+    }
+}
+
+int PriorityDispatcher::timeSlice() const
+{
+    return m_timeSlice;
+}
+
+void PriorityDispatcher::setTimeSlice(int timeSlice)
+{
+    m_timeSlice = qMax(0, timeSlice);
+}
+
+int PriorityDispatcher::pendingCount() const
+{
+    return m_bulk.count();
+}
+
+void PriorityDispatcher::flush()
+{
+    m_sliceTimer.stop();
+    while (!m_bulk.isEmpty()) {
+        runNext();
+    }
+}
+
+void PriorityDispatcher::runSlice()
+{
+    // A nested event loop in some work: the outer slice carries on
+    if (m_running || m_bulk.isEmpty()) {
+        return;
+    }
+    m_running = true;
+
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        runNext();
+    } while (!m_bulk.isEmpty() && (m_timeSlice == 0 || timer.elapsed() < m_timeSlice));
+
+    m_running = false;
+    if (!m_bulk.isEmpty()) {
+        m_sliceTimer.start();
+    }
+}
+
+void PriorityDispatcher::runNext()
+{
+    const Work work = m_bulk.dequeue();
+    if (work.context) {
+        work.work();
+    }
+}
+
+#include "moc_prioritydispatcher.cpp"
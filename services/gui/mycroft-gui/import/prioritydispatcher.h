@@ -0,0 +1,84 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QTimer>
+
+#include <functional>
+
+/**
+ * Dispatch stage shared by the sockets of the process, so that a burst of
+ * bulk data never delays a change of listening or speaking state.
+ *
+ * Critical work runs right away, ahead of everything queued. Bulk work is
+ * queued in arrival order and run in slices of at most timeSlice
+ * milliseconds, returning to the event loop in between so that frames get
+ * rendered and new messages, critical ones among them, get read.
+ */
+class PriorityDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Lane {
+        Critical,
+        Bulk
+    };
+
+    static PriorityDispatcher *instance();
+
+    /**
+     * Runs work on lane, skipped if context gets destroyed before
+     */
+    void post(Lane lane, QObject *context, const std::function<void()> &work);
+
+    /**
+     * Milliseconds of bulk work per slice, at least one item runs per slice.
+     * 0 runs the whole queue at once.
+     */
+    int timeSlice() const;
+    void setTimeSlice(int timeSlice);
+
+    /**
+     * Bulk work waiting
+     */
+    int pendingCount() const;
+
+    /**
+     * Runs all the bulk work waiting, now
+     */
+    void flush();
+
+private:
+    struct Work {
+        QPointer<QObject> context;
+        std::function<void()> work;
+    };
+
+    explicit PriorityDispatcher(QObject *parent = nullptr);
+    void runSlice();
+    void runNext();
+
+    QQueue<Work> m_bulk;
+    QTimer m_sliceTimer;
+    int m_timeSlice = 8;
+    bool m_running = false;
+};
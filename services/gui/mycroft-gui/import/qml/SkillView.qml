@@ -246,6 +246,13 @@ Mycroft.AbstractSkillView {
                                     backRequested.connect(delegatesView.globalBackRequest)
                             }
                             
+                            // Placeholder while the delegate is being created asynchronously
+                            Controls.BusyIndicator {
+                                anchors.centerIn: parent
+                                running: model.delegateLoading
+                                visible: running
+                            }
+
                             Connections {
                                 target: model.delegateUi
                                 onFocusChanged: {
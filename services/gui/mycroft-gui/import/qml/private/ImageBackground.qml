@@ -33,15 +33,23 @@ Item {
     onSourceChanged: {
         if (backgroundImage.currentImage == image1) {
             image2.opacity = 0;
-            image2.source = source;
+            image2.source = cachedSource(source);
             backgroundImage.setCurrent(image2);
         } else {
             image1.opacity = 0;
-            image1.source = source;
+            image1.source = cachedSource(source);
             backgroundImage.setCurrent(image1);
         }
     }
 
+    // Decoded off the GUI thread at the size shown, and shared between the views
+    function cachedSource(url) {
+        if (!url || url.indexOf("image://") === 0 || url.indexOf("data:") === 0) {
+            return url;
+        }
+        return "image://mycroft/" + encodeURIComponent(url);
+    }
+
     function setCurrent(image) {
         if (image.status === Image.Ready) {
             backgroundImage.currentImage = image;
@@ -59,6 +67,8 @@ Item {
         anchors.fill: parent
         z: backgroundImage.currentImage == image1 ? 1 : 0
         fillMode: Image.PreserveAspectCrop
+        sourceSize.width: width
+        sourceSize.height: height
         onStatusChanged: {
             if (backgroundImage.currentImage == image2 && status == Image.Ready) {
                 backgroundImage.setCurrent(image1);
@@ -70,6 +80,8 @@ Item {
         anchors.fill: parent
         z: backgroundImage.currentImage == image2 ? 1 : 0
         fillMode: Image.PreserveAspectCrop
+        sourceSize.width: width
+        sourceSize.height: height
         onStatusChanged: {
             if (backgroundImage.currentImage == image1 && status == Image.Ready) {
                 backgroundImage.setCurrent(image2);
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <random>
+
+/**
+ * Delays between reconnection attempts: they double at every attempt,
+ * from initial up to maximum milliseconds, and are randomized between
+ * half and the whole delay, so that many clients losing the same server
+ * don't all come back at the same moment.
+ */
+class ReconnectBackoff
+{
+public:
+    explicit ReconnectBackoff(int initial = 250, int maximum = 10000)
+        : m_initial(initial),
+          m_maximum(maximum),
+          m_random(std::random_device()())
+    {
+    }
+
+    /**
+     * @returns the delay before the next attempt, and counts it
+     */
+    int next()
+    {
+        const int delay = qMin(m_maximum, m_initial << qMin(m_attempts, 16));
+        ++m_attempts;
+        std::uniform_int_distribution<int> jitter(delay / 2, delay);
+        return jitter(m_random);
+    }
+
+    /**
+     * Back to the initial delay, once connected
+     */
+    void reset()
+    {
+        m_attempts = 0;
+    }
+
+private:
+    int m_initial;
+    int m_maximum;
+    int m_attempts = 0;
+    std::minstd_rand m_random;
+};
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "remoteskillassets.h"
+#include "networkcache.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocale>
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+static QString translationsDirectory(const QString &skillId)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/translations/") + skillId;
+}
+
+// The file names QTranslator::load() looks for with the current locale
+static QSet<QString> catalogNames(const QString &skillId)
+{
+    QSet<QString> names;
+    for (QString language : QLocale().uiLanguages()) {
+        language.replace(QLatin1Char('-'), QLatin1Char('_'));
+        while (!language.isEmpty()) {
+            names.insert(QStringLiteral("%1_%2.qm").arg(skillId, language).toLower());
+            const int separator = language.lastIndexOf(QLatin1Char('_'));
+            language.truncate(qMax(separator, 0));
+        }
+    }
+    return names;
+}
+
+RemoteSkillAssets *RemoteSkillAssets::instance()
+{
+    static RemoteSkillAssets *s_self = nullptr;
+    if (!s_self) {
+        s_self = new RemoteSkillAssets(QCoreApplication::instance());
+    }
+    return s_self;
+}
+
+RemoteSkillAssets::RemoteSkillAssets(QObject *parent)
+    : QObject(parent),
+      m_manager(NetworkCache::instance()->create(this))
+{
+}
+
+bool RemoteSkillAssets::isRemote(const QUrl &url)
+{
+    return url.scheme() == QLatin1String("http") || url.scheme() == QLatin1String("https");
+}
+
+void RemoteSkillAssets::fetch(const QString &skillId, const QUrl &uiUrl)
+{
+    if (m_requested.contains(skillId)) {
+        return;
+    }
+
+    m_requested.insert(skillId);
+    QNetworkReply *reply = m_manager->get(QNetworkRequest(uiUrl.resolved(QUrl(QStringLiteral("manifest.json")))));
+    connect(reply, &QNetworkReply::finished, this, [this, skillId, uiUrl, reply]() {
+        reply->deleteLater();
+        manifestReceived(skillId, uiUrl, reply);
+    });
+}
+
+bool RemoteSkillAssets::prefetch() const
+{
+    return m_prefetch;
+}
+
+void RemoteSkillAssets::setPrefetch(bool prefetch)
+{
+    m_prefetch = prefetch;
+}
+
+void RemoteSkillAssets::manifestReceived(const QString &skillId, const QUrl &uiUrl, QNetworkReply *reply)
+{
+    if (reply->error() != QNetworkReply::NoError) {
+        // The manifest is optional
+        if (reply->error() != QNetworkReply::ContentNotFoundError) {
+            qWarning() << "Cannot fetch the ui manifest of" << skillId << reply->errorString();
+        }
+        emit translationsFetched(skillId, QString(), QStringList());
+        return;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument manifest = QJsonDocument::fromJson(reply->readAll(), &parseError);
+    if (!manifest.isObject()) {
+        qWarning() << "Invalid ui manifest for" << skillId << parseError.errorString();
+        emit translationsFetched(skillId, QString(), QStringList());
+        return;
+    }
+
+    const QSet<QString> wantedCatalogs = catalogNames(skillId);
+    PendingCatalogs pending;
+    QStringList catalogs;
+
+    const QJsonArray files = manifest.object().value(QStringLiteral("files")).toArray();
+    for (const QJsonValue &value : files) {
+        const QString file = value.toString();
+        // Relative to the ui directory, never outside of it
+        if (file.isEmpty() || QDir::isAbsolutePath(file) || file.contains(QStringLiteral(".."))) {
+            continue;
+        }
+
+        const QFileInfo info(file);
+        if (info.suffix() == QLatin1String("qml")) {
+            pending.contexts << info.completeBaseName();
+        }
+
+        if (file.startsWith(QLatin1String("translations/")) && info.suffix() == QLatin1String("qm")) {
+            if (wantedCatalogs.contains(info.fileName().toLower())) {
+                catalogs << file;
+            }
+        } else if (m_prefetch) {
+            // Only there to fill the cache
+            QNetworkReply *prefetchReply = m_manager->get(QNetworkRequest(uiUrl.resolved(QUrl(file))));
+            connect(prefetchReply, &QNetworkReply::finished, prefetchReply, &QObject::deleteLater);
+        }
+    }
+
+    if (catalogs.isEmpty()) {
+        emit translationsFetched(skillId, QString(), pending.contexts);
+        return;
+    }
+
+    pending.count = catalogs.count();
+    m_pendingCatalogs.insert(skillId, pending);
+
+    for (const QString &catalog : catalogs) {
+        QNetworkReply *catalogReply = m_manager->get(QNetworkRequest(uiUrl.resolved(QUrl(catalog))));
+        const QString fileName = QFileInfo(catalog).fileName();
+        connect(catalogReply, &QNetworkReply::finished, this, [this, skillId, fileName, catalogReply]() {
+            catalogReply->deleteLater();
+            catalogReceived(skillId, fileName, catalogReply);
+        });
+    }
+}
+
+void RemoteSkillAssets::catalogReceived(const QString &skillId, const QString &fileName, QNetworkReply *reply)
+{
+    if (reply->error() != QNetworkReply::NoError) {
+        qWarning() << "Cannot download the translations" << reply->url() << reply->errorString();
+        catalogDone(skillId);
+        return;
+    }
+
+    const QString directory = translationsDirectory(skillId);
+    QDir().mkpath(directory);
+
+    QSaveFile file(directory + QLatin1Char('/') + fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(reply->readAll()) < 0 || !file.commit()) {
+        qWarning() << "Cannot save the translations of" << skillId << file.errorString();
+    }
+
+    catalogDone(skillId);
+}
+
+void RemoteSkillAssets::catalogDone(const QString &skillId)
+{
+    auto it = m_pendingCatalogs.find(skillId);
+    if (it == m_pendingCatalogs.end() || --it->count > 0) {
+        return;
+    }
+
+    const QStringList contexts = it->contexts;
+    m_pendingCatalogs.erase(it);
+    emit translationsFetched(skillId, translationsDirectory(skillId), contexts);
+}
+
+#include "moc_remoteskillassets.cpp"
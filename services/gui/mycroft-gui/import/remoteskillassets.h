@@ -0,0 +1,84 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QUrl>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+/**
+ * Fetches what remote skills (ui served over http, as for Hivemind
+ * satellites) can't provide file by file, the first time a skill shows a page.
+ *
+ * A skill lists the files of its ui directory in ui/manifest.json:
+ *   {"files": ["WeatherDelegate.qml", "images/sunny.svg", "translations/mycroft-weather_de.qm"]}
+ * Its translation catalogs are downloaded to a local directory for
+ * SkillTranslations. With prefetching on, all the other files are downloaded
+ * into the NetworkCache too, so the pages of the skill show up without
+ * waiting for the network.
+ */
+class RemoteSkillAssets : public QObject
+{
+    Q_OBJECT
+
+public:
+    static RemoteSkillAssets *instance();
+
+    static bool isRemote(const QUrl &url);
+
+    /**
+     * Starts fetching the manifest of skillId in uiUrl, its ui directory.
+     * Does nothing if it was fetched already
+     */
+    void fetch(const QString &skillId, const QUrl &uiUrl);
+
+    /**
+     * Also download the files of the manifest that aren't translations
+     */
+    bool prefetch() const;
+    void setPrefetch(bool prefetch);
+
+Q_SIGNALS:
+    /**
+     * The catalogs of skillId are in translationsPath, contexts are the
+     * names of its QML files. translationsPath is empty if there are none
+     */
+    void translationsFetched(const QString &skillId, const QString &translationsPath, const QStringList &contexts);
+
+private:
+    explicit RemoteSkillAssets(QObject *parent = nullptr);
+
+    void manifestReceived(const QString &skillId, const QUrl &uiUrl, QNetworkReply *reply);
+    void catalogReceived(const QString &skillId, const QString &fileName, QNetworkReply *reply);
+    void catalogDone(const QString &skillId);
+
+    QNetworkAccessManager *m_manager;
+    QSet<QString> m_requested;
+    bool m_prefetch = false;
+
+    struct PendingCatalogs {
+        int count = 0;
+        QStringList contexts;
+    };
+    QHash<QString, PendingCatalogs> m_pendingCatalogs;
+};
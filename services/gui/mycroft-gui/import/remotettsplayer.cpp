@@ -0,0 +1,296 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "remotettsplayer.h"
+
+#include <QAudioDeviceInfo>
+#include <QDebug>
+#include <QtEndian>
+
+static const char s_streamMagic[] = "MTTS";
+static const int s_frameHeaderSize = 5;
+
+// Compact the pending buffer once this much of it has been consumed
+static const int s_compactThreshold = 64 * 1024;
+
+static quint16 readUInt16(const QByteArray &data, int offset)
+{
+    return qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(data.constData() + offset));
+}
+
+static quint32 readUInt32(const QByteArray &data, int offset)
+{
+    return qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(data.constData() + offset));
+}
+
+RemoteTtsPlayer::RemoteTtsPlayer(QObject *parent)
+    : QObject(parent)
+{
+}
+
+RemoteTtsPlayer::~RemoteTtsPlayer()
+{
+    if (m_output) {
+        m_output->stop();
+    }
+}
+
+bool RemoteTtsPlayer::isStreamFrame(const QByteArray &frame)
+{
+    return frame.size() >= s_frameHeaderSize && frame.startsWith(s_streamMagic);
+}
+
+void RemoteTtsPlayer::handleStreamFrame(const QByteArray &frame)
+{
+    if (!isStreamFrame(frame)) {
+        qWarning() << "Invalid TTS stream frame";
+        return;
+    }
+
+    const quint8 flags = quint8(frame.at(4));
+
+    if (flags & BeginFlag) {
+        beginUtterance();
+    } else if (m_streamEnded) {
+        qWarning() << "TTS stream frame arrived outside of an utterance, dropping it";
+        return;
+    }
+
+    appendUtteranceData(frame.mid(s_frameHeaderSize));
+
+    if (flags & EndFlag) {
+        endUtterance();
+    }
+}
+
+void RemoteTtsPlayer::playWav(const QByteArray &wav)
+{
+    beginUtterance();
+    appendUtteranceData(wav);
+    endUtterance();
+}
+
+void RemoteTtsPlayer::stop()
+{
+    m_header.clear();
+    m_headerParsed = false;
+    m_streamEnded = true;
+    m_pending.clear();
+    m_pendingPos = 0;
+
+    if (m_output) {
+        // Drops what the audio device has buffered already
+        m_output->stop();
+        m_device = m_output->start();
+    }
+
+    updatePlaying();
+}
+
+bool RemoteTtsPlayer::isPlaying() const
+{
+    return m_playing;
+}
+
+void RemoteTtsPlayer::beginUtterance()
+{
+    if (!m_streamEnded) {
+        qWarning() << "New TTS utterance started before the previous one ended";
+    }
+
+    m_header.clear();
+    m_headerParsed = false;
+    m_streamEnded = false;
+}
+
+void RemoteTtsPlayer::appendUtteranceData(const QByteArray &data)
+{
+    if (m_streamEnded) {
+        return;
+    }
+
+    if (m_headerParsed) {
+        m_pending.append(data);
+        drain();
+        return;
+    }
+
+    m_header.append(data);
+    switch (parseHeader()) {
+    case HeaderIncomplete:
+        return;
+    case HeaderInvalid:
+        m_header.clear();
+        m_streamEnded = true;
+        updatePlaying();
+        return;
+    case HeaderComplete:
+        drain();
+        return;
+    }
+}
+
+void RemoteTtsPlayer::endUtterance()
+{
+    if (!m_streamEnded && !m_headerParsed) {
+        qWarning() << "TTS utterance ended before its WAV header was complete";
+    }
+
+    m_header.clear();
+    m_streamEnded = true;
+    updatePlaying();
+}
+
+RemoteTtsPlayer::HeaderStatus RemoteTtsPlayer::parseHeader()
+{
+    if (m_header.size() < 12) {
+        return HeaderIncomplete;
+    }
+
+    if (!m_header.startsWith("RIFF") || m_header.mid(8, 4) != "WAVE") {
+        qWarning() << "TTS audio is not a WAV file";
+        return HeaderInvalid;
+    }
+
+    QAudioFormat format;
+    bool hasFormat = false;
+    int offset = 12;
+
+    while (offset + 8 <= m_header.size()) {
+        const QByteArray id = m_header.mid(offset, 4);
+        const quint32 size = readUInt32(m_header, offset + 4);
+        const int body = offset + 8;
+
+        if (id == "data") {
+            if (!hasFormat) {
+                qWarning() << "WAV data chunk arrived before the fmt chunk";
+                return HeaderInvalid;
+            }
+
+            // The size of the data chunk is unknown while streaming, play until the end
+            setupOutput(format);
+            m_pending.append(m_header.constData() + body, m_header.size() - body);
+            m_header.clear();
+            m_headerParsed = true;
+            return HeaderComplete;
+        }
+
+        if (id == "fmt ") {
+            if (body + 16 > m_header.size()) {
+                return HeaderIncomplete;
+            }
+
+            const quint16 audioFormat = readUInt16(m_header, body);
+            const int bitsPerSample = readUInt16(m_header, body + 14);
+            if (audioFormat != 1 && !(audioFormat == 3 && bitsPerSample == 32)) {
+                qWarning() << "Unsupported WAV encoding" << audioFormat;
+                return HeaderInvalid;
+            }
+
+            format.setCodec(QStringLiteral("audio/pcm"));
+            format.setByteOrder(QAudioFormat::LittleEndian);
+            format.setChannelCount(readUInt16(m_header, body + 2));
+            format.setSampleRate(int(readUInt32(m_header, body + 4)));
+            format.setSampleSize(bitsPerSample);
+            if (audioFormat == 3) {
+                format.setSampleType(QAudioFormat::Float);
+            } else {
+                format.setSampleType(bitsPerSample == 8 ? QAudioFormat::UnSignedInt : QAudioFormat::SignedInt);
+            }
+            hasFormat = true;
+        }
+
+        // Chunks are padded to an even size
+        offset = body + int(size) + int(size % 2);
+    }
+
+    return HeaderIncomplete;
+}
+
+void RemoteTtsPlayer::setupOutput(const QAudioFormat &format)
+{
+    if (m_output && m_output->format() == format) {
+        return;
+    }
+
+    if (m_output) {
+        // Samples of the previous format can't be played on the new output
+        m_output->stop();
+        delete m_output;
+        m_device = nullptr;
+        m_pending.clear();
+        m_pendingPos = 0;
+    }
+
+    if (!QAudioDeviceInfo::defaultOutputDevice().isFormatSupported(format)) {
+        qWarning() << "TTS audio format is not supported by the output device, playback may fail:" << format;
+    }
+
+    m_output = new QAudioOutput(format, this);
+    m_output->setNotifyInterval(20);
+    connect(m_output.data(), &QAudioOutput::notify, this, &RemoteTtsPlayer::drain);
+    connect(m_output.data(), &QAudioOutput::stateChanged, this, [this](QAudio::State state) {
+        if (state == QAudio::IdleState) {
+            drain();
+        }
+        updatePlaying();
+    });
+
+    // Push mode: samples are written as soon as they arrive and there is room
+    m_device = m_output->start();
+}
+
+void RemoteTtsPlayer::drain()
+{
+    if (!m_device || !m_output) {
+        return;
+    }
+
+    const int available = m_pending.size() - m_pendingPos;
+    const int room = qMin(available, m_output->bytesFree());
+    if (room > 0) {
+        const qint64 written = m_device->write(m_pending.constData() + m_pendingPos, room);
+        if (written > 0) {
+            m_pendingPos += int(written);
+        }
+    }
+
+    if (m_pendingPos == m_pending.size()) {
+        m_pending.clear();
+        m_pendingPos = 0;
+    } else if (m_pendingPos > s_compactThreshold) {
+        m_pending.remove(0, m_pendingPos);
+        m_pendingPos = 0;
+    }
+
+    updatePlaying();
+}
+
+void RemoteTtsPlayer::updatePlaying()
+{
+    const bool playing = !m_streamEnded || m_pendingPos < m_pending.size()
+        || (m_output && m_output->state() == QAudio::ActiveState);
+
+    if (playing == m_playing) {
+        return;
+    }
+
+    m_playing = playing;
+    emit playingChanged();
+}
+
+#include "moc_remotettsplayer.cpp"
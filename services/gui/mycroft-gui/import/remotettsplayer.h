@@ -0,0 +1,101 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QAudioFormat>
+#include <QAudioOutput>
+#include <QByteArray>
+#include <QPointer>
+
+/**
+ * Plays the audio of remote TTS as it arrives, on a single audio output
+ * that lives as long as the player.
+ *
+ * Audio can arrive either as a whole WAV file (the legacy remote.tts.audio
+ * message) or streamed in binary websocket frames:
+ *   "MTTS" magic, one flags byte, then the payload.
+ *   Flag 0x01: first frame of an utterance, the payload starts with the WAV header
+ *   Flag 0x02: last frame of an utterance
+ * Playback starts as soon as the WAV header and the first samples are there.
+ */
+class RemoteTtsPlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum StreamFlag {
+        BeginFlag = 0x01,
+        EndFlag = 0x02
+    };
+
+    explicit RemoteTtsPlayer(QObject *parent = nullptr);
+    ~RemoteTtsPlayer() override;
+
+    /**
+     * @returns true if the binary frame is a TTS stream frame
+     */
+    static bool isStreamFrame(const QByteArray &frame);
+
+    /**
+     * Feeds one "MTTS" frame to the player
+     */
+    void handleStreamFrame(const QByteArray &frame);
+
+    /**
+     * Plays a whole WAV file from memory, queued after what is already playing
+     */
+    void playWav(const QByteArray &wav);
+
+    void stop();
+
+    bool isPlaying() const;
+
+Q_SIGNALS:
+    void playingChanged();
+
+private:
+    enum HeaderStatus {
+        HeaderIncomplete,
+        HeaderComplete,
+        HeaderInvalid
+    };
+
+    void beginUtterance();
+    void appendUtteranceData(const QByteArray &data);
+    void endUtterance();
+    HeaderStatus parseHeader();
+    void setupOutput(const QAudioFormat &format);
+    void drain();
+    void updatePlaying();
+
+    QPointer<QAudioOutput> m_output;
+    QIODevice *m_device = nullptr;
+
+    // Bytes of the current utterance before its data chunk has been found
+    QByteArray m_header;
+    bool m_headerParsed = false;
+    // No utterance is being received
+    bool m_streamEnded = true;
+
+    // Samples waiting for room in the audio output
+    QByteArray m_pending;
+    int m_pendingPos = 0;
+
+    bool m_playing = false;
+};
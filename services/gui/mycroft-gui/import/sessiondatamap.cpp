@@ -21,6 +21,8 @@
 
 #include <QDebug>
 #include <QJSValue>
+#include <QJsonArray>
+#include <QJsonObject>
 #include <cstddef>
 
 SessionDataMap::SessionDataMap(const QString &skillId, AbstractSkillView *parent)
@@ -30,17 +32,25 @@ SessionDataMap::SessionDataMap(const QString &skillId, AbstractSkillView *parent
 {
     m_updateTimer = new QTimer(this);
     m_updateTimer->setSingleShot(true);
-    m_updateTimer->setInterval(250); //arbitrary
-    connect(m_updateTimer, &QTimer::timeout, this, [this]() {
-        if (!m_propertiesToUpdate.isEmpty()) {
-            m_view->writeProperties(m_skillId, m_propertiesToUpdate);
-        }
-        for (auto k : m_propertiesToDelete) {
-            m_view->deleteProperty(m_skillId, k);
-        }
-        m_propertiesToUpdate.clear();
-        m_propertiesToDelete.clear();
-    });
+    connect(m_updateTimer, &QTimer::timeout, this, &SessionDataMap::writeBack);
+
+    m_deadlineTimer = new QTimer(this);
+    m_deadlineTimer->setSingleShot(true);
+    connect(m_deadlineTimer, &QTimer::timeout, this, &SessionDataMap::writeBack);
+}
+
+SessionDataMap::SessionDataMap(SessionDataMap *parentMap, const QString &key)
+    : QQmlPropertyMap(this, parentMap),
+      m_skillId(parentMap->m_skillId),
+      // Written back by the top level map, as a whole
+      m_updateTimer(nullptr),
+      m_deadlineTimer(nullptr),
+      m_view(parentMap->m_view),
+      m_parentMap(parentMap),
+      m_parentKey(key),
+      m_batchingEnabled(parentMap->m_batchingEnabled)
+{
+    connect(this, &SessionDataMap::changesPending, parentMap, &SessionDataMap::changesPending);
 }
 
 SessionDataMap::~SessionDataMap()
@@ -49,32 +59,280 @@ SessionDataMap::~SessionDataMap()
 
 QVariant SessionDataMap::updateValue(const QString &key, const QVariant &newValue)
 {
-    if (value(key).canConvert<SessionDataModel *>()) {
+    const QVariant current = value(key);
+    if (current.canConvert<SessionDataModel *>()) {
         qWarning() << "Can't replace a model from the client side";
-        return value(key);
+        return current;
     }
 
-    if (newValue.isNull() || !newValue.isValid() ) {
-        m_propertiesToDelete << key;
+    // the client change is more recent than what the server sent
+    m_pendingValues.remove(key);
+
+    if (m_parentMap) {
+        QJsonObject object = toJson();
+        if (newValue.isNull() || !newValue.isValid()) {
+            object.remove(key);
+        } else {
+            object.insert(key, QJsonValue::fromVariant(newValue));
+        }
+        m_parentMap->writeChild(m_parentKey, object);
     } else {
-        m_propertiesToUpdate[key] = newValue;
+        if (newValue.isNull() || !newValue.isValid() ) {
+            m_propertiesToUpdate.remove(key);
+            if (!m_propertiesToDelete.contains(key)) {
+                m_propertiesToDelete << key;
+            }
+        } else {
+            m_propertiesToDelete.removeAll(key);
+            m_propertiesToUpdate[key] = newValue;
+        }
+
+        scheduleWriteBack(key);
     }
 
-    m_updateTimer->start();
+    // a child map replaced by a plain value
+    if (current != newValue) {
+        releaseValue(current);
+    }
 
     return QQmlPropertyMap::updateValue(key, newValue);
 }
 
+void SessionDataMap::writeChild(const QString &key, const QJsonObject &object)
+{
+    if (m_parentMap) {
+        QJsonObject parentObject = toJson();
+        parentObject.insert(key, object);
+        m_parentMap->writeChild(m_parentKey, parentObject);
+        return;
+    }
+
+    m_pendingValues.remove(key);
+    m_propertiesToDelete.removeAll(key);
+    m_propertiesToUpdate[key] = object.toVariantMap();
+    scheduleWriteBack(key);
+}
+
+SessionDataMap *SessionDataMap::childMap(const QVariant &value)
+{
+    return qobject_cast<SessionDataMap *>(value.value<QObject *>());
+}
+
+void SessionDataMap::releaseValue(const QVariant &value)
+{
+    // Child maps and models belong to the key holding them
+    QObject *object = value.value<QObject *>();
+    if (qobject_cast<SessionDataMap *>(object) || qobject_cast<SessionDataModel *>(object)) {
+        object->deleteLater();
+    }
+}
+
+void SessionDataMap::setJsonValue(const QString &key, const QJsonValue &value, const QString &listKey)
+{
+    const QVariant current = this->value(key);
+
+    if (value.isObject()) {
+        SessionDataMap *child = childMap(current);
+        if (child) {
+            // Only the keys that changed notify
+            child->assignJson(value.toObject());
+            return;
+        }
+
+        child = new SessionDataMap(this, key);
+        child->assignJson(value.toObject());
+        releaseValue(current);
+        insertAndNotify(key, QVariant::fromValue(child));
+        return;
+    }
+
+    //insert it as a model
+    const QList<QVariantMap> list = value.isArray() ? SessionDataModel::rowsFromJson(value.toArray()) : QList<QVariantMap>();
+    SessionDataModel *dm = current.value<SessionDataModel *>();
+
+    if (!list.isEmpty()) {
+        if (dm) {
+            // diff against the existing rows instead of resetting the model
+            dm->replaceData(list, listKey);
+            return;
+        }
+
+        dm = m_view->createSessionDataModel(this);
+        releaseValue(current);
+        insertAndNotify(key, QVariant::fromValue(dm));
+        dm->insertData(0, list);
+        return;
+    }
+
+    //insert it as is.
+    releaseValue(current);
+    insertAndNotify(key, value.toVariant());
+}
+
+void SessionDataMap::assignJson(const QJsonObject &object)
+{
+    for (const QString &key : keys()) {
+        if (!object.contains(key)) {
+            clearAndNotify(key);
+        }
+    }
+
+    for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+        const QJsonValue value = it.value();
+        if (!value.isObject() && !value.isArray() && contains(it.key())
+            && this->value(it.key()) == value.toVariant()) {
+            continue;
+        }
+        setJsonValue(it.key(), value);
+    }
+}
+
+QJsonValue SessionDataMap::jsonValue(const QString &key) const
+{
+    const QVariant value = this->value(key);
+
+    if (SessionDataMap *child = childMap(value)) {
+        return child->toJson();
+    }
+
+    if (SessionDataModel *dm = value.value<SessionDataModel *>()) {
+        QJsonArray rows;
+        for (const QVariantMap &row : dm->rows()) {
+            rows.append(QJsonObject::fromVariantMap(row));
+        }
+        return rows;
+    }
+
+    return QJsonValue::fromVariant(value);
+}
+
+QJsonObject SessionDataMap::toJson() const
+{
+    QJsonObject object;
+    for (const QString &key : keys()) {
+        object.insert(key, jsonValue(key));
+    }
+    return object;
+}
+
+void SessionDataMap::setWritePriority(const QString &key, WritePriority priority)
+{
+    if (priority == NormalPriority) {
+        m_writePriorities.remove(key);
+    } else {
+        m_writePriorities[key] = priority;
+    }
+}
+
+void SessionDataMap::scheduleWriteBack(const QString &key)
+{
+    const WritePriority priority = m_writePriorities.value(key, NormalPriority);
+    const int delay = m_view->writeBackDelay();
+
+    // Leading edge: nothing got written recently, don't make the first change wait
+    const bool quiet = !m_updateTimer->isActive() && !m_deadlineTimer->isActive()
+        && (!m_lastWriteBack.isValid() || m_lastWriteBack.elapsed() >= delay);
+
+    if (priority == HighPriority || (priority == NormalPriority && quiet)) {
+        writeBack();
+        return;
+    }
+
+    // Trailing edge, but never later than the max latency from the first pending change
+    m_updateTimer->start(delay);
+    if (!m_deadlineTimer->isActive()) {
+        m_deadlineTimer->start(qMax(delay, m_view->writeBackMaxLatency()));
+    }
+}
+
+void SessionDataMap::writeBack()
+{
+    m_updateTimer->stop();
+    m_deadlineTimer->stop();
+
+    if (m_propertiesToUpdate.isEmpty() && m_propertiesToDelete.isEmpty()) {
+        return;
+    }
+
+    // Sets and deletes go out together, in a single message
+    m_view->writeProperties(m_skillId, m_propertiesToUpdate, m_propertiesToDelete);
+    m_propertiesToUpdate.clear();
+    m_propertiesToDelete.clear();
+    m_lastWriteBack.start();
+}
+
 void SessionDataMap::insertAndNotify(const QString &key, const QVariant &value)
 {
+    const QVariant current = this->value(key);
+    if (m_batchingEnabled && !value.canConvert<SessionDataModel *>() && !childMap(value)
+        && !current.canConvert<SessionDataModel *>() && !childMap(current)) {
+        // Already changed in this interval: coalesce with the next changes
+        if (m_recentlyChangedKeys.contains(key)) {
+            m_pendingValues[key] = value;
+            emit changesPending();
+            return;
+        }
+        m_recentlyChangedKeys.insert(key);
+        emit changesPending();
+    } else {
+        m_pendingValues.remove(key);
+    }
+
     insert(key, value);
     emit valueChanged(key, value);
 }
 
 void SessionDataMap::clearAndNotify(const QString &key)
 {
+    m_pendingValues.remove(key);
+    releaseValue(value(key));
     clear(key);
     emit dataCleared(key);
 }
 
+void SessionDataMap::setBatchingEnabled(bool enabled)
+{
+    if (m_batchingEnabled == enabled) {
+        return;
+    }
+
+    m_batchingEnabled = enabled;
+    for (auto *child : findChildren<SessionDataMap *>(QString(), Qt::FindDirectChildrenOnly)) {
+        child->setBatchingEnabled(enabled);
+    }
+    if (!enabled) {
+        flushPendingChanges();
+        m_recentlyChangedKeys.clear();
+    }
+}
+
+void SessionDataMap::flushPendingChanges()
+{
+    m_recentlyChangedKeys.clear();
+
+    for (auto *child : findChildren<SessionDataMap *>(QString(), Qt::FindDirectChildrenOnly)) {
+        child->flushPendingChanges();
+    }
+
+    if (m_pendingValues.isEmpty()) {
+        return;
+    }
+
+    const QVariantMap pending = m_pendingValues;
+    m_pendingValues.clear();
+
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        insert(it.key(), it.value());
+        emit valueChanged(it.key(), it.value());
+        // what got flushed now counts for the next interval
+        if (m_batchingEnabled) {
+            m_recentlyChangedKeys.insert(it.key());
+        }
+    }
+
+    if (!m_recentlyChangedKeys.isEmpty()) {
+        emit changesPending();
+    }
+}
+
 #include "moc_sessiondatamap.cpp"
@@ -18,18 +18,51 @@
 #pragma once
 
 #include <QQmlPropertyMap>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QSet>
+#include <QElapsedTimer>
 
 class QTimer;
 class AbstractSkillView;
+class SessionDataModel;
 
 class SessionDataMap : public QQmlPropertyMap
 {
     Q_OBJECT
 
 public:
+    /**
+     * How eagerly changes done from the client side to a key are written back to the server
+     */
+    enum WritePriority {
+        LowPriority,    // only sent when writes settle or at the max latency deadline
+        NormalPriority, // the first write after a quiet period goes out immediately, then as LowPriority
+        HighPriority    // sends immediately, together with everything pending
+    };
+    Q_ENUM(WritePriority)
+
     SessionDataMap(const QString &skillId, AbstractSkillView *parent);
     ~SessionDataMap() override;
 
+    /**
+     * Sets the write back priority of key, NormalPriority by default
+     */
+    Q_INVOKABLE void setWritePriority(const QString &key, WritePriority priority);
+
+    /**
+     * Sets key to a value of the gui protocol. Objects become child maps and
+     * lists of objects models, converted once and updated in place by the
+     * next values: QML reads them as they are, without converting anything.
+     * @param listKey for lists, the key used to match rows between updates
+     */
+    void setJsonValue(const QString &key, const QJsonValue &value, const QString &listKey = QString());
+
+    /**
+     * The value of key as JSON, child maps and models included
+     */
+    QJsonValue jsonValue(const QString &key) const;
+
     /**
      * Like insert, but will emit the valueChanged() signal
      */
@@ -40,20 +73,64 @@ public:
      */
     void clearAndNotify(const QString &key);
 
+    /**
+     * When batching is enabled, a key changed more than once within the
+     * same batch interval only gets its last value applied, at the next
+     * flushPendingChanges(). The first change of a key is always applied
+     * immediately. Models, child maps and the values replacing them are
+     * never delayed.
+     */
+    void setBatchingEnabled(bool enabled);
+
+    /**
+     * Applies the changes delayed by batching, emitting valueChanged() for them
+     */
+    void flushPendingChanges();
+
 Q_SIGNALS:
     /**
      * Key has been removed fro the map
      */
     void dataCleared(const QString &key);
 
+    /**
+     * A batch interval is in progress, flushPendingChanges() should be called at its end
+     */
+    void changesPending();
+
 protected:
     QVariant updateValue(const QString &key, const QVariant &input) override;
 
 private:
+    void scheduleWriteBack(const QString &key);
+    void writeBack();
+    // A child map for the object under key of parentMap
+    SessionDataMap(SessionDataMap *parentMap, const QString &key);
+
+    static SessionDataMap *childMap(const QVariant &value);
+    void assignJson(const QJsonObject &object);
+    QJsonObject toJson() const;
+    // The client changed the value of a child map, written back as a whole
+    void writeChild(const QString &key, const QJsonObject &object);
+    void releaseValue(const QVariant &value);
+
     QString m_skillId;
     QVariantMap m_propertiesToUpdate;
     QStringList m_propertiesToDelete;
+    QHash<QString, WritePriority> m_writePriorities;
+    // trailing edge: restarted on every write
     QTimer *m_updateTimer;
+    // max latency: started by the first pending write, never restarted
+    QTimer *m_deadlineTimer;
+    QElapsedTimer m_lastWriteBack;
     AbstractSkillView *m_view;
+    // Set for child maps, see setJsonValue()
+    SessionDataMap *m_parentMap = nullptr;
+    QString m_parentKey;
+
+    // batching of the values coming from the server
+    QVariantMap m_pendingValues;
+    QSet<QString> m_recentlyChangedKeys;
+    bool m_batchingEnabled = false;
 };
 
@@ -16,8 +16,54 @@
  */
 
 #include "sessiondatamodel.h"
+#include "skillmemory.h"
 
 #include <QDebug>
+#include <QJsonObject>
+
+#include <algorithm>
+
+namespace {
+
+// The rows of the old order not placed yet, counted with a Fenwick tree
+class PendingRows
+{
+public:
+    explicit PendingRows(int count)
+        : m_tree(count + 1, 0)
+    {
+        for (int row = 0; row < count; ++row) {
+            add(row, 1);
+        }
+    }
+
+    // Pending rows before row
+    int before(int row) const
+    {
+        int count = 0;
+        for (int i = row; i > 0; i -= i & -i) {
+            count += m_tree[i];
+        }
+        return count;
+    }
+
+    void take(int row)
+    {
+        add(row, -1);
+    }
+
+private:
+    void add(int row, int delta)
+    {
+        for (int i = row + 1; i < m_tree.count(); i += i & -i) {
+            m_tree[i] += delta;
+        }
+    }
+
+    QVector<int> m_tree;
+};
+
+}
 
 SessionDataModel::SessionDataModel(QObject *parent)
     : QAbstractListModel(parent)
@@ -29,6 +75,54 @@ SessionDataModel::~SessionDataModel()
     //TODO: delete everything
 }
 
+QList<QVariantMap> SessionDataModel::rowsFromJson(const QJsonArray &array)
+{
+    QList<QVariantMap> rows;
+    rows.reserve(array.size());
+
+    for (const QJsonValue &item : array) {
+        if (!item.isObject()) {
+            qWarning() << "Error: Array data structure corrupted: " << array;
+            return QList<QVariantMap>();
+        }
+
+        // Both keep their keys sorted: append in order
+        const QJsonObject object = item.toObject();
+        QVariantMap row;
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            row.insert(row.constEnd(), it.key(), it.value().toVariant());
+        }
+
+        if (!rows.isEmpty()) {
+            const QVariantMap &first = rows.first();
+            if (first.size() != row.size() || !std::equal(first.keyBegin(), first.keyEnd(), row.keyBegin())) {
+                qWarning() << "WARNING: Item with a wrong set of roles encountered, some roles will be inaccessible from QML, expected: " << first.keys() << "Encountered: " << row.keys();
+            }
+        }
+        rows << row;
+    }
+
+    return rows;
+}
+
+int SessionDataModel::columnForRole(int role) const
+{
+    const int column = role - Qt::UserRole - 1;
+    if (column < 0 || column >= m_keys.count()) {
+        return -1;
+    }
+    return column;
+}
+
+SessionDataModel::Row SessionDataModel::rowFromMap(const QVariantMap &values) const
+{
+    Row row(m_keys.count());
+    for (int column = 0; column < m_keys.count(); ++column) {
+        row[column] = values.value(m_keys[column]);
+    }
+    return row;
+}
+
 void SessionDataModel::insertData(int position, const QList<QVariantMap> &dataList)
 {
     if (position < 0 || position > m_data.count()) {
@@ -44,14 +138,18 @@ void SessionDataModel::insertData(int position, const QList<QVariantMap> &dataLi
         int role = Qt::UserRole + 1;
         for (const auto &key : dataList.first().keys()) {
             m_roles[role] = key.toUtf8();
+            m_columns[key] = m_keys.count();
+            m_keys << key;
             ++role;
         }
     }
 
+    prepareStructuralChange();
     beginInsertRows(QModelIndex(), position, position + dataList.count() - 1);
+    m_data.insert(position, dataList.count(), Row());
     int i = 0;
     for (const auto &item : dataList) {
-        m_data.insert(position + i, item);
+        m_data[position + i] = rowFromMap(item);
         ++i;
     }
     endInsertRows();
@@ -71,18 +169,251 @@ void SessionDataModel::updateData(int position, const QList<QVariantMap> &dataLi
 
     int i = 0;
     for (auto it = m_data.begin() + position; it < m_data.begin() + position + dataList.count(); ++it) {
-        const QVariantMap newValues = dataList[i];
-        for (auto newIt = newValues.begin(); newIt != newValues.end(); ++newIt) {
-            (*it)[newIt.key()] = newIt.value();
-            roles.insert(m_roles.key(newIt.key().toUtf8()));
+        const QVariantMap &newValues = dataList[i];
+        for (auto newIt = newValues.constBegin(); newIt != newValues.constEnd(); ++newIt) {
+            const int column = m_columns.value(newIt.key(), -1);
+            // keys unknown at the first insert are ignored
+            if (column < 0) {
+                continue;
+            }
+            (*it)[column] = newIt.value();
+            roles.insert(Qt::UserRole + 1 + column);
         }
         ++i;
     }
-    emit dataChanged(index(position, 0), index(position + dataList.length() - 1, 0), roles.values().toVector());
+    notifyDataChanged(position, position + dataList.length() - 1, roles.values().toVector());
+}
+
+QVector<int> SessionDataModel::replaceRow(int row, const QVariantMap &newValues)
+{
+    QVector<int> changedRoles;
+    Row values = rowFromMap(newValues);
+    Row &oldValues = m_data[row];
+
+    for (int column = 0; column < values.count(); ++column) {
+        if (oldValues[column] != values[column]) {
+            changedRoles << Qt::UserRole + 1 + column;
+        }
+    }
+
+    oldValues.swap(values);
+    return changedRoles;
+}
+
+void SessionDataModel::replaceData(const QList<QVariantMap> &dataList, const QString &keyRole)
+{
+    if (m_data.isEmpty()) {
+        insertData(0, dataList);
+        return;
+    }
+
+    if (dataList.isEmpty()) {
+        removeRows(0, m_data.count());
+        return;
+    }
+
+    // Consecutive changed rows get notified with a single dataChanged
+    int changedFirst = -1;
+    int changedLast = -1;
+    QSet<int> changedRoles;
+    auto flushChanged = [&]() {
+        if (changedFirst >= 0) {
+            notifyDataChanged(changedFirst, changedLast, changedRoles.values().toVector());
+        }
+        changedFirst = changedLast = -1;
+        changedRoles.clear();
+    };
+    auto rowChanged = [&](int row, const QVector<int> &roles) {
+        if (roles.isEmpty()) {
+            flushChanged();
+            return;
+        }
+        if (changedFirst >= 0 && changedLast != row - 1) {
+            flushChanged();
+        }
+        if (changedFirst < 0) {
+            changedFirst = row;
+        }
+        changedLast = row;
+        for (int role : roles) {
+            changedRoles.insert(role);
+        }
+    };
+
+    const int keyColumn = m_columns.value(keyRole, -1);
+    if (!keyRole.isEmpty() && keyColumn < 0) {
+        qWarning() << "Unknown key role" << keyRole << "comparing rows by position";
+    }
+
+    if (keyColumn < 0) {
+        const int common = qMin(m_data.count(), dataList.count());
+        for (int i = 0; i < common; ++i) {
+            rowChanged(i, replaceRow(i, dataList[i]));
+        }
+        flushChanged();
+
+        if (dataList.count() > common) {
+            insertData(common, dataList.mid(common));
+        } else if (m_data.count() > common) {
+            removeRows(common, m_data.count() - common);
+        }
+        return;
+    }
+
+    // Drop the rows whose key is not present anymore, one signal per contiguous range
+    QSet<QString> newKeys;
+    for (const auto &item : dataList) {
+        newKeys.insert(item.value(keyRole).toString());
+    }
+
+    for (int row = m_data.count() - 1; row >= 0;) {
+        if (newKeys.contains(m_data[row][keyColumn].toString())) {
+            --row;
+            continue;
+        }
+        int first = row;
+        while (first > 0 && !newKeys.contains(m_data[first - 1][keyColumn].toString())) {
+            --first;
+        }
+        removeRows(first, row - first + 1);
+        row = first - 1;
+    }
+
+    // The rows before i are placed, the ones after are the pending old rows in
+    // their old order: the current row of an old one is i + the pending ones before it
+    QHash<QString, QVector<int>> oldRows;
+    for (int row = 0; row < m_data.count(); ++row) {
+        oldRows[m_data[row][keyColumn].toString()] << row;
+    }
+    PendingRows pending(m_data.count());
+
+    // Walk the new order: every position either already has the right row,
+    // gets it moved from further down, or gets a brand new row inserted
+    for (int i = 0; i < dataList.count(); ++i) {
+        const QString key = dataList[i].value(keyRole).toString();
+
+        auto it = oldRows.find(key);
+        if (it == oldRows.end() || it->isEmpty()) {
+            flushChanged();
+            insertData(i, QList<QVariantMap>() << dataList[i]);
+            continue;
+        }
+
+        const int oldRow = it->takeFirst();
+        const int found = i + pending.before(oldRow);
+        pending.take(oldRow);
+
+        if (found > i) {
+            flushChanged();
+            prepareStructuralChange();
+            beginMoveRows(QModelIndex(), found, found, QModelIndex(), i);
+            m_data.move(found, i);
+            endMoveRows();
+        }
+
+        rowChanged(i, replaceRow(i, dataList[i]));
+    }
+    flushChanged();
+
+    // Leftovers, only in case of duplicated keys
+    if (m_data.count() > dataList.count()) {
+        removeRows(dataList.count(), m_data.count() - dataList.count());
+    }
+}
+
+void SessionDataModel::setBatchingEnabled(bool enabled)
+{
+    if (m_batchingEnabled == enabled) {
+        return;
+    }
+
+    m_batchingEnabled = enabled;
+    if (!enabled) {
+        flushPendingChanges();
+        m_recentlyChangedRows.clear();
+    }
+}
+
+void SessionDataModel::flushPendingChanges()
+{
+    m_recentlyChangedRows.clear();
+
+    if (m_pendingChanges.isEmpty()) {
+        return;
+    }
+
+    const QMap<int, QSet<int>> pending = m_pendingChanges;
+    m_pendingChanges.clear();
+
+    // Merge consecutive rows in a single range, with the union of their roles
+    auto it = pending.constBegin();
+    while (it != pending.constEnd()) {
+        const int first = it.key();
+        int last = first;
+        QSet<int> roles = it.value();
+        for (++it; it != pending.constEnd() && it.key() == last + 1; ++it) {
+            last = it.key();
+            roles.unite(it.value());
+        }
+
+        emit dataChanged(index(first, 0), index(last, 0), roles.values().toVector());
+        if (m_batchingEnabled) {
+            for (int row = first; row <= last; ++row) {
+                m_recentlyChangedRows.insert(row);
+            }
+        }
+    }
+
+    if (!m_recentlyChangedRows.isEmpty()) {
+        emit changesPending();
+    }
+}
+
+void SessionDataModel::notifyDataChanged(int first, int last, const QVector<int> &roles)
+{
+    if (!m_batchingEnabled) {
+        emit dataChanged(index(first, 0), index(last, 0), roles);
+        return;
+    }
+
+    bool recent = false;
+    for (int row = first; row <= last && !recent; ++row) {
+        recent = m_recentlyChangedRows.contains(row);
+    }
+
+    // Rows already notified in this interval wait for the next flush
+    if (recent) {
+        for (int row = first; row <= last; ++row) {
+            QSet<int> &pendingRoles = m_pendingChanges[row];
+            for (int role : roles) {
+                pendingRoles.insert(role);
+            }
+        }
+    } else {
+        for (int row = first; row <= last; ++row) {
+            m_recentlyChangedRows.insert(row);
+        }
+        emit dataChanged(index(first, 0), index(last, 0), roles);
+    }
+
+    emit changesPending();
+}
+
+void SessionDataModel::prepareStructuralChange()
+{
+    // Row numbers are about to change: pending notifications go out with the current ones
+    if (!m_pendingChanges.isEmpty()) {
+        const bool batching = m_batchingEnabled;
+        m_batchingEnabled = false;
+        flushPendingChanges();
+        m_batchingEnabled = batching;
+    }
+    m_recentlyChangedRows.clear();
 }
 
 void SessionDataModel::clear()
 {
+    prepareStructuralChange();
     beginResetModel();
     m_data.clear();
     endResetModel();
@@ -100,6 +431,7 @@ bool SessionDataModel::moveRows(const QModelIndex &sourceParent, int sourceRow,
     }
     const int sourceLast = sourceRow + count - 1;
 
+    prepareStructuralChange();
     //beginMoveRows wants indexes before the source rows are removed from the old order
     if (!beginMoveRows(sourceParent, sourceRow, sourceLast, destinationParent, destinationChild)) {
         return false;
@@ -125,6 +457,7 @@ bool SessionDataModel::removeRows(int row, int count, const QModelIndex &parent)
         return false;
     }
 
+    prepareStructuralChange();
     beginRemoveRows(parent, row, row + count - 1);
 
     m_data.erase(m_data.begin() + row, m_data.begin() + row + count);
@@ -133,6 +466,38 @@ bool SessionDataModel::removeRows(int row, int count, const QModelIndex &parent)
 }
 
 
+QList<QVariantMap> SessionDataModel::rows() const
+{
+    QList<QVariantMap> rows;
+    rows.reserve(m_data.count());
+
+    for (const Row &row : m_data) {
+        QVariantMap values;
+        for (int column = 0; column < row.count() && column < m_keys.count(); ++column) {
+            values[m_keys[column]] = row[column];
+        }
+        rows << values;
+    }
+
+    return rows;
+}
+
+qint64 SessionDataModel::estimatedBytes() const
+{
+    qint64 size = 0;
+    for (const QString &key : m_keys) {
+        size += key.size() * 2;
+    }
+
+    for (const Row &row : m_data) {
+        for (const QVariant &value : row) {
+            size += SkillMemoryUsage::variantSize(value);
+        }
+    }
+
+    return size;
+}
+
 int SessionDataModel::rowCount(const QModelIndex &parent) const
 {
     if (parent.isValid()) {
@@ -148,11 +513,13 @@ QVariant SessionDataModel::data(const QModelIndex &index, int role) const
     }
     const int row = index.row();
 
-    if (row < 0 || row >= m_data.count() || !m_roles.contains(role)) {
+    const int column = columnForRole(role);
+
+    if (row < 0 || row >= m_data.count() || column < 0) {
         return QVariant();
     }
 
-    return m_data[row][QString::fromUtf8(m_roles[role])];
+    return m_data[row][column];
 }
 
 QHash<int, QByteArray> SessionDataModel::roleNames() const
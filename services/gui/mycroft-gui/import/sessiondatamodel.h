@@ -18,6 +18,8 @@
 #pragma once
 
 #include <QAbstractListModel>
+#include <QJsonArray>
+#include <QSet>
 
 class AbstractDelegate;
 class DelegatesModel;
@@ -31,6 +33,12 @@ public:
     explicit SessionDataModel(QObject *parent = nullptr);
     virtual ~SessionDataModel();
 
+    /**
+     * The rows of a list of objects of the gui protocol
+     * @returns an empty list if array is not a list of objects
+     */
+    static QList<QVariantMap> rowsFromJson(const QJsonArray &array);
+
     /**
      * Insert new data in the model, at a given position
      */
@@ -43,11 +51,44 @@ public:
      */
     void updateData(int position, const QList<QVariantMap> &dataList);
 
+    /**
+     * Replaces the whole content of the model with dataList, emitting only
+     * the minimal set of dataChanged, insert, remove and move signals
+     * instead of a model reset.
+     * If keyRole is empty rows are compared by position, otherwise rows
+     * are matched by the value of keyRole (compared as string), so reordered
+     * rows get moved.
+     */
+    void replaceData(const QList<QVariantMap> &dataList, const QString &keyRole = QString());
+
     /**
      * clears the whole model
      */
     void clear();
 
+    /**
+     * @returns the content of the model, one map per row
+     */
+    QList<QVariantMap> rows() const;
+
+    /**
+     * Approximate bytes held by the rows, @see SkillMemoryUsage
+     */
+    qint64 estimatedBytes() const;
+
+    /**
+     * When batching is enabled, rows whose data changes more than once within
+     * the same batch interval get a single merged dataChanged() at the next
+     * flushPendingChanges(). The first change of a row is notified immediately,
+     * inserts, moves and removals are never delayed.
+     */
+    void setBatchingEnabled(bool enabled);
+
+    /**
+     * Emits the dataChanged() delayed by batching, merging consecutive rows
+     */
+    void flushPendingChanges();
+
 //REIMPLEMENTED
     bool moveRows(const QModelIndex &sourceParent, int sourceRow, int count, const QModelIndex &destinationParent, int destinationChild) override;
     bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
@@ -55,9 +96,38 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::UserRole + 1) const override;
     QHash<int, QByteArray> roleNames() const override;
 
+Q_SIGNALS:
+    /**
+     * A batch interval is in progress, flushPendingChanges() should be called at its end
+     */
+    void changesPending();
+
 private:
+    // One value per role, in the column order established by the first insert
+    typedef QVector<QVariant> Row;
+
+    int columnForRole(int role) const;
+    Row rowFromMap(const QVariantMap &values) const;
+
+    /**
+     * Sets the values of row to newValues
+     * @returns the roles whose value actually changed
+     */
+    QVector<int> replaceRow(int row, const QVariantMap &newValues);
+
+    void notifyDataChanged(int first, int last, const QVector<int> &roles);
+    void prepareStructuralChange();
+
     QHash<int, QByteArray> m_roles;
-    QList<QVariantMap> m_data;
+    // column -> key and key -> column, role is always Qt::UserRole + 1 + column
+    QStringList m_keys;
+    QHash<QString, int> m_columns;
+    QVector<Row> m_data;
+
+    // row -> roles of the changes waiting for the next flush
+    QMap<int, QSet<int>> m_pendingChanges;
+    QSet<int> m_recentlyChangedRows;
+    bool m_batchingEnabled = false;
 };
 
 
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "sessionsnapshot.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QVariantList>
+
+static const quint32 s_snapshotMagic = 0x4d534e50; // "MSNP"
+static const quint32 s_snapshotVersion = 1;
+
+// Writes of the same snapshot must not overlap
+static QMutex s_writeMutex;
+
+namespace {
+
+class SnapshotWriter : public QRunnable
+{
+public:
+    SnapshotWriter(const QString &path, const QByteArray &data)
+        : m_path(path),
+          m_data(data)
+    {}
+
+    void run() override
+    {
+        SessionSnapshot::writeFile(m_path, m_data);
+    }
+
+private:
+    QString m_path;
+    QByteArray m_data;
+};
+
+}
+
+QString SessionSnapshot::defaultPath(const QString &name)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + QStringLiteral("/snapshots/") + name + QStringLiteral(".snapshot");
+}
+
+QByteArray SessionSnapshot::serialize(const QList<QJsonObject> &messages)
+{
+    QVariantList list;
+    list.reserve(messages.count());
+    for (const QJsonObject &message : messages) {
+        list << message.toVariantMap();
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_9);
+    stream << s_snapshotMagic << s_snapshotVersion << list;
+
+    return data;
+}
+
+bool SessionSnapshot::writeFile(const QString &path, const QByteArray &data)
+{
+    QMutexLocker locker(&s_writeMutex);
+
+    if (!QDir().mkpath(QFileInfo(path).path())) {
+        qWarning() << "Could not create the directory of the session snapshot" << path;
+        return false;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write the session snapshot" << path << file.errorString();
+        return false;
+    }
+
+    file.write(data);
+    if (!file.commit()) {
+        qWarning() << "Could not write the session snapshot" << path << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void SessionSnapshot::writeFileAsync(const QString &path, const QByteArray &data)
+{
+    QThreadPool::globalInstance()->start(new SnapshotWriter(path, data));
+}
+
+QList<QJsonObject> SessionSnapshot::read(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    // Mapped: the pages of the file are read only as the stream needs them
+    const qint64 size = file.size();
+    uchar *mapped = file.map(0, size);
+    if (!mapped) {
+        qWarning() << "Could not map the session snapshot" << path << file.errorString();
+        return {};
+    }
+
+    const QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), int(size));
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_9);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    QVariantList list;
+    stream >> magic >> version;
+    if (magic != s_snapshotMagic || version != s_snapshotVersion) {
+        qWarning() << "Ignoring the session snapshot" << path << "of an unknown format";
+        return {};
+    }
+
+    stream >> list;
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Ignoring the corrupted session snapshot" << path;
+        return {};
+    }
+
+    QList<QJsonObject> messages;
+    messages.reserve(list.count());
+    for (const QVariant &message : list) {
+        messages << QJsonObject::fromVariantMap(message.toMap());
+    }
+
+    return messages;
+}
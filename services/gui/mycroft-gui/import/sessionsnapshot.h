@@ -0,0 +1,60 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+/**
+ * On disk copy of what a view shows: active skills, their pages and session
+ * data. Written now and then, it is restored at startup so that the last
+ * screen comes back before the server is reachable.
+ *
+ * The snapshot is the list of gui messages rebuilding the state, in a
+ * compact QDataStream encoding after a magic and a version; it is read back
+ * through a memory mapping of the file.
+ */
+class SessionSnapshot
+{
+public:
+    /**
+     * @returns where the snapshot named name is kept, in the cache directory
+     */
+    static QString defaultPath(const QString &name);
+
+    static QByteArray serialize(const QList<QJsonObject> &messages);
+
+    /**
+     * Replaces the file at path with data atomically, in the calling thread
+     * @returns false, with a warning, on failure
+     */
+    static bool writeFile(const QString &path, const QByteArray &data);
+
+    /**
+     * Like writeFile, but on the global thread pool
+     */
+    static void writeFileAsync(const QString &path, const QByteArray &data);
+
+    /**
+     * @returns the messages of the snapshot at path, none if it's missing
+     * or invalid
+     */
+    static QList<QJsonObject> read(const QString &path);
+};
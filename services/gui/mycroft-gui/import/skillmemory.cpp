@@ -0,0 +1,127 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "skillmemory.h"
+#include "sessiondatamodel.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMetaProperty>
+#include <QSize>
+
+// Rough size of a QObject with its private data, or of a QQuickItem
+static const qint64 s_objectSize = 256;
+// Of a QVariant or a QJsonValue that holds no heap data
+static const qint64 s_valueSize = 16;
+
+qint64 SkillMemoryUsage::total() const
+{
+    return sessionBytes + modelBytes + delegateBytes + pooledBytes;
+}
+
+QVariantMap SkillMemoryUsage::toVariantMap() const
+{
+    return QVariantMap({{QStringLiteral("session_bytes"), sessionBytes},
+                        {QStringLiteral("model_bytes"), modelBytes},
+                        {QStringLiteral("delegate_bytes"), delegateBytes},
+                        {QStringLiteral("pooled_bytes"), pooledBytes},
+                        {QStringLiteral("total_bytes"), total()}});
+}
+
+qint64 SkillMemoryUsage::variantSize(const QVariant &value)
+{
+    switch (value.userType()) {
+    case QMetaType::QString:
+        return s_valueSize + value.toString().size() * 2;
+    case QMetaType::QByteArray:
+        return s_valueSize + value.toByteArray().size();
+    case QMetaType::QVariantList: {
+        qint64 size = s_valueSize;
+        for (const QVariant &item : value.toList()) {
+            size += variantSize(item);
+        }
+        return size;
+    }
+    case QMetaType::QVariantMap: {
+        const QVariantMap map = value.toMap();
+        qint64 size = s_valueSize;
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+            size += it.key().size() * 2 + variantSize(it.value());
+        }
+        return size;
+    }
+    case QMetaType::QJsonObject:
+        return jsonSize(value.toJsonObject());
+    case QMetaType::QJsonArray:
+        return jsonSize(value.toJsonArray());
+    case QMetaType::QJsonValue:
+        return jsonSize(value.toJsonValue());
+    default:
+        // Models are accounted on their own
+        return value.canConvert<SessionDataModel *>() ? 0 : s_valueSize;
+    }
+}
+
+qint64 SkillMemoryUsage::jsonSize(const QJsonValue &value)
+{
+    switch (value.type()) {
+    case QJsonValue::String:
+        return s_valueSize + value.toString().size() * 2;
+    case QJsonValue::Array: {
+        qint64 size = s_valueSize;
+        for (const QJsonValue &item : value.toArray()) {
+            size += jsonSize(item);
+        }
+        return size;
+    }
+    case QJsonValue::Object: {
+        const QJsonObject object = value.toObject();
+        qint64 size = s_valueSize;
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            size += it.key().size() * 2 + jsonSize(it.value());
+        }
+        return size;
+    }
+    default:
+        return s_valueSize;
+    }
+}
+
+qint64 SkillMemoryUsage::itemTreeSize(QObject *root)
+{
+    if (!root) {
+        return 0;
+    }
+
+    qint64 size = s_objectSize;
+
+    // Image, AnimatedImage, BorderImage and friends: the decoded pixels
+    const QMetaObject *mo = root->metaObject();
+    const int sourceSizeIndex = mo->indexOfProperty("sourceSize");
+    if (sourceSizeIndex >= 0 && mo->indexOfProperty("source") >= 0) {
+        const QSize sourceSize = mo->property(sourceSizeIndex).read(root).toSize();
+        if (sourceSize.isValid()) {
+            size += qint64(sourceSize.width()) * sourceSize.height() * 4;
+        }
+    }
+
+    for (QObject *child : root->children()) {
+        size += itemTreeSize(child);
+    }
+
+    return size;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QJsonValue>
+#include <QVariantMap>
+
+class QObject;
+
+/**
+ * Approximate bytes a skill holds in the GUI, for GuiMetrics and for
+ * AbstractSkillView::memoryBudget. These are estimates of the payload, not
+ * of the allocations: good enough to compare skills and to see growth.
+ */
+struct SkillMemoryUsage
+{
+    // Values of its SessionDataMap that aren't list models
+    qint64 sessionBytes = 0;
+    // Its SessionDataModels, nested models included
+    qint64 modelBytes = 0;
+    // Item trees of its pages
+    qint64 delegateBytes = 0;
+    // Item trees of its delegates waiting in the recycling pool
+    qint64 pooledBytes = 0;
+
+    qint64 total() const;
+
+    /**
+     * @returns session_bytes, model_bytes, delegate_bytes, pooled_bytes and total_bytes
+     */
+    QVariantMap toVariantMap() const;
+
+    static qint64 variantSize(const QVariant &value);
+    static qint64 jsonSize(const QJsonValue &value);
+
+    /**
+     * A fixed cost per QObject of the tree, plus the pixels of the
+     * images at their sourceSize
+     */
+    static qint64 itemTreeSize(QObject *root);
+};
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "skilltranslations.h"
+#include "remoteskillassets.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QLocale>
+#include <QRunnable>
+#include <QThreadPool>
+
+namespace {
+
+class CatalogReader : public QRunnable
+{
+public:
+    CatalogReader(SkillTranslations *target, const QString &skillId, const QString &translationsPath,
+                  const QStringList &contexts)
+        : m_target(target),
+          m_skillId(skillId),
+          m_translationsPath(translationsPath),
+          m_contexts(contexts)
+    {}
+
+    void run() override
+    {
+        QTranslator *translator = new QTranslator;
+        if (!translator->load(QLocale(), m_skillId, QStringLiteral("_"), m_translationsPath)) {
+            delete translator;
+            translator = nullptr;
+        } else {
+            translator->moveToThread(QCoreApplication::instance()->thread());
+        }
+
+        // The translation contexts of QML files are their names
+        QStringList contexts = m_contexts;
+        if (translator && contexts.isEmpty()) {
+            QDirIterator it(QFileInfo(m_translationsPath).path(), {QStringLiteral("*.qml")},
+                            QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                it.next();
+                contexts << it.fileInfo().completeBaseName();
+            }
+        }
+
+        QMetaObject::invokeMethod(m_target, "catalogRead", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_skillId),
+                                  Q_ARG(QTranslator *, translator),
+                                  Q_ARG(QStringList, contexts));
+    }
+
+private:
+    SkillTranslations *m_target;
+    QString m_skillId;
+    QString m_translationsPath;
+    // Known already for remote skills, otherwise found next to the catalogs
+    QStringList m_contexts;
+};
+
+}
+
+SkillTranslations *SkillTranslations::instance()
+{
+    static SkillTranslations *s_self = nullptr;
+    if (!s_self) {
+        s_self = new SkillTranslations(QCoreApplication::instance());
+        QCoreApplication::installTranslator(s_self);
+    }
+    return s_self;
+}
+
+SkillTranslations::SkillTranslations(QObject *parent)
+    : QTranslator(parent)
+{
+    qRegisterMetaType<QTranslator *>();
+
+    connect(RemoteSkillAssets::instance(), &RemoteSkillAssets::translationsFetched, this,
+            [this](const QString &skillId, const QString &translationsPath, const QStringList &contexts) {
+        if (translationsPath.isEmpty()) {
+            catalogRead(skillId, nullptr, QStringList());
+            return;
+        }
+        read(skillId, translationsPath, contexts);
+    });
+}
+
+SkillTranslations::~SkillTranslations()
+{
+    QCoreApplication::removeTranslator(this);
+    qDeleteAll(m_catalogs);
+}
+
+void SkillTranslations::load(const QString &skillId, const QUrl &translationsUrl)
+{
+    if (m_requested.contains(skillId)) {
+        return;
+    }
+
+    m_requested.insert(skillId);
+    if (RemoteSkillAssets::isRemote(translationsUrl)) {
+        // Continues in read() once downloaded
+        RemoteSkillAssets::instance()->fetch(skillId, translationsUrl.resolved(QUrl(QStringLiteral("."))));
+        return;
+    }
+
+    read(skillId, translationsUrl.path(), QStringList());
+}
+
+void SkillTranslations::read(const QString &skillId, const QString &translationsPath, const QStringList &contexts)
+{
+    QThreadPool::globalInstance()->start(new CatalogReader(this, skillId, translationsPath, contexts));
+}
+
+bool SkillTranslations::isLoaded(const QString &skillId) const
+{
+    return m_catalogs.contains(skillId);
+}
+
+void SkillTranslations::catalogRead(const QString &skillId, QTranslator *translator, const QStringList &contexts)
+{
+    m_catalogs.insert(skillId, translator);
+    if (!translator) {
+        return;
+    }
+
+    {
+        QWriteLocker locker(&m_lock);
+        for (const auto &context : contexts) {
+            QVector<QTranslator *> &catalogs = m_catalogsForContext[context.toUtf8()];
+            if (!catalogs.contains(translator)) {
+                catalogs << translator;
+            }
+        }
+    }
+
+    emit catalogLoaded(skillId);
+}
+
+QString SkillTranslations::translate(const char *context, const char *sourceText,
+                                     const char *disambiguation, int n) const
+{
+    if (!context) {
+        return QString();
+    }
+
+    QReadLocker locker(&m_lock);
+
+    auto it = m_catalogsForContext.constFind(QByteArray::fromRawData(context, int(qstrlen(context))));
+    if (it == m_catalogsForContext.constEnd()) {
+        return QString();
+    }
+
+    // More than one only when skills have QML files with the same name
+    for (const QTranslator *catalog : *it) {
+        const QString translation = catalog->translate(context, sourceText, disambiguation, n);
+        if (!translation.isNull()) {
+            return translation;
+        }
+    }
+
+    return QString();
+}
+
+bool SkillTranslations::isEmpty() const
+{
+    QReadLocker locker(&m_lock);
+    return m_catalogsForContext.isEmpty();
+}
+
+#include "moc_skilltranslations.cpp"
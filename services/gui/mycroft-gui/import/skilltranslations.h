@@ -0,0 +1,81 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QTranslator>
+#include <QUrl>
+#include <QVector>
+
+/**
+ * The translation catalogs of all the skills, behind a single translator
+ * installed in the application, shared by all the views.
+ *
+ * Catalogs are loaded in a worker thread the first time a skill shows a
+ * page and then stay cached. They are not installed themselves: a lookup
+ * goes straight to the catalogs of the skills having a QML file named
+ * after the translation context, so it doesn't depend on how many skills
+ * have been shown.
+ */
+class SkillTranslations : public QTranslator
+{
+    Q_OBJECT
+
+public:
+    static SkillTranslations *instance();
+    ~SkillTranslations() override;
+
+    /**
+     * Starts loading the catalog of skillId for the current locale, from
+     * translationsUrl, the translations directory inside its ui directory.
+     * Catalogs of remote skills are downloaded first, see RemoteSkillAssets.
+     * Does nothing if it's already loaded or loading.
+     */
+    void load(const QString &skillId, const QUrl &translationsUrl);
+
+    bool isLoaded(const QString &skillId) const;
+
+    QString translate(const char *context, const char *sourceText,
+                      const char *disambiguation = nullptr, int n = -1) const override;
+    bool isEmpty() const override;
+
+Q_SIGNALS:
+    /**
+     * The catalog of skillId is available: QML bindings using its strings
+     * have to be retranslated
+     */
+    void catalogLoaded(const QString &skillId);
+
+private:
+    explicit SkillTranslations(QObject *parent = nullptr);
+
+    void read(const QString &skillId, const QString &translationsPath, const QStringList &contexts);
+
+    // Called in the GUI thread by the worker, the translator is nullptr if the skill has no catalog
+    Q_INVOKABLE void catalogRead(const QString &skillId, QTranslator *translator, const QStringList &contexts);
+
+    QSet<QString> m_requested;
+    QHash<QString, QTranslator *> m_catalogs;
+
+    // translate() can be called from any thread
+    mutable QReadWriteLock m_lock;
+    // Catalogs that may know the strings of a QML file, by its name without suffix
+    QHash<QByteArray, QVector<QTranslator *>> m_catalogsForContext;
+};
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QVector>
+
+#include <algorithm>
+#include <atomic>
+
+/**
+ * Lock free ring buffer for exactly one producer thread and one consumer
+ * thread. All the memory is allocated upfront, reading and writing only
+ * copy the items in and out.
+ * Positions grow monotonically and wrap with a mask, so the capacity is
+ * rounded up to a power of two.
+ */
+template<typename T>
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(int capacity)
+    {
+        int size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_data.resize(size);
+        m_mask = size_t(size - 1);
+    }
+
+    int capacity() const
+    {
+        return m_data.size();
+    }
+
+    // Producer side: how many items can be written without blocking
+    int availableWrite() const
+    {
+        return capacity() - int(m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_acquire));
+    }
+
+    // Consumer side: how many items are ready to be read
+    int availableRead() const
+    {
+        return int(m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * Producer side, never overwrites unread items
+     * @returns how many items were actually written
+     */
+    int write(const T *items, int count)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        count = std::min(count, availableWrite());
+
+        const int offset = int(head & m_mask);
+        const int first = std::min(count, capacity() - offset);
+        T *data = m_data.data();
+        std::copy(items, items + first, data + offset);
+        std::copy(items + first, items + count, data);
+
+        m_head.store(head + size_t(count), std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * Consumer side
+     * @returns how many items were actually read
+     */
+    int read(T *items, int count)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        count = std::min(count, availableRead());
+
+        const int offset = int(tail & m_mask);
+        const int first = std::min(count, capacity() - offset);
+        const T *data = m_data.constData();
+        std::copy(data + offset, data + offset + first, items);
+        std::copy(data, data + (count - first), items + first);
+
+        m_tail.store(tail + size_t(count), std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * Consumer side, drops the oldest items without reading them
+     * @returns how many items were dropped
+     */
+    int skip(int count)
+    {
+        count = std::min(count, availableRead());
+        m_tail.fetch_add(size_t(count), std::memory_order_release);
+        return count;
+    }
+
+private:
+    QVector<T> m_data;
+    size_t m_mask = 0;
+    // Written only by the producer
+    std::atomic<size_t> m_head{0};
+    // Written only by the consumer
+    std::atomic<size_t> m_tail{0};
+};
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "startuptracer.h"
+#include "mycroftcontroller.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QQuickWindow>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+static const char s_traceVariable[] = "MYCROFT_GUI_STARTUP_TRACE";
+
+// The last phase, the trace is complete
+static const QString s_firstFrame = QStringLiteral("first_frame_swapped");
+
+static qint64 now()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef Q_OS_LINUX
+// When the process was started: field 22 of /proc/self/stat, in clock ticks
+// since boot. The monotonic clock also counts from boot if it never slept.
+static qint64 processStart()
+{
+    QFile stat(QStringLiteral("/proc/self/stat"));
+    if (!stat.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    // The command name, second field, may contain spaces: count after it
+    const QByteArray line = stat.readAll();
+    const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    if (fields.count() < 20) {
+        return -1;
+    }
+
+    bool ok = false;
+    const qint64 ticks = fields[19].toLongLong(&ok);
+    const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    if (!ok || ticksPerSecond <= 0) {
+        return -1;
+    }
+
+    return ticks * 1000000 / ticksPerSecond;
+}
+#endif
+
+bool StartupTracer::isEnabled()
+{
+    static const bool enabled = qEnvironmentVariableIsSet(s_traceVariable);
+    return enabled;
+}
+
+StartupTracer *StartupTracer::instance()
+{
+    static StartupTracer *s_self = nullptr;
+    if (!s_self) {
+        s_self = new StartupTracer(QCoreApplication::instance());
+    }
+    return s_self;
+}
+
+StartupTracer::StartupTracer(QObject *parent)
+    : QObject(parent)
+{
+#ifdef Q_OS_LINUX
+    const qint64 start = processStart();
+    if (start >= 0) {
+        m_phases << Phase{QStringLiteral("process_start"), start};
+    }
+#endif
+
+    MycroftController::instance()->subscribe({QStringLiteral("mycroft.gui.startup_trace")}, this,
+        [](const QString &, const QVariantMap &) {
+            MycroftController::instance()->sendRequest(QStringLiteral("mycroft.gui.startup_trace.response"),
+                                                       chromeTrace().toVariantMap());
+        });
+}
+
+void StartupTracer::mark(const QString &phase)
+{
+    if (isEnabled()) {
+        instance()->record(phase);
+    }
+}
+
+void StartupTracer::markNextFrame(QQuickWindow *window, const QString &phase)
+{
+    if (!isEnabled() || !window) {
+        return;
+    }
+
+    // One shot: the connection is dropped after the first frame. frameSwapped
+    // may come from the render thread, the phase is recorded once queued back
+    StartupTracer *tracer = instance();
+    if (tracer->m_written) {
+        return;
+    }
+
+    auto connection = std::make_shared<QMetaObject::Connection>();
+    *connection = connect(window, &QQuickWindow::frameSwapped, tracer, [tracer, connection, phase]() {
+        QObject::disconnect(*connection);
+        tracer->record(phase);
+    });
+    window->update();
+}
+
+void StartupTracer::record(const QString &phase)
+{
+    for (const Phase &p : m_phases) {
+        if (p.name == phase) {
+            return;
+        }
+    }
+
+    m_phases << Phase{phase, now()};
+
+    if (phase == s_firstFrame) {
+        writeTrace();
+    }
+}
+
+QJsonObject StartupTracer::chromeTrace()
+{
+    QVector<Phase> phases;
+    if (isEnabled()) {
+        phases = instance()->m_phases;
+    }
+
+    // Phases recorded by the application before the plugin was loaded
+    const QVariantList appPhases = QCoreApplication::instance()->property("mycroftStartupPhases").toList();
+    for (const QVariant &p : appPhases) {
+        const QVariantMap phase = p.toMap();
+        phases << Phase{phase.value(QStringLiteral("name")).toString(), phase.value(QStringLiteral("ts")).toLongLong()};
+    }
+
+    std::stable_sort(phases.begin(), phases.end(), [](const Phase &a, const Phase &b) {
+        return a.timestamp < b.timestamp;
+    });
+
+    // Every phase is a span from the previous one, so the critical path reads as a timeline
+    QJsonArray events;
+    const qint64 pid = QCoreApplication::applicationPid();
+    for (int i = 0; i < phases.count(); ++i) {
+        const Phase &phase = phases[i];
+        const qint64 begin = i > 0 ? phases[i - 1].timestamp : phase.timestamp;
+        events.append(QJsonObject({{QStringLiteral("name"), phase.name},
+                                   {QStringLiteral("cat"), QStringLiteral("startup")},
+                                   {QStringLiteral("ph"), QStringLiteral("X")},
+                                   {QStringLiteral("ts"), double(begin)},
+                                   {QStringLiteral("dur"), double(phase.timestamp - begin)},
+                                   {QStringLiteral("pid"), double(pid)},
+                                   {QStringLiteral("tid"), 0},
+                                   {QStringLiteral("args"), QJsonObject({{QStringLiteral("since_start_ms"),
+                                        (phase.timestamp - phases.first().timestamp) / 1000.0}})}}));
+    }
+
+    return QJsonObject({{QStringLiteral("traceEvents"), events},
+                        {QStringLiteral("displayTimeUnit"), QStringLiteral("ms")}});
+}
+
+void StartupTracer::writeTrace()
+{
+    if (m_written) {
+        return;
+    }
+    m_written = true;
+
+    const QJsonObject trace = chromeTrace();
+    for (const QJsonValue &event : trace.value(QStringLiteral("traceEvents")).toArray()) {
+        const QJsonObject e = event.toObject();
+        qInfo().noquote() << QStringLiteral("Startup: %1 at %2 ms")
+            .arg(e.value(QStringLiteral("name")).toString())
+            .arg(e.value(QStringLiteral("args")).toObject().value(QStringLiteral("since_start_ms")).toDouble(), 0, 'f', 1);
+    }
+
+    const QString path = QString::fromLocal8Bit(qgetenv(s_traceVariable));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Could not write the startup trace" << path << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(trace).toJson());
+}
+
+#include "moc_startuptracer.cpp"
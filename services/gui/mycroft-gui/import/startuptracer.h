@@ -0,0 +1,75 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QJsonObject>
+#include <QVector>
+
+class QQuickWindow;
+
+/**
+ * Records when the phases of the startup are reached, from the start of the
+ * process to the first frame showing a skill, on the monotonic clock.
+ *
+ * Only enabled when the MYCROFT_GUI_STARTUP_TRACE environment variable is
+ * set: after the first frame the trace is written, in the Chrome trace event
+ * format (chrome://tracing, Perfetto), to the file it names. It is also sent
+ * as mycroft.gui.startup_trace.response to mycroft.gui.startup_trace requests.
+ *
+ * The application records the phases before the plugin is loaded in the
+ * "mycroftStartupPhases" property of the application object, as a list of
+ * maps with "name" and "ts", microseconds of std::chrono::steady_clock.
+ */
+class StartupTracer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static bool isEnabled();
+
+    /**
+     * Records that phase was reached, only the first time
+     */
+    static void mark(const QString &phase);
+
+    /**
+     * Records phase when window has swapped its next frame
+     */
+    static void markNextFrame(QQuickWindow *window, const QString &phase);
+
+    /**
+     * @returns all the phases reached so far, in the Chrome trace event format
+     */
+    static QJsonObject chromeTrace();
+
+private:
+    struct Phase {
+        QString name;
+        qint64 timestamp;
+    };
+
+    static StartupTracer *instance();
+    explicit StartupTracer(QObject *parent = nullptr);
+
+    void record(const QString &phase);
+    void writeTrace();
+
+    QVector<Phase> m_phases;
+    bool m_written = false;
+};
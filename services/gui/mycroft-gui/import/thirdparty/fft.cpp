@@ -8,21 +8,58 @@
 
 #include "fft.h"
 
+#include <cassert>
+
+#if defined(MYCROFT_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define FFT_SIMD_SSE2
+#elif defined(MYCROFT_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FFT_SIMD_NEON
+#endif
+
+static size_t reverseBits(size_t value, size_t bits)
+{
+    size_t result = 0;
+    for (size_t i = 0; i < bits; ++i) {
+        result = (result << 1) | (value & 1);
+        value >>= 1;
+    }
+    return result;
+}
+
+static size_t log2Size(size_t size)
+{
+    size_t bits = 0;
+    while ((size_t(1) << bits) < size) {
+        ++bits;
+    }
+    return bits;
+}
+
 void fft(CArray& x){
     const size_t N = x.size();
     if (N <= 1) return;
 
-    CArray even = x[std::slice(0, N/2, 2)];
-    CArray  odd = x[std::slice(1, N/2, 2)];
-
-    fft(even);
-    fft(odd);
+    const size_t bits = log2Size(N);
+    for (size_t i = 0; i < N; ++i) {
+        const size_t j = reverseBits(i, bits);
+        if (j > i) {
+            std::swap(x[i], x[j]);
+        }
+    }
 
-    for (size_t k = 0; k < N/2; ++k)
-    {
-        Complex t = std::polar(1.0, -2 * PI * k / N) * odd[k];
-        x[k    ] = even[k] + t;
-        x[k+N/2] = even[k] - t;
+    for (size_t len = 2; len <= N; len <<= 1) {
+        const Complex step = std::polar(1.0, -2 * PI / len);
+        for (size_t block = 0; block < N; block += len) {
+            Complex w(1.0, 0.0);
+            for (size_t k = 0; k < len/2; ++k) {
+                const Complex t = w * x[block + k + len/2];
+                x[block + k + len/2] = x[block + k] - t;
+                x[block + k] += t;
+                w *= step;
+            }
+        }
     }
 }
 
@@ -32,3 +69,141 @@ void ifft(CArray& x){
     x = x.apply(std::conj);
     x /= x.size();
 }
+
+FFTEngine::FFTEngine(size_t size)
+    : m_size(size),
+      m_half(size / 2),
+      m_bitReverse(m_half),
+      m_realTwiddleRe(m_half + 1),
+      m_realTwiddleIm(m_half + 1),
+      m_re(m_half),
+      m_im(m_half)
+{
+    assert(size >= 4 && (size & (size - 1)) == 0);
+
+    const size_t bits = log2Size(m_half);
+    for (size_t i = 0; i < m_half; ++i) {
+        m_bitReverse[i] = reverseBits(i, bits);
+    }
+
+    // Stage with butterflies of half size h uses the entries [h - 1, 2h - 1)
+    m_stageTwiddleRe.reserve(m_half);
+    m_stageTwiddleIm.reserve(m_half);
+    for (size_t h = 1; h < m_half; h <<= 1) {
+        for (size_t j = 0; j < h; ++j) {
+            const Complex w = std::polar(1.0, -PI * j / h);
+            m_stageTwiddleRe.push_back(w.real());
+            m_stageTwiddleIm.push_back(w.imag());
+        }
+    }
+
+    for (size_t k = 0; k <= m_half; ++k) {
+        const Complex w = std::polar(1.0, -2 * PI * k / m_size);
+        m_realTwiddleRe[k] = w.real();
+        m_realTwiddleIm[k] = w.imag();
+    }
+}
+
+size_t FFTEngine::size() const
+{
+    return m_size;
+}
+
+void FFTEngine::butterflies()
+{
+    double *re = m_re.data();
+    double *im = m_im.data();
+
+    // First stage, all twiddles are 1
+    for (size_t a = 0; a < m_half; a += 2) {
+        const double tr = re[a + 1];
+        const double ti = im[a + 1];
+        re[a + 1] = re[a] - tr;
+        im[a + 1] = im[a] - ti;
+        re[a] += tr;
+        im[a] += ti;
+    }
+
+    for (size_t h = 2; h < m_half; h <<= 1) {
+        const double *wre = m_stageTwiddleRe.data() + h - 1;
+        const double *wim = m_stageTwiddleIm.data() + h - 1;
+
+        for (size_t block = 0; block < m_half; block += 2 * h) {
+            double *are = re + block;
+            double *aim = im + block;
+            double *bre = are + h;
+            double *bim = aim + h;
+
+            // h is even from here on: two butterflies per iteration
+            for (size_t j = 0; j < h; j += 2) {
+#if defined(FFT_SIMD_SSE2)
+                const __m128d wr = _mm_loadu_pd(wre + j);
+                const __m128d wi = _mm_loadu_pd(wim + j);
+                const __m128d br = _mm_loadu_pd(bre + j);
+                const __m128d bi = _mm_loadu_pd(bim + j);
+                const __m128d ar = _mm_loadu_pd(are + j);
+                const __m128d ai = _mm_loadu_pd(aim + j);
+                const __m128d tr = _mm_sub_pd(_mm_mul_pd(wr, br), _mm_mul_pd(wi, bi));
+                const __m128d ti = _mm_add_pd(_mm_mul_pd(wr, bi), _mm_mul_pd(wi, br));
+                _mm_storeu_pd(bre + j, _mm_sub_pd(ar, tr));
+                _mm_storeu_pd(bim + j, _mm_sub_pd(ai, ti));
+                _mm_storeu_pd(are + j, _mm_add_pd(ar, tr));
+                _mm_storeu_pd(aim + j, _mm_add_pd(ai, ti));
+#elif defined(FFT_SIMD_NEON)
+                const float64x2_t wr = vld1q_f64(wre + j);
+                const float64x2_t wi = vld1q_f64(wim + j);
+                const float64x2_t br = vld1q_f64(bre + j);
+                const float64x2_t bi = vld1q_f64(bim + j);
+                const float64x2_t ar = vld1q_f64(are + j);
+                const float64x2_t ai = vld1q_f64(aim + j);
+                const float64x2_t tr = vsubq_f64(vmulq_f64(wr, br), vmulq_f64(wi, bi));
+                const float64x2_t ti = vaddq_f64(vmulq_f64(wr, bi), vmulq_f64(wi, br));
+                vst1q_f64(bre + j, vsubq_f64(ar, tr));
+                vst1q_f64(bim + j, vsubq_f64(ai, ti));
+                vst1q_f64(are + j, vaddq_f64(ar, tr));
+                vst1q_f64(aim + j, vaddq_f64(ai, ti));
+#else
+                for (size_t k = j; k < j + 2; ++k) {
+                    const double tr = wre[k] * bre[k] - wim[k] * bim[k];
+                    const double ti = wre[k] * bim[k] + wim[k] * bre[k];
+                    bre[k] = are[k] - tr;
+                    bim[k] = aim[k] - ti;
+                    are[k] += tr;
+                    aim[k] += ti;
+                }
+#endif
+            }
+        }
+    }
+}
+
+void FFTEngine::realForward(const double *input, Complex *output)
+{
+    // Even samples as real part, odd ones as imaginary part, already bit reversed
+    for (size_t n = 0; n < m_half; ++n) {
+        const size_t j = m_bitReverse[n];
+        m_re[j] = input[2 * n];
+        m_im[j] = input[2 * n + 1];
+    }
+
+    butterflies();
+
+    // X[k] = E[k] + W^k O[k], with E and O the spectra of even and odd samples
+    for (size_t k = 0; k <= m_half; ++k) {
+        const size_t a = k % m_half;
+        const size_t b = (m_half - k) % m_half;
+        const double ar = m_re[a];
+        const double ai = m_im[a];
+        const double br = m_re[b];
+        const double bi = -m_im[b];
+
+        const double er = 0.5 * (ar + br);
+        const double ei = 0.5 * (ai + bi);
+        const double orr = 0.5 * (ai - bi);
+        const double oi = 0.5 * (br - ar);
+        const double wr = m_realTwiddleRe[k];
+        const double wi = m_realTwiddleIm[k];
+
+        output[k] = Complex(er + wr * orr - wi * oi, ei + wr * oi + wi * orr);
+    }
+}
@@ -12,12 +12,52 @@
 #include <complex>
 #include <iostream>
 #include <valarray>
+#include <vector>
 
 const double PI = 3.141592653589793238460;
 
 typedef std::complex<double> Complex;
 typedef std::valarray<Complex> CArray;
 
+// In place, iterative radix-2 FFT, the size of x must be a power of two
 void fft(CArray& x);
 
+/**
+ * FFT of real input of a fixed size, with the bit reversal and twiddle
+ * tables computed once.
+ * The input is packed in a complex FFT of half the size, computed in place
+ * on split real/imaginary arrays so the butterflies can be vectorized
+ * (SSE2 on x86, NEON on aarch64) when built with MYCROFT_SIMD.
+ * Not thread safe: every thread needs its own engine.
+ */
+class FFTEngine
+{
+public:
+    // size must be a power of two, at least 4
+    explicit FFTEngine(size_t size);
+
+    size_t size() const;
+
+    /**
+     * input must hold size() samples, output gets the size() / 2 + 1
+     * bins from 0 to the Nyquist frequency
+     */
+    void realForward(const double *input, Complex *output);
+
+private:
+    void butterflies();
+
+    size_t m_size;
+    size_t m_half;
+    std::vector<size_t> m_bitReverse;
+    // Twiddles of every stage of the half size FFT, one after the other
+    std::vector<double> m_stageTwiddleRe;
+    std::vector<double> m_stageTwiddleIm;
+    // Twiddles to split the half size FFT in the real spectrum
+    std::vector<double> m_realTwiddleRe;
+    std::vector<double> m_realTwiddleIm;
+    std::vector<double> m_re;
+    std::vector<double> m_im;
+};
+
 #endif
@@ -11,16 +11,38 @@
 #undef CLAMP
 #define CLAMP(a,min,max) ((a) < (min) ? (min) : (a) > (max) ? (max) : (a))
 
+// Polls without samples before the processor goes idle
+#define IDLEPASSES 10
+
+// Frequencies shown by the bands
+#define MINFREQUENCY 40.0
+#define MAXFREQUENCY 16000.0
+
+// Time for a band to fall back to a tenth of its value, in ms
+#define FALLOFF 250.0
+
+static double toMel(double frequency){
+    return 2595 * log10(1 + frequency / 700);
+}
+
+static double fromMel(double mel){
+    return 700 * (pow(10, mel / 2595) - 1);
+}
+
 FFTCalc::FFTCalc(QObject *parent)
-    :QObject(parent){
+    :QObject(parent),
+     sampleRate(0),
+     processor(&pipeline){
 
+    pipeline.output.fill(QVector<double>(DEFAULTBANDS, 0.0));
     processor.moveToThread(&processorThread);
 
-    qRegisterMetaType< QVector<double> >("QVector<double>");
-    connect(&processor, SIGNAL(calculatedSpectrum(QVector<double>)), SLOT(setSpectrum(QVector<double>)));
-    connect(&processor, SIGNAL(allDone()),SLOT(freeCalc()));
+    connect(&processor, &BufferProcessor::calculatedSpectrum, this, [this]() {
+        // Spectra published from now on need a new notification
+        pipeline.notified.store(false);
+        emit calculatedSpectrum();
+    });
     processorThread.start(QThread::LowestPriority);
-    isBusy = false;
 }
 
 FFTCalc::~FFTCalc(){
@@ -28,37 +50,65 @@ FFTCalc::~FFTCalc(){
     processorThread.wait(10000);
 }
 
-void FFTCalc::calc(QVector<double> &_array, int duration){
-    QMetaObject::invokeMethod(&processor, "processBuffer",
-                              Qt::QueuedConnection, Q_ARG(QVector<double>, _array), Q_ARG(int, duration));
+void FFTCalc::pushSamples(const float *data, int count, int rate){
+    if(pipeline.paused.load())
+        return;
+
+    if(rate != sampleRate){
+        sampleRate = rate;
+        QMetaObject::invokeMethod(&processor, "setSampleRate", Qt::QueuedConnection, Q_ARG(int, rate));
+    }
+
+    // What doesn't fit is dropped: the processor is late anyway
+    pipeline.samples.write(data, count);
+
+    if(pipeline.idle.exchange(false)){
+        QMetaObject::invokeMethod(&processor, "wake", Qt::QueuedConnection);
+    }
+}
+
+const QVector<double> &FFTCalc::spectrum(){
+    pipeline.output.update();
+    return pipeline.output.readBuffer();
 }
 
-void FFTCalc::setSpectrum(QVector<double> spectrum){
-    emit calculatedSpectrum(spectrum);
+void FFTCalc::setBands(int bands, BandMapping mapping){
+    QMetaObject::invokeMethod(&processor, "setBands", Qt::QueuedConnection, Q_ARG(int, bands), Q_ARG(int, mapping));
 }
 
-void FFTCalc::freeCalc()
-{
-    isBusy = false;
+void FFTCalc::setMaxFps(int maxFps){
+    QMetaObject::invokeMethod(&processor, "setMaxFps", Qt::QueuedConnection, Q_ARG(int, maxFps));
 }
 
-BufferProcessor::BufferProcessor(QObject *parent){
-    Q_UNUSED(parent);
+void FFTCalc::setPaused(bool paused){
+    if(pipeline.paused.exchange(paused) == paused)
+        return;
+    if(paused)
+        QMetaObject::invokeMethod(&processor, "suspend", Qt::QueuedConnection);
+}
+
+BufferProcessor::BufferProcessor(SpectrumPipeline *pipeline)
+    : pipeline(pipeline),
+      idlePasses(0),
+      sampleRate(0),
+      bands(DEFAULTBANDS),
+      mapping(FFTCalc::LogBands),
+      minInterval(1000/DEFAULTMAXFPS),
+      engine(SPECSIZE){
     timer = new QTimer(this);
+    timer->setTimerType(Qt::PreciseTimer);
     connect(timer,SIGNAL(timeout()),this,SLOT(run()));
     window.resize(SPECSIZE);
-    complexFrame.resize(SPECSIZE);
-    spectrum.resize(SPECSIZE/2);
-    logscale.resize(SPECSIZE/2+1);
-    compressed = true;
+    frame.resize(SPECSIZE);
+    windowedFrame.resize(SPECSIZE);
+    // Only the bins up to Nyquist, the rest mirrors them for real input
+    complexFrame.resize(SPECSIZE/2+1);
     for(int i=0; i<SPECSIZE;i++){
         window[i] = 0.5 * (1 - cos((2*PI*i)/(SPECSIZE)));
     }
-    for(int i=0; i<=SPECSIZE/2; i++){
-        logscale[i] = powf (SPECSIZE/2, (float) 2*i / SPECSIZE) - 0.5f;
-    }
-    running = false;
-    timer->start(100);
+    updateBandEdges();
+    // Until the sample rate is known
+    timer->setInterval(100);
 }
 
 BufferProcessor::~BufferProcessor(){
@@ -66,70 +116,144 @@ BufferProcessor::~BufferProcessor(){
 
 }
 
-void BufferProcessor::processBuffer(QVector<double> _array, int duration){
-    if(array.size() != _array.size()){
-        numberOfChunks = _array.size()/SPECSIZE;
-        array.resize(_array.size());
+void BufferProcessor::updateBandEdges(){
+    // Assume the most common rate until the real one is known
+    const double binWidth = double(sampleRate > 0 ? sampleRate : 44100) / SPECSIZE;
+    const double firstBin = qMax(0.5, MINFREQUENCY / binWidth);
+    const double lastBin = qMax(firstBin + 1, qMin(SPECSIZE/2 - 0.5, MAXFREQUENCY / binWidth));
+
+    bandEdges.resize(bands + 1);
+    previousBands.fill(0.0, bands);
+
+    if(mapping == FFTCalc::MelBands){
+        const double firstMel = toMel(firstBin * binWidth);
+        const double lastMel = toMel(lastBin * binWidth);
+        for(int i=0; i<=bands; i++){
+            bandEdges[i] = fromMel(firstMel + (lastMel - firstMel) * i / bands) / binWidth;
+        }
+    } else {
+        for(int i=0; i<=bands; i++){
+            bandEdges[i] = firstBin * pow(lastBin / firstBin, double(i) / bands);
+        }
     }
-    interval = duration/numberOfChunks;
-    if(interval < 1)
-        interval = 1;
-    array = _array;
-    pass = 0;
-    timer->start(interval);
+}
+
+void BufferProcessor::setSampleRate(int rate){
+    if(rate <= 0)
+        return;
+
+    sampleRate = rate;
+    // One chunk per tick keeps up with the audio
+    timer->setInterval(qMax(1, SPECSIZE*1000/sampleRate));
+    updateBandEdges();
+}
+
+void BufferProcessor::setBands(int count, int bandMapping){
+    if(count < 1){
+        qWarning() << "Invalid spectrum band count" << count;
+        return;
+    }
+
+    bands = count;
+    mapping = bandMapping;
+    updateBandEdges();
+}
+
+void BufferProcessor::setMaxFps(int maxFps){
+    minInterval = maxFps > 0 ? 1000/maxFps : 0;
+}
+
+void BufferProcessor::wake(){
+    idlePasses = 0;
+    if(!timer->isActive())
+        timer->start();
+}
+
+void BufferProcessor::suspend(){
+    timer->stop();
+    // Stale by the time the pipeline resumes
+    pipeline->samples.skip(pipeline->samples.availableRead());
+    idlePasses = 0;
+    pipeline->idle.store(true);
 }
 
 void BufferProcessor::run(){
-    unsigned long bufferSize;
-    qreal amplitude;
-    if(pass == numberOfChunks){
-        emit allDone();
+    SpscRingBuffer<float> &samples = pipeline->samples;
+
+    if(samples.availableRead() < SPECSIZE){
+        if(++idlePasses > IDLEPASSES){
+            timer->stop();
+            pipeline->idle.store(true);
+            // Samples may have arrived before the producer saw us idle
+            if(samples.availableRead() >= SPECSIZE && pipeline->idle.exchange(false))
+                wake();
+        }
         return;
     }
-    bufferSize = array.size();
-    if(bufferSize < SPECSIZE){
+    idlePasses = 0;
+
+    // Fell behind the audio: only the latest chunks matter
+    const int backlog = samples.availableRead() - 2*SPECSIZE;
+    if(backlog > 0)
+        samples.skip(backlog);
+
+    // The consumer didn't take the last spectrum yet or doesn't want one so soon:
+    // keep the pace with the audio, but don't compute anything
+    const qint64 elapsed = sincePublished.isValid() ? sincePublished.elapsed() : minInterval;
+    if(pipeline->notified.load() || elapsed < minInterval){
+        samples.skip(SPECSIZE);
         return;
     }
+
+    samples.read(frame.data(), SPECSIZE);
     for(uint i=0; i<SPECSIZE; i++){
-        complexFrame[i] = Complex(window[i]*array[i+pass*SPECSIZE],0);
+        windowedFrame[i] = window[i]*frame[i];
     }
-    fft(complexFrame);
-    for(uint i=0; i<SPECSIZE/2;i++){
+    engine.realForward(windowedFrame.constData(), &complexFrame[0]);
+
+    // Only the bins covered by the bands
+    const int firstBin = qMax(0, int(floor(bandEdges[0])) - 1);
+    const int lastBin = qMin(SPECSIZE/2 - 1, int(ceil(bandEdges[bands])));
+    for(int i=firstBin; i<=lastBin; i++){
         qreal SpectrumAnalyserMultiplier = 1e-2;
-        amplitude = SpectrumAnalyserMultiplier*std::abs(complexFrame[i]);
+        qreal amplitude = SpectrumAnalyserMultiplier*std::abs(complexFrame[i]);
         amplitude = qMax(qreal(0.0), amplitude);
         amplitude = qMin(qreal(1.0), amplitude);
         complexFrame[i] = amplitude;
     }
 
-    if(compressed){
-        for (int i = 0; i <SPECSIZE/2; i ++){
-            int a = ceilf (logscale[i]);
-            int b = floorf (logscale[i+1]);
-            float sum = 0;
-
-            if (b < a)
-                sum += complexFrame[b].real()*(logscale[i+1]-logscale[i]);
-            else{
-                if (a > 0)
-                    sum += complexFrame[a-1].real()*(a-logscale[i]);
-                for (; a < b; a++)
-                    sum += complexFrame[a].real();
-                if (b < SPECSIZE/2)
-                    sum += complexFrame[b].real()*(logscale[i+1] - b);
-            }
-
-            sum *= (float) SPECSIZE/24;
-            float val = 20*log10f (sum);
-            val = 1 + val / 40;
-            spectrum[i] = CLAMP (val, 0, 1);
-        }
-    }
-    else{
-        for(int i=0; i<SPECSIZE/2; i++){
-            spectrum[i] = CLAMP(complexFrame[i].real()*100,0,1);
+    // Smoothing: bands rise immediately and fall off over time
+    const double decay = pow(0.1, qMin<qint64>(elapsed, 1000) / FALLOFF);
+    sincePublished.start();
+
+    // Preallocated, written in place; resized only when the band count changes
+    QVector<double> &spectrum = pipeline->output.writeBuffer();
+    spectrum.resize(bands);
+    for (int i = 0; i <bands; i ++){
+        int a = ceil (bandEdges[i]);
+        int b = floor (bandEdges[i+1]);
+        float sum = 0;
+
+        if (b < a)
+            sum += complexFrame[b].real()*(bandEdges[i+1]-bandEdges[i]);
+        else{
+            if (a > 0)
+                sum += complexFrame[a-1].real()*(a-bandEdges[i]);
+            for (; a < b; a++)
+                sum += complexFrame[a].real();
+            if (b < SPECSIZE/2)
+                sum += complexFrame[b].real()*(bandEdges[i+1] - b);
         }
+
+        // Same scale as one band per bin used to have
+        sum *= (float) bands/12;
+        float val = 20*log10f (sum);
+        val = 1 + val / 40;
+        previousBands[i] = qMax<double>(CLAMP (val, 0, 1), previousBands[i] * decay);
+        spectrum[i] = previousBands[i];
     }
-    emit calculatedSpectrum(spectrum);
-    pass++;
+    pipeline->output.publish();
+
+    if(!pipeline->notified.exchange(true))
+        emit calculatedSpectrum();
 }
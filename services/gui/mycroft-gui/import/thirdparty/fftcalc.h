@@ -15,53 +15,112 @@
 #include <QVector>
 #include <QDebug>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QObject>
 #include "fft.h"
+#include "../spscringbuffer.h"
+#include "../triplebuffer.h"
+
+#include <atomic>
 
 #define SPECSIZE 512
 
+// Samples to buffer between the probe and the processor, about 0.75s at 44.1kHz
+#define RINGSIZE (SPECSIZE * 64)
+
+#define DEFAULTBANDS 20
+#define DEFAULTMAXFPS 30
+
+/**
+ * State shared between the probe thread and the processor thread,
+ * all of it preallocated and lock free.
+ */
+struct SpectrumPipeline {
+    SpectrumPipeline() : samples(RINGSIZE) {}
+
+    SpscRingBuffer<float> samples;
+    TripleBuffer<QVector<double> > output;
+    // The processor stopped polling, it needs a wake() for new samples
+    std::atomic<bool> idle{true};
+    // A calculatedSpectrum() is on its way to the consumer
+    std::atomic<bool> notified{false};
+    // Samples are dropped by the producer, the processor sleeps
+    std::atomic<bool> paused{false};
+};
+
 class BufferProcessor: public QObject{
     Q_OBJECT
-    QVector<double> array;
+    SpectrumPipeline *pipeline;
     QVector<double> window;
-    QVector<double> spectrum;
-    QVector<double> logscale;
+    // Fractional FFT bin where every band starts, plus where the last one ends
+    QVector<double> bandEdges;
+    QVector<double> previousBands;
     QTimer *timer;
-    bool compressed;
-    bool running;
-    int numberOfChunks;
-    int interval;
-    int pass;
+    int idlePasses;
+    int sampleRate;
+    int bands;
+    int mapping;
+    int minInterval;
+    QElapsedTimer sincePublished;
+    FFTEngine engine;
+    QVector<float> frame;
+    QVector<double> windowedFrame;
     CArray complexFrame;
 
+    void updateBandEdges();
+
 public slots:
-    void processBuffer(QVector<double> _array, int duration);
+    void setSampleRate(int sampleRate);
+    void setBands(int bands, int mapping);
+    void setMaxFps(int maxFps);
+    void wake();
+    void suspend();
 signals:
-    void calculatedSpectrum(QVector<double> spectrum);
-    void allDone(void);
+    void calculatedSpectrum();
 protected slots:
     void run();
 public:
-    explicit BufferProcessor(QObject *parent=0);
+    explicit BufferProcessor(SpectrumPipeline *pipeline);
     ~BufferProcessor();
-    void calc(QVector<double> &_array, int duration);
 };
+
+/**
+ * Computes the spectrum of the samples pushed from the audio probe,
+ * reduced to a few bands.
+ * Samples go through a lock free ring buffer to the processor thread,
+ * spectra come back through a triple buffer: nothing is allocated or
+ * deep copied per audio buffer.
+ */
 class FFTCalc : public QObject{
     Q_OBJECT
 private:
-    bool isBusy;
+    SpectrumPipeline pipeline;
+    int sampleRate;
     BufferProcessor processor;
     QThread processorThread;
 
 public:
+    // How the bands are spread over the frequencies
+    enum BandMapping {
+        LogBands,
+        MelBands
+    };
+
     explicit FFTCalc(QObject *parent = 0);
     ~FFTCalc();
-    void calc(QVector<double> &_array, int duration);
-public slots:
-    void setSpectrum(QVector<double> spectrum);
-    void freeCalc();
+    // From the thread of the probe only
+    void pushSamples(const float *data, int count, int sampleRate);
+    // From the thread of the FFTCalc only, the latest bands
+    const QVector<double> &spectrum();
+    // Only the bands are computed and smoothed, 20 log bands by default
+    void setBands(int bands, BandMapping mapping);
+    // Chunks beyond this rate are skipped, 0 for every chunk; 30 by default
+    void setMaxFps(int maxFps);
+    // Nothing is computed while paused, for when no one looks at the spectrum
+    void setPaused(bool paused);
 signals:
-    void calculatedSpectrum(QVector<double> spectrum);
+    // Coalesced: at most one is pending at any time
+    void calculatedSpectrum();
 };
 
 #endif // FFTCALC_H
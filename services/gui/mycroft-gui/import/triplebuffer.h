@@ -0,0 +1,85 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+
+/**
+ * Lock free exchange of the latest value from one writer thread to one
+ * reader thread. The writer fills writeBuffer() and publish()es it, the
+ * reader update()s to the most recent published value and reads it from
+ * readBuffer(). Neither side ever waits for the other one, or copies.
+ * The three buffers are reused, so values which keep their size never
+ * allocate after the first round.
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+    // Writer side
+    T &writeBuffer()
+    {
+        return m_buffers[m_writeIndex];
+    }
+
+    // Writer side, makes the content of writeBuffer() the latest value
+    void publish()
+    {
+        const int previous = m_middle.exchange(m_writeIndex | DirtyBit, std::memory_order_acq_rel);
+        m_writeIndex = previous & IndexMask;
+    }
+
+    /**
+     * Reader side, switches readBuffer() to the latest published value
+     * @returns false if nothing new was published since the last update
+     */
+    bool update()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & DirtyBit)) {
+            return false;
+        }
+        const int previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & IndexMask;
+        return true;
+    }
+
+    // Reader side
+    const T &readBuffer() const
+    {
+        return m_buffers[m_readIndex];
+    }
+
+    // Not thread safe, only before either side starts
+    void fill(const T &value)
+    {
+        for (T &buffer : m_buffers) {
+            buffer = value;
+        }
+    }
+
+private:
+    enum {
+        IndexMask = 0x3,
+        DirtyBit = 0x4
+    };
+
+    T m_buffers[3];
+    int m_writeIndex = 0;
+    std::atomic<int> m_middle{1};
+    int m_readIndex = 2;
+};
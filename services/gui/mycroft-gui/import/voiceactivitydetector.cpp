@@ -0,0 +1,139 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "voiceactivitydetector.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+
+// Below this RMS nothing is speech, whatever the noise floor: digital silence
+static const float s_minimumLevel = 0.005f;
+// Speech that long, in ms, before it counts: clicks and bumps don't
+static const int s_onsetMsecs = 60;
+// Frames of the first ms seeding the noise floor, decided on when it's over
+static const int s_calibrationMsecs = 200;
+
+VoiceActivityDetector::VoiceActivityDetector(int frameMsecs)
+    : m_frameMsecs(qMax(1, frameMsecs)),
+      m_onsetFrames(qMax(1, s_onsetMsecs / m_frameMsecs)),
+      m_calibrationFrames(qMax(1, s_calibrationMsecs / m_frameMsecs))
+{
+    setHangover(800);
+}
+
+void VoiceActivityDetector::reset()
+{
+    m_noiseFloor = -1;
+    m_calibration.clear();
+    m_voicedFrames = 0;
+    m_unvoicedFrames = 0;
+    m_voiced = false;
+    m_inSpeech = false;
+}
+
+VoiceActivityDetector::Event VoiceActivityDetector::process(float rms)
+{
+    if (m_noiseFloor >= 0) {
+        return detect(rms);
+    }
+
+    // The first frame may well be speech already, right after the listen chime
+    m_calibration << rms;
+    if (m_calibration.count() < m_calibrationFrames) {
+        return NoEvent;
+    }
+
+    m_noiseFloor = *std::min_element(m_calibration.constBegin(), m_calibration.constEnd());
+    const QVector<float> frames = m_calibration;
+    m_calibration.clear();
+
+    Event event = NoEvent;
+    for (float frame : frames) {
+        const Event frameEvent = detect(frame);
+        if (frameEvent != NoEvent) {
+            event = frameEvent;
+        }
+    }
+    return event;
+}
+
+VoiceActivityDetector::Event VoiceActivityDetector::detect(float rms)
+{
+    m_voiced = rms > qMax(m_noiseFloor * m_threshold, s_minimumLevel);
+
+    if (!m_inSpeech) {
+        if (!m_voiced) {
+            m_voicedFrames = 0;
+            m_noiseFloor += (rms - m_noiseFloor) * (rms < m_noiseFloor ? 0.2f : 0.02f);
+            return NoEvent;
+        }
+        if (++m_voicedFrames < m_onsetFrames) {
+            return NoEvent;
+        }
+        m_inSpeech = true;
+        m_unvoicedFrames = 0;
+        return SpeechStarted;
+    }
+
+    if (m_voiced) {
+        m_unvoicedFrames = 0;
+        return NoEvent;
+    }
+
+    if (++m_unvoicedFrames < m_hangoverFrames) {
+        return NoEvent;
+    }
+    m_inSpeech = false;
+    m_voicedFrames = 0;
+    return SpeechEnded;
+}
+
+bool VoiceActivityDetector::inSpeech() const
+{
+    return m_inSpeech;
+}
+
+bool VoiceActivityDetector::isVoiced() const
+{
+    return m_voiced;
+}
+
+float VoiceActivityDetector::noiseFloor() const
+{
+    return m_noiseFloor;
+}
+
+int VoiceActivityDetector::frameMsecs() const
+{
+    return m_frameMsecs;
+}
+
+void VoiceActivityDetector::setThreshold(float ratio)
+{
+    m_threshold = qMax(1.0f, ratio);
+}
+
+int VoiceActivityDetector::hangover() const
+{
+    return m_hangoverFrames * m_frameMsecs;
+}
+
+void VoiceActivityDetector::setHangover(int msecs)
+{
+    m_hangoverFrames = qMax(1, msecs / m_frameMsecs);
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2022 by Mycroft AI Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <QVector>
+
+/**
+ * Energy based voice activity detection, fed with the RMS of consecutive
+ * frames of a few tens of milliseconds.
+ *
+ * The noise floor starts at the quietest frame of a short calibration
+ * window, so speech going on since the first frame is told from steady
+ * noise by its pauses. Then it follows the quietest frames, falling quickly
+ * and rising slowly. Speech starts after a few frames well above it, and
+ * ends after hangover of frames without it, so short pauses between words
+ * don't.
+ */
+class VoiceActivityDetector
+{
+public:
+    enum Event {
+        NoEvent,
+        SpeechStarted,
+        SpeechEnded
+    };
+
+    explicit VoiceActivityDetector(int frameMsecs = 20);
+
+    /**
+     * Forgets the noise floor and the speech in progress
+     */
+    void reset();
+
+    Event process(float rms);
+
+    bool inSpeech() const;
+    // Whether the last frame was above the threshold
+    bool isVoiced() const;
+    float noiseFloor() const;
+    int frameMsecs() const;
+
+    /**
+     * How much louder than the noise floor speech is, 3 (about 10 dB) by default
+     */
+    void setThreshold(float ratio);
+
+    /**
+     * Milliseconds of silence ending the speech, 800 by default
+     */
+    int hangover() const;
+    void setHangover(int msecs);
+
+private:
+    Event detect(float rms);
+
+    int m_frameMsecs;
+    float m_threshold = 3;
+    int m_onsetFrames;
+    int m_hangoverFrames;
+    int m_calibrationFrames;
+
+    // Negative until the end of the calibration window
+    float m_noiseFloor = -1;
+    QVector<float> m_calibration;
+    int m_voicedFrames = 0;
+    int m_unvoicedFrames = 0;
+    bool m_voiced = false;
+    bool m_inSpeech = false;
+};
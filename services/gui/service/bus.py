@@ -22,10 +22,19 @@ The basic mechanism is:
     5) Connection persists for graphical interaction indefinitely
 
 If the connection is lost, it must be renegotiated and restarted.
+
+Every message sent to the GUIs is numbered ("seq") and the most recent ones
+are kept. A GUI reconnecting with the session and the last sequence number it
+applied in the query of the URL only gets the messages it missed, instead of
+the whole state. The first message of every connection is a
+mycroft.session.sync telling the GUI whether its session was resumed.
 """
 import asyncio
 import json
-from threading import Lock, Thread
+from collections import deque
+from threading import Lock, RLock, Thread
+from typing import Optional
+from uuid import uuid4
 
 from mycroft.configuration import Configuration
 from mycroft.messagebus import Message
@@ -37,6 +46,50 @@ from tornado.websocket import WebSocketHandler
 
 write_lock = Lock()
 
+# How many sent messages are kept for GUIs resuming their session
+SESSION_LOG_SIZE = 1000
+
+
+class SessionLog:
+    """Numbers the messages sent to the GUIs and keeps the most recent ones."""
+
+    def __init__(self, size: int = SESSION_LOG_SIZE):
+        # Changes when the service restarts, sequence numbers restart with it
+        self.session = uuid4().hex
+        self.sequence = 0
+        self.messages = deque(maxlen=size)
+        # Held while sending, so that messages go out in sequence order
+        self.lock = RLock()
+
+    def append(self, message: dict) -> dict:
+        """Returns a copy of the message, numbered."""
+        self.sequence += 1
+        message = dict(message, seq=self.sequence)
+        self.messages.append(message)
+        return message
+
+    def since(self, session: Optional[str], sequence: Optional[str]):
+        """Returns the messages after sequence, or None if they are not all known."""
+        if session != self.session or sequence is None:
+            return None
+
+        try:
+            sequence = int(sequence)
+        except ValueError:
+            return None
+
+        if sequence > self.sequence:
+            return None
+
+        oldest = self.messages[0]["seq"] if self.messages else self.sequence + 1
+        if sequence < oldest - 1:
+            return None
+
+        return [m for m in self.messages if m["seq"] > sequence]
+
+
+session_log = SessionLog()
+
 
 def get_gui_websocket_config():
     """Retrieves the configuration values for establishing a GUI message bus"""
@@ -65,11 +118,13 @@ def create_gui_service(enclosure) -> Application:
 
 def send_message_to_gui(message):
     """Sends the supplied message to all connected GUI clients."""
-    for connection in GUIWebsocketHandler.clients:
-        try:
-            connection.send(message)
-        except Exception as e:
-            LOG.exception(repr(e))
+    with session_log.lock:
+        message = session_log.append(message)
+        for connection in GUIWebsocketHandler.clients:
+            try:
+                connection.send(message)
+            except Exception as e:
+                LOG.exception(repr(e))
 
 
 def determine_if_gui_connected():
@@ -83,9 +138,28 @@ class GUIWebsocketHandler(WebSocketHandler):
     clients = []
 
     def open(self):
-        GUIWebsocketHandler.clients.append(self)
-        LOG.info("New Connection opened!")
-        self.application.enclosure.synchronize()
+        with session_log.lock:
+            GUIWebsocketHandler.clients.append(self)
+            missed = session_log.since(
+                self.get_argument("session", None),
+                self.get_argument("sequence", None),
+            )
+            self.send(
+                {
+                    "type": "mycroft.session.sync",
+                    "session": session_log.session,
+                    "sequence": session_log.sequence,
+                    "resumed": missed is not None,
+                }
+            )
+            for message in missed or []:
+                self.send(message)
+
+        if missed is None:
+            LOG.info("New Connection opened!")
+            self.application.enclosure.synchronize()
+        else:
+            LOG.info("Connection resumed, %d messages replayed", len(missed))
 
     def on_close(self):
         LOG.info("Closing {}".format(id(self)))
@@ -150,6 +224,18 @@ class GUIWebsocketHandler(WebSocketHandler):
             # A value was changed send it back to the skill
             msg_type = "{}.{}".format(msg["namespace"], "set")
             msg_data = msg["data"]
+            # Deleted keys are batched in the same message
+            for key in msg.get("deleted", []):
+                msg_data[key] = None
+
+        elif msg.get("type") == "mycroft.session.delete":
+            # Older GUIs send deletes on their own
+            msg_type = "{}.{}".format(msg["namespace"], "set")
+            msg_data = {msg["property"]: None}
+
+        else:
+            LOG.warning("Unhandled message type: %s", msg.get("type"))
+            return
 
         message = Message(msg_type, msg_data)
         LOG.info("Forwarding to bus...")
@@ -85,6 +85,8 @@ Mycroft.CardDelegate {
         onTriggered: {
             spectrum = audioService.spectrum
         }
+        // No need for the analyzer to produce more than what gets sampled
+        Component.onCompleted: audioService.spectrumMaxFps = 1000 / interval
     }
 
     onActiveFocusChanged: {